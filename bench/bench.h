@@ -0,0 +1,58 @@
+// streamlumo-engine/bench/bench.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+//
+// Small helpers shared by the benches: "--name value" options and timing
+
+#pragma once
+
+#include "platform/platform.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace streamlumo {
+namespace bench {
+
+// Value of "--name <value>", or fallback
+inline const char* option(int argc, char** argv, const char* name, const char* fallback) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+inline uint64_t option(int argc, char** argv, const char* name, uint64_t fallback) {
+    const char* value = option(argc, argv, name, static_cast<const char*>(nullptr));
+    return value ? std::strtoull(value, nullptr, 10) : fallback;
+}
+
+inline bool flag(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Wall time of one run, in microseconds
+class Stopwatch {
+public:
+    Stopwatch() : m_start(platform::getTimestampMicros()) {}
+    uint64_t micros() const { return platform::getTimestampMicros() - m_start; }
+
+private:
+    uint64_t m_start;
+};
+
+inline double perSecond(uint64_t count, uint64_t micros) {
+    return micros ? count * 1e6 / micros : 0.0;
+}
+
+} // namespace bench
+} // namespace streamlumo
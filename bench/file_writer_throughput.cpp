@@ -0,0 +1,245 @@
+// streamlumo-engine/bench/file_writer_throughput.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+//
+// AsyncFileWriter throughput: buffered vs direct I/O, over a batch size sweep.
+//
+//   bench-file-writer [--size-mb <MB>] [--packet-kb <KB>] [--dir <path>]
+//   bench-file-writer --throttle-mbps <Mbit/s> [--write-delay-ms <ms>] [--bitrate-mbps <Mbit/s>]
+//                     [--seconds <s>] [--max-queued-mb <MB>] [--packet-kb <KB>] [--dir <path>]
+//
+// A producer appends fixed-size packets (an encoder's output, at full speed)
+// and the writer thread writes them out in batches. Reported per run: the
+// producer's append rate, the rate to the end of stop() (everything
+// written), the writes issued, the slowest write and the appends that had
+// to wait for the disk. Buffered runs end once the data is in the page
+// cache; the kernel writes it back afterwards.
+//
+// With --throttle-mbps the disk is replaced by a slow sink: the writer
+// writes into a FIFO that a reader thread drains at that rate, sleeping
+// --write-delay-ms more after every MB (a latency spike per write-back).
+// The producer runs in real time at --bitrate-mbps, like an encoder; a
+// packet whose slot passed while append() waited is dropped, as an
+// encoder with a blocked output would. Reported: the peak backlog queued
+// in the writer, the stalled appends and the dropped packets. POSIX only.
+
+#include "async_file_writer.h"
+#include "bench.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace streamlumo;
+
+namespace {
+
+struct Run {
+    uint64_t appendMicros = 0;
+    uint64_t totalMicros = 0;
+    AsyncFileWriter::Stats stats;
+    bool failed = false;
+};
+
+Run runWriter(bool directIO, size_t batchBytes, uint64_t totalBytes, const std::vector<uint8_t>& packet,
+              const std::string& path) {
+    AsyncFileWriter::Options options;
+    options.directIO = directIO;
+    options.batchBytes = batchBytes;
+
+    AsyncFileWriter writer;
+    Run run;
+    bench::Stopwatch watch;
+    writer.start(options);
+    writer.open(path);
+    for (uint64_t written = 0; written < totalBytes; written += packet.size()) {
+        writer.append(packet.data(), packet.size());
+    }
+    run.appendMicros = watch.micros();
+    writer.closeFile({});
+    writer.stop();
+    run.totalMicros = watch.micros();
+    run.stats = writer.stats();
+    run.failed = writer.failed();
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return run;
+}
+
+struct ThrottledRun {
+    uint64_t packets = 0;
+    uint64_t dropped = 0;           // Slots missed, nearly always while append() was blocked
+    uint64_t maxAppendMicros = 0;
+    uint64_t drained = 0;           // Bytes the sink read
+    AsyncFileWriter::Stats stats;
+    bool failed = false;
+};
+
+#ifndef _WIN32
+// Reads the FIFO at no more than bytesPerSecond, plus delayMs after every MB
+void drainThrottled(const std::string& path, uint64_t bytesPerSecond, uint32_t delayMs,
+                    std::atomic<uint64_t>& drained) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    // A pipe hands out at most its buffer size per read
+    std::vector<uint8_t> chunk(1024 * 1024);
+    const uint64_t start = platform::getTimestampNanos();
+    uint64_t total = 0;
+    for (;;) {
+        const ssize_t n = ::read(fd, chunk.data(), chunk.size());
+        if (n <= 0) {
+            break;
+        }
+        total += static_cast<uint64_t>(n);
+        drained.store(total, std::memory_order_relaxed);
+        const uint64_t megabytes = total >> 20;
+        platform::sleepUntilNanos(start + total * 1000000000ULL / bytesPerSecond +
+                                  megabytes * delayMs * 1000000ULL);
+    }
+    ::close(fd);
+}
+
+ThrottledRun runThrottled(uint64_t bitrate, uint64_t sinkRate, uint32_t delayMs, uint64_t seconds,
+                          size_t maxQueuedBytes, const std::vector<uint8_t>& packet, const std::string& path) {
+    ThrottledRun run;
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    if (mkfifo(path.c_str(), 0600) != 0) {
+        run.failed = true;
+        return run;
+    }
+    std::atomic<uint64_t> drained{0};
+    std::thread sink(drainThrottled, path, sinkRate, delayMs, std::ref(drained));
+
+    AsyncFileWriter::Options options;
+    options.batchBytes = 1024 * 1024;
+    options.maxQueuedBytes = maxQueuedBytes;
+    AsyncFileWriter writer;
+    writer.start(options);
+    writer.open(path);
+
+    // One packet per slot at the encoder's bitrate
+    const uint64_t slotNanos = packet.size() * 8ULL * 1000000000ULL / bitrate;
+    const uint64_t slots = seconds * 1000000000ULL / slotNanos;
+    const uint64_t start = platform::getTimestampNanos();
+    for (uint64_t slot = 0; slot < slots; slot++) {
+        platform::sleepUntilNanos(start + slot * slotNanos);
+        const uint64_t before = platform::getTimestampNanos();
+        writer.append(packet.data(), packet.size());
+        const uint64_t after = platform::getTimestampNanos();
+        run.packets++;
+        run.maxAppendMicros = std::max<uint64_t>(run.maxAppendMicros, (after - before) / 1000);
+        const uint64_t next = (after - start) / slotNanos + 1;
+        if (next > slot + 1) {
+            run.dropped += std::min(next, slots) - (slot + 1);
+            slot = next - 1;
+        }
+    }
+    writer.closeFile({});
+    writer.stop();
+    sink.join();
+    run.drained = drained.load();
+    run.stats = writer.stats();
+    run.failed = writer.failed();
+    std::filesystem::remove(path, ec);
+    return run;
+}
+#endif
+
+int throttledMain(int argc, char** argv, const std::vector<uint8_t>& packet, const std::string& path) {
+    const uint64_t sinkMbps = bench::option(argc, argv, "--throttle-mbps", uint64_t{0});
+    const uint64_t bitrateMbps = bench::option(argc, argv, "--bitrate-mbps", uint64_t{50});
+    const uint32_t delayMs = static_cast<uint32_t>(bench::option(argc, argv, "--write-delay-ms", uint64_t{0}));
+    const uint64_t seconds = std::max<uint64_t>(bench::option(argc, argv, "--seconds", uint64_t{10}), 1);
+    const size_t maxQueued = bench::option(argc, argv, "--max-queued-mb", uint64_t{128}) * 1024 * 1024;
+    if (sinkMbps == 0 || bitrateMbps == 0) {
+        std::fprintf(stderr, "--throttle-mbps and --bitrate-mbps must be > 0\n");
+        return 1;
+    }
+#ifdef _WIN32
+    (void)delayMs;
+    (void)seconds;
+    (void)maxQueued;
+    (void)packet;
+    (void)path;
+    std::fprintf(stderr, "--throttle-mbps needs a FIFO, not available on Windows\n");
+    return 1;
+#else
+    std::printf("%llu Mbit/s producer into a %llu Mbit/s sink (+%u ms per MB) for %llus, %zu KB packets, "
+                "queue limit %zu MB\n\n",
+                static_cast<unsigned long long>(bitrateMbps), static_cast<unsigned long long>(sinkMbps), delayMs,
+                static_cast<unsigned long long>(seconds), packet.size() >> 10, maxQueued >> 20);
+    const ThrottledRun run = runThrottled(bitrateMbps * 1000000, sinkMbps * 1000000 / 8, delayMs, seconds,
+                                          maxQueued, packet, path);
+    if (run.failed) {
+        std::printf("write failed\n");
+        return 1;
+    }
+    std::printf("%10s %10s %8s %14s %14s %12s %11s\n", "packets", "dropped", "drop %", "peak queue MB",
+                "max append ms", "stalls", "drained MB");
+    std::printf("%10llu %10llu %8.2f %14.1f %14.2f %12llu %11.1f\n", static_cast<unsigned long long>(run.packets),
+                static_cast<unsigned long long>(run.dropped),
+                100.0 * run.dropped / std::max<uint64_t>(run.packets + run.dropped, 1),
+                run.stats.peakQueuedBytes / 1048576.0, run.maxAppendMicros / 1000.0,
+                static_cast<unsigned long long>(run.stats.stalls), run.drained / 1048576.0);
+    return 0;
+#endif
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const uint64_t totalBytes = bench::option(argc, argv, "--size-mb", uint64_t{1024}) * 1024 * 1024;
+    const size_t packetBytes = bench::option(argc, argv, "--packet-kb", uint64_t{32}) * 1024;
+    const std::string dir = bench::option(argc, argv, "--dir", platform::getTempDir().c_str());
+    const std::string path = platform::joinPath(dir, "streamlumo-bench.flv");
+
+    // Warnings (e.g. no direct I/O on this filesystem) still reach the console
+    Logging::init(LogLevel::Warning);
+
+    std::vector<uint8_t> packet(packetBytes);
+    for (size_t i = 0; i < packet.size(); i++) {
+        packet[i] = static_cast<uint8_t>(i * 131);
+    }
+
+    if (bench::option(argc, argv, "--throttle-mbps", static_cast<const char*>(nullptr))) {
+        const int result = throttledMain(argc, argv, packet, path);
+        Logging::shutdown();
+        return result;
+    }
+
+    std::printf("%llu MB in %zu KB packets to %s\n\n", static_cast<unsigned long long>(totalBytes >> 20),
+                packetBytes >> 10, path.c_str());
+    std::printf("%-9s %8s %12s %12s %8s %13s %8s\n", "mode", "batch", "append MB/s", "total MB/s", "writes",
+                "max write ms", "stalls");
+    for (bool directIO : {false, true}) {
+        for (size_t batchKb : {256, 1024, 4096, 16384}) {
+            const Run run = runWriter(directIO, batchKb * 1024, totalBytes, packet, path);
+            if (run.failed) {
+                std::printf("%-9s %6zuKB  write failed\n", directIO ? "direct" : "buffered", batchKb);
+                continue;
+            }
+            std::printf("%-9s %6zuKB %12.0f %12.0f %8llu %13.2f %8llu\n", directIO ? "direct" : "buffered", batchKb,
+                        bench::perSecond(totalBytes >> 20, run.appendMicros),
+                        bench::perSecond(totalBytes >> 20, run.totalMicros),
+                        static_cast<unsigned long long>(run.stats.writes), run.stats.maxWriteMicros / 1000.0,
+                        static_cast<unsigned long long>(run.stats.stalls));
+        }
+    }
+
+    Logging::shutdown();
+    return 0;
+}
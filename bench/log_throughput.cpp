@@ -0,0 +1,104 @@
+// streamlumo-engine/bench/log_throughput.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+//
+// Logging throughput: N threads log through Logging::logv into a file.
+//
+//   bench-logging [--lines <per thread>] [--max-threads <N>] [--file <path>]
+//
+// For 1, 2, 4 ... max-threads producers, reports the time callers spend in
+// log() (what the render and output threads pay), the rate the writer thread
+// drains the ring to disk, and the lines dropped because the ring was full.
+
+#include "bench.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+using namespace streamlumo;
+
+namespace {
+
+void logLine(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    Logging::logv(LogLevel::Info, format, args);
+    va_end(args);
+}
+
+struct Run {
+    uint64_t lines = 0;
+    uint64_t producerMicros = 0;    // Until every producer returned
+    uint64_t drainMicros = 0;       // Until the writer wrote the last line
+    uint64_t dropped = 0;
+};
+
+Run runThreads(unsigned threads, uint64_t linesPerThread, const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    const uint64_t droppedBefore = Logging::droppedCount();
+    Logging::init(LogLevel::Info, path);
+
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> producers;
+    for (unsigned t = 0; t < threads; t++) {
+        producers.emplace_back([&, t] {
+            ready++;
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (uint64_t i = 0; i < linesPerThread; i++) {
+                logLine("Outputs: thread %u packet %llu pts %lld size %d", t, static_cast<unsigned long long>(i),
+                        static_cast<long long>(i * 33), 4096);
+            }
+        });
+    }
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+
+    bench::Stopwatch watch;
+    go.store(true, std::memory_order_release);
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    Run run;
+    run.producerMicros = watch.micros();
+    // Drains the ring before it returns
+    Logging::shutdown();
+    run.drainMicros = watch.micros();
+    run.lines = threads * linesPerThread;
+    run.dropped = Logging::droppedCount() - droppedBefore;
+    return run;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const uint64_t lines = bench::option(argc, argv, "--lines", uint64_t{200000});
+    const unsigned maxThreads = static_cast<unsigned>(
+        bench::option(argc, argv, "--max-threads", uint64_t{std::max(1u, std::thread::hardware_concurrency())}));
+    const std::string path =
+        bench::option(argc, argv, "--file", platform::joinPath(platform::getTempDir(), "streamlumo-bench.log").c_str());
+
+    std::printf("%llu lines per thread into %s\n\n", static_cast<unsigned long long>(lines), path.c_str());
+    std::printf("%7s %12s %14s %14s %10s\n", "threads", "ns/call", "calls/s", "written/s", "dropped");
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        const Run run = runThreads(threads, lines, path);
+        std::printf("%7u %12.1f %14.0f %14.0f %10llu\n", threads,
+                    run.producerMicros * 1000.0 * threads / run.lines, bench::perSecond(run.lines, run.producerMicros),
+                    bench::perSecond(run.lines - run.dropped, run.drainMicros),
+                    static_cast<unsigned long long>(run.dropped));
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return 0;
+}
@@ -0,0 +1,342 @@
+// streamlumo-engine/bench/scene_collection_load.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+//
+// Scene collection load time: the binary format (--scene-format binary)
+// against obs_data JSON, on a generated collection.
+//
+//   bench-scene-collection [--inputs <N>] [--scenes <N>] [--iterations <N>] [--dir <path>]
+//
+// The collection has the shape OBS saves: browser, text, image and media
+// inputs with settings, filters and hotkeys, and scenes whose items point at
+// them. Both files are written once; each iteration reads one back from disk
+// and decodes it, the part of SceneCollectionStore::load() that differs
+// between the formats. Creating the sources afterwards costs the same
+// either way and is not measured.
+
+#include "bench.h"
+#include "logging.h"
+#include "scene_collection_store.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace streamlumo;
+
+namespace {
+
+obs_data_t* makeVec2(double x, double y) {
+    obs_data_t* vec = obs_data_create();
+    obs_data_set_double(vec, "x", x);
+    obs_data_set_double(vec, "y", y);
+    return vec;
+}
+
+void setObj(obs_data_t* data, const char* name, obs_data_t* obj) {
+    obs_data_set_obj(data, name, obj);
+    obs_data_release(obj);
+}
+
+void setArray(obs_data_t* data, const char* name, obs_data_array_t* array) {
+    obs_data_set_array(data, name, array);
+    obs_data_array_release(array);
+}
+
+void pushBack(obs_data_array_t* array, obs_data_t* data) {
+    obs_data_array_push_back(array, data);
+    obs_data_release(data);
+}
+
+obs_data_t* makeSettings(int kind, int index) {
+    obs_data_t* settings = obs_data_create();
+    char text[256];
+    switch (kind) {
+    case 0:
+        std::snprintf(text, sizeof(text), "https://overlay.example.com/widgets/alerts?id=%d&theme=dark", index);
+        obs_data_set_string(settings, "url", text);
+        obs_data_set_int(settings, "width", 1920);
+        obs_data_set_int(settings, "height", 1080);
+        obs_data_set_string(settings, "css", "body { background-color: rgba(0, 0, 0, 0); margin: 0px auto; overflow: hidden; }");
+        obs_data_set_bool(settings, "reroute_audio", true);
+        obs_data_set_bool(settings, "shutdown", index % 2 == 0);
+        break;
+    case 1: {
+        std::snprintf(text, sizeof(text), "Lower third %d\nSubtitle line for the segment", index);
+        obs_data_set_string(settings, "text", text);
+        obs_data_t* font = obs_data_create();
+        obs_data_set_string(font, "face", "Inter");
+        obs_data_set_string(font, "style", "Bold");
+        obs_data_set_int(font, "size", 48 + index % 24);
+        obs_data_set_int(font, "flags", 1);
+        setObj(settings, "font", font);
+        obs_data_set_int(settings, "color1", 4294967295LL);
+        obs_data_set_int(settings, "color2", 4278190080LL);
+        obs_data_set_bool(settings, "outline", true);
+        break;
+    }
+    case 2:
+        std::snprintf(text, sizeof(text), "/Users/streamer/Pictures/overlays/frame_%04d.png", index);
+        obs_data_set_string(settings, "file", text);
+        obs_data_set_bool(settings, "unload", false);
+        break;
+    default:
+        std::snprintf(text, sizeof(text), "/Users/streamer/Movies/loops/intro_%04d.mp4", index);
+        obs_data_set_string(settings, "local_file", text);
+        obs_data_set_bool(settings, "looping", true);
+        obs_data_set_bool(settings, "restart_on_activate", true);
+        obs_data_set_int(settings, "speed_percent", 100);
+        obs_data_set_double(settings, "buffering_mb", 2.5);
+        break;
+    }
+    return settings;
+}
+
+obs_data_t* makeFilter(int index) {
+    obs_data_t* filter = obs_data_create();
+    char name[64];
+    std::snprintf(name, sizeof(name), "Color Correction %d", index);
+    obs_data_set_string(filter, "name", name);
+    obs_data_set_string(filter, "id", "color_filter_v2");
+    obs_data_set_string(filter, "versioned_id", "color_filter_v2");
+    obs_data_set_bool(filter, "enabled", true);
+    obs_data_t* settings = obs_data_create();
+    obs_data_set_double(settings, "brightness", 0.05);
+    obs_data_set_double(settings, "contrast", 0.12);
+    obs_data_set_double(settings, "saturation", 0.2);
+    obs_data_set_double(settings, "gamma", -0.1);
+    setObj(filter, "settings", settings);
+    setObj(filter, "private_settings", obs_data_create());
+    return filter;
+}
+
+obs_data_t* makeSource(const char* name, const char* id, const char* uuid, obs_data_t* settings, int filters) {
+    obs_data_t* source = obs_data_create();
+    obs_data_set_string(source, "name", name);
+    obs_data_set_string(source, "uuid", uuid);
+    obs_data_set_string(source, "id", id);
+    obs_data_set_string(source, "versioned_id", id);
+    setObj(source, "settings", settings);
+    obs_data_set_int(source, "mixers", 255);
+    obs_data_set_int(source, "sync", 0);
+    obs_data_set_int(source, "flags", 0);
+    obs_data_set_double(source, "volume", 1.0);
+    obs_data_set_double(source, "balance", 0.5);
+    obs_data_set_bool(source, "enabled", true);
+    obs_data_set_bool(source, "muted", false);
+    obs_data_set_int(source, "monitoring_type", 0);
+    obs_data_set_int(source, "deinterlace_mode", 0);
+    obs_data_set_int(source, "deinterlace_field_order", 0);
+    setObj(source, "private_settings", obs_data_create());
+
+    obs_data_t* hotkeys = obs_data_create();
+    setArray(hotkeys, "libobs.mute", obs_data_array_create());
+    setArray(hotkeys, "libobs.unmute", obs_data_array_create());
+    setArray(hotkeys, "libobs.push-to-mute", obs_data_array_create());
+    setObj(source, "hotkeys", hotkeys);
+
+    if (filters > 0) {
+        obs_data_array_t* list = obs_data_array_create();
+        for (int i = 0; i < filters; i++) {
+            pushBack(list, makeFilter(i));
+        }
+        setArray(source, "filters", list);
+    }
+    return source;
+}
+
+obs_data_t* makeSceneItem(const std::string& name, const std::string& uuid, int id) {
+    obs_data_t* item = obs_data_create();
+    obs_data_set_string(item, "name", name.c_str());
+    obs_data_set_string(item, "source_uuid", uuid.c_str());
+    obs_data_set_bool(item, "visible", id % 5 != 0);
+    obs_data_set_bool(item, "locked", false);
+    obs_data_set_double(item, "rot", 0.0);
+    setObj(item, "pos", makeVec2(40.0 * (id % 16), 30.0 * (id % 12)));
+    setObj(item, "scale", makeVec2(0.5, 0.5));
+    obs_data_set_int(item, "alignment", 5);
+    obs_data_set_int(item, "bounds_type", 0);
+    obs_data_set_int(item, "bounds_align", 0);
+    setObj(item, "bounds", makeVec2(0.0, 0.0));
+    obs_data_set_int(item, "crop_left", 0);
+    obs_data_set_int(item, "crop_top", 0);
+    obs_data_set_int(item, "crop_right", 0);
+    obs_data_set_int(item, "crop_bottom", 0);
+    obs_data_set_int(item, "id", id);
+    obs_data_set_bool(item, "group_item_backup", false);
+    obs_data_set_int(item, "blend_method", 0);
+    obs_data_set_int(item, "blend_type", 0);
+    setObj(item, "private_settings", obs_data_create());
+    return item;
+}
+
+obs_data_t* makeCollection(int inputs, int scenes) {
+    static const char* const kInputIds[] = {"browser_source", "text_ft2_source_v2", "image_source", "ffmpeg_source"};
+
+    obs_data_array_t* sources = obs_data_array_create();
+    std::vector<std::string> names;
+    std::vector<std::string> uuids;
+    char name[64];
+    char uuid[40];
+    for (int i = 0; i < inputs; i++) {
+        const int kind = i % 4;
+        std::snprintf(name, sizeof(name), "%s %d", kInputIds[kind], i);
+        std::snprintf(uuid, sizeof(uuid), "0f8e%04x-1c2d-4e5f-8a9b-%012x", i, i * 7919);
+        names.push_back(name);
+        uuids.push_back(uuid);
+        pushBack(sources, makeSource(name, kInputIds[kind], uuid, makeSettings(kind, i), i % 3));
+    }
+
+    obs_data_array_t* order = obs_data_array_create();
+    const int itemsPerScene = std::max(1, std::min(inputs, 12));
+    for (int s = 0; s < scenes; s++) {
+        obs_data_t* settings = obs_data_create();
+        obs_data_array_t* items = obs_data_array_create();
+        for (int i = 0; i < itemsPerScene && inputs > 0; i++) {
+            const int input = (s * 7 + i) % inputs;
+            pushBack(items, makeSceneItem(names[input], uuids[input], i + 1));
+        }
+        setArray(settings, "items", items);
+        obs_data_set_int(settings, "id_counter", itemsPerScene);
+        obs_data_set_bool(settings, "custom_size", false);
+
+        std::snprintf(name, sizeof(name), "Scene %d", s);
+        std::snprintf(uuid, sizeof(uuid), "5ce0%04x-1c2d-4e5f-8a9b-%012x", s, s * 104729);
+        pushBack(sources, makeSource(name, "scene", uuid, settings, 0));
+
+        obs_data_t* entry = obs_data_create();
+        obs_data_set_string(entry, "name", name);
+        pushBack(order, entry);
+    }
+
+    obs_data_t* root = obs_data_create();
+    obs_data_set_string(root, "name", "Bench");
+    obs_data_set_string(root, "current_scene", "Scene 0");
+    obs_data_set_string(root, "current_program_scene", "Scene 0");
+    obs_data_set_string(root, "current_transition", "Fade");
+    obs_data_set_int(root, "transition_duration", 300);
+    setArray(root, "sources", sources);
+    setArray(root, "scene_order", order);
+    setArray(root, "transitions", obs_data_array_create());
+    setArray(root, "groups", obs_data_array_create());
+    return root;
+}
+
+bool writeFile(const std::string& path, const void* data, size_t size) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const bool ok = std::fwrite(data, 1, size, file) == size;
+    return std::fclose(file) == 0 && ok;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    bytes.clear();
+    uint8_t buffer[64 * 1024];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    std::fclose(file);
+    return true;
+}
+
+struct Timing {
+    uint64_t bytes = 0;
+    std::vector<uint64_t> micros;
+    size_t sources = 0;             // Entries in the decoded "sources", as a sanity check
+
+    double median() const {
+        std::vector<uint64_t> sorted = micros;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted.empty() ? 0.0 : sorted[sorted.size() / 2] / 1000.0;
+    }
+    double best() const {
+        return micros.empty() ? 0.0 : *std::min_element(micros.begin(), micros.end()) / 1000.0;
+    }
+};
+
+Timing timeLoad(const std::string& path, bool binary, uint64_t iterations) {
+    Timing timing;
+    std::vector<uint8_t> bytes;
+    for (uint64_t i = 0; i < iterations; i++) {
+        bench::Stopwatch watch;
+        if (!readFile(path, bytes)) {
+            break;
+        }
+        obs_data_t* data;
+        if (binary) {
+            data = SceneCollectionStore::decodeBinary(bytes.data(), bytes.size());
+        } else {
+            bytes.push_back('\0');
+            data = obs_data_create_from_json(reinterpret_cast<const char*>(bytes.data()));
+        }
+        timing.micros.push_back(watch.micros());
+
+        obs_data_array_t* sources = data ? obs_data_get_array(data, "sources") : nullptr;
+        timing.sources = sources ? obs_data_array_count(sources) : 0;
+        obs_data_array_release(sources);
+        obs_data_release(data);
+        timing.bytes = bytes.size();
+    }
+    return timing;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int inputs = static_cast<int>(bench::option(argc, argv, "--inputs", uint64_t{500}));
+    const int scenes = static_cast<int>(bench::option(argc, argv, "--scenes", uint64_t{60}));
+    const uint64_t iterations = std::max<uint64_t>(bench::option(argc, argv, "--iterations", uint64_t{20}), 1);
+    const std::string dir = bench::option(argc, argv, "--dir", platform::getTempDir().c_str());
+    const std::string jsonPath = platform::joinPath(dir, "streamlumo-bench.json");
+    const std::string binaryPath = platform::joinPath(dir, "streamlumo-bench.slsc");
+
+    Logging::init(LogLevel::Warning);
+
+    // Written the way the saver writes them
+    obs_data_t* root = makeCollection(inputs, scenes);
+    const char* json = obs_data_get_json(root);
+    std::vector<uint8_t> encoded;
+    SceneCollectionStore::encodeBinary(root, encoded);
+    const bool written = json && writeFile(jsonPath, json, std::strlen(json)) &&
+                         writeFile(binaryPath, encoded.data(), encoded.size());
+    obs_data_release(root);
+    if (!written) {
+        std::fprintf(stderr, "cannot write the collection to %s\n", dir.c_str());
+        Logging::shutdown();
+        return 1;
+    }
+
+    const Timing jsonTiming = timeLoad(jsonPath, false, iterations);
+    const Timing binaryTiming = timeLoad(binaryPath, true, iterations);
+
+    std::printf("%d inputs, %d scenes, %llu loads each\n\n", inputs, scenes,
+                static_cast<unsigned long long>(iterations));
+    std::printf("%-7s %10s %12s %10s %9s\n", "format", "size KB", "median ms", "best ms", "sources");
+    auto print = [](const char* label, const Timing& timing) {
+        std::printf("%-7s %10llu %12.2f %10.2f %9zu\n", label, static_cast<unsigned long long>(timing.bytes / 1024),
+                    timing.median(), timing.best(), timing.sources);
+    };
+    print("json", jsonTiming);
+    print("binary", binaryTiming);
+    if (binaryTiming.median() > 0.0) {
+        std::printf("\nbinary loads %.1fx faster (median)\n", jsonTiming.median() / binaryTiming.median());
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(jsonPath, ec);
+    std::filesystem::remove(binaryPath, ec);
+    Logging::shutdown();
+    return 0;
+}
@@ -0,0 +1,126 @@
+// streamlumo-engine/bench/scene_index_scale.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+//
+// SceneIndex at scale: listing and finding scenes through the index against
+// the libobs walks it replaces.
+//
+//   bench-scene-index [--scenes <N>] [--iterations <N>]
+//
+// Starts libobs without video, creates N scenes and times, per call:
+// SceneIndex::scenes() vs obs_enum_scenes() (what obs_frontend_get_scenes
+// did before), and SceneIndex::findScene() vs obs_get_source_by_name().
+// Creating and removing the scenes is timed too, since every one of those
+// goes through the index's signal handlers.
+
+#include "bench.h"
+#include "logging.h"
+#include "scene_index.h"
+
+#include <obs.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace streamlumo;
+
+namespace {
+
+double microsPerCall(uint64_t micros, uint64_t calls) {
+    return calls ? static_cast<double>(micros) / calls : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const uint64_t sceneCount = bench::option(argc, argv, "--scenes", uint64_t{1000});
+    const uint64_t iterations = bench::option(argc, argv, "--iterations", uint64_t{200});
+
+    Logging::init(LogLevel::Warning);
+    if (!obs_startup("en-US", nullptr, nullptr)) {
+        std::fprintf(stderr, "obs_startup failed\n");
+        Logging::shutdown();
+        return 1;
+    }
+
+    uint64_t changes = 0;
+    SceneIndex index;
+    index.start([&changes](SceneIndex::List) { changes++; });
+
+    std::vector<obs_scene_t*> scenes;
+    std::vector<std::string> names;
+    scenes.reserve(sceneCount);
+    bench::Stopwatch createWatch;
+    for (uint64_t i = 0; i < sceneCount; i++) {
+        names.push_back("Scene " + std::to_string(i));
+        scenes.push_back(obs_scene_create(names.back().c_str()));
+    }
+    const uint64_t createMicros = createWatch.micros();
+
+    // Listing: every call hands out a new reference per scene
+    bench::Stopwatch indexListWatch;
+    size_t listed = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        std::vector<obs_source_t*> list = index.scenes();
+        listed = list.size();
+        for (obs_source_t* source : list) {
+            obs_source_release(source);
+        }
+    }
+    const uint64_t indexListMicros = indexListWatch.micros();
+
+    bench::Stopwatch enumListWatch;
+    size_t enumerated = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        std::vector<obs_source_t*> list;
+        auto collect = [](void* param, obs_source_t* source) {
+            static_cast<std::vector<obs_source_t*>*>(param)->push_back(obs_source_get_ref(source));
+            return true;
+        };
+        obs_enum_scenes(collect, &list);
+        enumerated = list.size();
+        for (obs_source_t* source : list) {
+            obs_source_release(source);
+        }
+    }
+    const uint64_t enumListMicros = enumListWatch.micros();
+
+    // Lookups spread over the whole list
+    const uint64_t lookups = iterations * 10;
+    bench::Stopwatch indexFindWatch;
+    for (uint64_t i = 0; i < lookups; i++) {
+        obs_source_release(index.findScene(names[(i * 7919) % names.size()]));
+    }
+    const uint64_t indexFindMicros = indexFindWatch.micros();
+
+    bench::Stopwatch obsFindWatch;
+    for (uint64_t i = 0; i < lookups; i++) {
+        obs_source_release(obs_get_source_by_name(names[(i * 7919) % names.size()].c_str()));
+    }
+    const uint64_t obsFindMicros = obsFindWatch.micros();
+
+    bench::Stopwatch removeWatch;
+    for (obs_scene_t* scene : scenes) {
+        obs_source_remove(obs_scene_get_source(scene));
+        obs_scene_release(scene);
+    }
+    const uint64_t removeMicros = removeWatch.micros();
+
+    std::printf("%llu scenes, %llu list calls, %llu lookups\n\n", static_cast<unsigned long long>(sceneCount),
+                static_cast<unsigned long long>(iterations), static_cast<unsigned long long>(lookups));
+    std::printf("%-34s %12s\n", "operation", "us/call");
+    std::printf("%-34s %12.2f\n", "create scene (indexed)", microsPerCall(createMicros, sceneCount));
+    std::printf("%-34s %12.2f\n", "SceneIndex::scenes()", microsPerCall(indexListMicros, iterations));
+    std::printf("%-34s %12.2f\n", "obs_enum_scenes()", microsPerCall(enumListMicros, iterations));
+    std::printf("%-34s %12.3f\n", "SceneIndex::findScene()", microsPerCall(indexFindMicros, lookups));
+    std::printf("%-34s %12.3f\n", "obs_get_source_by_name()", microsPerCall(obsFindMicros, lookups));
+    std::printf("%-34s %12.2f\n", "remove scene (indexed)", microsPerCall(removeMicros, sceneCount));
+    std::printf("\nlisted %zu via the index, %zu via libobs; %llu change notifications\n", listed, enumerated,
+                static_cast<unsigned long long>(changes));
+
+    index.stop();
+    obs_shutdown();
+    Logging::shutdown();
+    return 0;
+}
@@ -24,9 +24,13 @@ class BrowserClient : public CefClient,
                       public CefRenderHandler,
                       public CefLoadHandler {
 public:
+    // startPaused: the engine is idle and wants no frames from this browser
+    // until it clears the SHM pause flag
     explicit BrowserClient(const std::string& browserId,
                            int width,
                            int height,
+                           const std::string& css,
+                           bool startPaused,
                            FrameCallback onFrame);
 
     // CefClient
@@ -55,6 +59,8 @@ public:
 
     // Accessors
     void SetSize(int w, int h);
+    // Replace the custom CSS; applied to the current page and every load
+    void SetCss(const std::string& css);
     CefRefPtr<CefBrowser> GetBrowser() const;
     const std::string& GetBrowserId() const { return browserId_; }
 
@@ -62,6 +68,7 @@ private:
     std::string browserId_;
     int width_;
     int height_;
+    std::string css_;
     FrameCallback onFrame_;
     CefRefPtr<CefBrowser> browser_;
     mutable std::mutex mutex_;
@@ -69,6 +76,10 @@ private:
     // Shared memory writer for zero-copy frame transport
     std::unique_ptr<browser_bridge::BrowserShmWriter> shmWriter_;
     bool useShmTransport_ = true;
+    
+    // Paused on request of the SHM consumer (engine idle mode)
+    bool producerPaused_ = false;
+    int activeFrameRate_ = 0;
 
     IMPLEMENT_REFCOUNTING(BrowserClient);
     DISALLOW_COPY_AND_ASSIGN(BrowserClient);
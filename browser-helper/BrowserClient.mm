@@ -2,11 +2,39 @@
 #include "BrowserClient.h"
 #import <Foundation/Foundation.h>
 
+// Script that puts the source's custom CSS into one <style> element,
+// replacing what an earlier call added
+static std::string customCssScript(const std::string& css) {
+    std::string literal = "\"";
+    for (char c : css) {
+        switch (c) {
+            case '"': literal += "\\\""; break;
+            case '\\': literal += "\\\\"; break;
+            case '\n': literal += "\\n"; break;
+            case '\r': literal += "\\r"; break;
+            case '<': literal += "\\x3c"; break;
+            default: literal += c; break;
+        }
+    }
+    literal += "\"";
+    return "(function() {"
+           "var style = document.getElementById('streamlumo-custom-css');"
+           "if (!style) {"
+           "style = document.createElement('style');"
+           "style.id = 'streamlumo-custom-css';"
+           "(document.head || document.documentElement).appendChild(style);"
+           "}"
+           "style.textContent = " + literal + ";"
+           "})();";
+}
+
 BrowserClient::BrowserClient(const std::string& browserId,
                              int width,
                              int height,
+                             const std::string& css,
+                             bool startPaused,
                              FrameCallback onFrame)
-    : browserId_(browserId), width_(width), height_(height), onFrame_(onFrame) {
+    : browserId_(browserId), width_(width), height_(height), css_(css), onFrame_(onFrame) {
     
     NSLog(@"[browser-helper] ===== BrowserClient constructor START for id=%s (%dx%d) =====", 
           browserId.c_str(), width, height);
@@ -15,7 +43,7 @@ BrowserClient::BrowserClient(const std::string& browserId,
     shmWriter_ = std::make_unique<browser_bridge::BrowserShmWriter>(browserId);
     NSLog(@"[browser-helper] Created BrowserShmWriter instance for %s", browserId.c_str());
     
-    if (shmWriter_->create(width, height)) {
+    if (shmWriter_->create(width, height, startPaused)) {
         useShmTransport_ = true;
         NSLog(@"[browser-helper] ✓ SHM transport ENABLED for %s (%dx%d)", 
               browserId.c_str(), width, height);
@@ -66,7 +94,7 @@ bool BrowserClient::GetScreenInfo(CefRefPtr<CefBrowser> /*browser*/, CefScreenIn
     return true;
 }
 
-void BrowserClient::OnPaint(CefRefPtr<CefBrowser> /*browser*/,
+void BrowserClient::OnPaint(CefRefPtr<CefBrowser> browser,
                             PaintElementType type,
                             const RectList& /*dirtyRects*/,
                             const void* buffer,
@@ -84,6 +112,28 @@ void BrowserClient::OnPaint(CefRefPtr<CefBrowser> /*browser*/,
               useShmTransport_ ? "yes" : "no");
     }
     
+    // The engine asked us to stop producing (idle mode): drop to 1 fps so we
+    // still see the resume request on a later paint, and skip the copy
+    if (useShmTransport_ && shmWriter_ && shmWriter_->isCreated()) {
+        bool pauseRequested = shmWriter_->isPauseRequested();
+        if (pauseRequested != producerPaused_) {
+            producerPaused_ = pauseRequested;
+            CefRefPtr<CefBrowserHost> host = browser->GetHost();
+            if (pauseRequested) {
+                activeFrameRate_ = host->GetWindowlessFrameRate();
+                host->SetWindowlessFrameRate(1);
+            } else if (activeFrameRate_ > 0) {
+                host->SetWindowlessFrameRate(activeFrameRate_);
+            }
+            shmWriter_->setProducerPaused(pauseRequested);
+            NSLog(@"[browser-helper] Producer %s for id=%s", pauseRequested ? "paused" : "resumed",
+                  browserId_.c_str());
+        }
+        if (producerPaused_) {
+            return;
+        }
+    }
+    
     // Prefer SHM transport (zero-copy) if available
     if (useShmTransport_ && shmWriter_ && shmWriter_->isCreated()) {
         // Write frame directly to shared memory - zero copy to OBS plugin
@@ -110,7 +160,7 @@ void BrowserClient::SetSize(int w, int h) {
     // Recreate SHM if size changed
     if (shmWriter_) {
         shmWriter_->destroy();
-        if (shmWriter_->create(w, h)) {
+        if (shmWriter_->create(w, h, producerPaused_)) {
             useShmTransport_ = true;
             NSLog(@"[browser-helper] SHM recreated for resize %dx%d", w, h);
         } else {
@@ -123,6 +173,19 @@ void BrowserClient::SetSize(int w, int h) {
     }
 }
 
+void BrowserClient::SetCss(const std::string& css) {
+    CefRefPtr<CefBrowser> browser;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        css_ = css;
+        browser = browser_;
+    }
+    if (browser && browser->GetMainFrame()) {
+        CefRefPtr<CefFrame> frame = browser->GetMainFrame();
+        frame->ExecuteJavaScript(customCssScript(css), frame->GetURL(), 0);
+    }
+}
+
 CefRefPtr<CefBrowser> BrowserClient::GetBrowser() const {
     std::lock_guard<std::mutex> lock(mutex_);
     return browser_;
@@ -139,6 +202,15 @@ void BrowserClient::OnLoadEnd(CefRefPtr<CefBrowser> browser,
     NSLog(@"[browser-helper] OnLoadEnd id=%s status=%d url=%s", 
           browserId_.c_str(), httpStatusCode, url.c_str());
     
+    std::string css;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        css = css_;
+    }
+    if (!css.empty()) {
+        frame->ExecuteJavaScript(customCssScript(css), url, 0);
+    }
+    
     // Inject JavaScript to auto-play videos on YouTube
     if (url.find("youtube.com") != std::string::npos || 
         url.find("youtu.be") != std::string::npos) {
@@ -15,16 +15,21 @@ public:
     // Shut down CEF (call on exit).
     void ShutdownCef();
 
-    // Create a browser with the given id/url/size/fps.
+    // Create a browser with the given id/url/size/fps and custom CSS;
+    // paused browsers produce no frames until the engine resumes them.
     bool CreateBrowser(const std::string& id,
                        const std::string& url,
                        int width,
                        int height,
-                       int fps);
+                       int fps,
+                       const std::string& css,
+                       bool paused);
     // Navigate an existing browser to a new URL.
     bool NavigateBrowser(const std::string& id, const std::string& url);
     // Resize an existing browser.
     bool ResizeBrowser(const std::string& id, int width, int height);
+    // Replace the custom CSS of an existing browser.
+    bool SetBrowserCss(const std::string& id, const std::string& css);
     // Close and remove a browser.
     bool CloseBrowser(const std::string& id);
 
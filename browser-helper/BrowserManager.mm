@@ -124,7 +124,9 @@ bool BrowserManager::CreateBrowser(const std::string& id,
                                     const std::string& url,
                                     int width,
                                     int height,
-                                    int fps) {
+                                    int fps,
+                                    const std::string& css,
+                                    bool paused) {
     // CEF requires browser creation on the UI thread.
     // Use dispatch_sync to the main queue (which is our CEF UI thread).
     __block bool result = false;
@@ -137,7 +139,7 @@ bool BrowserManager::CreateBrowser(const std::string& id,
             return;
         }
         int targetFps = fps > 0 ? fps : 60;
-        CefRefPtr<BrowserClient> client(new BrowserClient(id, width, height, frameCallback_));
+        CefRefPtr<BrowserClient> client(new BrowserClient(id, width, height, css, paused, frameCallback_));
         CefWindowInfo windowInfo;
         windowInfo.bounds.width = width;
         windowInfo.bounds.height = height;
@@ -227,6 +229,17 @@ bool BrowserManager::ResizeBrowser(const std::string& id, int width, int height)
     return true;
 }
 
+bool BrowserManager::SetBrowserCss(const std::string& id, const std::string& css) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = browsers_.find(id);
+    if (it == browsers_.end()) {
+        return false;
+    }
+    it->second->SetCss(css);
+    NSLog(@"[browser-helper] SetBrowserCss id=%s (%zu bytes)", id.c_str(), css.size());
+    return true;
+}
+
 bool BrowserManager::CloseBrowser(const std::string& id) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = browsers_.find(id);
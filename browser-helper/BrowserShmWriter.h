@@ -45,8 +45,9 @@ public:
     explicit BrowserShmWriter(const std::string& browserId);
     ~BrowserShmWriter();
     
-    // Create shared memory region
-    bool create(int width, int height);
+    // Create shared memory region; pauseRequested seeds the consumer's
+    // pause flag for a browser recreated while the engine is idle
+    bool create(int width, int height, bool pauseRequested = false);
     
     // Write frame to shared memory (called from OnPaint)
     bool writeFrame(const void* buffer, int width, int height);
@@ -60,6 +61,16 @@ public:
     // Check if connected
     bool isCreated() const { return m_shmPtr != nullptr; }
     
+    // Consumer-side pause request (engine idle mode) and our acknowledgement
+    bool isPauseRequested() const {
+        return m_shmPtr && m_shmPtr->pause_requested.load(std::memory_order_acquire) != 0;
+    }
+    void setProducerPaused(bool paused) {
+        if (m_shmPtr) {
+            m_shmPtr->producer_paused.store(paused ? 1 : 0, std::memory_order_release);
+        }
+    }
+    
 private:
     std::string m_browserId;
     std::string m_shmName;
@@ -25,7 +25,7 @@ BrowserShmWriter::~BrowserShmWriter() {
     destroy();
 }
 
-bool BrowserShmWriter::create(int width, int height) {
+bool BrowserShmWriter::create(int width, int height, bool pauseRequested) {
     if (m_shmPtr) {
         // Already created
         return true;
@@ -82,7 +82,7 @@ bool BrowserShmWriter::create(int width, int height) {
     m_shmPtr->frame_counter.store(0, std::memory_order_release);
     m_shmPtr->dropped_frames.store(0, std::memory_order_release);
     m_shmPtr->last_write_timestamp_ns = 0;
-    m_shmPtr->pause_requested.store(0, std::memory_order_release);
+    m_shmPtr->pause_requested.store(pauseRequested ? 1 : 0, std::memory_order_release);
     m_shmPtr->producer_paused.store(0, std::memory_order_release);
     
     NSLog(@"[BrowserShmWriter] Created SHM %s (%dx%d, %zu bytes)",
@@ -196,7 +196,11 @@
             [self closeClientSource:source];
             return;
         }
-        [self sendJSON:@{ @"type": @"pong", @"from": @"browser-helper", @"v": @1 } toSocket:socketFD];
+        // Echo seq/ts so the engine's health monitor can match pongs to pings
+        NSMutableDictionary *pong = [@{ @"type": @"pong", @"from": @"browser-helper", @"v": @1 } mutableCopy];
+        if (dict[@"seq"]) pong[@"seq"] = dict[@"seq"];
+        if (dict[@"ts"]) pong[@"ts"] = dict[@"ts"];
+        [self sendJSON:pong toSocket:socketFD];
     } else if ([type isEqualToString:@"handshake"]) {
         NSString *tok = dict[@"token"] ?: @"";
         if (self.token.length > 0 && ![tok isEqualToString:self.token]) {
@@ -220,18 +224,22 @@
         NSNumber *width = dict[@"width"] ?: @(1280);
         NSNumber *height = dict[@"height"] ?: @(720);
         NSNumber *fps = dict[@"fps"] ?: @(30);
-        NSDictionary *state = @{ @"id": browserId, @"url": dict[@"url"] ?: @"", @"width": width, @"height": height, @"fps": fps };
+        NSString *css = dict[@"css"] ?: @"";
+        BOOL paused = [dict[@"paused"] boolValue];
+        NSDictionary *state = @{ @"id": browserId, @"url": dict[@"url"] ?: @"", @"width": width, @"height": height, @"fps": fps, @"css": css };
         @synchronized (self.browserStates) {
             self.browserStates[browserId] = state;
         }
-        NSLog(@"[browser-helper] initBrowser id=%@ url=%@ %dx%d @%dfps", browserId, dict[@"url"], width.intValue, height.intValue, fps.intValue);
+        NSLog(@"[browser-helper] initBrowser id=%@ url=%@ %dx%d @%dfps%s", browserId, dict[@"url"], width.intValue, height.intValue, fps.intValue, paused ? " (paused)" : "");
         // CEF: Create off-screen browser
         BrowserManager::Instance().CreateBrowser(
             std::string([browserId UTF8String]),
             std::string([dict[@"url"] UTF8String] ?: ""),
             width.intValue,
             height.intValue,
-            fps.intValue);
+            fps.intValue,
+            std::string([css UTF8String] ?: ""),
+            paused);
         [self sendJSON:@{ @"type": @"browserReady", @"id": browserId, @"status": @"ok", @"v": @1 } toSocket:socketFD];
     } else if ([type isEqualToString:@"updateBrowser"]) {
         NSString *browserId = dict[@"id"];
@@ -249,6 +257,7 @@
             if (dict[@"url"]) next[@"url"] = dict[@"url"];
             if (dict[@"width"]) next[@"width"] = dict[@"width"];
             if (dict[@"height"]) next[@"height"] = dict[@"height"];
+            if (dict[@"css"]) next[@"css"] = dict[@"css"];
             self.browserStates[browserId] = next;
         }
         NSLog(@"[browser-helper] updateBrowser id=%@ url=%@ width=%@ height=%@", browserId, dict[@"url"], dict[@"width"], dict[@"height"]);
@@ -265,6 +274,12 @@
         if (w && h) {
             BrowserManager::Instance().ResizeBrowser(std::string([browserId UTF8String]), w.intValue, h.intValue);
         }
+        
+        // CEF: Replace the custom CSS if provided (empty removes it)
+        NSString *css = dict[@"css"];
+        if (css) {
+            BrowserManager::Instance().SetBrowserCss(std::string([browserId UTF8String]), std::string([css UTF8String] ?: ""));
+        }
         [self sendJSON:@{ @"type": @"browserUpdated", @"id": browserId, @"status": @"ok", @"v": @1 } toSocket:socketFD];
     } else if ([type isEqualToString:@"disposeBrowser"]) {
         NSString *browserId = dict[@"id"];
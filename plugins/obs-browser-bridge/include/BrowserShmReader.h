@@ -6,7 +6,11 @@
 
 #include <string>
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 namespace browser_bridge {
 
@@ -28,14 +32,18 @@ struct BrowserFrameBufferReader {
     std::atomic<uint64_t> frame_counter; // Total frames written
     std::atomic<uint64_t> dropped_frames; // Frames dropped by writer
     uint64_t last_write_timestamp_ns;    // Timestamp of last write (nanoseconds)
-    std::atomic<uint32_t> pause_requested; // Reader requests pause
-    std::atomic<uint32_t> producer_paused; // Producer acknowledges pause
-    uint8_t reserved[24];                // Reserved for future use (alignment)
+    std::atomic<uint8_t> pause_requested; // Reader requests pause
+    std::atomic<uint8_t> producer_paused; // Producer acknowledges pause
+    uint8_t reserved[6];                 // Pads the header to 64 bytes
     
     // Triple-buffered frame data
     unsigned char frames[SHM_NUM_BUFFERS_READER][SHM_FRAME_SIZE_READER];
 };
 
+// The writer's header is 64 bytes (aligned(64) in BrowserShmWriter.h)
+static_assert(offsetof(BrowserFrameBufferReader, frames) == 64,
+              "BrowserFrameBufferReader must match the helper's BrowserFrameBuffer layout");
+
 /**
  * @brief Reads video frames from shared memory written by browser-helper.
  * 
@@ -89,6 +97,21 @@ public:
         return m_shmPtr ? m_shmPtr->dropped_frames.load(std::memory_order_relaxed) : 0; 
     }
     
+    /**
+     * @brief Ask the producer to stop (or resume) rendering frames.
+     * 
+     * The helper drops to a 1 fps paint rate and stops writing while paused;
+     * isProducerPaused() reports its acknowledgement.
+     */
+    void setPauseRequested(bool paused) {
+        if (m_shmPtr) {
+            m_shmPtr->pause_requested.store(paused ? 1 : 0, std::memory_order_release);
+        }
+    }
+    bool isProducerPaused() const {
+        return m_shmPtr && m_shmPtr->producer_paused.load(std::memory_order_acquire) != 0;
+    }
+    
     /**
      * @brief Check if connected to shared memory.
      */
@@ -108,4 +131,44 @@ private:
     uint64_t m_lastFrameCounter = 0;
 };
 
+/**
+ * @brief One SHM reader for every source subscribed to a shared browser.
+ * 
+ * The triple buffer's read_index handoff assumes a single consumer: two
+ * readers on one segment overwrite each other's read_index and the writer
+ * may reuse a buffer one of them is still copying. Subscribers therefore
+ * share this object (BrowserBridgeManager::acquireSharedReader()). The first
+ * one to poll after the helper wrote a frame copies it out of SHM once; the
+ * others get that copy.
+ */
+class SharedShmReader {
+public:
+    explicit SharedShmReader(const std::string& browserId);
+    
+    SharedShmReader(const SharedShmReader&) = delete;
+    SharedShmReader& operator=(const SharedShmReader&) = delete;
+    
+    /**
+     * @brief Hand the latest frame to a subscriber that has not seen it.
+     * @param sequence The subscriber's last seen frame; updated on delivery
+     * @param consume Called with the pixels under the reader's lock
+     * @return false if the SHM segment is not available (use IPC frames)
+     */
+    bool readLatest(uint64_t& sequence,
+                    const std::function<void(const uint8_t* pixels, int width, int height)>& consume);
+    
+    /**
+     * @brief Remap the segment on the next read (the helper recreated it).
+     */
+    void reset();
+    
+private:
+    std::mutex m_mutex;
+    BrowserShmReader m_reader;
+    std::vector<uint8_t> m_frame;
+    int m_width = 0;
+    int m_height = 0;
+    uint64_t m_sequence = 0;  // Frames copied out of SHM, 0 = none yet
+};
+
 } // namespace browser_bridge
@@ -65,7 +65,8 @@ bool BrowserShmReader::hasNewFrame() const {
     }
     
     uint64_t currentFrameCounter = m_shmPtr->frame_counter.load(std::memory_order_acquire);
-    return currentFrameCounter > m_lastFrameCounter;
+    // != rather than >: a restarted helper starts counting from zero again
+    return currentFrameCounter != m_lastFrameCounter;
 }
 
 bool BrowserShmReader::readFrame(void* buffer, size_t maxSize, int& outWidth, int& outHeight) {
@@ -125,4 +126,41 @@ void BrowserShmReader::disconnect() {
     blog(LOG_INFO, "[BrowserShmReader] Disconnected from SHM %s", m_shmName.c_str());
 }
 
+SharedShmReader::SharedShmReader(const std::string& browserId)
+    : m_reader(browserId)
+{
+}
+
+bool SharedShmReader::readLatest(uint64_t& sequence,
+                                 const std::function<void(const uint8_t*, int, int)>& consume) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (!m_reader.isConnected() && !m_reader.connect()) {
+        return false;
+    }
+    
+    if (m_reader.hasNewFrame()) {
+        if (m_frame.empty()) {
+            m_frame.resize(SHM_FRAME_SIZE_READER);
+        }
+        int width = 0, height = 0;
+        if (m_reader.readFrame(m_frame.data(), m_frame.size(), width, height)) {
+            m_width = width;
+            m_height = height;
+            ++m_sequence;
+        }
+    }
+    
+    if (m_sequence != 0 && m_sequence != sequence) {
+        consume(m_frame.data(), m_width, m_height);
+        sequence = m_sequence;
+    }
+    return true;
+}
+
+void SharedShmReader::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reader.disconnect();
+}
+
 } // namespace browser_bridge
@@ -55,9 +55,15 @@
 #include "browser-bridge-source.hpp"
 #include "ipc-client.hpp"
 #include "frame-decoder.hpp"
+#include "BrowserShmReader.h"
 #include <obs.h>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
 
 #ifdef __APPLE__
 #include <signal.h>
@@ -79,6 +85,59 @@ namespace fs = std::filesystem;
 
 namespace browser_bridge {
 
+// Random ID for idle warm-pool browsers (SHM names are machine-global)
+static std::string generateWarmBrowserId()
+{
+    std::random_device rd;
+    std::mt19937_64 gen(rd());
+    char buf[40];
+    snprintf(buf, sizeof(buf), "browser_warm_%016" PRIx64, static_cast<uint64_t>(gen()));
+    return buf;
+}
+
+// Escapes a string for a JSON string literal (custom CSS is free-form text)
+static std::string jsonEscape(const std::string &text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+            break;
+        }
+    }
+    return out;
+}
+
+#ifndef _WIN32
+// The host may block SIGTERM in every thread (the engine reads it from a
+// signalfd); reset the mask so stopHelper()'s SIGTERM reaches the helper
+static int spawnHelperProcess(pid_t *pid, const char *path, char *const argv[])
+{
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    int status = posix_spawn(pid, path, nullptr, &attr, argv, environ);
+    posix_spawnattr_destroy(&attr);
+    return status;
+}
+#endif
+
 BrowserBridgeManager &BrowserBridgeManager::instance()
 {
     static BrowserBridgeManager inst;
@@ -88,21 +147,64 @@ BrowserBridgeManager &BrowserBridgeManager::instance()
 BrowserBridgeManager::BrowserBridgeManager()
 {
     m_port = 4777;
+    m_routes.store(new RouteMap());
 }
 
 BrowserBridgeManager::~BrowserBridgeManager()
 {
     shutdown();
+    delete m_routes.exchange(nullptr);
+    for (const auto &retired : m_retiredRoutes) {
+        delete retired.second;
+    }
+}
+
+/**
+ * Starts connecting to the browser helper on a background thread.
+ * 
+ * Called from obs_module_load() so the helper is usually ready by the time
+ * the first browser source ticks. Safe to call repeatedly; only the first
+ * call starts the init thread. Never blocks.
+ */
+void BrowserBridgeManager::startAsyncInit()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_initialized.exchange(true)) {
+        return;
+    }
+
+    m_initPending.store(true);
+    m_initThread = std::thread(&BrowserBridgeManager::initializeHelper, this);
+}
+
+/**
+ * Ensures initialization has been started and reports whether the helper is
+ * connected.
+ * 
+ * Does NOT wait for the helper: browser requests made before it is ready are
+ * queued by initBrowser() and sent once the connection is up.
+ * 
+ * @return true if connected and ready, false if still starting or failed
+ */
+bool BrowserBridgeManager::ensureInitialized()
+{
+    startAsyncInit();
+    return m_running.load();
 }
 
 /**
- * Ensures the manager is initialized and connected to the browser helper.
+ * Connects to (or launches) the browser helpers. Runs on m_initThread.
  * 
- * This method is called lazily on first browser creation. It:
  * 1. Reads the auth token from BROWSER_HELPER_TOKEN environment variable
- * 2. Tries to connect to an existing helper (engine may have started one)
- * 3. If no helper exists, resolves the helper path and launches a new one
- * 4. Sends authentication handshake after connecting
+ * 2. For each shard, tries to connect to an existing helper (engine may have
+ *    started one) and otherwise resolves the helper path and launches one
+ * 3. Sends authentication handshake after connecting
+ * 4. Places every initBrowser queued while we were starting
+ * 
+ * The slow steps (connect timeouts, posix_spawn, the post-launch sleep) run
+ * without m_mutex held so sources on the video thread never wait on them.
+ * Each phase is recorded and logged as a startup timeline.
  * 
  * ## Connection Order
  * 
@@ -110,18 +212,29 @@ BrowserBridgeManager::~BrowserBridgeManager()
  * - The engine may have launched the helper during startup
  * - Avoids duplicate helper processes
  * - Prevents "port already in use" errors
- * 
- * @return true if connected and ready, false on failure
  */
-bool BrowserBridgeManager::ensureInitialized()
+void BrowserBridgeManager::initializeHelper()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (m_initialized.load()) {
-        return m_running.load();
-    }
-
-    m_initialized.store(true);
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    auto phaseStart = start;
+    std::ostringstream timeline;
+    auto phase = [&](const char *name) {
+        auto now = clock::now();
+        timeline << " " << name << "="
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(now - phaseStart).count()
+                 << "ms";
+        phaseStart = now;
+    };
+    auto finish = [&](bool ok) {
+        auto total = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start);
+        blog(ok ? LOG_INFO : LOG_WARNING, "[browser-bridge] Startup timeline:%s total=%lldms (%s)",
+             timeline.str().c_str(), static_cast<long long>(total.count()),
+             ok ? "ready" : "failed");
+        if (!ok) {
+            failPendingInits();
+        }
+    };
 
     // Get token from environment (set by the engine)
     // The token is required for authentication with the browser helper
@@ -131,67 +244,663 @@ bool BrowserBridgeManager::ensureInitialized()
         blog(LOG_INFO, "[browser-bridge] Using token from BROWSER_HELPER_TOKEN");
     }
 
+    configureWarmPool();
+    configureShards();
+    phase("config");
+
+    size_t connected = 0;
+    for (auto &shard : m_shards) {
+        std::string prefix = "h" + std::to_string(shard->index) + ".";
+        auto client = connectShard(*shard, true, [&](const char *name) {
+            phase((prefix + name).c_str());
+        });
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (client) {
+            shard->ipc = std::move(client);
+            shard->alive = true;
+            ++connected;
+        } else {
+            // The monitor retries it once we are running
+            shard->failures = 1;
+            shard->nextRestart = clock::now() + std::chrono::milliseconds(500);
+        }
+    }
+
+    if (connected == 0) {
+        blog(LOG_WARNING, "[browser-bridge] No browser helper available; retrying in the background");
+        finish(false);
+
+        // The monitor keeps reconnecting with backoff; the first helper it
+        // brings up re-queues the dropped sources (see checkShards())
+        m_monitorRunning.store(true);
+        m_monitorThread = std::thread(&BrowserBridgeManager::monitorLoop, this);
+        return;
+    }
+
+    size_t flushed = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running.store(true);
+        m_initPending.store(false);
+
+        // Requests made while we were starting, in the order they were made
+        for (const auto &pending : m_pendingInits) {
+            if (placeBrowser(pending.browserId, pending.url, pending.width,
+                             pending.height, pending.fps, pending.css)) {
+                ++flushed;
+            }
+        }
+        m_pendingInits.clear();
+    }
+    if (flushed > 0) {
+        blog(LOG_INFO, "[browser-bridge] Sent %zu queued initBrowser requests", flushed);
+    }
+    phase("flush_queue");
+
+    blog(LOG_INFO, "[browser-bridge] %zu of %zu browser helpers connected",
+         connected, m_shards.size());
+    finish(true);
+    startWarmPool();
+
+    m_monitorRunning.store(true);
+    m_monitorThread = std::thread(&BrowserBridgeManager::monitorLoop, this);
+}
+
+/**
+ * Drops queued initBrowser requests after the helper failed to start.
+ * 
+ * Their sources are told to forget the browser (they believed it
+ * initialized) and are asked to initialize again once the monitor connects
+ * a helper.
+ */
+void BrowserBridgeManager::failPendingInits()
+{
+    std::vector<std::string> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (const auto &pending : m_pendingInits) {
+            blog(LOG_ERROR, "[browser-bridge] Dropping queued initBrowser for %s - helper unavailable",
+                 pending.browserId.c_str());
+            dropped.push_back(pending.browserId);
+            m_droppedInits.push_back(pending.browserId);
+        }
+        m_pendingInits.clear();
+        m_sharedBrowsers.clear();
+        m_initPending.store(false);
+    }
+
+    uint64_t epoch = pinRoutes();
+    const RouteMap *routes = m_routes.load();
+    for (const auto &browserId : dropped) {
+        auto it = routes->find(browserId);
+        if (it == routes->end()) {
+            continue;
+        }
+        for (BrowserBridgeSource *source : it->second) {
+            source->onBrowserDropped();
+        }
+    }
+    unpinRoutes(epoch);
+}
+
+/**
+ * Asks every source whose initBrowser was dropped (or refused) before any
+ * helper was up to initialize again. Runs once, on the monitor thread, when
+ * the first helper connects after a failed startup. Never called with
+ * m_mutex held.
+ */
+void BrowserBridgeManager::retryDroppedInits()
+{
+    std::vector<std::string> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        dropped.swap(m_droppedInits);
+    }
+    if (dropped.empty()) {
+        return;
+    }
+    std::sort(dropped.begin(), dropped.end());
+    dropped.erase(std::unique(dropped.begin(), dropped.end()), dropped.end());
+
+    size_t requeued = 0;
+    uint64_t epoch = pinRoutes();
+    const RouteMap *routes = m_routes.load();
+    for (const auto &browserId : dropped) {
+        auto it = routes->find(browserId);
+        if (it == routes->end()) {
+            continue;
+        }
+        for (BrowserBridgeSource *source : it->second) {
+            source->onHelperAvailable();
+            ++requeued;
+        }
+    }
+    unpinRoutes(epoch);
+
+    blog(LOG_INFO, "[browser-bridge] Helper available; re-initializing %zu dropped sources", requeued);
+}
+
+// ============================================================================
+// Helper Shards
+// ============================================================================
+
+/**
+ * Reads the helper shard configuration exported by the engine.
+ * 
+ * - BROWSER_HELPER_PORT: port of the first helper (default 4777)
+ * - BROWSER_BRIDGE_HELPERS: number of helper processes (default 1, max 16)
+ */
+void BrowserBridgeManager::configureShards()
+{
+    const char *portEnv = std::getenv("BROWSER_HELPER_PORT");
+    if (portEnv) {
+        int port = std::atoi(portEnv);
+        if (port > 0 && port < 65536) {
+            m_port = static_cast<uint16_t>(port);
+        }
+    }
+
+    size_t count = 1;
+    const char *countEnv = std::getenv("BROWSER_BRIDGE_HELPERS");
+    if (countEnv) {
+        int requested = std::atoi(countEnv);
+        if (requested >= 1 && requested <= 16) {
+            count = static_cast<size_t>(requested);
+        } else {
+            blog(LOG_WARNING, "[browser-bridge] Ignoring invalid BROWSER_BRIDGE_HELPERS=%s",
+                 countEnv);
+        }
+    }
+    if (m_port + count - 1 > 65535) {
+        count = 65536 - m_port;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shards.clear();
+    for (size_t i = 0; i < count; ++i) {
+        auto shard = std::make_unique<HelperShard>();
+        shard->index = i;
+        shard->port = static_cast<uint16_t>(m_port + i);
+        m_shards.push_back(std::move(shard));
+    }
+
+    blog(LOG_INFO, "[browser-bridge] Using %zu browser helper(s) on ports %u-%u",
+         count, m_port, static_cast<unsigned>(m_port + count - 1));
+}
+
+/**
+ * Connects to the helper of one shard, launching it if nothing listens on
+ * its port. Blocks for up to ~7.5 s; never called with m_mutex held.
+ * 
+ * @param allowLaunch false to only reconnect (the engine restarts its own helper)
+ * @param phase Called after each step with its name (startup timeline)
+ * @return Connected and authenticated client, or nullptr
+ */
+std::unique_ptr<IPCClient> BrowserBridgeManager::connectShard(
+    HelperShard &shard, bool allowLaunch, const std::function<void(const char *)> &phase)
+{
     // Connect IPC with frame callback
     // Frames are delivered as base64-encoded BGRA data via frameReady messages
-    m_ipcClient = std::make_unique<IPCClient>();
-    m_ipcClient->setFrameCallback([this](const std::string &browserId,
-                                          const uint8_t *data, size_t size,
-                                          int width, int height) {
+    auto client = std::make_unique<IPCClient>();
+    HelperShard *owner = &shard;
+    client->setFrameCallback([this, owner](const std::string &browserId,
+                                           const uint8_t *data, size_t size,
+                                           int width, int height) {
+        owner->ipcFrames.fetch_add(1, std::memory_order_relaxed);
         dispatchFrame(browserId, data, size, width, height);
     });
+    // Wake the monitor right away instead of at its next poll
+    client->setDisconnectCallback([this]() { m_monitorCv.notify_all(); });
 
     // IMPORTANT: Try existing helper first to avoid duplicate processes
     // The engine typically launches the helper during startup and sets the token
-    blog(LOG_INFO, "[browser-bridge] Trying to connect to existing helper on port %u", m_port);
-    if (m_ipcClient->connect("127.0.0.1", m_port, 2000)) { // 2 second timeout
-        // Send handshake with token for authentication
-        // Without this, the helper will reject all subsequent commands with "unauthorized"
-        if (!m_authToken.empty()) {
-            m_ipcClient->sendHandshake(m_authToken);
-        }
-        blog(LOG_INFO, "[browser-bridge] Connected to existing helper on port %u", m_port);
-        m_running.store(true);
-        return true;
+    blog(LOG_INFO, "[browser-bridge] Trying to connect to existing helper on port %u", shard.port);
+    bool connected = client->connect("127.0.0.1", shard.port, 2000); // 2 second timeout
+    phase("connect_existing");
+
+    if (connected) {
+        blog(LOG_INFO, "[browser-bridge] Connected to existing helper on port %u", shard.port);
+    } else if (!allowLaunch) {
+        return nullptr;
+    } else {
+        // No existing helper, resolve path and launch our own
+        if (m_helperPath.empty()) {
+            m_helperPath = resolveHelperPath();
+            phase("resolve_path");
+            if (m_helperPath.empty()) {
+                blog(LOG_WARNING, "[browser-bridge] Could not find browser helper");
+                return nullptr;
+            }
+            blog(LOG_INFO, "[browser-bridge] Helper path: %s", m_helperPath.c_str());
+        }
+
+        // Launch helper
+        bool launched = launchHelper(shard);
+        phase("launch");
+        if (!launched) {
+            blog(LOG_ERROR, "[browser-bridge] Failed to launch browser helper");
+            return nullptr;
+        }
+        shard.owned = true;
+
+        // Give helper time to start listening
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        phase("startup_wait");
+
+        // Try to connect to the helper we just launched
+        connected = client->connect("127.0.0.1", shard.port, 5000); // 5 second timeout
+        phase("connect_launched");
+        if (!connected) {
+            blog(LOG_ERROR, "[browser-bridge] Failed to connect to helper on port %u",
+                 shard.port);
+            stopHelper(shard);
+            return nullptr;
+        }
+
+        blog(LOG_INFO, "[browser-bridge] Connected to helper on port %u", shard.port);
     }
 
-    // No existing helper, resolve path and launch our own
-    m_helperPath = resolveHelperPath();
-    if (m_helperPath.empty()) {
-        blog(LOG_WARNING,
-             "[browser-bridge] Could not find browser helper; browser sources disabled");
-        return false;
+    // Send handshake with token for authentication
+    // Without this, the helper will reject all subsequent commands with "unauthorized"
+    if (!m_authToken.empty()) {
+        client->sendHandshake(m_authToken);
     }
+    phase("handshake");
 
-    blog(LOG_INFO, "[browser-bridge] Helper path: %s", m_helperPath.c_str());
+    return client;
+}
 
-    // Launch helper
-    if (!launchHelper()) {
-        blog(LOG_ERROR, "[browser-bridge] Failed to launch browser helper");
-        return false;
+/**
+ * Picks the live shard with the lowest requested pixel rate (ties: fewest
+ * browsers). The helper reports no CPU figures, so width * height * fps of
+ * the browsers already placed is the load estimate. Caller holds m_mutex.
+ */
+BrowserBridgeManager::HelperShard *BrowserBridgeManager::pickShard()
+{
+    std::vector<uint64_t> pixelRate(m_shards.size(), 0);
+    std::vector<size_t> browsers(m_shards.size(), 0);
+    for (const auto &kv : m_browsers) {
+        const BrowserRecord &record = kv.second;
+        pixelRate[record.shard] += static_cast<uint64_t>(record.width) * record.height * record.fps;
+        ++browsers[record.shard];
     }
 
-    // Give helper time to start listening
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    HelperShard *best = nullptr;
+    for (auto &shard : m_shards) {
+        if (!shard->alive || !shard->ipc || !shard->ipc->isConnected()) {
+            continue;
+        }
+        size_t i = shard->index;
+        if (!best || pixelRate[i] < pixelRate[best->index] ||
+            (pixelRate[i] == pixelRate[best->index] && browsers[i] < browsers[best->index])) {
+            best = shard.get();
+        }
+    }
+    return best;
+}
 
-    // Try to connect to the helper we just launched
-    if (!m_ipcClient->connect("127.0.0.1", m_port, 5000)) { // 5 second timeout
-        blog(LOG_ERROR, "[browser-bridge] Failed to connect to helper on port %u",
-             m_port);
-        stopHelper();
+/**
+ * Creates a browser on the least-loaded helper and records where it lives.
+ * Caller holds m_mutex.
+ */
+bool BrowserBridgeManager::placeBrowser(const std::string &browserId, const std::string &url,
+                                        int width, int height, int fps, const std::string &css)
+{
+    HelperShard *shard = pickShard();
+    if (!shard) {
+        blog(LOG_ERROR, "[browser-bridge] Cannot init browser - no helper connected");
         return false;
     }
 
-    // Send handshake with token for authentication
+    BrowserRecord record{url, css, width, height, fps, shard->index,
+                         m_producersPaused.load() && !browserShowing(browserId)};
+    queueLine(*shard, initBrowserLine(browserId, record));
+    m_browsers[browserId] = record;
+
+    blog(LOG_INFO, "[browser-bridge] Queued initBrowser for %s on helper %zu (%dx%d @%dfps) url=%s",
+         browserId.c_str(), shard->index, width, height, fps, url.c_str());
+    return true;
+}
+
+/**
+ * Builds the initBrowser command for a browser record.
+ */
+std::string BrowserBridgeManager::initBrowserLine(const std::string &browserId,
+                                                  const BrowserRecord &record) const
+{
+    // initBrowser command with token
+    // IMPORTANT: Helper expects "id" not "browserId" - using wrong field causes "missing_id" error
+    std::ostringstream ss;
+    ss << "{\"type\":\"initBrowser\",\"id\":\"" << browserId << "\","
+       << "\"url\":\"" << record.url << "\","
+       << "\"width\":" << record.width << ",\"height\":" << record.height 
+       << ",\"fps\":" << record.fps;
+    if (!record.css.empty()) {
+        ss << ",\"css\":\"" << jsonEscape(record.css) << "\"";
+    }
+    if (record.paused) {
+        ss << ",\"paused\":true";
+    }
     if (!m_authToken.empty()) {
-        m_ipcClient->sendHandshake(m_authToken);
+        ss << ",\"token\":\"" << m_authToken << "\"";
+    }
+    ss << "}";
+    return ss.str();
+}
+
+/**
+ * Sends an initBrowser command to one helper right away (replays on the
+ * monitor thread). Caller holds m_mutex.
+ */
+bool BrowserBridgeManager::sendInitBrowser(HelperShard &shard, const std::string &browserId,
+                                           const BrowserRecord &record)
+{
+    if (!shard.ipc || !shard.ipc->isConnected()) {
+        blog(LOG_ERROR, "[browser-bridge] Cannot init browser - IPC not connected");
+        return false;
     }
 
-    blog(LOG_INFO, "[browser-bridge] Connected to helper on port %u", m_port);
+    std::string line = initBrowserLine(browserId, record);
+    blog(LOG_INFO, "[browser-bridge] Sending initBrowser to helper %zu: %s",
+         shard.index, line.c_str());
+
+    if (!shard.ipc->sendLine(line)) {
+        blog(LOG_ERROR, "[browser-bridge] Failed to send initBrowser for %s",
+             browserId.c_str());
+        return false;
+    }
 
-    m_running.store(true);
+    blog(LOG_INFO, "[browser-bridge] Successfully sent initBrowser for %s (%dx%d @%dfps) url=%s",
+         browserId.c_str(), record.width, record.height, record.fps, record.url.c_str());
     return true;
 }
 
+/**
+ * Recreates every browser whose helper is dead on a live helper.
+ * 
+ * Browsers stay parked on their dead shard when no helper is alive; the
+ * next successful restart picks them up. Caller holds m_mutex.
+ * 
+ * @param moved Receives the IDs of migrated browsers
+ */
+void BrowserBridgeManager::migrateOrphans(std::vector<std::string> &moved)
+{
+    for (auto &kv : m_browsers) {
+        BrowserRecord &record = kv.second;
+        if (m_shards[record.shard]->alive) {
+            continue;
+        }
+
+        HelperShard *target = pickShard();
+        if (!target) {
+            return;
+        }
+
+        size_t from = record.shard;
+        if (sendInitBrowser(*target, kv.first, record)) {
+            record.shard = target->index;
+            moved.push_back(kv.first);
+            blog(LOG_INFO, "[browser-bridge] Migrated browser %s from helper %zu to helper %zu",
+                 kv.first.c_str(), from, target->index);
+        }
+    }
+}
+
+/**
+ * Tells every consumer of the given browsers that its helper went away
+ * (established = false) or that the browser was replayed to a live helper
+ * (established = true; consumers reopen the SHM segment the helper
+ * recreates). Never called with m_mutex held.
+ */
+void BrowserBridgeManager::notifySources(const std::vector<std::string> &browserIds,
+                                         bool established)
+{
+    if (browserIds.empty()) {
+        return;
+    }
+
+    uint64_t epoch = pinRoutes();
+    const RouteMap *routes = m_routes.load();
+    for (const auto &browserId : browserIds) {
+        auto it = routes->find(browserId);
+        if (it == routes->end()) {
+            continue;
+        }
+        for (BrowserBridgeSource *source : it->second) {
+            if (established) {
+                source->onConnectionEstablished();
+            } else {
+                source->onConnectionLost();
+            }
+        }
+    }
+    unpinRoutes(epoch);
+
+    if (!established) {
+        return;
+    }
+
+    // Idle warm-pool browsers are remapped by the refill thread
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    for (auto &warm : m_warmPool) {
+        if (std::find(browserIds.begin(), browserIds.end(), warm.browserId) != browserIds.end()) {
+            warm.shmReader->disconnect();
+        }
+    }
+    m_poolCv.notify_one();
+}
+
+/**
+ * Monitor thread: wakes once a second, when an IPC connection drops, or
+ * when the next reconnect attempt is due.
+ */
+void BrowserBridgeManager::monitorLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_monitorRunning.load()) {
+        auto wakeAt = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        for (const auto &shard : m_shards) {
+            if (!shard->alive && shard->nextRestart < wakeAt) {
+                wakeAt = shard->nextRestart;
+            }
+        }
+        m_monitorCv.wait_until(lock, wakeAt, [this]() {
+            return !m_monitorRunning.load() || !m_outbox.empty() || m_pauseDirty.load();
+        });
+        if (!m_monitorRunning.load()) {
+            break;
+        }
+        lock.unlock();
+        flushOutbox();
+        if (m_pauseDirty.exchange(false)) {
+            applyProducerPause();
+        }
+        checkShards();
+        lock.lock();
+    }
+}
+
+/**
+ * Hands a command for one helper to the monitor thread, which writes it
+ * without m_mutex held: a full socket must not block the video thread that
+ * asked for a browser. Lines go out in the order they were queued. Caller
+ * holds m_mutex.
+ */
+void BrowserBridgeManager::queueLine(HelperShard &shard, std::string line)
+{
+    m_outbox.push_back(OutboundLine{shard.index, std::move(line)});
+    m_monitorCv.notify_all();
+}
+
+/**
+ * Writes the queued helper commands. Runs on the monitor thread (or in
+ * shutdown() after it stopped), the only place a running shard's IPC client
+ * is replaced, so the clients stay valid with m_mutex released.
+ * 
+ * Lines for a dead helper are dropped: its browsers are replayed from their
+ * records, and a failed send marks the connection lost for checkShards().
+ */
+void BrowserBridgeManager::flushOutbox()
+{
+    std::vector<std::pair<IPCClient *, std::string>> lines;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &out : m_outbox) {
+            HelperShard &shard = *m_shards[out.shard];
+            if (shard.alive && shard.ipc) {
+                lines.emplace_back(shard.ipc.get(), std::move(out.line));
+            }
+        }
+        m_outbox.clear();
+    }
+
+    for (auto &line : lines) {
+        if (!line.first->sendLine(line.second)) {
+            blog(LOG_ERROR, "[browser-bridge] Failed to send a queued helper command");
+        }
+    }
+}
+
+/**
+ * One monitor pass:
+ * 1. Detect helpers whose connection dropped and tell their sources
+ * 2. Replay their browsers (url, size, fps) on live helpers
+ * 3. Reconnect dead helpers with exponential backoff (250 ms doubling to
+ *    30 s, first attempt immediate), re-handshake and replay any browsers
+ *    parked while no helper was alive
+ * 
+ * A helper the engine launched is never launched here: after four failed
+ * reconnects the engine is asked to restart it and we keep reconnecting.
+ * Only without an engine (plain OBS) do we launch a helper of our own.
+ * Replays are pipelined: every initBrowser is written without waiting for
+ * the helper's browserReady.
+ */
+void BrowserBridgeManager::checkShards()
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<std::unique_ptr<IPCClient>> lost;
+    std::vector<HelperShard *> restart;
+    std::vector<std::string> orphaned;
+    std::vector<std::string> moved;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto now = clock::now();
+        for (auto &shard : m_shards) {
+            if (shard->alive && !(shard->ipc && shard->ipc->isConnected())) {
+                blog(LOG_WARNING, "[browser-bridge] Helper %zu (port %u) lost; replaying its browsers",
+                     shard->index, shard->port);
+                shard->alive = false;
+                shard->failures = 0;
+                shard->nextRestart = now;
+                lost.push_back(std::move(shard->ipc));
+                for (const auto &kv : m_browsers) {
+                    if (kv.second.shard == shard->index) {
+                        orphaned.push_back(kv.first);
+                    }
+                }
+            }
+        }
+        if (!lost.empty()) {
+            migrateOrphans(moved);
+        }
+        for (auto &shard : m_shards) {
+            if (!shard->alive && now >= shard->nextRestart) {
+                restart.push_back(shard.get());
+            }
+        }
+    }
+
+    for (auto &client : lost) {
+        client->disconnect();
+    }
+    notifySources(orphaned, false);
+    notifySources(moved, true);
+
+    for (HelperShard *shard : restart) {
+        // One owner per helper: the engine restarts the helper it launched,
+        // we only launch one when no engine takes the request
+        if (!shard->owned && shard->failures == 4) {
+            shard->engineManaged = requestEngineRestart(*shard);
+        }
+        bool allowLaunch = shard->owned || (shard->failures >= 4 && !shard->engineManaged);
+
+        // Reap the old process (if we launched it) before reusing the port
+        stopHelper(*shard);
+        auto client = connectShard(*shard, allowLaunch, [](const char *) {});
+
+        moved.clear();
+        bool firstConnect = false;
+        auto replayStart = clock::now();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!client) {
+                uint32_t shift = std::min<uint32_t>(shard->failures, 7);
+                shard->nextRestart = clock::now() + std::chrono::milliseconds(250u << shift);
+                ++shard->failures;
+                continue;
+            }
+            shard->ipc = std::move(client);
+            shard->alive = true;
+            shard->failures = 0;
+            ++shard->restarts;
+            blog(LOG_INFO, "[browser-bridge] Helper %zu (port %u) reconnected (restart #%u)",
+                 shard->index, shard->port, shard->restarts);
+
+            // Browsers parked while no helper was alive
+            migrateOrphans(moved);
+
+            // First helper after a failed startup: start serving requests
+            firstConnect = !m_running.exchange(true);
+        }
+        if (!moved.empty()) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                clock::now() - replayStart);
+            blog(LOG_INFO, "[browser-bridge] Replayed %zu browsers to helper %zu in %.1f ms",
+                 moved.size(), shard->index, elapsed.count() / 1000.0);
+        }
+        notifySources(moved, true);
+
+        if (firstConnect) {
+            retryDroppedInits();
+            startWarmPool();
+        }
+    }
+}
+
+std::vector<HelperLoad> BrowserBridgeManager::helperLoads() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<HelperLoad> loads;
+    for (const auto &shard : m_shards) {
+        loads.push_back({shard->port, shard->alive, 0, 0,
+                         shard->ipcFrames.load(std::memory_order_relaxed), shard->restarts});
+    }
+    for (const auto &kv : m_browsers) {
+        const BrowserRecord &record = kv.second;
+        ++loads[record.shard].browsers;
+        loads[record.shard].pixelRate +=
+            static_cast<uint64_t>(record.width) * record.height * record.fps;
+    }
+    return loads;
+}
+
+void BrowserBridgeManager::logHelperLoads()
+{
+    std::vector<HelperLoad> loads = helperLoads();
+    for (size_t i = 0; i < loads.size(); ++i) {
+        const HelperLoad &load = loads[i];
+        blog(LOG_INFO, "[browser-bridge] Helper %zu (port %u): %s, %zu browsers, "
+             "%.1f Mpx/s requested, %llu IPC frames, %u restarts",
+             i, load.port, load.alive ? "alive" : "dead", load.browsers,
+             load.pixelRate / 1e6, static_cast<unsigned long long>(load.ipcFrames),
+             load.restarts);
+    }
+}
+
 /**
  * Shuts down the browser bridge manager.
  * 
@@ -202,20 +911,40 @@ bool BrowserBridgeManager::ensureInitialized()
  */
 void BrowserBridgeManager::shutdown()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    // Must run before taking m_mutex: the init, pool and monitor threads all
+    // lock it. Join init first since it is what starts the other two.
+    if (m_initThread.joinable()) {
+        m_initThread.join();
+    }
+    stopWarmPool();
+    if (m_monitorRunning.exchange(false)) {
+        m_monitorCv.notify_all();
+    }
+    if (m_monitorThread.joinable()) {
+        m_monitorThread.join();
+    }
 
     if (!m_initialized.load()) {
         return;
     }
 
+    // Commands the monitor had not written yet (disposes in particular)
+    flushOutbox();
+
+    logHelperLoads();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     blog(LOG_INFO, "[browser-bridge] Shutting down");
 
     m_running.store(false);
 
-    // Dispose all browsers
+    // Dispose all browsers on the helper that owns them (one message per
+    // browser, however many subscribers)
     // IMPORTANT: Helper expects "id" not "browserId" - this was a source of bugs
-    for (auto &kv : m_sources) {
-        if (m_ipcClient && m_ipcClient->isConnected()) {
+    for (const auto &kv : m_browsers) {
+        HelperShard &shard = *m_shards[kv.second.shard];
+        if (shard.alive && shard.ipc && shard.ipc->isConnected()) {
             std::ostringstream ss;
             ss << "{\"type\":\"disposeBrowser\",\"id\":\"" << kv.first << "\"";
             // Include token for authentication
@@ -223,20 +952,26 @@ void BrowserBridgeManager::shutdown()
                 ss << ",\"token\":\"" << m_authToken << "\"";
             }
             ss << "}";
-            m_ipcClient->sendLine(ss.str());
+            shard.ipc->sendLine(ss.str());
         }
     }
-    m_sources.clear();
-
-    // Stop IPC
-    if (m_ipcClient) {
-        m_ipcClient->disconnect();
+    m_browsers.clear();
+    updateRoutes([](RouteMap &routes) { routes.clear(); });
+    m_sharedBrowsers.clear();
+    m_pendingInits.clear();
+    m_droppedInits.clear();
+
+    // Stop IPC and helpers
+    for (auto &shard : m_shards) {
+        if (shard->ipc) {
+            shard->ipc->disconnect();
+            shard->ipc.reset();
+        }
+        shard->alive = false;
+        stopHelper(*shard);
     }
+    m_shards.clear();
 
-    // Stop helper
-    stopHelper();
-
-    m_ipcClient.reset();
     m_initialized.store(false);
 
     blog(LOG_INFO, "[browser-bridge] Shutdown complete");
@@ -245,18 +980,167 @@ void BrowserBridgeManager::shutdown()
 void BrowserBridgeManager::registerSource(const std::string &browserId, 
                                           BrowserBridgeSource *source)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_sources[browserId] = source;
-    blog(LOG_DEBUG, "[browser-bridge] Registered source: %s", browserId.c_str());
+    size_t count = 0;
+    updateRoutes([&](RouteMap &routes) {
+        auto &subscribers = routes[browserId];
+        if (std::find(subscribers.begin(), subscribers.end(), source) == subscribers.end()) {
+            subscribers.push_back(source);
+        }
+        count = subscribers.size();
+    });
+    blog(LOG_DEBUG, "[browser-bridge] Registered source: %s (%zu subscribers)",
+         browserId.c_str(), count);
 }
 
-void BrowserBridgeManager::unregisterSource(const std::string &browserId)
+/**
+ * Removes a source from frame routing.
+ * 
+ * Does not wait for readers: a dispatchFrame() already running may still
+ * deliver one frame to the source. Call synchronizeRoutes() before
+ * destroying it.
+ */
+void BrowserBridgeManager::unregisterSource(const std::string &browserId,
+                                            BrowserBridgeSource *source)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_sources.erase(browserId);
+    updateRoutes([&](RouteMap &routes) {
+        auto it = routes.find(browserId);
+        if (it == routes.end()) {
+            return;
+        }
+        auto &subscribers = it->second;
+        subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), source),
+                          subscribers.end());
+        if (subscribers.empty()) {
+            routes.erase(it);
+        }
+    });
     blog(LOG_DEBUG, "[browser-bridge] Unregistered source: %s", browserId.c_str());
 }
 
+/**
+ * Publishes a modified copy of the routing table.
+ * 
+ * Writers are serialized by m_routesMutex. After the new table is visible the
+ * epoch is flipped so new readers pin the other slot; the old table is
+ * retired with the epoch it belonged to. Nothing waits here: tables retired
+ * earlier whose slot has drained are freed on the way out. Readers never
+ * block.
+ */
+void BrowserBridgeManager::updateRoutes(const std::function<void(RouteMap &)> &mutate)
+{
+    std::lock_guard<std::mutex> lock(m_routesMutex);
+
+    const RouteMap *current = m_routes.load();
+    auto *next = new RouteMap(*current);
+    mutate(*next);
+    m_routes.store(next);
+
+    uint64_t epoch = m_routeEpoch.load();
+    m_routeEpoch.store(epoch + 1);
+    m_retiredRoutes.emplace_back(epoch, current);
+
+    reclaimRoutes();
+}
+
+/**
+ * Frees retired tables no reader can still hold. A reader that may see a
+ * table retired in epoch E pinned slot E & 1 before the flip, so once that
+ * slot is seen empty after the flip every such reader has left (later
+ * readers of the slot only see newer tables). Caller holds m_routesMutex.
+ */
+void BrowserBridgeManager::reclaimRoutes()
+{
+    bool drained[2] = {m_routeReaders[0].load() == 0, m_routeReaders[1].load() == 0};
+    auto it = std::remove_if(m_retiredRoutes.begin(), m_retiredRoutes.end(),
+                             [&](const std::pair<uint64_t, const RouteMap *> &retired) {
+                                 if (!drained[retired.first & 1]) {
+                                     return false;
+                                 }
+                                 delete retired.second;
+                                 return true;
+                             });
+    m_retiredRoutes.erase(it, m_retiredRoutes.end());
+}
+
+/**
+ * Waits for the grace period of every table retired so far, then frees them.
+ * 
+ * Called off the video thread (source destruction). The slots are polled
+ * without m_routesMutex held, so writers on other threads carry on meanwhile;
+ * an empty slot seen at any point after a retirement is proof enough, even if
+ * later readers pin it again.
+ */
+void BrowserBridgeManager::synchronizeRoutes()
+{
+    bool pending[2] = {false, false};
+    {
+        std::lock_guard<std::mutex> lock(m_routesMutex);
+        for (const auto &retired : m_retiredRoutes) {
+            pending[retired.first & 1] = true;
+        }
+    }
+
+    for (int slot = 0; slot < 2; ++slot) {
+        while (pending[slot] && m_routeReaders[slot].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_routesMutex);
+    reclaimRoutes();
+}
+
+/**
+ * Builds the browser ID shared by all sources with identical render settings.
+ * 
+ * The ID is a 64-bit FNV-1a hash of the (url, width, height, fps, css) tuple,
+ * so every source with the same key resolves to the same helper browser and
+ * the same SHM segment (/streamlumo_browser_<id>) without a lookup table.
+ */
+std::string BrowserBridgeManager::sharedBrowserId(const std::string &url, int width,
+                                                  int height, int fps,
+                                                  const std::string &css)
+{
+    std::ostringstream key;
+    key << url << '\n' << width << 'x' << height << '@' << fps << '\n' << css;
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key.str()) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    char buf[40];
+    snprintf(buf, sizeof(buf), "browser_shared_%016" PRIx64, hash);
+    return buf;
+}
+
+/**
+ * Returns the SHM reader every subscriber of a shared browser uses.
+ * 
+ * Entries are weak so the reader (and its mapping) goes away with the last
+ * subscriber; expired entries are pruned here.
+ */
+std::shared_ptr<SharedShmReader> BrowserBridgeManager::acquireSharedReader(const std::string &browserId)
+{
+    std::lock_guard<std::mutex> lock(m_sharedReadersMutex);
+
+    for (auto it = m_sharedReaders.begin(); it != m_sharedReaders.end();) {
+        if (it->second.expired() && it->first != browserId) {
+            it = m_sharedReaders.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::shared_ptr<SharedShmReader> reader = m_sharedReaders[browserId].lock();
+    if (!reader) {
+        reader = std::make_shared<SharedShmReader>(browserId);
+        m_sharedReaders[browserId] = reader;
+    }
+    return reader;
+}
+
 /**
  * Initializes a browser instance in the helper process.
  * 
@@ -275,6 +1159,8 @@ void BrowserBridgeManager::unregisterSource(const std::string &browserId)
  *   "width": 1920,
  *   "height": 1080,
  *   "fps": 30,
+ *   "css": "body { background: transparent; }",  // only if set
+ *   "paused": true,                               // only while paused
  *   "token": "<auth-token>"
  * }
  * ```
@@ -284,57 +1170,59 @@ void BrowserBridgeManager::unregisterSource(const std::string &browserId)
  * @param width Browser width in pixels
  * @param height Browser height in pixels  
  * @param fps Frame rate for rendering
+ * @param css Custom CSS the helper injects into every page load
+ * @param shared true if browserId came from sharedBrowserId(); subscribers
+ *               after the first attach to the existing helper browser
  * @return true if command sent successfully
  */
 bool BrowserBridgeManager::initBrowser(const std::string &browserId,
                                         const std::string &url,
-                                        int width, int height, int fps)
+                                        int width, int height, int fps,
+                                        const std::string &css, bool shared)
 {
-    // Ensure initialized on first browser creation
-    if (!ensureInitialized()) {
-        blog(LOG_ERROR, "[browser-bridge] ensureInitialized() failed");
-        return false;
-    }
+    // Kick off helper startup on first use if module load didn't
+    startAsyncInit();
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
-    if (!m_running.load()) {
-        blog(LOG_ERROR, "[browser-bridge] Cannot init browser - manager not running");
-        return false;
-    }
-    
-    if (!m_ipcClient) {
-        blog(LOG_ERROR, "[browser-bridge] Cannot init browser - no IPC client");
-        return false;
-    }
-    
-    if (!m_ipcClient->isConnected()) {
-        blog(LOG_ERROR, "[browser-bridge] Cannot init browser - IPC not connected");
-        return false;
-    }
-
-    // Send initBrowser command with token
-    // IMPORTANT: Helper expects "id" not "browserId" - using wrong field causes "missing_id" error
-    std::ostringstream ss;
-    ss << "{\"type\":\"initBrowser\",\"id\":\"" << browserId << "\","
-       << "\"url\":\"" << url << "\","
-       << "\"width\":" << width << ",\"height\":" << height 
-       << ",\"fps\":" << fps;
-    if (!m_authToken.empty()) {
-        ss << ",\"token\":\"" << m_authToken << "\"";
+    // A shared browser that is already live (or queued) only gains a subscriber
+    if (shared) {
+        auto it = m_sharedBrowsers.find(browserId);
+        if (it != m_sharedBrowsers.end()) {
+            ++it->second;
+            blog(LOG_INFO, "[browser-bridge] Attached to shared browser %s (%d subscribers)",
+                 browserId.c_str(), it->second);
+            return true;
+        }
     }
-    ss << "}";
 
-    blog(LOG_INFO, "[browser-bridge] Sending initBrowser: %s", ss.str().c_str());
+    if (!m_running.load()) {
+        if (!m_initPending.load()) {
+            // Startup failed and the monitor is still retrying; the source is
+            // asked again once a helper connects
+            blog(LOG_ERROR, "[browser-bridge] Cannot init browser %s - no helper yet, will retry",
+                 browserId.c_str());
+            m_droppedInits.push_back(browserId);
+            return false;
+        }
 
-    if (!m_ipcClient->sendLine(ss.str())) {
-        blog(LOG_ERROR, "[browser-bridge] Failed to send initBrowser for %s",
+        // Helper still starting: queue and send once connected
+        m_pendingInits.push_back(PendingInit{browserId, url, css, width, height, fps});
+        if (shared) {
+            m_sharedBrowsers[browserId] = 1;
+        }
+        blog(LOG_INFO, "[browser-bridge] Helper not ready yet, queued initBrowser for %s",
              browserId.c_str());
+        return true;
+    }
+
+    if (!placeBrowser(browserId, url, width, height, fps, css)) {
         return false;
     }
 
-    blog(LOG_INFO, "[browser-bridge] Successfully sent initBrowser for %s (%dx%d @%dfps) url=%s",
-         browserId.c_str(), width, height, fps, url.c_str());
+    if (shared) {
+        m_sharedBrowsers[browserId] = 1;
+    }
     return true;
 }
 
@@ -342,7 +1230,34 @@ void BrowserBridgeManager::disposeBrowser(const std::string &browserId)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
 
-    if (!m_running.load() || !m_ipcClient || !m_ipcClient->isConnected()) {
+    // Shared browsers stay alive until their last subscriber disposes
+    auto shared = m_sharedBrowsers.find(browserId);
+    if (shared != m_sharedBrowsers.end()) {
+        if (--shared->second > 0) {
+            blog(LOG_INFO, "[browser-bridge] Detached from shared browser %s (%d subscribers left)",
+                 browserId.c_str(), shared->second);
+            return;
+        }
+        m_sharedBrowsers.erase(shared);
+    }
+
+    // Never reached the helper: just forget the queued request
+    auto pending = std::find_if(m_pendingInits.begin(), m_pendingInits.end(),
+                                [&](const PendingInit &p) { return p.browserId == browserId; });
+    if (pending != m_pendingInits.end()) {
+        m_pendingInits.erase(pending);
+        return;
+    }
+
+    auto record = m_browsers.find(browserId);
+    if (record == m_browsers.end()) {
+        return;
+    }
+    HelperShard &shard = *m_shards[record->second.shard];
+    m_browsers.erase(record);
+
+    // A browser parked on a dead helper only needs forgetting
+    if (!m_running.load() || !shard.alive || !shard.ipc || !shard.ipc->isConnected()) {
         return;
     }
 
@@ -352,51 +1267,164 @@ void BrowserBridgeManager::disposeBrowser(const std::string &browserId)
         ss << ",\"token\":\"" << m_authToken << "\"";
     }
     ss << "}";
-    m_ipcClient->sendLine(ss.str());
+    // Through the monitor's queue, behind the browser's initBrowser
+    queueLine(shard, ss.str());
 
     blog(LOG_INFO, "[browser-bridge] Disposed browser %s", browserId.c_str());
 }
 
 bool BrowserBridgeManager::updateBrowser(const std::string &browserId,
                                           const std::string &url,
-                                          int width, int height)
+                                          int width, int height,
+                                          const std::string &css)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
 
-    if (!m_running.load() || !m_ipcClient || !m_ipcClient->isConnected()) {
+    // Still queued: fold the change into the pending initBrowser
+    for (auto &pending : m_pendingInits) {
+        if (pending.browserId == browserId) {
+            if (!url.empty()) {
+                pending.url = url;
+            }
+            pending.css = css;
+            pending.width = width;
+            pending.height = height;
+            return true;
+        }
+    }
+
+    auto record = m_browsers.find(browserId);
+    if (!m_running.load() || record == m_browsers.end()) {
         blog(LOG_ERROR, "[browser-bridge] Cannot update browser - not connected");
         return false;
     }
 
+    // Keep the record current so a migration recreates the browser as is
+    if (!url.empty()) {
+        record->second.url = url;
+    }
+    record->second.css = css;
+    record->second.width = width;
+    record->second.height = height;
+
+    HelperShard &shard = *m_shards[record->second.shard];
+    if (!shard.alive || !shard.ipc || !shard.ipc->isConnected()) {
+        // Parked until a helper comes back; applied when it is recreated
+        return true;
+    }
+
     std::ostringstream ss;
     ss << "{\"type\":\"updateBrowser\",\"id\":\"" << browserId << "\"";
     if (!url.empty()) {
         ss << ",\"url\":\"" << url << "\"";
     }
-    ss << ",\"width\":" << width << ",\"height\":" << height;
+    ss << ",\"width\":" << width << ",\"height\":" << height
+       << ",\"css\":\"" << jsonEscape(css) << "\"";
     if (!m_authToken.empty()) {
         ss << ",\"token\":\"" << m_authToken << "\"";
     }
     ss << "}";
 
-    blog(LOG_INFO, "[browser-bridge] Sending updateBrowser: %s", ss.str().c_str());
-    if (!m_ipcClient->sendLine(ss.str())) {
-        blog(LOG_ERROR, "[browser-bridge] Failed to send updateBrowser for %s", browserId.c_str());
+    blog(LOG_INFO, "[browser-bridge] Queued updateBrowser for %s url=%s %dx%d",
+         browserId.c_str(), url.c_str(), width, height);
+    queueLine(shard, ss.str());
+    return true;
+}
+
+bool BrowserBridgeManager::isHelperRunning() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_running.load()) {
         return false;
     }
+    return std::any_of(m_shards.begin(), m_shards.end(),
+                       [](const std::unique_ptr<HelperShard> &shard) { return shard->alive; });
+}
 
-    blog(LOG_INFO, "[browser-bridge] Successfully sent updateBrowser for %s url=%s",
-         browserId.c_str(), url.c_str());
-    return true;
+void BrowserBridgeManager::setProducersPaused(bool paused)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_producersPaused.store(paused);
+    }
+    applyProducerPause();
 }
 
-bool BrowserBridgeManager::isHelperRunning() const
+void BrowserBridgeManager::refreshProducerPause()
 {
-#ifdef _WIN32
-    return m_running.load() && m_helperProcess != nullptr;
-#else
-    return m_running.load() && m_helperPid > 0;
-#endif
+    if (!m_producersPaused.load()) {
+        return;
+    }
+    m_pauseDirty.store(true);
+    m_monitorCv.notify_all();
+}
+
+/**
+ * True if any source subscribed to the browser is showing on some canvas.
+ * Lock-free (routes read side); safe with m_mutex held.
+ */
+bool BrowserBridgeManager::browserShowing(const std::string &browserId)
+{
+    bool showing = false;
+    uint64_t epoch = pinRoutes();
+    const RouteMap *routes = m_routes.load();
+    auto it = routes->find(browserId);
+    if (it != routes->end()) {
+        for (BrowserBridgeSource *source : it->second) {
+            if (obs_source_showing(source->m_source)) {
+                showing = true;
+                break;
+            }
+        }
+    }
+    unpinRoutes(epoch);
+    return showing;
+}
+
+/**
+ * Brings every browser's pause flag in line with idle mode and visibility.
+ * Only browsers whose state changes are touched; the new state is kept in
+ * their record so replays recreate them the same way.
+ */
+void BrowserBridgeManager::applyProducerPause()
+{
+    std::vector<std::pair<std::string, bool>> changes;
+    size_t paused = 0;
+    size_t total = 0;
+    bool idle = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        idle = m_producersPaused.load();
+        total = m_browsers.size();
+        for (auto &kv : m_browsers) {
+            bool pause = idle && !browserShowing(kv.first);
+            if (pause != kv.second.paused) {
+                kv.second.paused = pause;
+                changes.emplace_back(kv.first, pause);
+            }
+            if (pause) {
+                ++paused;
+            }
+        }
+    }
+
+    // A short-lived mapping per browser: the flag lives in the shared header,
+    // so the sources' own readers are left alone
+    size_t flagged = 0;
+    for (const auto &change : changes) {
+        BrowserShmReader control(change.first);
+        if (!control.connect()) {
+            continue;
+        }
+        control.setPauseRequested(change.second);
+        ++flagged;
+    }
+
+    if (!changes.empty()) {
+        blog(LOG_INFO, "[browser-bridge] Idle mode %s: %zu of %zu browser producers paused "
+             "(%zu flags updated)", idle ? "on" : "off", paused, total, flagged);
+    }
 }
 
 void BrowserBridgeManager::dispatchFrame(const std::string &browserId,
@@ -410,20 +1438,224 @@ void BrowserBridgeManager::dispatchFrame(const std::string &browserId,
              dispatchCount, browserId.c_str(), width, height);
     }
     
-    BrowserBridgeSource *source = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        auto it = m_sources.find(browserId);
-        if (it != m_sources.end()) {
-            source = it->second;
+    uint64_t epoch = pinRoutes();
+
+    // Fan the frame out to every subscriber of this browser. Subscribers
+    // can't be destroyed while we are pinned: synchronizeRoutes() waits.
+    const RouteMap *routes = m_routes.load();
+    auto it = routes->find(browserId);
+    if (it != routes->end()) {
+        for (BrowserBridgeSource *source : it->second) {
+            source->receiveFrame(data, size, width, height);
+        }
+    } else {
+        blog(LOG_WARNING, "[browser-bridge] No source found for browser %s", browserId.c_str());
+    }
+
+    unpinRoutes(epoch);
+}
+
+/**
+ * Enters a routing read-side section: the table loaded after this call
+ * (and every source in it) stays valid until unpinRoutes().
+ */
+uint64_t BrowserBridgeManager::pinRoutes()
+{
+    // Re-check so a concurrent epoch flip can't be missed
+    for (;;) {
+        uint64_t epoch = m_routeEpoch.load();
+        m_routeReaders[epoch & 1].fetch_add(1);
+        if (m_routeEpoch.load() == epoch) {
+            return epoch;
+        }
+        m_routeReaders[epoch & 1].fetch_sub(1);
+    }
+}
+
+void BrowserBridgeManager::unpinRoutes(uint64_t epoch)
+{
+    m_routeReaders[epoch & 1].fetch_sub(1);
+}
+
+// ============================================================================
+// Warm Pool
+// ============================================================================
+
+/**
+ * Reads the warm pool configuration exported by the engine.
+ * 
+ * - BROWSER_BRIDGE_WARM_POOL: number of idle browsers to keep (0 = disabled)
+ * - BROWSER_BRIDGE_WARM_POOL_SIZE: "<width>x<height>@<fps>" of pool browsers
+ */
+void BrowserBridgeManager::configureWarmPool()
+{
+    const char *countEnv = std::getenv("BROWSER_BRIDGE_WARM_POOL");
+    if (countEnv) {
+        int count = std::atoi(countEnv);
+        m_warmPoolTarget = count > 0 ? static_cast<size_t>(count) : 0;
+    }
+
+    const char *sizeEnv = std::getenv("BROWSER_BRIDGE_WARM_POOL_SIZE");
+    if (sizeEnv) {
+        int width = 0, height = 0, fps = 0;
+        if (sscanf(sizeEnv, "%dx%d@%d", &width, &height, &fps) == 3 &&
+            width > 0 && height > 0 && fps > 0) {
+            m_warmWidth = width;
+            m_warmHeight = height;
+            m_warmFps = fps;
         } else {
-            blog(LOG_WARNING, "[browser-bridge] No source found for browser %s", browserId.c_str());
+            blog(LOG_WARNING, "[browser-bridge] Ignoring invalid BROWSER_BRIDGE_WARM_POOL_SIZE=%s",
+                 sizeEnv);
+        }
+    }
+}
+
+void BrowserBridgeManager::startWarmPool()
+{
+    if (m_warmPoolTarget == 0 || m_poolRunning.exchange(true)) {
+        return;
+    }
+    m_poolThread = std::thread(&BrowserBridgeManager::warmPoolLoop, this);
+}
+
+/**
+ * Stops the refill thread and disposes every browser still idle in the pool.
+ */
+void BrowserBridgeManager::stopWarmPool()
+{
+    if (!m_poolRunning.exchange(false)) {
+        return;
+    }
+
+    m_poolCv.notify_all();
+    if (m_poolThread.joinable()) {
+        m_poolThread.join();
+    }
+
+    std::vector<WarmBrowser> idle;
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        idle.swap(m_warmPool);
+    }
+
+    for (auto &warm : idle) {
+        warm.shmReader->disconnect();
+        disposeBrowser(warm.browserId);
+        updateRoutes([&warm](RouteMap &routes) {
+            auto it = routes.find(warm.browserId);
+            if (it != routes.end() && it->second.empty()) {
+                routes.erase(it);
+            }
+        });
+    }
+
+    WarmPoolStats stats = warmPoolStats();
+    blog(LOG_INFO, "[browser-bridge] Warm pool stopped: hits=%llu misses=%llu created=%llu",
+         static_cast<unsigned long long>(stats.hits),
+         static_cast<unsigned long long>(stats.misses),
+         static_cast<unsigned long long>(stats.created));
+}
+
+/**
+ * Background refill loop.
+ * 
+ * Keeps m_warmPoolTarget idle browsers alive and maps each one's SHM segment
+ * as soon as the helper has created it, so a claimed browser is ready to
+ * read on the claiming source's next tick. Browser creation happens without
+ * m_poolMutex held so claims never wait on helper IPC.
+ */
+void BrowserBridgeManager::warmPoolLoop()
+{
+    blog(LOG_INFO, "[browser-bridge] Warm pool started: %zu browsers at %dx%d@%dfps",
+         m_warmPoolTarget, m_warmWidth, m_warmHeight, m_warmFps);
+
+    std::unique_lock<std::mutex> lock(m_poolMutex);
+    while (m_poolRunning.load()) {
+        bool unmapped = false;
+        for (auto &warm : m_warmPool) {
+            if (!warm.shmReader->isConnected() && !warm.shmReader->connect()) {
+                unmapped = true;
+            }
+        }
+
+        if (m_warmPool.size() >= m_warmPoolTarget) {
+            if (unmapped) {
+                m_poolCv.wait_for(lock, std::chrono::milliseconds(100));
+            } else {
+                m_poolCv.wait(lock);
+            }
+            continue;
+        }
+
+        std::string browserId = generateWarmBrowserId();
+        lock.unlock();
+
+        bool created = initBrowser(browserId, "about:blank", m_warmWidth, m_warmHeight,
+                                   m_warmFps, std::string());
+        if (created) {
+            // Known browser without subscribers: IPC frames are dropped quietly
+            updateRoutes([&browserId](RouteMap &routes) {
+                routes.emplace(browserId, std::vector<BrowserBridgeSource *>());
+            });
+        }
+
+        lock.lock();
+        if (!created) {
+            // Helper not reachable; retry later instead of spinning
+            m_poolCv.wait_for(lock, std::chrono::seconds(1));
+            continue;
         }
+
+        m_poolCreated.fetch_add(1);
+        m_warmPool.push_back({browserId, std::make_unique<BrowserShmReader>(browserId)});
+    }
+
+    blog(LOG_INFO, "[browser-bridge] Warm pool thread exiting");
+}
+
+bool BrowserBridgeManager::claimWarmBrowser(int width, int height, int fps,
+                                            std::string &browserId,
+                                            std::unique_ptr<BrowserShmReader> &shmReader)
+{
+    if (m_warmPoolTarget == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+
+    if (width != m_warmWidth || height != m_warmHeight || fps != m_warmFps ||
+        m_warmPool.empty()) {
+        m_poolMisses.fetch_add(1);
+        blog(LOG_INFO, "[browser-bridge] Warm pool miss for %dx%d@%dfps (idle=%zu)",
+             width, height, fps, m_warmPool.size());
+        return false;
     }
 
-    if (source) {
-        source->receiveFrame(data, size, width, height);
+    // Prefer a browser whose SHM segment is already mapped
+    auto it = std::find_if(m_warmPool.begin(), m_warmPool.end(),
+                           [](const WarmBrowser &warm) {
+                               return warm.shmReader->isConnected();
+                           });
+    if (it == m_warmPool.end()) {
+        it = m_warmPool.begin();
     }
+
+    browserId = it->browserId;
+    shmReader = std::move(it->shmReader);
+    m_warmPool.erase(it);
+    m_poolHits.fetch_add(1);
+    m_poolCv.notify_one();
+
+    blog(LOG_INFO, "[browser-bridge] Warm pool hit: %s (hits=%llu misses=%llu idle=%zu)",
+         browserId.c_str(), static_cast<unsigned long long>(m_poolHits.load()),
+         static_cast<unsigned long long>(m_poolMisses.load()), m_warmPool.size());
+    return true;
+}
+
+WarmPoolStats BrowserBridgeManager::warmPoolStats() const
+{
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    return {m_poolHits.load(), m_poolMisses.load(), m_poolCreated.load(), m_warmPool.size()};
 }
 
 std::string BrowserBridgeManager::resolveHelperPath()
@@ -489,26 +1721,25 @@ std::string BrowserBridgeManager::resolveHelperPath()
     return "";
 }
 
-bool BrowserBridgeManager::launchHelper()
+bool BrowserBridgeManager::launchHelper(HelperShard &shard)
 {
 #ifdef __APPLE__
     // Build command line with port argument
     fs::path helperBinary =
         fs::path(m_helperPath) / "Contents" / "MacOS" / "streamlumo-browser-helper";
     std::string binaryStr = helperBinary.string();
-    std::string portArg = "--port=" + std::to_string(m_port);
+    std::string portArg = "--port=" + std::to_string(shard.port);
     const char *argv[] = {binaryStr.c_str(), portArg.c_str(), nullptr};
 
     pid_t pid;
-    int status = posix_spawn(&pid, binaryStr.c_str(), nullptr, nullptr,
-                             const_cast<char *const *>(argv), environ);
+    int status = spawnHelperProcess(&pid, binaryStr.c_str(), const_cast<char *const *>(argv));
     if (status != 0) {
         blog(LOG_ERROR, "[browser-bridge] posix_spawn failed: %d", status);
         return false;
     }
 
-    m_helperPid = pid;
-    blog(LOG_INFO, "[browser-bridge] Launched helper pid=%d port=%u", pid, m_port);
+    shard.pid = pid;
+    blog(LOG_INFO, "[browser-bridge] Launched helper pid=%d port=%u", pid, shard.port);
     return true;
 
 #elif defined(_WIN32)
@@ -517,7 +1748,7 @@ bool BrowserBridgeManager::launchHelper()
     PROCESS_INFORMATION pi = {};
 
     std::wstring cmdLine = std::wstring(m_helperPath.begin(), m_helperPath.end()) +
-                           L" --port=" + std::to_wstring(m_port);
+                           L" --port=" + std::to_wstring(shard.port);
 
     if (!CreateProcessW(nullptr, cmdLine.data(), nullptr, nullptr, FALSE,
                         CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) {
@@ -527,47 +1758,79 @@ bool BrowserBridgeManager::launchHelper()
     }
 
     CloseHandle(pi.hThread);
-    m_helperProcess = pi.hProcess;
+    shard.process = pi.hProcess;
     blog(LOG_INFO, "[browser-bridge] Launched helper pid=%lu port=%u", 
-         pi.dwProcessId, m_port);
+         pi.dwProcessId, shard.port);
     return true;
 
 #else
     // Linux
-    std::string portArg = "--port=" + std::to_string(m_port);
+    std::string portArg = "--port=" + std::to_string(shard.port);
     const char *argv[] = {m_helperPath.c_str(), portArg.c_str(), nullptr};
 
     pid_t pid;
-    int status = posix_spawn(&pid, m_helperPath.c_str(), nullptr, nullptr,
-                             const_cast<char *const *>(argv), environ);
+    int status = spawnHelperProcess(&pid, m_helperPath.c_str(), const_cast<char *const *>(argv));
     if (status != 0) {
         blog(LOG_ERROR, "[browser-bridge] posix_spawn failed: %d", status);
         return false;
     }
 
-    m_helperPid = pid;
-    blog(LOG_INFO, "[browser-bridge] Launched helper pid=%d port=%u", pid, m_port);
+    shard.pid = pid;
+    blog(LOG_INFO, "[browser-bridge] Launched helper pid=%d port=%u", pid, shard.port);
     return true;
 #endif
 }
 
-void BrowserBridgeManager::stopHelper()
+/**
+ * Asks the engine's helper health monitor to restart the helper on this
+ * shard's port. Called from the monitor thread.
+ * 
+ * @return true if the engine owns that helper and took the request
+ */
+bool BrowserBridgeManager::requestEngineRestart(HelperShard &shard)
+{
+    calldata_t cd;
+    calldata_init(&cd);
+    calldata_set_int(&cd, "port", shard.port);
+    bool called = proc_handler_call(obs_get_proc_handler(), "streamlumo_browser_helper_restart", &cd);
+    bool accepted = called && calldata_bool(&cd, "accepted");
+    calldata_free(&cd);
+
+    blog(LOG_WARNING, "[browser-bridge] Helper %zu (port %u) unreachable; %s",
+         shard.index, shard.port,
+         accepted ? "asked the engine to restart it" : "launching our own");
+    return accepted;
+}
+
+void BrowserBridgeManager::stopHelper(HelperShard &shard)
 {
 #ifdef _WIN32
-    if (m_helperProcess) {
-        TerminateProcess(m_helperProcess, 0);
-        WaitForSingleObject(m_helperProcess, 3000);
-        CloseHandle(m_helperProcess);
-        m_helperProcess = nullptr;
+    if (shard.process) {
+        TerminateProcess(shard.process, 0);
+        WaitForSingleObject(shard.process, 3000);
+        CloseHandle(shard.process);
+        shard.process = nullptr;
     }
 #else
-    if (m_helperPid <= 0) {
+    if (shard.pid <= 0) {
         return;
     }
-    kill(m_helperPid, SIGTERM);
+    // Same 3 s grace as on Windows, then SIGKILL; a helper stuck in CEF
+    // shutdown must not hang the monitor or plugin unload
+    kill(shard.pid, SIGTERM);
     int status;
-    waitpid(m_helperPid, &status, 0);
-    m_helperPid = -1;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    pid_t reaped = waitpid(shard.pid, &status, WNOHANG);
+    while (reaped == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        reaped = waitpid(shard.pid, &status, WNOHANG);
+    }
+    if (reaped == 0) {
+        blog(LOG_WARNING, "[browser-bridge] Helper %d ignored SIGTERM; killing it", shard.pid);
+        kill(shard.pid, SIGKILL);
+        waitpid(shard.pid, &status, 0);
+    }
+    shard.pid = -1;
 #endif
 
     blog(LOG_INFO, "[browser-bridge] Helper stopped");
@@ -9,7 +9,7 @@
  * 
  * The BrowserBridgeManager is a singleton that:
  * 1. Launches/manages the browser-helper process
- * 2. Maintains the TCP IPC connection on port 4777
+ * 2. Maintains the TCP IPC connection(s), starting at port 4777
  * 3. Routes frame data to the correct browser source instances
  * 
  * ## Authentication
@@ -18,11 +18,90 @@
  * environment variable and includes it in all IPC messages. Without the
  * correct token, the helper rejects commands with "unauthorized" errors.
  * 
+ * ## Shared Browsers
+ * 
+ * Sources with the `share_browser` property enabled derive their browser ID
+ * from (url, width, height, fps, css) via sharedBrowserId(). Every source with
+ * the same key subscribes to the same helper browser and SHM segment; the
+ * manager reference-counts initBrowser/disposeBrowser calls so the helper
+ * browser is created by the first subscriber and disposed with the last.
+ * The subscribers also share one SHM reader (acquireSharedReader()), so
+ * each frame is copied out of the segment once and the triple buffer keeps
+ * its single consumer.
+ * 
+ * ## Warm Pool
+ * 
+ * When BROWSER_BRIDGE_WARM_POOL is set to N > 0 the manager keeps N idle
+ * helper browsers (about:blank, SHM segment already mapped) pre-sized to
+ * BROWSER_BRIDGE_WARM_POOL_SIZE ("<width>x<height>@<fps>", default
+ * 1920x1080@30). A non-shared source whose size and fps match claims one in
+ * claimWarmBrowser() and navigates it instead of paying for browser creation;
+ * a background thread refills the pool after every claim.
+ * 
+ * ## Helper Shards
+ * 
+ * BROWSER_BRIDGE_HELPERS (default 1) sets how many helper processes to run,
+ * on ports BROWSER_HELPER_PORT (default 4777) + 0..N-1. Each new browser is
+ * placed on the live helper with the lowest requested pixel rate
+ * (width * height * fps, ties broken by browser count), so heavy pages spread
+ * across processes and cores. A monitor thread notices a helper whose
+ * connection dropped (woken immediately by the IPC disconnect callback),
+ * replays its browsers on the remaining helpers and reconnects/restarts it
+ * with exponential backoff (250 ms to 30 s), re-handshaking and replaying
+ * any browsers still parked on it. A helper the engine launched stays the
+ * engine's: after a few failed reconnects the manager asks the engine's
+ * health monitor to restart it (`streamlumo_browser_helper_restart` proc)
+ * and keeps reconnecting, launching its own helper only when no engine
+ * answers. Sources are told via
+ * onConnectionLost()/onConnectionEstablished() and log their
+ * time-to-first-frame after recovery.
+ * helperLoads() reports per-helper load.
+ * 
+ * If no helper can be reached at startup the monitor still runs and keeps
+ * retrying with the same backoff. Queued initBrowser requests are dropped
+ * and their sources told (onBrowserDropped()); once a helper connects,
+ * they are asked to initialize again (onHelperAvailable()).
+ * 
+ * ## Idle Mode
+ * 
+ * setProducersPaused() (exposed to the engine as the
+ * `browser_bridge_set_paused` proc) turns idle mode on or off. While it is
+ * on, every browser none of whose sources is showing gets the
+ * pause_requested flag in its SHM header; browsers still shown (on an extra
+ * canvas that keeps rendering while the program is detached) run on. Sources
+ * report show/hide through refreshProducerPause() and the monitor thread
+ * re-evaluates. The helper answers a set flag by dropping that browser to
+ * 1 fps and skipping frame writes until the flag is cleared. The pause is kept in
+ * the browser's record, so a browser replayed on another helper is created
+ * with the flag already set, and the manager remembers the mode, so browsers
+ * initialized while it is on (including queued ones) start paused as well.
+ * 
  * ## Thread Safety
  * 
  * All public methods are thread-safe via m_mutex. The IPC client runs
  * its own receive thread for non-blocking frame delivery.
  * 
+ * Helper startup (connect, launch, handshake) runs on its own thread started
+ * from obs_module_load(), never on the video thread. Until it finishes,
+ * initBrowser() queues requests and returns immediately.
+ * 
+ * initBrowser/updateBrowser/disposeBrowser never write to a socket either:
+ * they record the change and queue the command, and the monitor thread
+ * writes queued commands in order without m_mutex held. stopHelper() waits
+ * at most 3 s for a helper to exit before killing it.
+ * 
+ * Frame routing does not use m_mutex. The browserId -> subscribers map is an
+ * immutable RouteMap published through an atomic pointer; writers
+ * (registerSource/unregisterSource) copy, modify and publish a new map under
+ * m_routesMutex and retire the old one, which is freed by a later update once
+ * the readers of its epoch have left. Writers never wait for readers, so a
+ * source rebinding on the video thread is not held up by the IPC thread
+ * copying a large frame. dispatchFrame() delivers frames inside the read-side
+ * section; a source about to be destroyed calls synchronizeRoutes() after
+ * unregisterSource(), which waits out that grace period so no frame can reach
+ * it any more. A slow socket send in initBrowser/updateBrowser never stalls
+ * frame delivery.
+ * 
  * ## Usage
  * 
  * ```cpp
@@ -31,7 +110,8 @@
  * mgr.initBrowser("browser_123", "https://example.com", 1920, 1080, 30);
  * // Frames arrive via BrowserBridgeSource::receiveFrame()
  * mgr.disposeBrowser("browser_123");
- * mgr.unregisterSource("browser_123");
+ * mgr.unregisterSource("browser_123", this);
+ * mgr.synchronizeRoutes();  // before deleting the source
  * ```
  * 
  * @see IPCClient for TCP communication
@@ -41,6 +121,8 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -60,8 +142,28 @@ struct FrameData {
 };
 
 class BrowserBridgeSource;  // Forward declaration
+class BrowserShmReader;     // Forward declaration
+class SharedShmReader;      // Forward declaration
 class IPCClient;             // Forward declaration
 
+// Load of one helper process (shard), used for placement and monitoring
+struct HelperLoad {
+    uint16_t port;
+    bool alive;
+    size_t browsers;
+    uint64_t pixelRate;  // sum of width * height * fps of its browsers
+    uint64_t ipcFrames;  // frames received over IPC since startup
+    uint32_t restarts;
+};
+
+// Warm pool counters (claims served from the pool vs. cold creations)
+struct WarmPoolStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t created;
+    size_t idle;
+};
+
 class BrowserBridgeManager {
 public:
     // Singleton access
@@ -71,55 +173,201 @@ public:
     BrowserBridgeManager(const BrowserBridgeManager &) = delete;
     BrowserBridgeManager &operator=(const BrowserBridgeManager &) = delete;
 
-    // Initialize the manager (called on first browser source creation)
+    // Start connecting to / launching the helper in the background
+    // (called from obs_module_load, never blocks)
+    void startAsyncInit();
+
+    // Starts initialization if needed; true once the helper is connected
     bool ensureInitialized();
 
     // Shutdown (called on plugin unload)
     void shutdown();
 
     // Source registration (for frame routing)
+    // Several sources may subscribe to the same (shared) browserId.
     void registerSource(const std::string &browserId, BrowserBridgeSource *source);
-    void unregisterSource(const std::string &browserId);
+    void unregisterSource(const std::string &browserId, BrowserBridgeSource *source);
+
+    // Waits until no frame delivery that could still see an unregistered
+    // source is running; call before destroying the source (never blocks on
+    // m_routesMutex)
+    void synchronizeRoutes();
+
+    // Deterministic browser ID for sources that opt into browser sharing
+    static std::string sharedBrowserId(const std::string &url, int width, int height,
+                                       int fps, const std::string &css);
 
     // Browser instance management (called by sources)
+    // Shared browsers are reference-counted: only the first initBrowser and
+    // the last disposeBrowser for a browserId reach the helper.
+    // Before the helper is ready initBrowser queues the request and returns
+    // true; updateBrowser/disposeBrowser edit or drop queued requests.
     bool initBrowser(const std::string &browserId, const std::string &url,
-                     int width, int height, int fps);
+                     int width, int height, int fps, const std::string &css,
+                     bool shared = false);
     bool updateBrowser(const std::string &browserId, const std::string &url,
-                       int width, int height);
+                       int width, int height, const std::string &css);
     void disposeBrowser(const std::string &browserId);
 
-    // Check if helper is running
+    // The single SHM reader of a shared browser, created by its first
+    // subscriber and freed with the last reference
+    std::shared_ptr<SharedShmReader> acquireSharedReader(const std::string &browserId);
+
+    // Warm pool: hand an idle pre-created browser (and its already mapped
+    // SHM reader) to a source. Returns false on a pool miss.
+    bool claimWarmBrowser(int width, int height, int fps, std::string &browserId,
+                          std::unique_ptr<BrowserShmReader> &shmReader);
+    WarmPoolStats warmPoolStats() const;
+
+    // Check if helper is running (at least one shard connected)
     bool isHelperRunning() const;
 
+    // Per-helper load, one entry per shard
+    std::vector<HelperLoad> helperLoads() const;
+
+    // Engine idle mode: ask every helper browser that no source is showing
+    // to stop producing frames through its SHM segment (or resume them all)
+    void setProducersPaused(bool paused);
+
+    // A source was shown or hidden; re-evaluates the pauses on the monitor
+    // thread while idle mode is on (cheap, called from the video thread)
+    void refreshProducerPause();
+
 private:
     BrowserBridgeManager();
     ~BrowserBridgeManager();
 
+    // Background startup (runs on m_initThread)
+    struct PendingInit {
+        std::string browserId;
+        std::string url;
+        std::string css;
+        int width;
+        int height;
+        int fps;
+    };
+    void initializeHelper();
+    void failPendingInits();
+    void retryDroppedInits();
+
+    // Helper shards: one helper process per port (m_port + index)
+    struct HelperShard {
+        size_t index{0};
+        uint16_t port{0};
+#ifdef _WIN32
+        void *process{nullptr}; // HANDLE on Windows
+#else
+        pid_t pid{-1};
+#endif
+        std::unique_ptr<IPCClient> ipc;
+        bool alive{false};
+        bool owned{false};  // we launched this helper (vs. the engine)
+        bool engineManaged{false};  // the engine's health monitor restarts it
+        uint32_t restarts{0};
+        uint32_t failures{0};
+        std::chrono::steady_clock::time_point nextRestart;
+        std::atomic<uint64_t> ipcFrames{0};
+    };
+
+    // What the helper was asked to create, so it can be recreated elsewhere
+    // exactly as it was, including a pause requested by setProducersPaused()
+    struct BrowserRecord {
+        std::string url;
+        std::string css;
+        int width;
+        int height;
+        int fps;
+        size_t shard;
+        bool paused{false};
+    };
+
+    void configureShards();
+    std::unique_ptr<IPCClient> connectShard(HelperShard &shard, bool allowLaunch,
+                                            const std::function<void(const char *)> &phase);
+    HelperShard *pickShard();
+    bool placeBrowser(const std::string &browserId, const std::string &url,
+                      int width, int height, int fps, const std::string &css);
+    std::string initBrowserLine(const std::string &browserId,
+                                const BrowserRecord &record) const;
+    bool sendInitBrowser(HelperShard &shard, const std::string &browserId,
+                         const BrowserRecord &record);
+    void queueLine(HelperShard &shard, std::string line);
+    void flushOutbox();
+    void migrateOrphans(std::vector<std::string> &moved);
+    void notifySources(const std::vector<std::string> &browserIds, bool established);
+    void monitorLoop();
+    void checkShards();
+    bool browserShowing(const std::string &browserId);
+    void applyProducerPause();
+    void logHelperLoads();
+
     // Helper process management
-    bool launchHelper();
-    void stopHelper();
+    bool launchHelper(HelperShard &shard);
+    bool requestEngineRestart(HelperShard &shard);
+    void stopHelper(HelperShard &shard);
     std::string resolveHelperPath();
 
-    // Frame routing
+    // Warm pool maintenance
+    struct WarmBrowser {
+        std::string browserId;
+        std::unique_ptr<BrowserShmReader> shmReader;
+    };
+    void configureWarmPool();
+    void startWarmPool();
+    void stopWarmPool();
+    void warmPoolLoop();
+
+    // Frame routing (RCU-style, see "Thread Safety" above)
+    using RouteMap = std::unordered_map<std::string, std::vector<BrowserBridgeSource *>>;
+    void updateRoutes(const std::function<void(RouteMap &)> &mutate);
+    void reclaimRoutes();
+    uint64_t pinRoutes();
+    void unpinRoutes(uint64_t epoch);
     void dispatchFrame(const std::string &browserId, const uint8_t *data,
                        size_t size, int width, int height);
 
     // State
     std::atomic<bool> m_initialized{false};
     std::atomic<bool> m_running{false};
-    std::mutex m_mutex;
+    std::atomic<bool> m_initPending{false};
+    mutable std::mutex m_mutex;
+    std::thread m_initThread;
 
-    // Helper process
-#ifdef _WIN32
-    void *m_helperProcess{nullptr}; // HANDLE on Windows
-#else
-    pid_t m_helperPid{-1};
-#endif
+    // initBrowser requests made before the helper was ready (guarded by m_mutex)
+    std::vector<PendingInit> m_pendingInits;
+
+    // Browser IDs whose init was dropped or refused because no helper could
+    // be started; re-requested from their sources when one connects
+    // (guarded by m_mutex)
+    std::vector<std::string> m_droppedInits;
+
+    // Helper processes (shards), fixed after configureShards(); guarded by
+    // m_mutex except for process handles, which only the init and monitor
+    // threads touch
     uint16_t m_port{4777};
     std::string m_helperPath;
+    std::vector<std::unique_ptr<HelperShard>> m_shards;
+
+    // Every browser sent to a helper, by browserId (guarded by m_mutex)
+    std::unordered_map<std::string, BrowserRecord> m_browsers;
 
-    // IPC
-    std::unique_ptr<IPCClient> m_ipcClient;
+    // init/update/dispose commands waiting for the monitor thread to write
+    // them (guarded by m_mutex)
+    struct OutboundLine {
+        size_t shard;
+        std::string line;
+    };
+    std::vector<OutboundLine> m_outbox;
+
+    // Engine idle mode (setProducersPaused); browsers placed while it is on
+    // are created paused unless shown (written under m_mutex)
+    std::atomic<bool> m_producersPaused{false};
+    std::atomic<bool> m_pauseDirty{false};
+
+    // Shard health monitor (detects dead helpers, migrates, restarts)
+    std::thread m_monitorThread;
+    std::condition_variable m_monitorCv;
+    std::atomic<bool> m_monitorRunning{false};
     
     /**
      * Authentication token from BROWSER_HELPER_TOKEN environment variable.
@@ -134,8 +382,37 @@ private:
     std::string m_authToken;
 
     // Registered browser sources (for frame routing)
-    // Key is browserId, value is the source pointer
-    std::unordered_map<std::string, BrowserBridgeSource *> m_sources;
+    // Key is browserId, value is every source subscribed to that browser.
+    // Readers pin an epoch slot in m_routeReaders; writers hold m_routesMutex.
+    // Replaced tables wait in m_retiredRoutes (epoch they were retired in,
+    // guarded by m_routesMutex) until their slot drains.
+    std::mutex m_routesMutex;
+    std::atomic<const RouteMap *> m_routes{nullptr};
+    std::atomic<uint64_t> m_routeEpoch{0};
+    std::atomic<int> m_routeReaders[2] = {{0}, {0}};
+    std::vector<std::pair<uint64_t, const RouteMap *>> m_retiredRoutes;
+
+    // Live shared browsers: browserId -> number of initialized subscribers
+    std::unordered_map<std::string, int> m_sharedBrowsers;
+
+    // SHM readers of shared browsers, one per browserId (guarded by
+    // m_sharedReadersMutex, which is never held with another lock)
+    std::mutex m_sharedReadersMutex;
+    std::unordered_map<std::string, std::weak_ptr<SharedShmReader>> m_sharedReaders;
+
+    // Warm pool (guarded by m_poolMutex, never held together with m_mutex)
+    size_t m_warmPoolTarget{0};
+    int m_warmWidth{1920};
+    int m_warmHeight{1080};
+    int m_warmFps{30};
+    mutable std::mutex m_poolMutex;
+    std::condition_variable m_poolCv;
+    std::vector<WarmBrowser> m_warmPool;
+    std::thread m_poolThread;
+    std::atomic<bool> m_poolRunning{false};
+    std::atomic<uint64_t> m_poolHits{0};
+    std::atomic<uint64_t> m_poolMisses{0};
+    std::atomic<uint64_t> m_poolCreated{0};
 };
 
 } // namespace browser_bridge
@@ -7,6 +7,7 @@
 #include "browser-bridge-source.hpp"
 #include "browser-bridge-manager.hpp"
 #include "BrowserShmReader.h"
+#include "trace-scope.hpp"
 #include <obs-module.h>
 #include <graphics/graphics.h>
 #include <util/platform.h>
@@ -86,6 +87,7 @@ void BrowserBridgeSource::getDefaults(obs_data_t *settings) {
     obs_data_set_default_string(settings, "css", "");
     obs_data_set_default_bool(settings, "shutdown_on_hidden", false);
     obs_data_set_default_bool(settings, "restart_on_active", false);
+    obs_data_set_default_bool(settings, "share_browser", false);
     // Match OBS browser source default frame pacing (60 fps) for smoother video sources
     obs_data_set_default_int(settings, "fps", 60);
 }
@@ -100,6 +102,7 @@ obs_properties_t *BrowserBridgeSource::getProperties(void *) {
     obs_properties_add_bool(props, "shutdown_on_hidden", obs_module_text("ShutdownOnHidden"));
     obs_properties_add_bool(props, "restart_on_active", obs_module_text("RestartOnActive"));
     obs_properties_add_int(props, "fps", obs_module_text("FPS"), 1, 120, 1);
+    obs_properties_add_bool(props, "share_browser", obs_module_text("ShareBrowser"));
     
     return props;
 }
@@ -116,6 +119,23 @@ uint32_t BrowserBridgeSource::getHeight(void *data) {
 
 void BrowserBridgeSource::videoTick(void *data, float) {
     auto *self = static_cast<BrowserBridgeSource *>(data);
+    BB_TRACE_SCOPE("video_tick");
+    
+    // Apply browser ID changes (shared key changed) before anything reads SHM
+    if (self->m_pendingRebind.exchange(false)) {
+        std::string browserId;
+        {
+            std::lock_guard<std::mutex> lock(self->m_rebindMutex);
+            browserId = std::move(self->m_pendingBrowserId);
+        }
+        self->rebindBrowser(browserId);
+    }
+    
+    // Our queued init was dropped because no helper came up; forget it
+    // here, on the thread that sets the flag, so initBrowser() runs again
+    if (self->m_browserDropped.exchange(false)) {
+        self->m_browserInitialized.store(false);
+    }
     
     // Handle pending browser initialization FIRST
     if (self->m_pendingInit.load()) {
@@ -124,8 +144,19 @@ void BrowserBridgeSource::videoTick(void *data, float) {
         self->m_pendingInit.store(false);
     }
     
+    // Browser was recreated by another helper: remap its SHM segment
+    if (self->m_shmResetPending.exchange(false)) {
+        if (self->m_shmReader) {
+            self->m_shmReader->disconnect();
+        } else if (self->m_sharedReader) {
+            self->m_sharedReader->reset();
+        }
+    }
+    
     // Prefer SHM transport (zero-copy) over IPC callback
-    if (self->m_useShmTransport.load() && self->m_shmReader) {
+    if (self->m_useShmTransport.load() && self->m_sharedReader) {
+        self->updateTextureFromSharedShm();
+    } else if (self->m_useShmTransport.load() && self->m_shmReader) {
         self->updateTextureFromShm();
     } else {
         // Fallback to IPC-based frame updates
@@ -177,6 +208,7 @@ void BrowserBridgeSource::deactivate(void *data) {
 void BrowserBridgeSource::show(void *data) {
     auto *self = static_cast<BrowserBridgeSource *>(data);
     self->m_visible.store(true);
+    BrowserBridgeManager::instance().refreshProducerPause();
     
     if (!self->m_browserInitialized.load()) {
         self->m_pendingInit.store(true);
@@ -186,6 +218,7 @@ void BrowserBridgeSource::show(void *data) {
 void BrowserBridgeSource::hide(void *data) {
     auto *self = static_cast<BrowserBridgeSource *>(data);
     self->m_visible.store(false);
+    BrowserBridgeManager::instance().refreshProducerPause();
     
     if (self->m_shutdownOnHidden && self->m_browserInitialized.load()) {
         self->disposeBrowser();
@@ -198,18 +231,16 @@ void BrowserBridgeSource::hide(void *data) {
 
 BrowserBridgeSource::BrowserBridgeSource(obs_data_t *settings, obs_source_t *source)
     : m_source(source)
-    , m_browserId(generateBrowserId())
 {
     applySettings(settings);
     
-    // Create SHM reader for zero-copy frame transport
-    m_shmReader = std::make_unique<BrowserShmReader>(m_browserId);
-    
     // Pre-allocate frame buffer for SHM reads (max 1920x1080x4)
     m_shmFrameBuffer.resize(1920 * 1080 * 4);
     
-    // Register with manager
-    BrowserBridgeManager::instance().registerSource(m_browserId, this);
+    // Pick our browser ID (shared or unique), create the SHM reader for
+    // zero-copy frame transport and register with the manager
+    rebindBrowser(resolveBrowserId());
+    m_pendingRebind.store(false);
     
     // Initialize browser on first show
     m_pendingInit.store(true);
@@ -221,14 +252,17 @@ BrowserBridgeSource::~BrowserBridgeSource() {
         m_shmReader->disconnect();
         m_shmReader.reset();
     }
+    m_sharedReader.reset();
     
     // Dispose browser
     if (m_browserInitialized.load()) {
         disposeBrowser();
     }
     
-    // Unregister from manager
-    BrowserBridgeManager::instance().unregisterSource(m_browserId);
+    // Unregister from manager and wait out frame deliveries that may still
+    // hold a pointer to us
+    BrowserBridgeManager::instance().unregisterSource(m_browserId, this);
+    BrowserBridgeManager::instance().synchronizeRoutes();
     
     // Clean up texture on graphics thread
     obs_enter_graphics();
@@ -251,15 +285,13 @@ void BrowserBridgeSource::applySettings(obs_data_t *settings) {
     bool newShutdownOnHidden = obs_data_get_bool(settings, "shutdown_on_hidden");
     bool newRestartOnActive = obs_data_get_bool(settings, "restart_on_active");
     int newFps = static_cast<int>(obs_data_get_int(settings, "fps"));
+    bool newShareBrowser = obs_data_get_bool(settings, "share_browser");
     
     // Check if we need to update the browser (URL or size changed)
     bool needsUpdate = m_browserInitialized.load() &&
                          (newUrl != m_url || newWidth != m_width || 
                           newHeight != m_height || newCss != m_css);
-    
-    std::string oldUrl = m_url;
-    int oldWidth = m_width;
-    int oldHeight = m_height;
+    bool sharingChanged = newShareBrowser != m_shareBrowser;
     
     m_url = newUrl;
     m_width = newWidth;
@@ -268,11 +300,79 @@ void BrowserBridgeSource::applySettings(obs_data_t *settings) {
     m_shutdownOnHidden = newShutdownOnHidden;
     m_restartOnActive = newRestartOnActive;
     m_fps = newFps;
+    m_shareBrowser = newShareBrowser;
+    
+    if (m_browserId.empty()) {
+        // Called from the constructor; the browser ID is assigned there
+        return;
+    }
+    
+    if (m_shareBrowser || sharingChanged) {
+        // Shared browsers are keyed by their settings, so any change moves
+        // this source to a different browser; leaving sharing mode moves it
+        // to a private one. The switch happens on the next video tick.
+        std::string browserId = resolveBrowserId();
+        if (browserId != m_browserId) {
+            std::lock_guard<std::mutex> lock(m_rebindMutex);
+            m_pendingBrowserId = browserId;
+            m_pendingRebind.store(true);
+        }
+        return;
+    }
     
     if (needsUpdate) {
         // Use updateBrowser instead of dispose+recreate to avoid race conditions
         blog(LOG_INFO, "[browser-bridge] Settings changed, sending updateBrowser");
-        BrowserBridgeManager::instance().updateBrowser(m_browserId, m_url, m_width, m_height);
+        BrowserBridgeManager::instance().updateBrowser(m_browserId, m_url, m_width, m_height, m_css);
+    }
+}
+
+std::string BrowserBridgeSource::resolveBrowserId() const {
+    if (m_shareBrowser) {
+        return BrowserBridgeManager::sharedBrowserId(m_url, m_width, m_height, m_fps, m_css);
+    }
+    return generateBrowserId();
+}
+
+/**
+ * Moves this source to a different helper browser.
+ * 
+ * Releases the current browser (the manager only disposes it in the helper
+ * once no other subscriber remains), re-registers for frame routing under
+ * the new ID and reopens the SHM reader. If a browser was running it is
+ * re-initialized on the next video tick.
+ */
+void BrowserBridgeSource::rebindBrowser(const std::string &browserId) {
+    auto &mgr = BrowserBridgeManager::instance();
+    bool wasInitialized = m_browserInitialized.load();
+    
+    if (!m_browserId.empty()) {
+        blog(LOG_INFO, "[browser-bridge] Rebinding source from %s to %s",
+             m_browserId.c_str(), browserId.c_str());
+        if (wasInitialized) {
+            disposeBrowser();
+        }
+        mgr.unregisterSource(m_browserId, this);
+    }
+    
+    if (m_shmReader) {
+        m_shmReader->disconnect();
+    }
+    
+    // Subscribers of a shared browser read its segment through one reader
+    m_browserId = browserId;
+    if (m_shareBrowser) {
+        m_shmReader.reset();
+        m_sharedReader = mgr.acquireSharedReader(m_browserId);
+        m_sharedSequence = 0;
+    } else {
+        m_sharedReader.reset();
+        m_shmReader = std::make_unique<BrowserShmReader>(m_browserId);
+    }
+    mgr.registerSource(m_browserId, this);
+    
+    if (wasInitialized) {
+        m_pendingInit.store(true);
     }
 }
 
@@ -282,12 +382,32 @@ void BrowserBridgeSource::initBrowser() {
         return;
     }
     
-    blog(LOG_INFO, "[browser-bridge] Initializing browser: id=%s url=%s size=%dx%d fps=%d",
-         m_browserId.c_str(), m_url.c_str(), m_width, m_height, m_fps);
-    
-    // Send init command to helper
-    bool success = BrowserBridgeManager::instance().initBrowser(
-        m_browserId, m_url, m_width, m_height, m_fps);
+    blog(LOG_INFO, "[browser-bridge] Initializing browser: id=%s url=%s size=%dx%d fps=%d%s",
+         m_browserId.c_str(), m_url.c_str(), m_width, m_height, m_fps,
+         m_shareBrowser ? " (shared)" : "");
+    
+    auto &mgr = BrowserBridgeManager::instance();
+    bool success = false;
+    
+    // Claim a pre-created browser from the warm pool when one fits; it only
+    // needs to be navigated, and its SHM segment is usually already mapped
+    std::string warmId;
+    std::unique_ptr<BrowserShmReader> warmReader;
+    if (!m_shareBrowser &&
+        mgr.claimWarmBrowser(m_width, m_height, m_fps, warmId, warmReader)) {
+        mgr.unregisterSource(m_browserId, this);
+        if (m_shmReader) {
+            m_shmReader->disconnect();
+        }
+        m_browserId = warmId;
+        m_shmReader = std::move(warmReader);
+        mgr.registerSource(m_browserId, this);
+        success = mgr.updateBrowser(m_browserId, m_url, m_width, m_height, m_css);
+    } else {
+        // Send init command to helper (shared browsers only on first subscriber)
+        success = mgr.initBrowser(m_browserId, m_url, m_width, m_height, m_fps, m_css,
+                                  m_shareBrowser);
+    }
     
     if (success) {
         m_browserInitialized.store(true);
@@ -347,6 +467,7 @@ void BrowserBridgeSource::updateTexture() {
         return;
     }
     
+    BB_TRACE_SCOPE("texture_upload");
     obs_enter_graphics();
     
     // Recreate texture if size changed
@@ -371,6 +492,7 @@ void BrowserBridgeSource::updateTexture() {
     obs_leave_graphics();
     
     m_frameReady.store(false);
+    noteFrameUploaded();
 }
 
 void BrowserBridgeSource::updateTextureFromShm() {
@@ -396,11 +518,39 @@ void BrowserBridgeSource::updateTextureFromShm() {
     
     // Read frame from SHM
     int frameW = 0, frameH = 0;
-    if (!m_shmReader->readFrame(m_shmFrameBuffer.data(), m_shmFrameBuffer.size(), frameW, frameH)) {
-        return;
+    {
+        BB_TRACE_SCOPE("shm_acquire");
+        if (!m_shmReader->readFrame(m_shmFrameBuffer.data(), m_shmFrameBuffer.size(), frameW, frameH)) {
+            return;
+        }
     }
     
+    uploadFrame(m_shmFrameBuffer.data(), frameW, frameH);
+}
+
+/**
+ * Shared-browser variant of updateTextureFromShm(): the first subscriber to
+ * tick after the helper wrote a frame copies it out of SHM, every
+ * subscriber uploads that copy once.
+ */
+void BrowserBridgeSource::updateTextureFromSharedShm() {
+    bool connected;
+    {
+        BB_TRACE_SCOPE("shm_acquire");
+        connected = m_sharedReader->readLatest(m_sharedSequence,
+            [this](const uint8_t *pixels, int width, int height) {
+                uploadFrame(pixels, width, height);
+            });
+    }
+    if (!connected) {
+        // SHM not ready yet (helper hasn't created it)
+        updateTexture();
+    }
+}
+
+void BrowserBridgeSource::uploadFrame(const uint8_t *pixels, int frameW, int frameH) {
     // Update OBS texture
+    BB_TRACE_SCOPE("texture_upload");
     obs_enter_graphics();
     
     // Recreate texture if size changed
@@ -418,22 +568,64 @@ void BrowserBridgeSource::updateTextureFromShm() {
     
     // Update texture data directly from SHM buffer - zero-copy to GPU
     size_t expectedSize = static_cast<size_t>(frameW) * frameH * 4;
-    if (m_texture && m_shmFrameBuffer.size() >= expectedSize) {
-        gs_texture_set_image(m_texture, m_shmFrameBuffer.data(), frameW * 4, false);
+    if (m_texture && expectedSize <= SHM_FRAME_SIZE_READER) {
+        gs_texture_set_image(m_texture, pixels, frameW * 4, false);
     }
     
     obs_leave_graphics();
+    noteFrameUploaded();
 }
 
+/**
+ * Called by the manager (monitor thread) once this source's browser has been
+ * replayed to a reconnected or different helper. The manager already sent
+ * initBrowser, so we only reopen the SHM segment the new helper creates and
+ * start timing the first frame.
+ */
 void BrowserBridgeSource::onConnectionEstablished() {
-    // Re-initialize browser if it was previously active
-    if (m_browserInitialized.load()) {
+    m_shmResetPending.store(true);
+    m_recoveryStartNs.store(os_gettime_ns());
+}
+
+/**
+ * Called by the manager (monitor thread) when the helper rendering this
+ * source's browser went away. The last frame stays on screen until the
+ * browser is replayed; the manager keeps it initialized on our behalf.
+ */
+void BrowserBridgeSource::onConnectionLost() {
+    blog(LOG_WARNING, "[browser-bridge] Helper connection lost for %s, waiting for replay",
+         m_browserId.c_str());
+}
+
+/**
+ * Called by the manager (init thread) when the helper failed to start and
+ * the initBrowser it had queued for us was dropped. The browser does not
+ * exist anywhere; the next video tick clears our initialized flag.
+ */
+void BrowserBridgeSource::onBrowserDropped() {
+    m_browserDropped.store(true);
+}
+
+/**
+ * Called by the manager (monitor thread) when a helper finally connected
+ * after a failed startup. Re-requests the browser on the next video tick,
+ * unless it is hidden and only runs while shown.
+ */
+void BrowserBridgeSource::onHelperAvailable() {
+    if (m_visible.load() || !m_shutdownOnHidden) {
         m_pendingInit.store(true);
     }
 }
 
-void BrowserBridgeSource::onConnectionLost() {
-    m_browserInitialized.store(false);
+void BrowserBridgeSource::noteFrameUploaded() {
+    if (m_recoveryStartNs.load() == 0) {
+        return;
+    }
+    uint64_t start = m_recoveryStartNs.exchange(0);
+    if (start != 0) {
+        blog(LOG_INFO, "[browser-bridge] First frame for %s %.1f ms after helper recovery",
+             m_browserId.c_str(), (os_gettime_ns() - start) / 1e6);
+    }
 }
 
 } // namespace browser_bridge
@@ -17,6 +17,7 @@
 // Forward declaration
 namespace browser_bridge {
     class BrowserShmReader;
+    class SharedShmReader;
 }
 
 namespace browser_bridge {
@@ -35,6 +36,8 @@ namespace browser_bridge {
  *   - shutdown_on_hidden: Stop rendering when source is hidden
  *   - restart_on_active: Restart browser when source becomes active
  *   - fps: Target frame rate (default 30)
+ *   - share_browser: Share one helper browser with every other source that
+ *     has the same url/size/fps/css (one CEF render, many OBS sources)
  */
 class BrowserBridgeSource {
 public:
@@ -65,11 +68,18 @@ private:
     void applySettings(obs_data_t *settings);
     void initBrowser();
     void disposeBrowser();
+    void rebindBrowser(const std::string &browserId);
+    std::string resolveBrowserId() const;
     void receiveFrame(const uint8_t *data, size_t size, int width, int height);
     void updateTexture();
     void updateTextureFromShm();
+    void updateTextureFromSharedShm();
+    void uploadFrame(const uint8_t *pixels, int width, int height);
     void onConnectionEstablished();
     void onConnectionLost();
+    void onBrowserDropped();
+    void onHelperAvailable();
+    void noteFrameUploaded();
 
     // Friend for frame callback
     friend class BrowserBridgeManager;
@@ -86,6 +96,14 @@ private:
     bool m_shutdownOnHidden = false;
     bool m_restartOnActive = false;
     int m_fps = 30;
+    bool m_shareBrowser = false;
+    
+    // Browser ID change requested by applySettings(), applied on the
+    // graphics thread in videoTick() so the SHM reader is never swapped
+    // while it is being read
+    std::mutex m_rebindMutex;
+    std::string m_pendingBrowserId;
+    std::atomic<bool> m_pendingRebind{false};
     
     // Frame buffer (double-buffered for smooth updates)
     std::mutex m_frameMutex;
@@ -107,10 +125,16 @@ private:
     std::atomic<bool> m_visible{true};
     std::atomic<bool> m_browserInitialized{false};
     std::atomic<bool> m_pendingInit{false};
+    std::atomic<bool> m_browserDropped{false};  // Manager dropped our queued init
     
-    // Shared memory reader (zero-copy frame transport)
+    // Shared memory reader (zero-copy frame transport); a shared browser's
+    // subscribers use the manager's m_sharedReader instead
     std::unique_ptr<BrowserShmReader> m_shmReader;
+    std::shared_ptr<SharedShmReader> m_sharedReader;
+    uint64_t m_sharedSequence = 0;              // Last shared frame uploaded
     std::atomic<bool> m_useShmTransport{true};  // Enable SHM by default
+    std::atomic<bool> m_shmResetPending{false}; // Browser recreated by a helper
+    std::atomic<uint64_t> m_recoveryStartNs{0};  // Replay time, 0 = not recovering
     std::vector<uint8_t> m_shmFrameBuffer;      // Local buffer for SHM reads
 };
 
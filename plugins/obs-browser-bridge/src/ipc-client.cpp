@@ -50,6 +50,7 @@
 
 #include "ipc-client.hpp"
 #include "frame-decoder.hpp"
+#include "trace-scope.hpp"
 #include <obs.h>
 #include <cstring>
 #include <chrono>
@@ -93,6 +94,11 @@ void IPCClient::setFrameCallback(FrameCallback callback)
     m_frameCallback = std::move(callback);
 }
 
+void IPCClient::setDisconnectCallback(DisconnectCallback callback)
+{
+    m_disconnectCallback = std::move(callback);
+}
+
 bool IPCClient::connect(const std::string &host, uint16_t port, int timeoutMs)
 {
     if (m_connected.load()) {
@@ -274,6 +280,7 @@ bool IPCClient::sendLine(const std::string &json)
 void IPCClient::receiveLoop()
 {
     blog(LOG_INFO, "[ipc-client] Receive loop started");
+    traceSetThreadName("ipc-receive");
     
     char buf[262144]; // 256KB buffer for large frames
     
@@ -296,6 +303,10 @@ void IPCClient::receiveLoop()
         if (ret < 0) {
             if (!m_running.load()) break;
             blog(LOG_ERROR, "[ipc-client] poll/select failed");
+            m_connected.store(false);
+            if (m_disconnectCallback) {
+                m_disconnectCallback();
+            }
             break;
         }
         
@@ -313,6 +324,9 @@ void IPCClient::receiveLoop()
             if (!m_running.load()) break;
             blog(LOG_WARNING, "[ipc-client] Connection closed");
             m_connected.store(false);
+            if (m_disconnectCallback) {
+                m_disconnectCallback();
+            }
             break;
         }
 
@@ -393,6 +407,7 @@ void IPCClient::handleMessage(const std::string &json)
     std::string type = findStringValue("type");
     
     if (type == "frameReady") {
+        BB_TRACE_SCOPE("ipc_decode_frame");
         // Only log periodically to avoid performance impact
         static int frameCount = 0;
         if (++frameCount % 300 == 1) {
@@ -44,6 +44,10 @@ namespace browser_bridge {
 using FrameCallback = std::function<void(const std::string &, const uint8_t *, 
                                           size_t, int, int)>;
 
+// Callback invoked (from the receive thread) when the helper closes the
+// connection or the socket fails; not called for disconnect()
+using DisconnectCallback = std::function<void()>;
+
 class IPCClient {
 public:
     IPCClient();
@@ -56,6 +60,9 @@ public:
     // Set frame callback before connect
     void setFrameCallback(FrameCallback callback);
 
+    // Set disconnect callback before connect
+    void setDisconnectCallback(DisconnectCallback callback);
+
     // Connect to helper on localhost
     bool connect(const std::string &host, uint16_t port, int timeoutMs = 5000);
     void disconnect();
@@ -88,6 +95,7 @@ private:
     std::mutex m_writeMutex;
     std::thread m_receiveThread;
     FrameCallback m_frameCallback;
+    DisconnectCallback m_disconnectCallback;
 
 #ifdef _WIN32
     void *m_socket{nullptr}; // SOCKET on Windows
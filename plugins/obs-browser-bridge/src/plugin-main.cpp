@@ -5,6 +5,7 @@
 #include <obs-module.h>
 #include "browser-bridge-manager.hpp"
 #include "browser-bridge-source.hpp"
+#include "trace-scope.hpp"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE("obs-browser-bridge", "en-US")
@@ -19,13 +20,33 @@ MODULE_EXPORT const char *obs_module_description(void)
     return "Browser source using external helper process";
 }
 
+// proc: void browser_bridge_set_paused(in bool paused)
+// Called by the engine's idle governor when nothing consumes the output;
+// browsers still showing on some canvas keep producing
+static void setPausedProc(void *, calldata_t *cd)
+{
+    bool paused = calldata_bool(cd, "paused");
+    browser_bridge::BrowserBridgeManager::instance().setProducersPaused(paused);
+}
+
 MODULE_EXPORT bool obs_module_load(void)
 {
     blog(LOG_INFO, "[obs-browser-bridge] Loading plugin v%s", "1.0.0");
 
+    // Hook into streamlumo-engine's --trace-file tracing when hosted by it
+    browser_bridge::traceInit();
+
     // Register the browser source type
     browser_bridge_source_register();
 
+    // Connect to (or launch) the helper in the background so the first
+    // browser source never waits for it on the video thread
+    browser_bridge::BrowserBridgeManager::instance().startAsyncInit();
+
+    proc_handler_add(obs_get_proc_handler(),
+                     "void browser_bridge_set_paused(in bool paused)",
+                     setPausedProc, nullptr);
+
     blog(LOG_INFO, "[obs-browser-bridge] Plugin loaded successfully");
     return true;
 }
@@ -0,0 +1,79 @@
+/**
+ * @file trace-scope.hpp
+ * @brief Scoped timing events recorded into the engine's Chrome trace
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (C) 2024 StreamLumo
+ *
+ * ## Overview
+ *
+ * streamlumo-engine owns the trace buffers (--trace-file) and hands out a
+ * function table through the proc "streamlumo_trace_get_api". The plugin
+ * fetches it once in obs_module_load(); under any other OBS host the proc is
+ * missing and every BB_TRACE_SCOPE is a null-pointer check.
+ *
+ * TraceApi must stay layout-compatible with streamlumo::TraceApi in the
+ * engine's src/trace.h.
+ */
+
+#pragma once
+
+#include <obs-module.h>
+#include <cstdint>
+
+namespace browser_bridge {
+
+struct TraceApi {
+    uint32_t version;
+    bool (*enabled)(void);
+    uint64_t (*now)(void);
+    void (*complete)(const char *category, const char *name, uint64_t startNanos, uint64_t endNanos);
+    void (*setThreadName)(const char *name);
+};
+
+inline const TraceApi *g_traceApi = nullptr;
+
+inline void traceInit()
+{
+    calldata_t cd;
+    calldata_init(&cd);
+    if (proc_handler_call(obs_get_proc_handler(), "streamlumo_trace_get_api", &cd)) {
+        auto *api = static_cast<const TraceApi *>(calldata_ptr(&cd, "api"));
+        if (api && api->version >= 1) {
+            g_traceApi = api;
+        }
+    }
+    calldata_free(&cd);
+}
+
+inline void traceSetThreadName(const char *name)
+{
+    if (g_traceApi && g_traceApi->enabled()) {
+        g_traceApi->setThreadName(name);
+    }
+}
+
+class TraceScope {
+public:
+    explicit TraceScope(const char *name)
+        : m_name(name), m_start(g_traceApi && g_traceApi->enabled() ? g_traceApi->now() : 0) {}
+    ~TraceScope()
+    {
+        if (m_start != 0) {
+            g_traceApi->complete("browser-bridge", m_name, m_start, g_traceApi->now());
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *m_name;
+    uint64_t m_start;
+};
+
+} // namespace browser_bridge
+
+#define BB_TRACE_CONCAT_INNER(a, b) a##b
+#define BB_TRACE_CONCAT(a, b) BB_TRACE_CONCAT_INNER(a, b)
+#define BB_TRACE_SCOPE(name) browser_bridge::TraceScope BB_TRACE_CONCAT(bb_trace_scope_, __LINE__)(name)
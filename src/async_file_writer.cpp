@@ -0,0 +1,293 @@
+// streamlumo-engine/src/async_file_writer.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "async_file_writer.h"
+#include "logging.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+namespace streamlumo {
+
+// A partly filled batch is handed to the writer after this long, so a
+// low-bitrate recording still reaches the disk regularly (buffered mode only:
+// direct I/O needs whole aligned blocks)
+static constexpr uint64_t kMaxBatchAgeNanos = 1000000000ULL;
+
+AsyncFileWriter::~AsyncFileWriter() {
+    stop();
+}
+
+bool AsyncFileWriter::start(const Options& options) {
+    if (m_thread.joinable()) {
+        return true;
+    }
+    m_options = options;
+    m_alignment = platform::getDirectIOAlignment();
+    m_options.batchBytes = (std::max(options.batchBytes, m_alignment) + m_alignment - 1) & ~(m_alignment - 1);
+    m_options.maxQueuedBytes = std::max(options.maxQueuedBytes, 2 * m_options.batchBytes);
+    m_stats = Stats();
+    m_stopping = false;
+    m_failed.store(false);
+    m_fileOffset = 0;
+    m_thread = std::thread(&AsyncFileWriter::writerMain, this);
+    return true;
+}
+
+void AsyncFileWriter::stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+    if (m_current && m_current->used > 0) {
+        submitCurrent();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    if (m_current) {
+        m_free.push_back(m_current);
+        m_current = nullptr;
+    }
+    for (Buffer* buffer : m_all) {
+        platform::alignedFree(buffer->data);
+        delete buffer;
+    }
+    m_all.clear();
+    m_free.clear();
+    m_queuedBytes = 0;
+}
+
+AsyncFileWriter::Stats AsyncFileWriter::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void AsyncFileWriter::open(const std::string& path) {
+    Command command;
+    command.kind = Command::Kind::Open;
+    command.path = path;
+    push(std::move(command));
+    m_fileOffset = 0;
+}
+
+void AsyncFileWriter::append(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_fileOffset += size;
+    while (size > 0) {
+        if (!m_current) {
+            m_current = takeBuffer();
+            m_current->firstNanos = platform::getTimestampNanos();
+        }
+        const size_t n = std::min(size, m_options.batchBytes - m_current->used);
+        memcpy(m_current->data + m_current->used, bytes, n);
+        m_current->used += n;
+        bytes += n;
+        size -= n;
+        if (m_current->used == m_options.batchBytes) {
+            submitCurrent();
+        }
+    }
+    if (m_current && !m_options.directIO &&
+        platform::getTimestampNanos() - m_current->firstNanos >= kMaxBatchAgeNanos) {
+        submitCurrent();
+    }
+}
+
+void AsyncFileWriter::closeFile(std::vector<Patch> patches, const std::string& sidecarPath,
+                                const std::string& sidecarText) {
+    if (m_current && m_current->used > 0) {
+        submitCurrent();
+    }
+    Command command;
+    command.kind = Command::Kind::Close;
+    command.patches = std::move(patches);
+    command.sidecarPath = sidecarPath;
+    command.sidecarText = sidecarText;
+    push(std::move(command));
+}
+
+AsyncFileWriter::Buffer* AsyncFileWriter::takeBuffer() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_free.empty() && (m_all.size() + 1) * m_options.batchBytes <= m_options.maxQueuedBytes) {
+        auto* buffer = new Buffer();
+        buffer->data = static_cast<uint8_t*>(platform::alignedAlloc(m_options.batchBytes, m_alignment));
+        if (buffer->data) {
+            m_all.push_back(buffer);
+            return buffer;
+        }
+        delete buffer;
+    }
+    if (m_free.empty()) {
+        // Every buffer is queued behind the disk: the only place the
+        // producer waits
+        const uint64_t waitStart = platform::getTimestampNanos();
+        m_freed.wait(lock, [this] { return !m_free.empty(); });
+        m_stats.stalls++;
+        m_stats.stallMicros += (platform::getTimestampNanos() - waitStart) / 1000;
+    }
+    Buffer* buffer = m_free.back();
+    m_free.pop_back();
+    buffer->used = 0;
+    return buffer;
+}
+
+void AsyncFileWriter::submitCurrent() {
+    Command command;
+    command.kind = Command::Kind::Data;
+    command.buffer = m_current;
+    m_current = nullptr;
+    push(std::move(command));
+}
+
+void AsyncFileWriter::push(Command command) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (command.buffer) {
+            m_queuedBytes += command.buffer->used;
+            m_stats.peakQueuedBytes = std::max<uint64_t>(m_stats.peakQueuedBytes, m_queuedBytes);
+        }
+        m_queue.push_back(std::move(command));
+    }
+    m_wake.notify_one();
+}
+
+void AsyncFileWriter::recycle(Buffer* buffer) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedBytes -= buffer->used;
+        m_free.push_back(buffer);
+    }
+    m_freed.notify_one();
+}
+
+void AsyncFileWriter::writerMain() {
+    platform::setThreadName("file-writer");
+    Trace::setThreadName("file-writer");
+
+    for (;;) {
+        Command command;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                break;
+            }
+            command = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        switch (command.kind) {
+        case Command::Kind::Open:
+            m_path = command.path;
+            m_fileBytes = 0;
+            m_fileWrites = 0;
+            m_fileMaxWriteMicros = 0;
+            m_file = platform::openFileForWrite(m_path, m_options.directIO);
+            m_fileDirect = m_options.directIO;
+            if (m_file == platform::kInvalidFile) {
+                fail("open");
+            }
+            break;
+        case Command::Kind::Data:
+            if (m_file != platform::kInvalidFile && !failed()) {
+                writeBuffer(*command.buffer);
+            }
+            recycle(command.buffer);
+            break;
+        case Command::Kind::Close:
+            finishFile(command);
+            break;
+        }
+    }
+
+    if (m_file != platform::kInvalidFile) {
+        finishFile(Command());
+    }
+}
+
+void AsyncFileWriter::writeBuffer(const Buffer& buffer) {
+    TRACE_SCOPE("io", "file_write");
+    const uint64_t start = platform::getTimestampNanos();
+
+    size_t direct = buffer.used;
+    if (m_fileDirect) {
+        // Only the last batch of a file can be short; its unaligned tail
+        // goes through the page cache
+        direct = buffer.used & ~(m_alignment - 1);
+    }
+    bool ok = platform::writeFile(m_file, buffer.data, direct);
+    if (!ok && m_fileDirect && errno == EINVAL) {
+        log_warn("File writer: %s does not support direct I/O, continuing buffered", m_path.c_str());
+        m_fileDirect = !platform::setFileDirectIO(m_file, false);
+        ok = !m_fileDirect && platform::writeFile(m_file, buffer.data, direct);
+    }
+    if (ok && direct < buffer.used) {
+        if (m_fileDirect && platform::setFileDirectIO(m_file, false)) {
+            m_fileDirect = false;
+        }
+        ok = platform::writeFile(m_file, buffer.data + direct, buffer.used - direct);
+    }
+    if (!ok) {
+        fail("write");
+        return;
+    }
+
+    const uint64_t micros = (platform::getTimestampNanos() - start) / 1000;
+    m_fileBytes += buffer.used;
+    m_fileWrites++;
+    m_fileMaxWriteMicros = std::max(m_fileMaxWriteMicros, micros);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.bytesWritten += buffer.used;
+    m_stats.writes++;
+    m_stats.totalWriteMicros += micros;
+    m_stats.maxWriteMicros = std::max(m_stats.maxWriteMicros, micros);
+}
+
+void AsyncFileWriter::finishFile(const Command& command) {
+    if (m_file == platform::kInvalidFile) {
+        return;
+    }
+    if (!command.patches.empty() && !failed()) {
+        if (m_fileDirect) {
+            platform::setFileDirectIO(m_file, false);
+            m_fileDirect = false;
+        }
+        for (const Patch& patch : command.patches) {
+            if (!platform::writeFileAt(m_file, patch.offset, patch.bytes.data(), patch.bytes.size())) {
+                fail("patch");
+                break;
+            }
+        }
+    }
+    platform::closeFile(m_file);
+    m_file = platform::kInvalidFile;
+
+    if (!command.sidecarPath.empty()) {
+        std::ofstream sidecar(command.sidecarPath, std::ios::binary | std::ios::trunc);
+        sidecar << command.sidecarText;
+        if (!sidecar) {
+            log_warn("File writer: could not write %s", command.sidecarPath.c_str());
+        }
+    }
+
+    log_info("File writer: closed %s (%.1f MB in %llu writes, slowest %.1f ms)", m_path.c_str(),
+             m_fileBytes / 1048576.0, static_cast<unsigned long long>(m_fileWrites),
+             m_fileMaxWriteMicros / 1000.0);
+}
+
+void AsyncFileWriter::fail(const char* what) {
+    if (!m_failed.exchange(true)) {
+        log_error("File writer: %s failed for %s: %s", what, m_path.c_str(), strerror(errno));
+    }
+}
+
+} // namespace streamlumo
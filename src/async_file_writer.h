@@ -0,0 +1,140 @@
+// streamlumo-engine/src/async_file_writer.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include "platform/platform.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Writes a stream of files from a dedicated thread in large batches
+ *
+ * The producer (an output's encoded-packet callback) only copies bytes into
+ * the current batch buffer; full batches are queued to the writer thread,
+ * which writes each one with a single syscall. A disk latency spike grows the
+ * queue, up to Options::maxQueuedBytes, instead of stalling the producer; only
+ * past that limit does append() wait for the disk (counted as a stall).
+ *
+ * Files are written one after another: open(), append()..., closeFile(),
+ * open() the next one. All producer calls must come from one thread at a time.
+ */
+class AsyncFileWriter {
+public:
+    struct Options {
+        size_t batchBytes = 4 * 1024 * 1024;          // Rounded up to the direct-I/O alignment
+        size_t maxQueuedBytes = 128 * 1024 * 1024;    // Buffers allocated before append() blocks
+        bool directIO = false;                        // Bypass the page cache where supported
+    };
+
+    // Bytes overwritten in place when the file is closed (header fields
+    // such as duration that are only known at the end)
+    struct Patch {
+        uint64_t offset = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct Stats {
+        uint64_t bytesWritten = 0;
+        uint64_t writes = 0;
+        uint64_t totalWriteMicros = 0;
+        uint64_t maxWriteMicros = 0;
+        uint64_t stalls = 0;              // append() calls that waited for the disk
+        uint64_t stallMicros = 0;
+        uint64_t peakQueuedBytes = 0;
+    };
+
+    AsyncFileWriter() = default;
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    bool start(const Options& options);
+
+    // Writes out everything queued, closes the current file and joins the thread
+    void stop();
+
+    void open(const std::string& path);
+    void append(const void* data, size_t size);
+
+    /**
+     * @brief Queue the close of the current file
+     * @param sidecarPath Small companion file written after the close (empty = none)
+     */
+    void closeFile(std::vector<Patch> patches, const std::string& sidecarPath = std::string(),
+                   const std::string& sidecarText = std::string());
+
+    // Bytes appended to the current file so far (producer side)
+    uint64_t fileOffset() const { return m_fileOffset; }
+
+    // Set once a write fails; later data is discarded
+    bool failed() const { return m_failed.load(std::memory_order_relaxed); }
+
+    Stats stats() const;
+
+private:
+    struct Buffer {
+        uint8_t* data = nullptr;
+        size_t used = 0;
+        uint64_t firstNanos = 0;    // When the first byte was appended
+    };
+
+    struct Command {
+        enum class Kind { Open, Data, Close } kind = Kind::Data;
+        std::string path;
+        Buffer* buffer = nullptr;
+        std::vector<Patch> patches;
+        std::string sidecarPath;
+        std::string sidecarText;
+    };
+
+    Buffer* takeBuffer();
+    void submitCurrent();
+    void push(Command command);
+    void recycle(Buffer* buffer);
+    void writerMain();
+    void writeBuffer(const Buffer& buffer);
+    void finishFile(const Command& command);
+    void fail(const char* what);
+
+    Options m_options;
+    size_t m_alignment = 4096;
+
+    // Producer side
+    Buffer* m_current = nullptr;
+    uint64_t m_fileOffset = 0;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;          // Writer: command queued / stopping
+    std::condition_variable m_freed;         // Producer: buffer recycled
+    std::deque<Command> m_queue;
+    std::vector<Buffer*> m_free;
+    std::vector<Buffer*> m_all;
+    size_t m_queuedBytes = 0;
+    bool m_stopping = false;
+    Stats m_stats;
+    std::thread m_thread;
+
+    // Writer side
+    platform::FileHandle m_file = platform::kInvalidFile;
+    std::string m_path;
+    bool m_fileDirect = false;
+    uint64_t m_fileBytes = 0;
+    uint64_t m_fileWrites = 0;
+    uint64_t m_fileMaxWriteMicros = 0;
+
+    std::atomic<bool> m_failed{false};
+};
+
+} // namespace streamlumo
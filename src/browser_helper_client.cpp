@@ -77,13 +77,8 @@ bool BrowserHelperClient::start(uint16_t port, const std::string &token)
         log_warn("[helper] handshake_ack not received");
     }
 
-    // Send a ping to verify bidirectional flow.
-    std::string ping = "{\"type\":\"ping\",\"client\":\"streamlumo-engine\"";
-    if (!m_token.empty()) {
-        ping += ",\"token\":\"" + m_token + "\"";
-    }
-    ping += "}\n";
-    sendLine(ping);
+    // Send a ping to verify bidirectional flow (seq 0: not a health check ping).
+    sendPing(0, 0);
 
     return true;
 }
@@ -95,6 +90,7 @@ void BrowserHelperClient::stop()
         shutdown(m_fd, SHUT_RDWR);
         close(m_fd);
         m_fd = -1;
+        m_readBuffer.clear();
         log_info("[helper] disconnected from browser helper");
     }
 }
@@ -177,29 +173,55 @@ bool BrowserHelperClient::readLine(std::string &line, int timeoutMs)
     return true;
 }
 
-bool BrowserHelperClient::ping()
+bool BrowserHelperClient::sendPing(uint64_t seq, uint64_t timestampNanos)
 {
     if (m_fd < 0) {
         return false;
     }
     std::string ping = "{\"type\":\"ping\",\"client\":\"streamlumo-engine\"";
+    ping += ",\"seq\":" + std::to_string(seq) + ",\"ts\":" + std::to_string(timestampNanos);
     if (!m_token.empty()) {
         ping += ",\"token\":\"" + m_token + "\"";
     }
     ping += "}\n";
-    if (!sendLine(ping)) {
-        stop();
+    return sendLine(ping);
+}
+
+bool BrowserHelperClient::readLines(std::vector<std::string> &lines)
+{
+    if (m_fd < 0) {
         return false;
     }
 
-    std::string line;
-    if (!readLine(line, 500)) {
-        stop();
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = recv(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n > 0) {
+            m_readBuffer.append(buffer, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        log_warn("[helper] recv() failed (errno=%d)", errno);
         return false;
     }
-    if (line.find("pong") == std::string::npos) {
-        return false;
+
+    size_t start = 0;
+    size_t newline;
+    while ((newline = m_readBuffer.find('\n', start)) != std::string::npos) {
+        if (newline > start) {
+            lines.emplace_back(m_readBuffer, start, newline - start);
+        }
+        start = newline + 1;
     }
+    m_readBuffer.erase(0, start);
     return true;
 }
 
@@ -261,6 +283,16 @@ bool BrowserHelperClient::readLine(std::string &, int)
     return false;
 }
 
+bool BrowserHelperClient::sendPing(uint64_t, uint64_t)
+{
+    return false;
+}
+
+bool BrowserHelperClient::readLines(std::vector<std::string> &)
+{
+    return false;
+}
+
 bool BrowserHelperClient::sendShutdown()
 {
     return false;
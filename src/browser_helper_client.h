@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace streamlumo {
 
@@ -20,7 +21,14 @@ public:
     bool start(uint16_t port, const std::string &token);
     void stop();
     bool isConnected() const { return m_fd >= 0; }
-    bool ping();
+    int fd() const { return m_fd; }
+
+    // Non-blocking health check: sendPing() only writes the ping (the helper
+    // echoes seq/ts in its pong), and readLines() drains every complete line
+    // the helper sent once fd() is readable. readLines() returns false when
+    // the helper closed the connection.
+    bool sendPing(uint64_t seq, uint64_t timestampNanos);
+    bool readLines(std::vector<std::string> &lines);
     
     // Request graceful shutdown of the browser helper
     bool sendShutdown();
@@ -32,6 +40,7 @@ private:
 
     int m_fd{-1};
     std::string m_token;
+    std::string m_readBuffer;
 };
 
 } // namespace streamlumo
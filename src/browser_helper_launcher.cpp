@@ -128,7 +128,15 @@ bool BrowserHelperLauncher::launchProcess(const std::string &binaryPath)
 {
     pid_t pid = 0;
     const char *argv[] = {binaryPath.c_str(), nullptr};
-    int rc = posix_spawn(&pid, binaryPath.c_str(), nullptr, nullptr, const_cast<char **>(argv), environ);
+    // Start the helper with an empty signal mask so stop()'s SIGTERM reaches it
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    int rc = posix_spawn(&pid, binaryPath.c_str(), nullptr, &attr, const_cast<char **>(argv), environ);
+    posix_spawnattr_destroy(&attr);
     if (rc != 0) {
         log_warn("[helper] posix_spawn failed (%d) for %s", rc, binaryPath.c_str());
         return false;
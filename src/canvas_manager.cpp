@@ -0,0 +1,249 @@
+// streamlumo-engine/src/canvas_manager.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "canvas_manager.h"
+#include "logging.h"
+
+#include <graphics/vec2.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace streamlumo {
+
+namespace {
+
+bool nameTaken(const std::vector<obs_canvas_t*>& canvases, const char* name) {
+    return std::any_of(canvases.begin(), canvases.end(), [name](obs_canvas_t* canvas) {
+        const char* existing = obs_canvas_get_name(canvas);
+        return existing && std::strcmp(existing, name) == 0;
+    });
+}
+
+} // namespace
+
+CanvasManager::~CanvasManager() {
+    clear();
+}
+
+obs_canvas_t* CanvasManager::add(const char* name, const obs_video_info* ovi, int flags) {
+    if (!name || !*name) {
+        log_error("Canvas: a name is required");
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (nameTaken(m_canvases, name)) {
+            log_warn("Canvas '%s' already exists", name);
+            return nullptr;
+        }
+    }
+
+    obs_video_info main = {};
+    if (!obs_get_video_info(&main)) {
+        log_error("Canvas '%s': video is not initialized", name);
+        return nullptr;
+    }
+
+    // The graphics device is shared, and anything the caller left unset
+    // follows the main canvas
+    obs_video_info video = ovi ? *ovi : main;
+    video.graphics_module = main.graphics_module;
+    video.adapter = main.adapter;
+    if (!video.base_width || !video.base_height) {
+        video.base_width = main.base_width;
+        video.base_height = main.base_height;
+    }
+    if (!video.output_width || !video.output_height) {
+        video.output_width = video.base_width;
+        video.output_height = video.base_height;
+    }
+    if (!video.fps_num || !video.fps_den) {
+        video.fps_num = main.fps_num;
+        video.fps_den = main.fps_den;
+    }
+    if (video.output_format == VIDEO_FORMAT_NONE) video.output_format = main.output_format;
+    if (video.scale_type == OBS_SCALE_DISABLE) video.scale_type = main.scale_type;
+
+    // Mixes render on the main clock; anything but an integer divisor of the
+    // main rate comes out as uneven frame spacing
+    const uint64_t mainRate = static_cast<uint64_t>(main.fps_num) * video.fps_den;
+    const uint64_t canvasRate = static_cast<uint64_t>(video.fps_num) * main.fps_den;
+    if (canvasRate > mainRate || mainRate % canvasRate != 0) {
+        log_warn("Canvas '%s': %u/%u fps does not divide the main %u/%u fps; frames will be paced unevenly",
+                 name, video.fps_num, video.fps_den, main.fps_num, main.fps_den);
+    }
+
+    // libobs fires canvas signals from here; don't hold the lock across it
+    obs_canvas_t* canvas = obs_canvas_create(name, &video, static_cast<uint32_t>(flags));
+    if (!canvas) {
+        log_error("Canvas '%s': libobs refused %ux%u -> %ux%u", name, video.base_width, video.base_height,
+                  video.output_width, video.output_height);
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (nameTaken(m_canvases, name)) {
+            // Lost a race with another add() of the same name
+            obs_canvas_remove(canvas);
+            obs_canvas_release(canvas);
+            log_warn("Canvas '%s' already exists", name);
+            return nullptr;
+        }
+        m_canvases.push_back(canvas);
+    }
+    log_info("Canvas '%s': %ux%u -> %ux%u at %u/%u fps (flags 0x%x)", name, video.base_width,
+             video.base_height, video.output_width, video.output_height, video.fps_num, video.fps_den,
+             static_cast<unsigned>(flags));
+    return canvas;
+}
+
+obs_canvas_t* CanvasManager::addWithScene(const std::string& name, uint32_t width, uint32_t height, uint32_t fps,
+                                          obs_source_t* mainScene) {
+    obs_video_info ovi = {};
+    ovi.base_width = ovi.output_width = width;
+    ovi.base_height = ovi.output_height = height;
+    ovi.fps_num = fps;
+    ovi.fps_den = fps ? 1 : 0;
+    ovi.gpu_conversion = true;
+    obs_canvas_t* canvas = add(name.c_str(), &ovi, PROGRAM);
+    if (!canvas) {
+        return nullptr;
+    }
+
+    obs_scene_t* scene = obs_canvas_scene_create(canvas, name.c_str());
+    if (!scene) {
+        log_warn("Canvas '%s': failed to create its scene", name.c_str());
+        return canvas;
+    }
+    if (mainScene) {
+        // Nesting shares the main scene's sources; nothing is created twice
+        obs_sceneitem_t* item = obs_scene_add(scene, mainScene);
+        if (item) {
+            vec2 bounds;
+            vec2_set(&bounds, static_cast<float>(width), static_cast<float>(height));
+            obs_sceneitem_set_bounds_type(item, OBS_BOUNDS_SCALE_INNER);
+            obs_sceneitem_set_bounds(item, &bounds);
+            obs_sceneitem_set_bounds_alignment(item, OBS_ALIGN_CENTER);
+
+            std::lock_guard<std::mutex> lock(m_programMutex);
+            m_programItems.push_back(
+                ProgramItem{canvas, obs_source_get_weak_source(obs_scene_get_source(scene)), obs_sceneitem_get_id(item)});
+        }
+    }
+    obs_canvas_set_channel(canvas, 0, obs_scene_get_source(scene));
+    obs_scene_release(scene);
+    return canvas;
+}
+
+void CanvasManager::setProgramScene(obs_source_t* programScene) {
+    if (!programScene) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_programMutex);
+    for (auto it = m_programItems.begin(); it != m_programItems.end();) {
+        obs_source_t* canvasSource = obs_weak_source_get_source(it->scene);
+        obs_scene_t* scene = obs_scene_from_source(canvasSource);
+        obs_sceneitem_t* item = scene ? obs_scene_find_sceneitem_by_id(scene, it->itemId) : nullptr;
+        if (!item) {
+            // The canvas scene is gone, or its user removed the item: stop following
+            obs_source_release(canvasSource);
+            obs_weak_source_release(it->scene);
+            it = m_programItems.erase(it);
+            continue;
+        }
+        if (obs_sceneitem_get_source(item) == programScene) {
+            obs_source_release(canvasSource);
+            ++it;
+            continue;
+        }
+
+        // Scene items can't change their source: add a twin and drop the old one
+        obs_transform_info transform;
+        obs_sceneitem_crop crop;
+        obs_sceneitem_get_info2(item, &transform);
+        obs_sceneitem_get_crop(item, &crop);
+        const int order = obs_sceneitem_get_order_position(item);
+        const bool visible = obs_sceneitem_visible(item);
+
+        // nullptr if the program scene contains the canvas scene (a loop)
+        obs_sceneitem_t* replacement = obs_scene_add(scene, programScene);
+        if (replacement) {
+            obs_sceneitem_set_info2(replacement, &transform);
+            obs_sceneitem_set_crop(replacement, &crop);
+            obs_sceneitem_set_visible(replacement, visible);
+            obs_sceneitem_remove(item);
+            obs_sceneitem_set_order_position(replacement, order);
+            it->itemId = obs_sceneitem_get_id(replacement);
+        } else {
+            log_warn("Canvas '%s': cannot nest '%s' in its scene", obs_canvas_get_name(it->canvas),
+                     obs_source_get_name(programScene));
+        }
+        obs_source_release(canvasSource);
+        ++it;
+    }
+}
+
+bool CanvasManager::remove(obs_canvas_t* canvas) {
+    if (!canvas) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find(m_canvases.begin(), m_canvases.end(), canvas);
+        if (it == m_canvases.end()) {
+            return false;
+        }
+        m_canvases.erase(it);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_programMutex);
+        for (auto it = m_programItems.begin(); it != m_programItems.end();) {
+            if (it->canvas == canvas) {
+                obs_weak_source_release(it->scene);
+                it = m_programItems.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    log_info("Canvas '%s' removed", obs_canvas_get_name(canvas));
+    obs_canvas_remove(canvas);
+    obs_canvas_release(canvas);
+    return true;
+}
+
+std::vector<obs_canvas_t*> CanvasManager::canvases() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<obs_canvas_t*> refs;
+    refs.reserve(m_canvases.size());
+    for (obs_canvas_t* canvas : m_canvases) {
+        if (obs_canvas_t* ref = obs_canvas_get_ref(canvas)) {
+            refs.push_back(ref);
+        }
+    }
+    return refs;
+}
+
+void CanvasManager::clear() {
+    std::vector<obs_canvas_t*> canvases;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        canvases.swap(m_canvases);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_programMutex);
+        for (ProgramItem& item : m_programItems) {
+            obs_weak_source_release(item.scene);
+        }
+        m_programItems.clear();
+    }
+    for (auto it = canvases.rbegin(); it != canvases.rend(); ++it) {
+        obs_canvas_remove(*it);
+        obs_canvas_release(*it);
+    }
+}
+
+} // namespace streamlumo
@@ -0,0 +1,88 @@
+// streamlumo-engine/src/canvas_manager.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <obs.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Canvases added through the frontend API, next to the main canvas
+ *
+ * A canvas is a libobs video mix with its own resolution, frame rate and
+ * program channel. Sources are not tied to a canvas: a browser source placed
+ * in scenes on two canvases is rendered by CEF once and drawn into both
+ * mixes, so a 1920x1080 and a 1080x1920 feed share one set of browsers.
+ * Outputs and encoders attach to a canvas through obs_canvas_get_video();
+ * the profile's [SimpleOutput] StreamCanvas/RecCanvas pick one by name.
+ *
+ * libobs renders every mix on the main video clock, so a canvas frame rate
+ * that does not divide the main rate is paced unevenly (a warning is logged).
+ */
+class CanvasManager {
+public:
+    CanvasManager() = default;
+    ~CanvasManager();
+
+    CanvasManager(const CanvasManager&) = delete;
+    CanvasManager& operator=(const CanvasManager&) = delete;
+
+    /**
+     * @brief Create a canvas; unset fields of ovi are taken from the main canvas
+     * @param ovi nullptr = same settings as the main canvas
+     * @return The canvas (owned by the manager), or nullptr if the name is taken or libobs refused
+     */
+    obs_canvas_t* add(const char* name, const obs_video_info* ovi, int flags);
+
+    /**
+     * @brief Create a canvas whose program is a new scene of the same name
+     *
+     * The scene starts with the main program scene nested in it, scaled to
+     * fit, so the canvas shows the main layout until its items are rearranged.
+     * That item follows the main program (setProgramScene()) until it is
+     * removed from the canvas scene.
+     */
+    obs_canvas_t* addWithScene(const std::string& name, uint32_t width, uint32_t height, uint32_t fps,
+                               obs_source_t* mainScene);
+
+    /**
+     * @brief Point every canvas's nested program item at a new main program scene
+     *
+     * The item keeps its transform, crop, visibility and position in the
+     * canvas scene. Called by the frontend whenever the program scene
+     * changes; canvases cut straight to the new scene.
+     */
+    void setProgramScene(obs_source_t* programScene);
+
+    // false if the canvas was not added through this manager
+    bool remove(obs_canvas_t* canvas);
+
+    // New references, in creation order; release each with obs_canvas_release()
+    std::vector<obs_canvas_t*> canvases() const;
+
+    // Removes every canvas; call before obs_shutdown()
+    void clear();
+
+private:
+    // A canvas scene item that mirrors the main program scene
+    struct ProgramItem {
+        obs_canvas_t* canvas;           // Identifies the canvas only
+        obs_weak_source_t* scene;       // The canvas's scene
+        int64_t itemId;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<obs_canvas_t*> m_canvases;
+
+    // Serializes setProgramScene(); never taken inside m_mutex
+    std::mutex m_programMutex;
+    std::vector<ProgramItem> m_programItems;
+};
+
+} // namespace streamlumo
@@ -10,6 +10,41 @@
 
 namespace streamlumo {
 
+// "a,b, c" -> {"a", "b", "c"}
+static std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t comma = value.find(',', start);
+        if (comma == std::string::npos) {
+            comma = value.size();
+        }
+        std::string item = value.substr(start, comma - start);
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+        start = comma + 1;
+    }
+    return items;
+}
+
+static bool parseLogLevel(const std::string& value, LogLevel& level) {
+    if (value == "debug") {
+        level = LogLevel::Debug;
+    } else if (value == "info") {
+        level = LogLevel::Info;
+    } else if (value == "warn" || value == "warning") {
+        level = LogLevel::Warning;
+    } else if (value == "error") {
+        level = LogLevel::Error;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 Config::Config() = default;
 
 bool Config::parseArgs(int argc, char* argv[]) {
@@ -90,22 +125,38 @@ bool Config::parseArgs(int argc, char* argv[]) {
         
         // Log level
         if ((arg == "-l" || arg == "--log-level") && i + 1 < argc) {
-            std::string level = argv[++i];
-            if (level == "debug") {
-                m_logLevel = LogLevel::Debug;
-            } else if (level == "info") {
-                m_logLevel = LogLevel::Info;
-            } else if (level == "warn" || level == "warning") {
-                m_logLevel = LogLevel::Warning;
-            } else if (level == "error") {
-                m_logLevel = LogLevel::Error;
-            } else {
+            if (!parseLogLevel(argv[++i], m_logLevel)) {
                 std::cerr << "Error: Invalid log level. Use: debug, info, warn, error" << std::endl;
                 return false;
             }
             continue;
         }
         
+        // Per-subsystem levels for libobs/plugin output: "browser-bridge=warn,libobs=error"
+        if (arg == "--log-levels" && i + 1 < argc) {
+            for (const std::string& item : splitList(argv[++i])) {
+                size_t eq = item.find('=');
+                LogLevel level;
+                if (eq == std::string::npos || eq == 0 || !parseLogLevel(item.substr(eq + 1), level)) {
+                    std::cerr << "Error: Invalid --log-levels entry '" << item
+                              << "'. Use SUBSYSTEM=LEVEL" << std::endl;
+                    return false;
+                }
+                m_subsystemLogLevels[item.substr(0, eq)] = level;
+            }
+            continue;
+        }
+        
+        // libobs/plugin lines per second per call site (0 = unlimited)
+        if (arg == "--log-rate-limit" && i + 1 < argc) {
+            m_logRateLimit = std::atoi(argv[++i]);
+            if (m_logRateLimit < 0) {
+                std::cerr << "Error: Invalid log rate limit" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        
         // Log file
         if (arg == "--log-file" && i + 1 < argc) {
             m_logFile = argv[++i];
@@ -128,6 +179,109 @@ bool Config::parseArgs(int argc, char* argv[]) {
             continue;
         }
         
+        // Browser warm pool size (idle pre-created helper browsers)
+        if (arg == "--browser-warm-pool" && i + 1 < argc) {
+            m_browserWarmPool = std::atoi(argv[++i]);
+            if (m_browserWarmPool < 0 || m_browserWarmPool > 32) {
+                std::cerr << "Error: Invalid warm pool size (must be 0-32)" << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        // Browser warm pool geometry
+        if (arg == "--browser-warm-pool-size" && i + 1 < argc) {
+            m_browserWarmPoolSize = argv[++i];
+            int w = 0, h = 0, f = 0;
+            if (sscanf(m_browserWarmPoolSize.c_str(), "%dx%d@%d", &w, &h, &f) != 3 ||
+                w <= 0 || h <= 0 || f <= 0) {
+                std::cerr << "Error: Invalid warm pool size format. Use WIDTHxHEIGHT@FPS (e.g., 1920x1080@30)" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        
+        // Browser helper process count (sharded browser rendering)
+        if (arg == "--browser-helpers" && i + 1 < argc) {
+            m_browserHelpers = std::atoi(argv[++i]);
+            if (m_browserHelpers < 1 || m_browserHelpers > 16) {
+                std::cerr << "Error: Invalid browser helper count (must be 1-16)" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        
+        // Idle mode timeout
+        if (arg == "--idle-timeout" && i + 1 < argc) {
+            m_idleTimeout = std::atoi(argv[++i]);
+            if (m_idleTimeout < 0 || m_idleTimeout > 86400) {
+                std::cerr << "Error: Invalid idle timeout (must be 0-86400 seconds)" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        
+        // Module allowlist / denylist
+        if (arg == "--modules" && i + 1 < argc) {
+            m_moduleAllowlist = splitList(argv[++i]);
+            continue;
+        }
+        if (arg == "--disable-modules" && i + 1 < argc) {
+            for (const std::string& name : splitList(argv[++i])) {
+                m_moduleDenylist.push_back(name);
+            }
+            continue;
+        }
+        
+        // Module manifest cache location ("off" disables it)
+        if (arg == "--module-cache" && i + 1 < argc) {
+            m_moduleCachePath = argv[++i];
+            continue;
+        }
+        
+        // Chrome trace / Perfetto JSON output
+        if (arg == "--trace-file" && i + 1 < argc) {
+            m_traceFile = argv[++i];
+            continue;
+        }
+        
+        // Extra canvas (repeatable), e.g. vertical=1080x1920@30
+        if (arg == "--canvas" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            CanvasSpec canvas;
+            const size_t eq = spec.find('=');
+            if (eq != std::string::npos) {
+                canvas.name = spec.substr(0, eq);
+                const int n = sscanf(spec.c_str() + eq + 1, "%dx%d@%d", &canvas.width, &canvas.height, &canvas.fps);
+                if (n < 2) canvas.width = 0;
+            }
+            if (canvas.name.empty() || canvas.width <= 0 || canvas.height <= 0 || canvas.fps < 0 ||
+                canvas.fps > 120) {
+                std::cerr << "Error: Invalid canvas format. Use NAME=WIDTHxHEIGHT[@FPS] (e.g., vertical=1080x1920@30)" << std::endl;
+                return false;
+            }
+            m_canvases.push_back(canvas);
+            continue;
+        }
+        
+        // Scene collection name and file format
+        if (arg == "--scene-collection" && i + 1 < argc) {
+            m_sceneCollection = argv[++i];
+            if (m_sceneCollection.empty()) {
+                std::cerr << "Error: Scene collection name cannot be empty" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        if (arg == "--scene-format" && i + 1 < argc) {
+            m_sceneFormat = argv[++i];
+            if (m_sceneFormat != "json" && m_sceneFormat != "binary") {
+                std::cerr << "Error: Invalid scene format (must be json or binary)" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        
         // Test browser URL - creates a browser source on startup
         if (arg == "--test-browser-url" && i + 1 < argc) {
             m_testBrowserUrl = argv[++i];
@@ -166,14 +320,37 @@ void Config::printHelp() const {
     std::cout << "      --data-path <PATH>        Path to OBS data directory\n\n";
     
     std::cout << "  -l, --log-level <LEVEL>       Log level: debug, info, warn, error\n";
+    std::cout << "      --log-levels <SUB=LEVEL,...>  Levels for libobs/plugin subsystems, e.g.\n";
+    std::cout << "                                 browser-bridge=warn,libobs=error\n";
+    std::cout << "      --log-rate-limit <N>       libobs/plugin lines per second per call site (default: 10, 0 = off)\n";
     std::cout << "      --log-file <PATH>         Log to file instead of stdout\n\n";
 
     std::cout << "      --helper-port <PORT>       Browser helper TCP port (default: 4777)\n";
-    std::cout << "      --helper-token <TOKEN>     Shared secret for helper handshake (recommended)\n\n";
+    std::cout << "      --helper-token <TOKEN>     Shared secret for helper handshake (recommended)\n";
+    std::cout << "      --browser-warm-pool <N>    Idle pre-created browsers for instant activation (default: 0)\n";
+    std::cout << "      --browser-warm-pool-size <WxH@FPS>  Warm pool browser geometry (default: output size)\n";
+    std::cout << "      --browser-helpers <N>      Browser helper processes to spread browsers over (default: 1)\n\n";
+
+    std::cout << "      --idle-timeout <SECONDS>   Suspend rendering after this long with nothing consuming\n";
+    std::cout << "                                 the output (default: 0 = never)\n\n";
+
+    std::cout << "      --modules <A,B,...>        Load only these OBS modules (default: all found)\n";
+    std::cout << "      --disable-modules <A,...>  Never load these OBS modules\n";
+    std::cout << "      --module-cache <PATH|off>  Module manifest cache (default: <cache dir>/module-manifest.txt)\n\n";
+
+    std::cout << "      --trace-file <PATH>        Record a Chrome trace (Perfetto) of startup and frame work;\n";
+    std::cout << "                                 written at exit and on SIGUSR1\n\n";
+
+    std::cout << "      --canvas <NAME=WxH[@FPS]>  Extra canvas sharing the main canvas's sources, e.g.\n";
+    std::cout << "                                 vertical=1080x1920@30 (repeatable)\n\n";
+
+    std::cout << "      --scene-collection <NAME>  Scene collection to load and save (default: Default)\n";
+    std::cout << "      --scene-format <FMT>       Scene collection file format: json, binary (default: json)\n\n";
     
     std::cout << "EXAMPLES:\n";
     std::cout << "  streamlumo-engine --port 4466 --resolution 1920x1080 --fps 30\n";
-    std::cout << "  streamlumo-engine -p 4455 -r 1280x720 -f 60 --log-level debug\n\n";
+    std::cout << "  streamlumo-engine -p 4455 -r 1280x720 -f 60 --log-level debug\n";
+    std::cout << "  streamlumo-engine -r 1920x1080 -f 60 --canvas vertical=1080x1920@30\n\n";
     
     std::cout << "For more information, visit: https://github.com/chocofoxai/streamlumo-engine\n";
 }
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <map>
 #include <string>
+#include <vector>
 
 #define STREAMLUMO_ENGINE_VERSION "1.0.0"
 
@@ -51,11 +53,52 @@ public:
     // Logging configuration
     LogLevel getLogLevel() const { return m_logLevel; }
     const std::string& getLogFile() const { return m_logFile; }
+    // libobs/plugin output: levels keyed by "[subsystem]" prefix ("libobs" for
+    // unprefixed lines; never more verbose than getLogLevel()) and a
+    // per-call-site lines/second limit (0 = unlimited)
+    const std::map<std::string, LogLevel>& getSubsystemLogLevels() const { return m_subsystemLogLevels; }
+    int getLogRateLimit() const { return m_logRateLimit; }
     bool isQuiet() const { return m_quiet; }
 
     // Browser helper IPC
     int getHelperPort() const { return m_helperPort; }
     const std::string& getHelperToken() const { return m_helperToken; }
+
+    // Browser bridge warm pool (idle pre-created browsers)
+    int getBrowserWarmPool() const { return m_browserWarmPool; }
+    const std::string& getBrowserWarmPoolSize() const { return m_browserWarmPoolSize; }
+
+    // Number of browser helper processes (browsers are spread across them)
+    int getBrowserHelpers() const { return m_browserHelpers; }
+
+    // Idle mode: seconds without outputs, control clients or visible browser
+    // sources before rendering is suspended (0 = never)
+    int getIdleTimeout() const { return m_idleTimeout; }
+
+    // OBS module selection: only allowlisted modules are loaded (empty = all),
+    // denylisted ones never are. Discovered modules are cached in a manifest
+    // at getModuleCachePath() (empty = default cache dir, "off" = no cache).
+    const std::vector<std::string>& getModuleAllowlist() const { return m_moduleAllowlist; }
+    const std::vector<std::string>& getModuleDenylist() const { return m_moduleDenylist; }
+    const std::string& getModuleCachePath() const { return m_moduleCachePath; }
+
+    // Chrome trace output; non-empty enables tracing, written on SIGUSR1 and at exit
+    const std::string& getTraceFile() const { return m_traceFile; }
+
+    // Extra canvases (--canvas NAME=WxH[@FPS]) created at startup next to the
+    // main one; fps 0 = the main canvas's rate
+    struct CanvasSpec {
+        std::string name;
+        int width = 0;
+        int height = 0;
+        int fps = 0;
+    };
+    const std::vector<CanvasSpec>& getCanvases() const { return m_canvases; }
+
+    // Scene collection loaded at startup and saved on change, and its file
+    // format ("json" or "binary")
+    const std::string& getSceneCollection() const { return m_sceneCollection; }
+    const std::string& getSceneFormat() const { return m_sceneFormat; }
     
 private:
     void printHelp() const;
@@ -77,12 +120,39 @@ private:
     
     // Logging
     LogLevel m_logLevel = LogLevel::Info;
+    std::map<std::string, LogLevel> m_subsystemLogLevels;
+    int m_logRateLimit = 10;
     std::string m_logFile;
     bool m_quiet = false;
 
     // Browser helper IPC
     int m_helperPort = 4777;
     std::string m_helperToken;
+
+    // Browser bridge warm pool
+    int m_browserWarmPool = 0;
+    std::string m_browserWarmPoolSize;  // "<w>x<h>@<fps>", empty = output size/fps
+
+    // Browser helper processes (ports helper-port .. helper-port + N - 1)
+    int m_browserHelpers = 1;
+
+    // Idle governor
+    int m_idleTimeout = 0;
+
+    // Module loading
+    std::vector<std::string> m_moduleAllowlist;
+    std::vector<std::string> m_moduleDenylist;
+    std::string m_moduleCachePath;
+
+    // Tracing
+    std::string m_traceFile;
+
+    // Extra canvases
+    std::vector<CanvasSpec> m_canvases;
+
+    // Scene collection persistence
+    std::string m_sceneCollection = "Default";
+    std::string m_sceneFormat = "json";
     
     // Test mode
     std::string m_testBrowserUrl;
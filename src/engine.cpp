@@ -3,9 +3,15 @@
 // Copyright (C) 2024 StreamLumo
 
 #include "engine.h"
+#include "flv_recorder.h"
 #include "logging.h"
 #include "browser_helper_launcher.h"
 #include "frontend-stubs.h"
+#include "program_feed.h"
+#include "replay_buffer.h"
+#include "idle_governor.h"
+#include "startup_graph.h"
+#include "trace.h"
 #include "platform/platform.h"
 
 #include <random>
@@ -18,6 +24,7 @@
 #include <filesystem>
 #include <cstdio>
 #include <set>
+#include <algorithm>
 
 #ifdef __APPLE__
 #include <mach-o/dyld.h>
@@ -40,6 +47,48 @@ static std::string generateHelperToken()
     return std::string(buf);
 }
 
+// Frame clock statistics are logged (and reset) this often
+static constexpr uint64_t kFrameClockReportNanos = 30ULL * 1000000000ULL;
+
+// Consumer poll interval while the idle governor has rendering suspended
+static constexpr uint64_t kIdlePollNanos = 100ULL * 1000000ULL;
+
+/**
+ * @brief Per-window statistics of the main loop frame clock
+ *
+ * Jitter is how late a tick woke up relative to its deadline; an overrun is
+ * a tick whose work ran past the next deadline (the ticks it covered are
+ * counted as dropped).
+ */
+struct FrameClockStats {
+    uint64_t ticks = 0;
+    uint64_t rendered = 0;
+    uint64_t jitterSumNs = 0;
+    uint64_t jitterMaxNs = 0;
+    uint64_t overruns = 0;
+    uint64_t dropped = 0;
+
+    void record(uint64_t latenessNs) {
+        ++ticks;
+        jitterSumNs += latenessNs;
+        if (latenessNs > jitterMaxNs) {
+            jitterMaxNs = latenessNs;
+        }
+    }
+
+    void report(bool obsDriving) const {
+        if (ticks == 0) {
+            return;
+        }
+        log_info("Frame clock: %llu ticks (%llu rendered, %s), jitter avg %.1f us max %.1f us, "
+                 "%llu overruns (%llu ticks dropped)",
+                 static_cast<unsigned long long>(ticks), static_cast<unsigned long long>(rendered),
+                 obsDriving ? "libobs-driven" : "manual",
+                 jitterSumNs / 1000.0 / ticks, jitterMaxNs / 1000.0,
+                 static_cast<unsigned long long>(overruns), static_cast<unsigned long long>(dropped));
+    }
+};
+
 Engine::Engine(const Config& config) 
     : m_config(config) 
 {
@@ -54,42 +103,101 @@ Engine::~Engine() {
 bool Engine::initialize() {
     log_info("Initializing StreamLumo Engine...");
 
-#ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
-    // Attempt to launch the external browser helper app on macOS to host CEF safely.
-    // The helper bundle is expected at ../Helpers/streamlumo-browser-helper.app relative to the engine binary.
-    char exePath[PATH_MAX];
-    uint32_t size = sizeof(exePath);
-    std::string helperBundlePath;
-    if (_NSGetExecutablePath(exePath, &size) == 0) {
-        char *dir = dirname(exePath);
-        fs::path appPath = fs::path(dir).parent_path(); // Contents/
-        helperBundlePath = (appPath / "Helpers" / "streamlumo-browser-helper.app").string();
+    if (!m_config.getTraceFile().empty()) {
+        Trace::enable();
+        Trace::setThreadName("main");
+        log_info("Tracing enabled, writing %s at exit and on SIGUSR1", m_config.getTraceFile().c_str());
+    }
+
+    m_obsLogRouter.install(m_config.getLogLevel(), m_config.getSubsystemLogLevels(),
+                           m_config.getLogRateLimit());
+
+    // Open the loop now so a termination signal during startup is seen
+    // between phases instead of waiting in the signalfd until run()
+    if (!m_eventLoop.open()) {
+        log_error("Failed to open the main event loop");
+        return false;
     }
-    if (!helperBundlePath.empty()) {
-        m_helperPort = m_config.getHelperPort();
-        m_helperToken = m_config.getHelperToken();
-        if (m_helperToken.empty()) {
-            m_helperToken = generateHelperToken();
-            log_info("Generated ephemeral helper token");
+
+    // Startup runs as a dependency graph: helper launch, path resolution and
+    // module discovery run on worker threads while the main thread brings up
+    // OBS core, video and audio. Everything that touches libobs state stays on
+    // the main thread and keeps its original order.
+    StartupGraph graph;
+    using Runs = StartupGraph::Runs;
+
+    graph.add("env", {}, Runs::Main, [this] { exportEnvironment(); return true; });
+#ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
+    graph.add("helper", {"env"}, Runs::Worker, [this] { return launchBrowserHelper(); }, false);
+#endif
+    graph.add("paths", {}, Runs::Worker, [this] { resolveStartupPaths(); return true; });
+    graph.add("obs-core", {"env", "paths"}, Runs::Main, [this] { return initOBS(); });
+    graph.add("module-scan", {"obs-core"}, Runs::Worker, [this] {
+        // Manifest check or read-only walk of the module paths; overlaps video/audio init
+        discoverModules();
+        return true;
+    }, false);
+    graph.add("video", {"obs-core"}, Runs::Main, [this] { return initVideo(); });
+    graph.add("audio", {"video"}, Runs::Main, [this] { return initAudio(); });
+    graph.add("modules", {"audio", "module-scan"}, Runs::Main, [this] { return loadModules(); });
+    graph.add("scene", {"modules"}, Runs::Main, [this] { return setupDefaultScene(); }, false);
+    graph.add("transition", {"modules"}, Runs::Main, [this] { return setupDefaultTransition(); }, false);
+    graph.add("canvases", {"scene"}, Runs::Main, [this] { return setupCanvases(); }, false);
+    graph.add("ready", {"scene", "transition", "canvases"}, Runs::Main, [] {
+        // Signal that OBS has finished loading - this enables obs-websocket to accept requests
+        HeadlessFrontend* frontend = HeadlessFrontend::instance();
+        if (frontend) {
+            frontend->signalFinishedLoading();
         }
+        return true;
+    });
+    // If test browser URL is specified, create a test browser source
+    if (m_config.hasTestBrowserUrl()) {
+        graph.add("test-browser", {"ready"}, Runs::Main, [this] {
+            return createTestBrowserSource(m_config.getTestBrowserUrl());
+        }, false);
+    }
 
-        // Export port/token so the helper process can read them from its environment.
-        platform::setEnv("BROWSER_HELPER_PORT", std::to_string(m_helperPort));
-        platform::setEnv("BROWSER_HELPER_TOKEN", m_helperToken);
+    graph.setCancelCheck([this] {
+        m_startupSignal = m_eventLoop.pendingSignal();
+        return m_startupSignal != 0;
+    });
 
-        m_helperBundlePath = helperBundlePath;
-        if (m_browserHelper.start(helperBundlePath)) {
-            // Try to connect to the helper over local TCP JSON-line IPC.
-            m_browserHelperClient = std::make_unique<BrowserHelperClient>();
-            if (!m_browserHelperClient->start(static_cast<uint16_t>(m_helperPort), m_helperToken)) {
-                log_warn("Helper IPC client failed to connect on port %d", m_helperPort);
-            }
-        } else {
-            log_warn("Browser helper failed to launch; browser sources will remain unavailable.");
+    const bool ok = graph.run();
+    graph.report();
+    if (graph.cancelled()) {
+        log_info("Received signal %d during startup, shutting down...", m_startupSignal);
+        writeTrace();
+        if (obs_initialized()) {
+            // Tear down what the completed phases brought up
+            m_initialized = true;
+            shutdown();
         }
-    } else {
-        log_warn("Could not resolve browser helper path; browser sources will remain unavailable.");
+        m_eventLoop.close();
+        return false;
     }
+    if (!ok) {
+        log_error("Engine initialization failed");
+        writeTrace();
+        return false;
+    }
+    
+    m_initialized = true;
+    return true;
+}
+
+void Engine::exportEnvironment() {
+#ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
+    m_helperPort = m_config.getHelperPort();
+    m_helperToken = m_config.getHelperToken();
+    if (m_helperToken.empty()) {
+        m_helperToken = generateHelperToken();
+        log_info("Generated ephemeral helper token");
+    }
+
+    // Export port/token so the helper process can read them from its environment.
+    platform::setEnv("BROWSER_HELPER_PORT", std::to_string(m_helperPort));
+    platform::setEnv("BROWSER_HELPER_TOKEN", m_helperToken);
 #endif
     
     // Set environment variables for obs-websocket before loading modules
@@ -98,101 +206,99 @@ bool Engine::initialize() {
     platform::setEnv("SL_WEBSOCKET_PORT", std::to_string(m_config.getWebSocketPort()));
     platform::setEnv("SL_WEBSOCKET_AUTH_DISABLED", "1"); // Disable auth for local IPC
     log_info("Set SL_WEBSOCKET_PORT=%d for obs-websocket", m_config.getWebSocketPort());
-    
-    if (!initOBS()) {
-        log_error("Failed to initialize OBS core");
-        return false;
+
+    // Warm pool settings for obs-browser-bridge (read when the bridge connects)
+    if (m_config.getBrowserWarmPool() > 0) {
+        std::string poolSize = m_config.getBrowserWarmPoolSize();
+        if (poolSize.empty()) {
+            poolSize = std::to_string(m_config.getWidth()) + "x" +
+                       std::to_string(m_config.getHeight()) + "@" +
+                       std::to_string(m_config.getFPS());
+        }
+        platform::setEnv("BROWSER_BRIDGE_WARM_POOL", std::to_string(m_config.getBrowserWarmPool()));
+        platform::setEnv("BROWSER_BRIDGE_WARM_POOL_SIZE", poolSize);
+        log_info("Browser warm pool: %d browsers at %s", m_config.getBrowserWarmPool(), poolSize.c_str());
     }
-    
-    if (!initVideo()) {
-        log_error("Failed to initialize video subsystem");
-        return false;
+
+    // Helper process count for obs-browser-bridge (ports helper-port + 0..N-1)
+    if (m_config.getBrowserHelpers() > 1) {
+        platform::setEnv("BROWSER_BRIDGE_HELPERS", std::to_string(m_config.getBrowserHelpers()));
+        log_info("Browser helpers: %d processes", m_config.getBrowserHelpers());
     }
-    
-    if (!initAudio()) {
-        log_error("Failed to initialize audio subsystem");
-        return false;
+}
+
+#ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
+bool Engine::launchBrowserHelper() {
+    // Attempt to launch the external browser helper app on macOS to host CEF safely.
+    // The helper bundle is expected at ../Helpers/streamlumo-browser-helper.app relative to the engine binary.
+    char exePath[PATH_MAX];
+    uint32_t size = sizeof(exePath);
+    std::string helperBundlePath;
+    if (_NSGetExecutablePath(exePath, &size) == 0) {
+        char *dir = dirname(exePath);
+        fs::path appPath = fs::path(dir).parent_path(); // Contents/
+        helperBundlePath = (appPath / "Helpers" / "streamlumo-browser-helper.app").string();
     }
-    
-    log_info("DEBUG: loadModules() returning");
-    if (!loadModules()) {
-        log_error("Failed to load OBS modules");
+    if (helperBundlePath.empty()) {
+        log_warn("Could not resolve browser helper path; browser sources will remain unavailable.");
         return false;
     }
-    log_info("DEBUG: loadModules() completed successfully");
-    
-    log_info("DEBUG: About to call setupDefaultScene()");
-    if (!setupDefaultScene()) {
-        log_warn("Failed to setup default scene (non-fatal)");
-    }
-    log_info("DEBUG: setupDefaultScene() completed");
-    
-    log_info("DEBUG: About to call setupDefaultTransition()");
-    if (!setupDefaultTransition()) {
-        log_warn("Failed to setup default transition (non-fatal)");
-    }
-    log_info("DEBUG: setupDefaultTransition() completed");
-    
-    // Signal that OBS has finished loading - this enables obs-websocket to accept requests
-    log_info("DEBUG: About to signal finished loading");
-    HeadlessFrontend* frontend = HeadlessFrontend::instance();
-    if (frontend) {
-        frontend->signalFinishedLoading();
-    }
-    log_info("DEBUG: Finished loading signal sent");
-    
-    // If test browser URL is specified, create a test browser source
-    if (m_config.hasTestBrowserUrl()) {
-        if (!createTestBrowserSource(m_config.getTestBrowserUrl())) {
-            log_warn("Failed to create test browser source (non-fatal)");
-        }
+
+    m_helperBundlePath = helperBundlePath;
+    if (!m_browserHelper.start(helperBundlePath)) {
+        log_warn("Browser helper failed to launch; browser sources will remain unavailable.");
+        return false;
     }
-    
-    m_initialized = true;
+
+    // The monitor makes the first connection (with retries) on its own thread,
+    // then takes over pings, reconnects and helper restarts
+    std::lock_guard<std::mutex> lock(m_helperMonitorMutex);
+    m_helperMonitor = std::make_unique<HelperHealthMonitor>(
+        m_browserHelper, m_helperBundlePath, static_cast<uint16_t>(m_helperPort), m_helperToken);
+    m_helperMonitor->start(nullptr);
     return true;
 }
 
-bool Engine::initOBS() {
-    log_info("Initializing OBS core...");
-    
-    // Set up module paths before startup
-    std::string pluginPath = getPluginPath();
-    std::string dataPath = getDataPath();
-    
-    log_info("Plugin path: %s", pluginPath.c_str());
-    log_info("Data path: %s", dataPath.c_str());
-    
-    // Get config path
-    std::string configPath = m_config.getConfigPath();
-    if (configPath.empty()) {
-        configPath = getModuleConfigPath();
+void Engine::helperRestartProc(void* data, calldata_t* cd) {
+    // obs-browser-bridge asks instead of launching a second helper on our port
+    auto* engine = static_cast<Engine*>(data);
+    const long long port = calldata_int(cd, "port");
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(engine->m_helperMonitorMutex);
+        if (engine->m_helperMonitor && port == engine->m_helperPort) {
+            engine->m_helperMonitor->requestRestart();
+            accepted = true;
+        }
     }
-    log_info("Config path: %s", configPath.c_str());
-    
-    // Initialize OBS
-    if (!obs_startup("en-US", configPath.c_str(), nullptr)) {
-        log_error("obs_startup() failed");
-        return false;
+    calldata_set_bool(cd, "accepted", accepted);
+}
+#endif
+
+void Engine::resolveStartupPaths() {
+    m_paths.pluginPath = getPluginPath();
+    m_paths.dataPath = getDataPath();
+    m_paths.configPath = m_config.getConfigPath();
+    if (m_paths.configPath.empty()) {
+        m_paths.configPath = getModuleConfigPath();
     }
-    
+    m_paths.modulePaths.clear();
+
     // Add module search paths AFTER obs_startup
     // On macOS, plugins are in .plugin bundles with structure:
     // <base>/%module%.plugin/Contents/MacOS/%module%
     // <base>/%module%.plugin/Contents/Resources/
+    const std::string& pluginPath = m_paths.pluginPath;
     if (!pluginPath.empty() && fs::exists(pluginPath)) {
         // Format for macOS .plugin bundles - standard bundled structure
-        std::string binPath = pluginPath + "/%module%.plugin/Contents/MacOS/";
-        std::string dataModulePath = pluginPath + "/%module%.plugin/Contents/Resources/";
-        log_info("Adding module path: bin=%s, data=%s", binPath.c_str(), dataModulePath.c_str());
-        obs_add_module_path(binPath.c_str(), dataModulePath.c_str());
+        m_paths.modulePaths.push_back({pluginPath + "/%module%.plugin/Contents/MacOS/",
+                                       pluginPath + "/%module%.plugin/Contents/Resources/"});
         
         // Also add OBS build directory structure for development:
         // <base>/%module%/Release/%module%.plugin/Contents/MacOS/%module%
         // This allows loading plugins from obs-studio/build_macos/plugins/
-        std::string devBinPath = pluginPath + "/%module%/Release/%module%.plugin/Contents/MacOS/";
-        std::string devDataPath = pluginPath + "/%module%/Release/%module%.plugin/Contents/Resources/";
-        log_info("Adding OBS dev module path: bin=%s, data=%s", devBinPath.c_str(), devDataPath.c_str());
-        obs_add_module_path(devBinPath.c_str(), devDataPath.c_str());
+        m_paths.modulePaths.push_back({pluginPath + "/%module%/Release/%module%.plugin/Contents/MacOS/",
+                                       pluginPath + "/%module%/Release/%module%.plugin/Contents/Resources/"});
     }
     
     // Add path for directly loading .so plugins (like obs-browser-bridge)
@@ -232,10 +338,8 @@ bool Engine::initOBS() {
                 return;
             }
             
-            std::string bin = canonicalPath.string() + "/";
-            std::string data = canonicalPath.string() + "/";
-            log_info("Adding %s: %s", description.c_str(), bin.c_str());
-            obs_add_module_path(bin.c_str(), data.c_str());
+            log_info("Resolved %s: %s", description.c_str(), canonicalStr.c_str());
+            m_paths.modulePaths.push_back({canonicalStr + "/", canonicalStr + "/"});
             addedPaths.insert(canonicalStr);
         };
         
@@ -247,6 +351,39 @@ bool Engine::initOBS() {
         addModulePathOnce(engineDir / "PlugIns", "dev PlugIns path");
     }
 #endif
+}
+
+bool Engine::initOBS() {
+    log_info("Initializing OBS core...");
+    
+    // Paths were resolved by the "paths" startup phase
+    log_info("Plugin path: %s", m_paths.pluginPath.c_str());
+    log_info("Data path: %s", m_paths.dataPath.c_str());
+    log_info("Config path: %s", m_paths.configPath.c_str());
+    
+    // Initialize OBS
+    if (!obs_startup("en-US", m_paths.configPath.c_str(), nullptr)) {
+        log_error("obs_startup() failed");
+        return false;
+    }
+    
+    // Before any module loads, so obs-browser-bridge can find the trace API
+    Trace::registerProc();
+#ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
+    // Lets obs-browser-bridge leave our helper's restarts to the health monitor
+    proc_handler_add(obs_get_proc_handler(),
+                     "void streamlumo_browser_helper_restart(in int port, out bool accepted)",
+                     helperRestartProc, this);
+#endif
+    registerFlvRecorderOutput();
+    registerReplayBufferOutput();
+    registerProgramFeedOutput();
+    
+    // Add module search paths AFTER obs_startup
+    for (const auto& modulePath : m_paths.modulePaths) {
+        log_info("Adding module path: bin=%s, data=%s", modulePath.first.c_str(), modulePath.second.c_str());
+        obs_add_module_path(modulePath.first.c_str(), modulePath.second.c_str());
+    }
     
     log_info("OBS core initialized (version %s)", obs_get_version_string());
     return true;
@@ -337,14 +474,6 @@ bool Engine::initAudio() {
     return true;
 }
 
-// Callback for enumerating found modules
-static void log_found_module(void* param, const struct obs_module_info2* info) {
-    (void)param;
-    log_info("  Found module: %s", info->name);
-    log_info("    bin_path: %s", info->bin_path);
-    log_info("    data_path: %s", info->data_path);
-}
-
 // List of modules to skip in headless mode (they require Qt GUI or are not needed)
 static const char* headless_skip_modules[] = {
     "frontend-tools",      // Requires Qt GUI
@@ -373,6 +502,42 @@ static bool should_skip_module(const char* name) {
     return false;
 }
 
+static bool list_contains(const std::vector<std::string>& list, const std::string& name) {
+    return std::find(list.begin(), list.end(), name) != list.end();
+}
+
+void Engine::discoverModules() {
+    std::string manifestPath = m_config.getModuleCachePath();
+    if (manifestPath == "off") {
+        manifestPath.clear();
+    } else if (manifestPath.empty()) {
+        manifestPath = platform::joinPath(platform::getCacheDir(), "module-manifest.txt");
+    }
+
+    // The manifest is only valid for this libobs and this set of search paths;
+    // their roots (the part before %module%) are watched for added bundles
+    std::string key = obs_get_version_string();
+    std::vector<std::string> roots;
+    for (const auto& modulePath : m_paths.modulePaths) {
+        key += "|" + modulePath.first;
+        std::string root = modulePath.first.substr(0, modulePath.first.find("%module%"));
+        while (root.size() > 1 && root.back() == '/') {
+            root.pop_back();
+        }
+        roots.push_back(root);
+    }
+
+    m_moduleCatalog.discover(manifestPath, key, roots);
+}
+
+bool Engine::moduleAllowed(const std::string& name) const {
+    if (should_skip_module(name.c_str()) || list_contains(m_config.getModuleDenylist(), name)) {
+        return false;
+    }
+    const auto& allowlist = m_config.getModuleAllowlist();
+    return allowlist.empty() || list_contains(allowlist, name);
+}
+
 bool Engine::loadModules() {
     log_info("Loading OBS modules...");
     
@@ -383,18 +548,51 @@ bool Engine::loadModules() {
     HeadlessFrontend::install();
 #endif
     
-    // First, enumerate what modules can be found
-    log_info("Searching for modules in registered paths...");
-    obs_find_modules2(log_found_module, nullptr);
-    
     // Mark modules to skip in headless mode
     for (int i = 0; headless_skip_modules[i] != nullptr; i++) {
         log_info("Disabling module for headless mode: %s", headless_skip_modules[i]);
         obs_add_disabled_module(headless_skip_modules[i]);
     }
+    for (const std::string& name : m_config.getModuleDenylist()) {
+        obs_add_disabled_module(name.c_str());
+    }
     
-    // Load all modules from the search paths
-    obs_load_all_modules();
+    // Load the modules found by the "module-scan" phase (cached manifest or
+    // directory walk) that pass the allowlist/denylist, instead of letting
+    // obs_load_all_modules() dlopen and initialize every one of them
+    const uint64_t loadStart = platform::getTimestampNanos();
+    const uint64_t rssBefore = platform::getProcessResidentBytes();
+    int loaded = 0, skipped = 0, failed = 0;
+    std::set<std::string> seen;
+    for (const ModuleCatalog::Module& info : m_moduleCatalog.modules()) {
+        if (!moduleAllowed(info.name) || !seen.insert(info.name).second) {
+            ++skipped;
+            continue;
+        }
+        obs_module_t* module = nullptr;
+        int result = obs_open_module(&module, info.binPath.c_str(), info.dataPath.c_str());
+        if (result != MODULE_SUCCESS) {
+            log_warn("Failed to open module %s: error code %d", info.name.c_str(), result);
+            ++failed;
+            continue;
+        }
+        if (!obs_init_module(module)) {
+            log_warn("Failed to initialize module %s", info.name.c_str());
+            ++failed;
+            continue;
+        }
+        ++loaded;
+    }
+    for (const std::string& name : m_config.getModuleAllowlist()) {
+        if (!seen.count(name)) {
+            log_warn("Allowlisted module not found: %s", name.c_str());
+        }
+    }
+    const uint64_t rssAfter = platform::getProcessResidentBytes();
+    log_info("Modules: %d loaded, %d skipped, %d failed in %.1f ms (%s), RSS %.1f -> %.1f MB",
+             loaded, skipped, failed, (platform::getTimestampNanos() - loadStart) / 1e6,
+             m_moduleCatalog.fromCache() ? "manifest cache" : "directory scan",
+             rssBefore / 1048576.0, rssAfter / 1048576.0);
     
     // Explicitly load obs-browser-bridge plugin (it's a .so file, not a .plugin bundle)
 #ifdef __APPLE__
@@ -429,15 +627,21 @@ bool Engine::loadModules() {
     obs_log_loaded_modules();
     
     // Post-load initialization (this calls obs_module_post_load() on all modules)
-    log_info("DEBUG: About to call obs_post_load_modules()");
     obs_post_load_modules();
-    log_info("DEBUG: obs_post_load_modules() completed");
     
     log_info("Modules loaded successfully");
     return true;
 }
 
 bool Engine::setupDefaultScene() {
+    // A saved scene collection replaces the default scene
+    HeadlessFrontend* frontend = HeadlessFrontend::instance();
+    SceneCollectionStore::Format format = SceneCollectionStore::Format::Json;
+    SceneCollectionStore::parseFormat(m_config.getSceneFormat(), format);
+    if (frontend && frontend->openSceneCollection(m_config.getSceneCollection(), format)) {
+        return true;
+    }
+    
     log_info("Setting up default scene...");
     
     // Create a default scene
@@ -455,7 +659,6 @@ bool Engine::setupDefaultScene() {
     
     // IMPORTANT: Also set as current program scene via frontend API
     // This is required for obs-websocket to return the current scene correctly
-    HeadlessFrontend* frontend = HeadlessFrontend::instance();
     if (frontend) {
         frontend->obs_frontend_set_current_scene(sceneSource);
         log_info("Set default scene as current program scene");
@@ -468,6 +671,34 @@ bool Engine::setupDefaultScene() {
     return true;
 }
 
+bool Engine::setupCanvases() {
+    const auto& specs = m_config.getCanvases();
+    if (specs.empty()) {
+        return true;
+    }
+    HeadlessFrontend* frontend = HeadlessFrontend::instance();
+    if (!frontend) {
+        log_warn("Canvases need the frontend API; ignoring %zu --canvas option(s)", specs.size());
+        return false;
+    }
+
+    // Each canvas starts out showing the main program scene, scaled to fit
+    obs_source_t* mainScene = frontend->obs_frontend_get_current_scene();
+    bool ok = true;
+    for (const Config::CanvasSpec& spec : specs) {
+        obs_canvas_t* canvas = frontend->canvases().addWithScene(spec.name, static_cast<uint32_t>(spec.width),
+                                                                 static_cast<uint32_t>(spec.height),
+                                                                 static_cast<uint32_t>(spec.fps), mainScene);
+        if (canvas) {
+            frontend->on_event(OBS_FRONTEND_EVENT_CANVAS_ADDED);
+        } else {
+            ok = false;
+        }
+    }
+    obs_source_release(mainScene);
+    return ok;
+}
+
 bool Engine::setupDefaultTransition() {
     log_info("Setting up default transition...");
     
@@ -486,8 +717,8 @@ bool Engine::setupDefaultTransition() {
     // Set as current transition via frontend API
     HeadlessFrontend* frontend = HeadlessFrontend::instance();
     if (frontend) {
+        // The duration keeps the frontend default (300 ms) or the saved collection's value
         frontend->obs_frontend_set_current_transition(transition);
-        frontend->obs_frontend_set_transition_duration(300); // 300ms fade
         log_info("Set default transition: %s", obs_source_get_name(transition));
     }
     
@@ -499,68 +730,152 @@ bool Engine::setupDefaultTransition() {
 
 int Engine::run(std::atomic<bool>& running) {
     log_info("Entering main event loop...");
-#ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
-    m_lastHelperPing = std::chrono::steady_clock::now();
-#endif
     
     // CRITICAL: In headless mode, sources don't get video_tick() called unless we actively render
     // or have an output running. Browser sources need video_tick to initialize and receive frames.
     // We call obs_render_main_texture() manually to drive the rendering pipeline.
-    auto lastRenderTick = std::chrono::steady_clock::now();
+    //
+    // Ticks are scheduled on absolute deadlines at the configured frame rate
+    // (fps_num/fps_den as libobs sees it), so the tick period neither drifts
+    // nor picks up the time spent rendering. If a tick overruns the next
+    // deadline, the missed ticks are dropped instead of rendered back-to-back.
+    // The deadline is armed on the EventLoop timer (timerfd on Linux), so
+    // signals are handled the moment they arrive. Helper health checks run on
+    // the HelperHealthMonitor thread and never delay a tick; the helper
+    // socket is read and written there too, so this loop only waits on
+    // signals, the frame timer and wakeups.
+    //
+    // With --idle-timeout the IdleGovernor suspends rendering while no output
+    // is active and no control client is connected: it detaches the program
+    // from libobs' output channel and the loop skips its manual tick, only
+    // polling for consumers and re-anchoring the frame clock when one appears.
+    struct obs_video_info ovi = {};
+    uint64_t fpsNum = static_cast<uint64_t>(m_config.getFPS());
+    uint64_t fpsDen = 1;
+    if (obs_get_video_info(&ovi) && ovi.fps_num > 0 && ovi.fps_den > 0) {
+        fpsNum = ovi.fps_num;
+        fpsDen = ovi.fps_den;
+    }
+    uint64_t clockStart = platform::getTimestampNanos();
+    auto tickDeadline = [&](uint64_t tick) {
+        return clockStart + tick * 1000000000ULL * fpsDen / fpsNum;
+    };
+    log_info("Frame clock: %llu/%llu fps (%.3f ms period)",
+             static_cast<unsigned long long>(fpsNum), static_cast<unsigned long long>(fpsDen),
+             1000.0 * fpsDen / fpsNum);
 
+    FrameClockStats stats;
+    uint64_t lastReport = clockStart;
+    uint64_t tick = 0;
+    uint64_t lastObsFrameTime = obs_get_video_frame_time();
+    bool obsDrivingTicks = false;
+
+    IdleGovernor idle(m_config.getIdleTimeout(), static_cast<uint16_t>(m_config.getWebSocketPort()));
+    bool wasIdle = false;
+
+    // Opened by initialize(); a no-op unless run() is used without it
+    if (!m_eventLoop.open()) {
+        log_error("Failed to open the main event loop");
+        EventLoop::releaseSignals();
+        return 1;
+    }
+    log_info("Event loop: %s backend", m_eventLoop.backend());
+    m_eventLoop.setTimer(tickDeadline(1));
+
+    int exitCode = 0;
     while (running && !m_shutdownRequested) {
-        // The obs-websocket plugin handles its own event loop for WebSocket connections
-        // We just need to keep the process alive and process any pending events
-        
-        auto now = std::chrono::steady_clock::now();
+        // The obs-websocket plugin handles its own event loop for WebSocket connections;
+        // this thread sleeps until a signal, the frame timer or a wakeup
+        EventLoop::Events events;
+        if (!m_eventLoop.wait(events)) {
+            exitCode = 1;
+            break;
+        }
+        if (events.signal != 0) {
+            log_info("Received signal %d, initiating shutdown...", events.signal);
+            running = false;
+            break;
+        }
+        if (events.userSignal) {
+            // On-demand dump; runs on this thread, so expect one late tick
+            writeTrace();
+        }
+        if (!events.timer) {
+            continue;
+        }
 
-#ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastHelperPing).count();
-        if (elapsed >= 2000) { // ping every 2s
-            bool healthy = false;
-            if (m_browserHelperClient && m_browserHelperClient->isConnected()) {
-                healthy = m_browserHelperClient->ping();
-                if (!healthy) {
-                    log_warn("Helper ping failed; will attempt reconnect");
-                    m_browserHelperClient->stop();
-                }
-            }
+        TRACE_SCOPE("engine", "tick");
+        const uint64_t wake = platform::getTimestampNanos();
+        if (idle.update(wake)) {
+            wasIdle = true;
+            m_eventLoop.setTimer(wake + kIdlePollNanos);
+            continue;
+        }
+        if (wasIdle) {
+            // Resume on a fresh clock (tick 0 is due now) rather than dropping
+            // every tick we slept through
+            wasIdle = false;
+            clockStart = wake;
+            tick = 0;
+            lastReport = clockStart;
+            stats = FrameClockStats();
+            lastObsFrameTime = obs_get_video_frame_time();
+        } else {
+            ++tick;
+        }
+        const uint64_t deadline = tickDeadline(tick);
+        stats.record(wake > deadline ? wake - deadline : 0);
 
-            if (!healthy) {
-                if (!m_browserHelper.checkAlive() && !m_helperBundlePath.empty()) {
-                    log_warn("Helper process not alive; restarting...");
-                    m_browserHelper.start(m_helperBundlePath);
-                }
-                if (!m_browserHelperClient) {
-                    m_browserHelperClient = std::make_unique<BrowserHelperClient>();
-                }
-                m_browserHelperClient->start(static_cast<uint16_t>(m_helperPort), m_helperToken);
-            }
-            m_lastHelperPing = now;
+        // libobs' own video thread advances the video frame time whenever it
+        // renders; while it does, it is already ticking sources and a manual
+        // render would only duplicate the work
+        const uint64_t obsFrameTime = obs_get_video_frame_time();
+        const bool driving = obsFrameTime != lastObsFrameTime;
+        lastObsFrameTime = obsFrameTime;
+        if (driving != obsDrivingTicks) {
+            obsDrivingTicks = driving;
+            log_info(driving ? "Frame clock: libobs video thread is ticking sources, manual rendering paused"
+                             : "Frame clock: libobs video thread idle, resuming manual rendering");
         }
-#endif
 
-        // Tick OBS rendering pipeline at ~30 FPS to drive source video_tick callbacks
-        // This is essential for browser sources and other time-based sources to function
-        auto renderElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastRenderTick).count();
-        if (renderElapsed >= 33) { // ~30 FPS
+        if (!obsDrivingTicks) {
             // obs_render_main_texture() calls video_tick on all sources in the scene
             // Note: This requires graphics context, so we wrap in obs_enter_graphics/obs_leave_graphics
+            TRACE_SCOPE("engine", "render_main_texture");
             obs_enter_graphics();
             obs_render_main_texture();
             obs_leave_graphics();
-            lastRenderTick = now;
+            ++stats.rendered;
+        }
+
+        // Overrun: this tick's work ran past the next deadline
+        const uint64_t done = platform::getTimestampNanos();
+        if (done >= tickDeadline(tick + 1)) {
+            ++stats.overruns;
+            while (tickDeadline(tick + 1) <= done) {
+                ++tick;
+                ++stats.dropped;
+            }
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Reduced from 100ms for smoother ticking
+        if (done - lastReport >= kFrameClockReportNanos) {
+            stats.report(obsDrivingTicks);
+            stats = FrameClockStats();
+            lastReport = done;
+        }
+        m_eventLoop.setTimer(tickDeadline(tick + 1));
     }
     
+    m_eventLoop.close();
+    // Nothing reads the signalfd any more; let a second signal end shutdown
+    EventLoop::releaseSignals();
     log_info("Exiting main event loop");
-    return 0;
+    return exitCode;
 }
 
 void Engine::requestShutdown() {
     m_shutdownRequested = true;
+    m_eventLoop.wakeup();
 }
 
 void Engine::shutdown() {
@@ -591,20 +906,36 @@ void Engine::shutdown() {
     obs_shutdown();
     
 #ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
-    if (m_browserHelperClient) {
+    // Stop health checks first so nothing reconnects or restarts the helper
+    std::unique_ptr<BrowserHelperClient> helperClient;
+    {
+        std::lock_guard<std::mutex> lock(m_helperMonitorMutex);
+        if (m_helperMonitor) {
+            helperClient = m_helperMonitor->stop();
+            m_helperMonitor.reset();
+        }
+    }
+    if (helperClient && helperClient->isConnected()) {
         // First, request graceful shutdown via IPC
-        m_browserHelperClient->sendShutdown();
+        helperClient->sendShutdown();
         // Give it a moment to process the shutdown command
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
         // Then close our client connection
-        m_browserHelperClient->stop();
-        m_browserHelperClient.reset();
+        helperClient->stop();
     }
     // Finally, stop the helper process (with timeout for graceful exit)
     m_browserHelper.stop();
 #endif
+    m_obsLogRouter.uninstall();
     m_initialized = false;
     log_info("Engine shutdown complete");
+    writeTrace();
+}
+
+void Engine::writeTrace() {
+    if (Trace::enabled()) {
+        Trace::writeJson(m_config.getTraceFile());
+    }
 }
 
 std::string Engine::getPluginPath() const {
@@ -5,14 +5,23 @@
 #pragma once
 
 #include "config.h"
+#include "event_loop.h"
+#include "obs_log_router.h"
+#include "module_catalog.h"
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 // Forward declarations for OBS types
 struct obs_video_info;
 struct obs_audio_info;
+struct calldata;
 #include "browser_helper_launcher.h"
 #include "browser_helper_client.h"
+#include "helper_health_monitor.h"
 
 namespace streamlumo {
 
@@ -48,7 +57,7 @@ public:
     int run(std::atomic<bool>& running);
     
     /**
-     * @brief Request graceful shutdown
+     * @brief Request graceful shutdown (thread-safe, wakes the main loop)
      */
     void requestShutdown();
     
@@ -61,16 +70,29 @@ public:
      * @brief Check if engine is running
      */
     bool isRunning() const { return m_initialized && !m_shutdownRequested; }
+
+    /**
+     * @brief Signal that cancelled initialize(), 0 if startup was not interrupted
+     */
+    int startupSignal() const { return m_startupSignal; }
     
 private:
-    // Initialization steps
+    // Initialization steps (phases of the StartupGraph in initialize())
+    void exportEnvironment();
+    void resolveStartupPaths();
     bool initOBS();
     bool initVideo();
     bool initAudio();
+    void discoverModules();
+    bool moduleAllowed(const std::string& name) const;
     bool loadModules();
     bool setupDefaultScene();
+    bool setupCanvases();
     bool setupDefaultTransition();
     
+    // Dump the Chrome trace to --trace-file (no-op when tracing is off)
+    void writeTrace();
+    
     // Path helpers
     std::string getPluginPath() const;
     std::string getDataPath() const;
@@ -79,20 +101,44 @@ private:
     // Configuration
     const Config& m_config;
     
+    // Resolved by the "paths" startup phase (worker thread), used by initOBS()
+    struct StartupPaths {
+        std::string pluginPath;
+        std::string dataPath;
+        std::string configPath;
+        std::vector<std::pair<std::string, std::string>> modulePaths;  // bin, data
+    };
+    StartupPaths m_paths;
+    
+    // Filled by the "module-scan" startup phase, consumed by loadModules()
+    ModuleCatalog m_moduleCatalog;
+    
     // State
     bool m_initialized = false;
     std::atomic<bool> m_shutdownRequested{false};
+    int m_startupSignal = 0;
+    
+    // Main thread event loop (signals, frame timer, wakeups)
+    EventLoop m_eventLoop;
+    
+    // libobs/plugin blog() output -> Logging, installed before obs_startup()
+    ObsLogRouter m_obsLogRouter;
     
     // Test mode browser source
     void* m_testBrowserSource = nullptr;  // obs_source_t*
     bool createTestBrowserSource(const std::string& url);
 
+
 #ifdef STREAMLUMO_ENABLE_BROWSER_HELPER
+    bool launchBrowserHelper();
+    // proc: void streamlumo_browser_helper_restart(in int port, out bool accepted)
+    static void helperRestartProc(void* data, calldata* cd);
     BrowserHelperLauncher m_browserHelper;
-    std::unique_ptr<BrowserHelperClient> m_browserHelperClient;
+    // Set by the "helper" startup phase (worker thread), read by the proc
+    std::mutex m_helperMonitorMutex;
+    std::unique_ptr<HelperHealthMonitor> m_helperMonitor;
     int m_helperPort = 4777;
     std::string m_helperToken;
-    std::chrono::steady_clock::time_point m_lastHelperPing;
     std::string m_helperBundlePath;
 #endif
 };
@@ -0,0 +1,416 @@
+// streamlumo-engine/src/event_loop.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "event_loop.h"
+#include "logging.h"
+#include "platform/platform.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace streamlumo {
+
+#if defined(__linux__)
+
+static sigset_t terminationSignals()
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGHUP);
+    sigaddset(&set, SIGUSR1);
+    return set;
+}
+
+// Runs in the child of fork(); only async-signal-safe calls
+static void unblockInChild()
+{
+    sigset_t set = terminationSignals();
+    pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+}
+
+void EventLoop::captureSignals()
+{
+    sigset_t set = terminationSignals();
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+    static bool atforkRegistered = false;
+    if (!atforkRegistered) {
+        atforkRegistered = pthread_atfork(nullptr, nullptr, unblockInChild) == 0;
+    }
+}
+
+void EventLoop::releaseSignals()
+{
+    sigset_t set = terminationSignals();
+    pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+}
+
+const char* EventLoop::backend() const { return "epoll"; }
+
+bool EventLoop::open()
+{
+    if (m_open) {
+        return true;
+    }
+
+    sigset_t set = terminationSignals();
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_signalFd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epollFd < 0 || m_signalFd < 0 || m_timerFd < 0 || m_wakeFd < 0) {
+        log_error("Event loop: failed to create epoll/signalfd/timerfd/eventfd: %s", strerror(errno));
+        close();
+        return false;
+    }
+
+    for (int fd : {m_signalFd, m_timerFd, m_wakeFd}) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            log_error("Event loop: epoll_ctl failed: %s", strerror(errno));
+            close();
+            return false;
+        }
+    }
+    m_open = true;
+    return true;
+}
+
+void EventLoop::close()
+{
+    for (int* fd : {&m_epollFd, &m_signalFd, &m_timerFd, &m_wakeFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    m_open = false;
+}
+
+void EventLoop::setTimer(uint64_t deadlineNanos)
+{
+    m_deadlineNanos = deadlineNanos;
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = static_cast<time_t>(deadlineNanos / 1000000000ULL);
+    spec.it_value.tv_nsec = static_cast<long>(deadlineNanos % 1000000000ULL);
+    if (deadlineNanos != 0 && spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;  // An all-zero value would disarm the timer
+    }
+    timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void EventLoop::wakeup()
+{
+    uint64_t one = 1;
+    ssize_t n = write(m_wakeFd, &one, sizeof(one));
+    (void)n;  // EAGAIN: counter saturated, a wakeup is already pending
+}
+
+bool EventLoop::wait(Events& events)
+{
+    events = Events();
+
+    struct epoll_event ready[8];
+    int count;
+    do {
+        count = epoll_wait(m_epollFd, ready, 8, -1);
+    } while (count < 0 && errno == EINTR);
+    if (count < 0) {
+        log_error("Event loop: epoll_wait failed: %s", strerror(errno));
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const int fd = ready[i].data.fd;
+        if (fd == m_signalFd) {
+            struct signalfd_siginfo info;
+            while (read(m_signalFd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+                if (info.ssi_signo == SIGUSR1) {
+                    events.userSignal = true;
+                } else {
+                    events.signal = static_cast<int>(info.ssi_signo);
+                }
+            }
+        } else if (fd == m_timerFd) {
+            uint64_t expirations = 0;
+            if (read(m_timerFd, &expirations, sizeof(expirations)) > 0) {
+                events.timer = true;
+            }
+        } else if (fd == m_wakeFd) {
+            uint64_t value = 0;
+            if (read(m_wakeFd, &value, sizeof(value)) > 0) {
+                events.wakeup = true;
+            }
+        }
+    }
+    return true;
+}
+
+int EventLoop::pendingSignal()
+{
+    int signal = 0;
+    struct signalfd_siginfo info;
+    while (m_signalFd >= 0 &&
+           read(m_signalFd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+        if (info.ssi_signo != SIGUSR1) {
+            signal = static_cast<int>(info.ssi_signo);
+        }
+    }
+    return signal;
+}
+
+#elif !defined(_WIN32)
+
+// Written by the signal handler; read end is watched by every open loop
+static int s_signalPipe[2] = {-1, -1};
+
+static void signalToPipe(int sig)
+{
+    const int savedErrno = errno;
+    unsigned char byte = static_cast<unsigned char>(sig);
+    ssize_t n = write(s_signalPipe[1], &byte, 1);
+    (void)n;
+    errno = savedErrno;
+}
+
+static bool makeNonBlockingPipe(int fds[2])
+{
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    for (int i = 0; i < 2; ++i) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    return true;
+}
+
+void EventLoop::captureSignals()
+{
+    if (s_signalPipe[0] >= 0 || !makeNonBlockingPipe(s_signalPipe)) {
+        return;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signalToPipe;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGHUP, &sa, nullptr);
+    sigaction(SIGUSR1, &sa, nullptr);
+}
+
+void EventLoop::releaseSignals()
+{
+    // Handlers are reset by exec, so children never saw them
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGHUP, SIG_DFL);
+    signal(SIGUSR1, SIG_DFL);
+}
+
+const char* EventLoop::backend() const { return "poll"; }
+
+bool EventLoop::open()
+{
+    if (m_open) {
+        return true;
+    }
+    if (!makeNonBlockingPipe(m_wakePipe)) {
+        log_error("Event loop: failed to create wakeup pipe: %s", strerror(errno));
+        return false;
+    }
+    m_open = true;
+    return true;
+}
+
+void EventLoop::close()
+{
+    for (int& fd : m_wakePipe) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    m_open = false;
+}
+
+void EventLoop::setTimer(uint64_t deadlineNanos)
+{
+    m_deadlineNanos = deadlineNanos;
+}
+
+void EventLoop::wakeup()
+{
+    unsigned char byte = 1;
+    ssize_t n = write(m_wakePipe[1], &byte, 1);
+    (void)n;
+}
+
+bool EventLoop::wait(Events& events)
+{
+    events = Events();
+
+    struct pollfd pfds[2] = {{m_wakePipe[0], POLLIN, 0}, {s_signalPipe[0], POLLIN, 0}};
+    const nfds_t count = s_signalPipe[0] >= 0 ? 2 : 1;
+
+    for (;;) {
+        int timeoutMs = -1;
+        if (m_deadlineNanos != 0) {
+            const uint64_t now = platform::getTimestampNanos();
+            timeoutMs = now >= m_deadlineNanos
+                ? 0 : static_cast<int>((m_deadlineNanos - now) / 1000000ULL);
+        }
+
+        int ready = poll(pfds, count, timeoutMs);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("Event loop: poll failed: %s", strerror(errno));
+            return false;
+        }
+
+        if (ready == 0) {
+            // poll() only has millisecond resolution: sleep off the remainder
+            platform::sleepUntilNanos(m_deadlineNanos);
+            m_deadlineNanos = 0;
+            events.timer = true;
+            return true;
+        }
+
+        unsigned char buffer[64];
+        if (pfds[0].revents & POLLIN) {
+            while (read(m_wakePipe[0], buffer, sizeof(buffer)) > 0) {
+            }
+            events.wakeup = true;
+        }
+        if (count > 1 && (pfds[1].revents & POLLIN)) {
+            ssize_t n;
+            while ((n = read(s_signalPipe[0], buffer, sizeof(buffer))) > 0) {
+                for (ssize_t j = 0; j < n; ++j) {
+                    if (buffer[j] == SIGUSR1) {
+                        events.userSignal = true;
+                    } else {
+                        events.signal = buffer[j];
+                    }
+                }
+            }
+        }
+        if (m_deadlineNanos != 0 && platform::getTimestampNanos() >= m_deadlineNanos) {
+            m_deadlineNanos = 0;
+            events.timer = true;
+        }
+        return true;
+    }
+}
+
+int EventLoop::pendingSignal()
+{
+    int signal = 0;
+    unsigned char buffer[64];
+    ssize_t n;
+    while (s_signalPipe[0] >= 0 && (n = read(s_signalPipe[0], buffer, sizeof(buffer))) > 0) {
+        for (ssize_t j = 0; j < n; ++j) {
+            if (buffer[j] != SIGUSR1) {
+                signal = buffer[j];
+            }
+        }
+    }
+    return signal;
+}
+
+#else
+
+static volatile sig_atomic_t s_pendingSignal = 0;
+
+static void recordSignal(int sig)
+{
+    s_pendingSignal = sig;
+}
+
+void EventLoop::captureSignals()
+{
+    std::signal(SIGINT, recordSignal);
+    std::signal(SIGTERM, recordSignal);
+}
+
+void EventLoop::releaseSignals()
+{
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+}
+
+const char* EventLoop::backend() const { return "sleep"; }
+
+bool EventLoop::open()
+{
+    m_open = true;
+    return true;
+}
+
+void EventLoop::close()
+{
+    m_open = false;
+}
+
+void EventLoop::setTimer(uint64_t deadlineNanos)
+{
+    m_deadlineNanos = deadlineNanos;
+}
+
+void EventLoop::wakeup()
+{
+}
+
+bool EventLoop::wait(Events& events)
+{
+    events = Events();
+    // Signals are noticed at the next deadline (at most one idle poll late)
+    if (m_deadlineNanos != 0) {
+        platform::sleepUntilNanos(m_deadlineNanos);
+        m_deadlineNanos = 0;
+        events.timer = true;
+    } else {
+        platform::sleepUntilNanos(platform::getTimestampNanos() + 100000000ULL);
+    }
+    events.signal = s_pendingSignal;
+    s_pendingSignal = 0;
+    return true;
+}
+
+int EventLoop::pendingSignal()
+{
+    const int signal = s_pendingSignal;
+    s_pendingSignal = 0;
+    return signal;
+}
+
+#endif
+
+EventLoop::~EventLoop()
+{
+    close();
+}
+
+} // namespace streamlumo
@@ -0,0 +1,104 @@
+// streamlumo-engine/src/event_loop.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <cstdint>
+
+namespace streamlumo {
+
+/**
+ * @brief Single-threaded readiness loop for the engine's main thread
+ * 
+ * Waits on termination signals, one absolute frame timer and an internal
+ * wakeup at once, so the main thread sleeps until one of them has something
+ * to do. Helper health checks run on their own thread (HelperHealthMonitor);
+ * other threads reach the loop through wakeup(), e.g. Engine::requestShutdown().
+ * 
+ * - Linux: epoll over a signalfd, a timerfd (CLOCK_MONOTONIC, absolute) and
+ *   an eventfd.
+ * - Other POSIX: poll() over a self-pipe written by an async-signal-safe
+ *   handler and the wakeup pipe; the timer is the poll timeout, topped up
+ *   with platform::sleepUntilNanos() for sub-millisecond precision.
+ * - Windows: wait() sleeps until the timer and reports signals recorded by
+ *   a flag-only handler.
+ */
+class EventLoop {
+public:
+    struct Events {
+        int signal = 0;       // Termination signal received (0 = none)
+        bool userSignal = false; // SIGUSR1 received (POSIX only)
+        bool timer = false;   // Timer deadline reached
+        bool wakeup = false;  // wakeup() was called
+    };
+
+    EventLoop() = default;
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Route SIGINT/SIGTERM/SIGHUP/SIGUSR1 to the loop instead of handlers
+     * 
+     * Call from main() before any thread is started: on Linux the signals
+     * are blocked so every thread inherits the mask and they are only ever
+     * consumed through the signalfd. The engine opens its loop at the start
+     * of initialize() and polls pendingSignal() between startup phases, so
+     * a signal during startup is acted on there rather than held until run(). Children do not inherit the mask:
+     * forked children clear it in a pthread_atfork() handler, and the
+     * posix_spawn() calls in the engine and the browser bridge pass an
+     * empty one with POSIX_SPAWN_SETSIGMASK.
+     */
+    static void captureSignals();
+
+    /**
+     * @brief Undo captureSignals() once the loop no longer reads signals
+     * 
+     * Restores default delivery for the calling thread, so a signal that
+     * arrives during shutdown takes its default action instead of staying
+     * pending forever.
+     */
+    static void releaseSignals();
+
+    bool open();
+    void close();
+    bool isOpen() const { return m_open; }
+    const char* backend() const;
+
+    // Absolute CLOCK_MONOTONIC deadline (platform::getTimestampNanos()); 0 disarms
+    void setTimer(uint64_t deadlineNanos);
+
+    // Thread-safe and async-signal-safe
+    void wakeup();
+
+    /**
+     * @brief Block until at least one event is ready
+     * @return false if the underlying wait failed
+     */
+    bool wait(Events& events);
+
+    /**
+     * @brief Non-blocking check for a termination signal (startup phases)
+     * 
+     * Consumes what is pending; a SIGUSR1 read here is dropped.
+     * @return The signal number, 0 if none arrived
+     */
+    int pendingSignal();
+
+private:
+    bool m_open = false;
+    uint64_t m_deadlineNanos = 0;
+
+#if defined(__linux__)
+    int m_epollFd = -1;
+    int m_signalFd = -1;
+    int m_timerFd = -1;
+    int m_wakeFd = -1;
+#elif !defined(_WIN32)
+    int m_wakePipe[2] = {-1, -1};
+#endif
+};
+
+} // namespace streamlumo
@@ -0,0 +1,239 @@
+// streamlumo-engine/src/flv_muxer.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "flv_muxer.h"
+
+#include <obs-avc.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace streamlumo {
+
+namespace {
+
+constexpr uint8_t kTagAudio = 8;
+constexpr uint8_t kTagVideo = 9;
+constexpr uint8_t kTagScript = 18;
+
+constexpr uint8_t kAmfNumber = 0x00;
+constexpr uint8_t kAmfBoolean = 0x01;
+constexpr uint8_t kAmfString = 0x02;
+constexpr uint8_t kAmfObject = 0x03;
+constexpr uint8_t kAmfEcmaArray = 0x08;
+constexpr uint8_t kAmfObjectEnd = 0x09;
+
+// FLV video tag byte: frame type (1 key, 2 inter) << 4 | codec 7 (AVC)
+constexpr uint8_t kVideoKeyframe = 0x17;
+constexpr uint8_t kVideoInterframe = 0x27;
+// FLV audio tag byte: AAC, 44 kHz, 16 bit, stereo (fixed for AAC)
+constexpr uint8_t kAudioAac = 0xAF;
+
+void put8(std::vector<uint8_t>& out, uint8_t value) {
+    out.push_back(value);
+}
+
+void putBe16(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putBe24(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    putBe16(out, value);
+}
+
+void putBe32(std::vector<uint8_t>& out, uint32_t value) {
+    putBe16(out, value >> 16);
+    putBe16(out, value);
+}
+
+std::vector<uint8_t> amfDouble(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    std::vector<uint8_t> out;
+    putBe32(out, static_cast<uint32_t>(bits >> 32));
+    putBe32(out, static_cast<uint32_t>(bits));
+    return out;
+}
+
+void putAmfKey(std::vector<uint8_t>& out, const char* key) {
+    const size_t length = strlen(key);
+    putBe16(out, static_cast<uint32_t>(length));
+    out.insert(out.end(), key, key + length);
+}
+
+void putAmfString(std::vector<uint8_t>& out, const std::string& value) {
+    const size_t length = std::min<size_t>(value.size(), 0xFFFF);
+    put8(out, kAmfString);
+    putBe16(out, static_cast<uint32_t>(length));
+    out.insert(out.end(), value.begin(), value.begin() + length);
+}
+
+// Returns the offset of the 8 value bytes within out
+size_t putAmfNumber(std::vector<uint8_t>& out, const char* key, double value) {
+    putAmfKey(out, key);
+    put8(out, kAmfNumber);
+    const size_t offset = out.size();
+    const std::vector<uint8_t> bytes = amfDouble(value);
+    out.insert(out.end(), bytes.begin(), bytes.end());
+    return offset;
+}
+
+void putAmfBool(std::vector<uint8_t>& out, const char* key, bool value) {
+    putAmfKey(out, key);
+    put8(out, kAmfBoolean);
+    put8(out, value ? 1 : 0);
+}
+
+void putAmfEnd(std::vector<uint8_t>& out) {
+    putBe24(out, kAmfObjectEnd);
+}
+
+std::vector<uint8_t> extraData(obs_encoder_t* encoder) {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    if (!encoder || !obs_encoder_get_extra_data(encoder, &data, &size) || !data) {
+        return {};
+    }
+    return std::vector<uint8_t>(data, data + size);
+}
+
+} // namespace
+
+int64_t FlvMuxer::toMillis(int64_t value, const encoder_packet* packet) {
+    return value * 1000 * packet->timebase_num / packet->timebase_den;
+}
+
+FlvMuxer::StreamInfo FlvMuxer::describe(obs_encoder_t* video, obs_encoder_t* audio) {
+    StreamInfo info;
+    obs_video_info ovi = {};
+    if (obs_get_video_info(&ovi) && ovi.fps_den > 0) {
+        info.framerate = static_cast<double>(ovi.fps_num) / ovi.fps_den;
+    }
+    // The encoder may run on another canvas, at its own rate
+    video_t* encoderVideo = video ? obs_encoder_video(video) : nullptr;
+    const video_output_info* voi = encoderVideo ? video_output_get_info(encoderVideo) : nullptr;
+    if (voi && voi->fps_den > 0) {
+        info.framerate = static_cast<double>(voi->fps_num) / voi->fps_den;
+    }
+    if (video) {
+        info.width = obs_encoder_get_width(video);
+        info.height = obs_encoder_get_height(video);
+        obs_data_t* settings = obs_encoder_get_settings(video);
+        info.videoBitrate = obs_data_get_int(settings, "bitrate");
+        obs_data_release(settings);
+        info.videoConfig = extraData(video);
+    }
+    if (audio) {
+        info.sampleRate = obs_encoder_get_sample_rate(audio);
+        obs_data_t* settings = obs_encoder_get_settings(audio);
+        info.audioBitrate = obs_data_get_int(settings, "bitrate");
+        obs_data_release(settings);
+        info.audioConfig = extraData(audio);
+    }
+    return info;
+}
+
+void FlvMuxer::writeHeader(const StreamInfo& info) {
+    // "FLV", version 1, audio + video, header size 9, PreviousTagSize0
+    static const uint8_t kHeader[13] = {'F', 'L', 'V', 1, 5, 0, 0, 0, 9, 0, 0, 0, 0};
+    m_writer.append(kHeader, sizeof(kHeader));
+    m_bytesWritten += sizeof(kHeader);
+
+    std::vector<uint8_t> meta;
+    putAmfString(meta, "onMetaData");
+    put8(meta, kAmfEcmaArray);
+    putBe32(meta, 12);
+    // Patched when the file is closed; the tag data follows the 11-byte tag header
+    const uint64_t dataStart = m_writer.fileOffset() + 11;
+    m_durationOffset = dataStart + putAmfNumber(meta, "duration", 0.0);
+    m_fileSizeOffset = dataStart + putAmfNumber(meta, "filesize", 0.0);
+    putAmfNumber(meta, "width", info.width);
+    putAmfNumber(meta, "height", info.height);
+    putAmfNumber(meta, "videocodecid", 7.0);
+    putAmfNumber(meta, "videodatarate", static_cast<double>(info.videoBitrate));
+    putAmfNumber(meta, "framerate", info.framerate);
+    putAmfNumber(meta, "audiocodecid", 10.0);
+    putAmfNumber(meta, "audiodatarate", static_cast<double>(info.audioBitrate));
+    putAmfNumber(meta, "audiosamplerate", info.sampleRate);
+    putAmfNumber(meta, "audiosamplesize", 16.0);
+    putAmfBool(meta, "stereo", true);
+    putAmfEnd(meta);
+    writeTag(kTagScript, 0, nullptr, 0, meta.data(), meta.size());
+
+    // AVCDecoderConfigurationRecord and AudioSpecificConfig
+    if (!info.videoConfig.empty()) {
+        uint8_t* avcc = nullptr;
+        const size_t avccSize = obs_parse_avc_header(&avcc, info.videoConfig.data(), info.videoConfig.size());
+        const uint8_t prefix[5] = {kVideoKeyframe, 0, 0, 0, 0};
+        writeTag(kTagVideo, 0, prefix, sizeof(prefix), avcc, avccSize);
+        bfree(avcc);
+    }
+    if (!info.audioConfig.empty()) {
+        const uint8_t prefix[2] = {kAudioAac, 0};
+        writeTag(kTagAudio, 0, prefix, sizeof(prefix), info.audioConfig.data(), info.audioConfig.size());
+    }
+}
+
+void FlvMuxer::writeVideo(int64_t millis, const encoder_packet* packet) {
+    encoder_packet avc = {};
+    obs_parse_avc_packet(&avc, packet);
+    const int32_t cts = static_cast<int32_t>(toMillis(packet->pts, packet) - toMillis(packet->dts, packet));
+    const uint8_t prefix[5] = {
+        packet->keyframe ? kVideoKeyframe : kVideoInterframe, 1,
+        static_cast<uint8_t>(cts >> 16), static_cast<uint8_t>(cts >> 8), static_cast<uint8_t>(cts)};
+    writeTag(kTagVideo, millis, prefix, sizeof(prefix), avc.data, avc.size);
+    obs_encoder_packet_release(&avc);
+}
+
+void FlvMuxer::writeAudio(int64_t millis, const encoder_packet* packet) {
+    const uint8_t prefix[2] = {kAudioAac, 1};
+    writeTag(kTagAudio, millis, prefix, sizeof(prefix), packet->data, packet->size);
+}
+
+void FlvMuxer::writeCuePoint(int64_t millis, const std::string& name) {
+    std::vector<uint8_t> cue;
+    putAmfString(cue, "onCuePoint");
+    put8(cue, kAmfObject);
+    putAmfKey(cue, "name");
+    putAmfString(cue, name);
+    putAmfNumber(cue, "time", millis / 1000.0);
+    putAmfKey(cue, "type");
+    putAmfString(cue, "navigation");
+    putAmfEnd(cue);
+    writeTag(kTagScript, millis, nullptr, 0, cue.data(), cue.size());
+}
+
+std::vector<AsyncFileWriter::Patch> FlvMuxer::closingPatches(int64_t durationMillis) const {
+    std::vector<AsyncFileWriter::Patch> patches(2);
+    patches[0].offset = m_durationOffset;
+    patches[0].bytes = amfDouble(durationMillis / 1000.0);
+    patches[1].offset = m_fileSizeOffset;
+    patches[1].bytes = amfDouble(static_cast<double>(m_writer.fileOffset()));
+    return patches;
+}
+
+void FlvMuxer::writeTag(uint8_t type, int64_t millis, const uint8_t* prefix, size_t prefixSize,
+                        const uint8_t* data, size_t size) {
+    const uint32_t dataSize = static_cast<uint32_t>(prefixSize + size);
+    const uint32_t timestamp = static_cast<uint32_t>(millis);
+
+    m_tag.clear();
+    put8(m_tag, type);
+    putBe24(m_tag, dataSize);
+    putBe24(m_tag, timestamp & 0xFFFFFF);
+    put8(m_tag, static_cast<uint8_t>(timestamp >> 24));
+    putBe24(m_tag, 0);
+    m_tag.insert(m_tag.end(), prefix, prefix + prefixSize);
+    m_writer.append(m_tag.data(), m_tag.size());
+    m_writer.append(data, size);
+
+    m_tag.clear();
+    putBe32(m_tag, dataSize + 11);
+    m_writer.append(m_tag.data(), m_tag.size());
+    m_bytesWritten += dataSize + 15;
+}
+
+} // namespace streamlumo
@@ -0,0 +1,68 @@
+// streamlumo-engine/src/flv_muxer.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include "async_file_writer.h"
+
+#include <obs.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Builds FLV (H.264 + AAC) tags into an AsyncFileWriter
+ *
+ * Timestamps are milliseconds relative to the start of the file. Video
+ * packets are taken as the encoder produced them (Annex B) and converted
+ * to AVCC here.
+ */
+class FlvMuxer {
+public:
+    // Everything the file header needs, copied so it outlives the encoders
+    struct StreamInfo {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        double framerate = 0.0;
+        int64_t videoBitrate = 0;
+        int64_t audioBitrate = 0;
+        uint32_t sampleRate = 0;
+        std::vector<uint8_t> videoConfig;    // Encoder extra data (SPS/PPS, Annex B)
+        std::vector<uint8_t> audioConfig;    // AudioSpecificConfig
+    };
+
+    static StreamInfo describe(obs_encoder_t* video, obs_encoder_t* audio);
+
+    // Packet pts/dts in milliseconds
+    static int64_t toMillis(int64_t value, const encoder_packet* packet);
+
+    explicit FlvMuxer(AsyncFileWriter& writer) : m_writer(writer) {}
+
+    // FLV header, onMetaData and the decoder configuration tags
+    void writeHeader(const StreamInfo& info);
+    void writeVideo(int64_t millis, const encoder_packet* packet);
+    void writeAudio(int64_t millis, const encoder_packet* packet);
+    void writeCuePoint(int64_t millis, const std::string& name);
+
+    // Fills in onMetaData duration/filesize; pass to AsyncFileWriter::closeFile()
+    std::vector<AsyncFileWriter::Patch> closingPatches(int64_t durationMillis) const;
+
+    // Bytes muxed since the muxer was created
+    uint64_t bytesWritten() const { return m_bytesWritten; }
+
+private:
+    void writeTag(uint8_t type, int64_t millis, const uint8_t* prefix, size_t prefixSize,
+                  const uint8_t* data, size_t size);
+
+    AsyncFileWriter& m_writer;
+    uint64_t m_durationOffset = 0;
+    uint64_t m_fileSizeOffset = 0;
+    uint64_t m_bytesWritten = 0;
+    std::vector<uint8_t> m_tag;
+};
+
+} // namespace streamlumo
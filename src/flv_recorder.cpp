@@ -0,0 +1,396 @@
+// streamlumo-engine/src/flv_recorder.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "flv_recorder.h"
+#include "async_file_writer.h"
+#include "flv_muxer.h"
+#include "logging.h"
+#include "platform/platform.h"
+#include "trace.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace streamlumo {
+
+const char* const kFlvRecorderOutputId = "streamlumo_flv_recorder";
+
+namespace {
+
+// "dir/2024-01-01 10-00-00.flv", 2 -> "dir/2024-01-01 10-00-00 (2).flv"
+std::string numberedPath(const std::string& path, int part) {
+    if (part <= 1) {
+        return path;
+    }
+    const std::string ext = platform::getExtension(path);
+    const std::string stem = ext.empty() ? path : path.substr(0, path.size() - ext.size() - 1);
+    return stem + " (" + std::to_string(part) + ")" + (ext.empty() ? "" : "." + ext);
+}
+
+std::string sidecarPath(const std::string& path) {
+    const std::string ext = platform::getExtension(path);
+    return (ext.empty() ? path : path.substr(0, path.size() - ext.size() - 1)) + ".chapters.ffmeta";
+}
+
+class FlvRecorder {
+public:
+    explicit FlvRecorder(obs_output_t* output);
+    ~FlvRecorder();
+
+    bool start();
+    void stop(uint64_t ts);
+    void onPacket(encoder_packet* packet);
+    uint64_t totalBytes() const { return m_totalBytes; }
+
+    static void splitFileProc(void* data, calldata_t* cd);
+    static void addChapterProc(void* data, calldata_t* cd);
+
+private:
+    struct Chapter {
+        int64_t millis = 0;
+        std::string name;
+    };
+
+    void openFile(int64_t startMillis);
+    void closeCurrentFile();
+    void writeChapters(int64_t millis);
+    bool shouldSplit(int64_t millis);
+    void stopNow(int code);
+    void joinFinalizer();
+
+    obs_output_t* m_output = nullptr;
+    AsyncFileWriter m_writer;
+    FlvMuxer m_muxer{m_writer};
+    std::thread m_finalizer;
+
+    // Settings, read at start
+    std::string m_basePath;
+    uint64_t m_maxBytes = 0;
+    int64_t m_maxMillis = 0;
+    bool m_directIO = false;
+
+    // Mux state; the encoder thread and stop() both take m_mutex
+    std::mutex m_mutex;
+    bool m_active = false;
+    int64_t m_stopTsUsec = 0;
+    bool m_fileOpen = false;
+    int m_part = 0;
+    std::string m_path;
+    int64_t m_fileStartMillis = 0;
+    int64_t m_lastMillis = 0;
+    std::vector<Chapter> m_fileChapters;
+    uint64_t m_sessionStartBytes = 0;
+    std::atomic<uint64_t> m_totalBytes{0};     // Read by obs_output_get_total_bytes()
+
+    // Requests from proc calls on arbitrary threads
+    std::mutex m_requestMutex;
+    bool m_splitRequested = false;
+    std::vector<std::string> m_pendingChapters;
+    int m_chapterCount = 0;
+};
+
+FlvRecorder::FlvRecorder(obs_output_t* output)
+    : m_output(output) {
+    proc_handler_t* procs = obs_output_get_proc_handler(output);
+    proc_handler_add(procs, "void split_file(out bool split_file_enabled)", splitFileProc, this);
+    proc_handler_add(procs, "void add_chapter(string chapter_name, out bool success)", addChapterProc, this);
+    signal_handler_add(obs_output_get_signal_handler(output), "void file_changed(string next_file)");
+}
+
+FlvRecorder::~FlvRecorder() {
+    joinFinalizer();
+    m_writer.stop();
+}
+
+void FlvRecorder::joinFinalizer() {
+    if (m_finalizer.joinable()) {
+        m_finalizer.join();
+    }
+}
+
+bool FlvRecorder::start() {
+    joinFinalizer();
+
+    obs_data_t* settings = obs_output_get_settings(m_output);
+    const char* path = obs_data_get_string(settings, "path");
+    m_basePath = path ? path : "";
+    m_maxBytes = static_cast<uint64_t>(obs_data_get_int(settings, "max_size_mb")) * 1024 * 1024;
+    m_maxMillis = obs_data_get_int(settings, "max_time_sec") * 1000;
+    m_directIO = obs_data_get_bool(settings, "direct_io");
+    obs_data_release(settings);
+
+    if (m_basePath.empty()) {
+        obs_output_set_last_error(m_output, "No recording path set");
+        return false;
+    }
+    obs_encoder_t* video = obs_output_get_video_encoder(m_output);
+    obs_encoder_t* audio = obs_output_get_audio_encoder(m_output, 0);
+    if (!video || !audio || strcmp(obs_encoder_get_codec(video), "h264") != 0 ||
+        strcmp(obs_encoder_get_codec(audio), "aac") != 0) {
+        obs_output_set_last_error(m_output, "FLV recording needs an H.264 video and an AAC audio encoder");
+        return false;
+    }
+    if (!obs_output_can_begin_data_capture(m_output, 0) || !obs_output_initialize_encoders(m_output, 0)) {
+        return false;
+    }
+
+    AsyncFileWriter::Options options;
+    options.directIO = m_directIO;
+    m_writer.start(options);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_active = true;
+        m_stopTsUsec = 0;
+        m_fileOpen = false;
+        m_part = 0;
+        m_totalBytes = 0;
+        m_sessionStartBytes = m_muxer.bytesWritten();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        m_splitRequested = false;
+        m_pendingChapters.clear();
+        m_chapterCount = 0;
+    }
+
+    log_info("FLV recorder: recording to %s (split at %llu MB / %lld s, %s I/O)", m_basePath.c_str(),
+             static_cast<unsigned long long>(m_maxBytes / (1024 * 1024)),
+             static_cast<long long>(m_maxMillis / 1000), m_directIO ? "direct" : "buffered");
+    return obs_output_begin_data_capture(m_output, 0);
+}
+
+void FlvRecorder::stop(uint64_t ts) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_active) {
+        return;
+    }
+    if (ts == 0) {
+        stopNow(OBS_OUTPUT_SUCCESS);
+    } else {
+        // Keep muxing packets captured before the stop request
+        m_stopTsUsec = static_cast<int64_t>(ts / 1000);
+    }
+}
+
+// Caller holds m_mutex. Flushing to disk and joining the writer happen on
+// a separate thread so neither the encoder thread nor the caller of
+// obs_output_stop() waits for the disk.
+void FlvRecorder::stopNow(int code) {
+    m_active = false;
+    if (m_fileOpen) {
+        closeCurrentFile();
+    }
+    joinFinalizer();
+    m_finalizer = std::thread([this, code] {
+        platform::setThreadName("flv-finalize");
+        m_writer.stop();
+        const AsyncFileWriter::Stats stats = m_writer.stats();
+        log_info("FLV recorder: %.1f MB in %llu writes (avg %.2f ms, slowest %.1f ms), peak queue %.1f MB, "
+                 "%llu encoder-thread stalls (%.1f ms)",
+                 stats.bytesWritten / 1048576.0, static_cast<unsigned long long>(stats.writes),
+                 stats.writes > 0 ? stats.totalWriteMicros / 1000.0 / stats.writes : 0.0,
+                 stats.maxWriteMicros / 1000.0, stats.peakQueuedBytes / 1048576.0,
+                 static_cast<unsigned long long>(stats.stalls), stats.stallMicros / 1000.0);
+        if (code == OBS_OUTPUT_SUCCESS) {
+            obs_output_end_data_capture(m_output);
+        } else {
+            obs_output_signal_stop(m_output, code);
+        }
+    });
+}
+
+bool FlvRecorder::shouldSplit(int64_t millis) {
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        if (m_splitRequested) {
+            m_splitRequested = false;
+            return true;
+        }
+    }
+    return (m_maxBytes > 0 && m_writer.fileOffset() >= m_maxBytes) ||
+           (m_maxMillis > 0 && millis >= m_maxMillis);
+}
+
+void FlvRecorder::onPacket(encoder_packet* packet) {
+    if (!packet) {
+        // Encoder failure
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_active) {
+            stopNow(OBS_OUTPUT_ENCODE_ERROR);
+        }
+        return;
+    }
+
+    TRACE_SCOPE("output", "flv_mux");
+    std::string changedTo;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_active) {
+            return;
+        }
+        if (m_writer.failed()) {
+            obs_output_set_last_error(m_output, "Writing the recording failed (disk full or removed?)");
+            stopNow(OBS_OUTPUT_ERROR);
+            return;
+        }
+        if (m_stopTsUsec != 0 && packet->sys_dts_usec >= m_stopTsUsec) {
+            stopNow(OBS_OUTPUT_SUCCESS);
+            return;
+        }
+
+        const bool video = packet->type == OBS_ENCODER_VIDEO;
+        if (!video && packet->track_idx != 0) {
+            return;
+        }
+        const int64_t dtsMillis = FlvMuxer::toMillis(packet->dts, packet);
+
+        // Files start on a keyframe so every part plays on its own
+        if (video && packet->keyframe) {
+            if (!m_fileOpen) {
+                openFile(dtsMillis);
+            } else if (shouldSplit(dtsMillis - m_fileStartMillis)) {
+                closeCurrentFile();
+                openFile(dtsMillis);
+                changedTo = m_path;
+            }
+        }
+        if (!m_fileOpen) {
+            return;
+        }
+        const int64_t millis = dtsMillis - m_fileStartMillis;
+        if (millis < 0) {
+            // Audio captured before the file's first keyframe
+            return;
+        }
+        writeChapters(millis);
+
+        if (video) {
+            m_muxer.writeVideo(millis, packet);
+        } else {
+            m_muxer.writeAudio(millis, packet);
+        }
+        m_totalBytes = m_muxer.bytesWritten() - m_sessionStartBytes;
+        m_lastMillis = std::max(m_lastMillis, millis);
+    }
+
+    if (!changedTo.empty()) {
+        uint8_t stack[256];
+        calldata_t cd;
+        calldata_init_fixed(&cd, stack, sizeof(stack));
+        calldata_set_string(&cd, "next_file", changedTo.c_str());
+        signal_handler_signal(obs_output_get_signal_handler(m_output), "file_changed", &cd);
+    }
+}
+
+void FlvRecorder::openFile(int64_t startMillis) {
+    m_part++;
+    m_path = numberedPath(m_basePath, m_part);
+    m_fileStartMillis = startMillis;
+    m_lastMillis = 0;
+    m_fileChapters.clear();
+    m_writer.open(m_path);
+    m_fileOpen = true;
+    m_muxer.writeHeader(FlvMuxer::describe(obs_output_get_video_encoder(m_output),
+                                           obs_output_get_audio_encoder(m_output, 0)));
+    if (m_part > 1) {
+        log_info("FLV recorder: split to %s", m_path.c_str());
+    }
+}
+
+void FlvRecorder::closeCurrentFile() {
+    std::string chapters;
+    if (!m_fileChapters.empty()) {
+        chapters = ";FFMETADATA1\n";
+        for (size_t i = 0; i < m_fileChapters.size(); ++i) {
+            const int64_t end = i + 1 < m_fileChapters.size() ? m_fileChapters[i + 1].millis : m_lastMillis;
+            chapters += "[CHAPTER]\nTIMEBASE=1/1000\nSTART=" + std::to_string(m_fileChapters[i].millis) +
+                        "\nEND=" + std::to_string(std::max(end, m_fileChapters[i].millis)) +
+                        "\ntitle=" + m_fileChapters[i].name + "\n";
+        }
+    }
+    m_writer.closeFile(m_muxer.closingPatches(m_lastMillis),
+                       chapters.empty() ? std::string() : sidecarPath(m_path), chapters);
+    m_fileOpen = false;
+}
+
+void FlvRecorder::writeChapters(int64_t millis) {
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        if (m_pendingChapters.empty()) {
+            return;
+        }
+        names.swap(m_pendingChapters);
+    }
+    for (std::string& name : names) {
+        m_muxer.writeCuePoint(millis, name);
+
+        Chapter chapter;
+        chapter.millis = millis;
+        chapter.name = std::move(name);
+        m_fileChapters.push_back(std::move(chapter));
+    }
+}
+
+void FlvRecorder::splitFileProc(void* data, calldata_t* cd) {
+    auto* recorder = static_cast<FlvRecorder*>(data);
+    bool active;
+    {
+        std::lock_guard<std::mutex> lock(recorder->m_mutex);
+        active = recorder->m_active;
+    }
+    if (active) {
+        std::lock_guard<std::mutex> lock(recorder->m_requestMutex);
+        recorder->m_splitRequested = true;
+    }
+    calldata_set_bool(cd, "split_file_enabled", active);
+}
+
+void FlvRecorder::addChapterProc(void* data, calldata_t* cd) {
+    auto* recorder = static_cast<FlvRecorder*>(data);
+    bool active;
+    {
+        std::lock_guard<std::mutex> lock(recorder->m_mutex);
+        active = recorder->m_active;
+    }
+    if (active) {
+        const char* name = calldata_string(cd, "chapter_name");
+        std::lock_guard<std::mutex> lock(recorder->m_requestMutex);
+        recorder->m_chapterCount++;
+        recorder->m_pendingChapters.push_back(name && *name ? name
+                                              : "Chapter " + std::to_string(recorder->m_chapterCount));
+    }
+    calldata_set_bool(cd, "success", active);
+}
+
+} // namespace
+
+void registerFlvRecorderOutput() {
+    obs_output_info info = {};
+    info.id = kFlvRecorderOutputId;
+    info.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_CAN_PAUSE;
+    info.encoded_video_codecs = "h264";
+    info.encoded_audio_codecs = "aac";
+    info.get_name = [](void*) -> const char* { return "StreamLumo FLV Recorder"; };
+    info.create = [](obs_data_t*, obs_output_t* output) -> void* { return new FlvRecorder(output); };
+    info.destroy = [](void* data) { delete static_cast<FlvRecorder*>(data); };
+    info.start = [](void* data) { return static_cast<FlvRecorder*>(data)->start(); };
+    info.stop = [](void* data, uint64_t ts) { static_cast<FlvRecorder*>(data)->stop(ts); };
+    info.encoded_packet = [](void* data, encoder_packet* packet) {
+        static_cast<FlvRecorder*>(data)->onPacket(packet);
+    };
+    info.get_total_bytes = [](void* data) { return static_cast<FlvRecorder*>(data)->totalBytes(); };
+    obs_register_output(&info);
+}
+
+} // namespace streamlumo
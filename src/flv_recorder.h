@@ -0,0 +1,27 @@
+// streamlumo-engine/src/flv_recorder.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+namespace streamlumo {
+
+/**
+ * @brief Output id of the engine's own FLV recording output
+ *
+ * An encoded H.264 + AAC output that muxes FLV in the encoder's packet
+ * callback and leaves every disk write to an AsyncFileWriter thread.
+ *
+ * Settings: "path", "max_size_mb", "max_time_sec" (0 = no split), "direct_io".
+ * Procs: "split_file(out bool split_file_enabled)" splits at the next
+ * keyframe; "add_chapter(string chapter_name, out bool success)" writes an
+ * onCuePoint tag and a <name>.chapters.ffmeta sidecar (FFmpeg metadata,
+ * usable with -map_metadata when remuxing). Signal: "file_changed(string
+ * next_file)" after every split.
+ */
+extern const char* const kFlvRecorderOutputId;
+
+// Call once after obs_startup()
+void registerFlvRecorderOutput();
+
+} // namespace streamlumo
@@ -6,13 +6,18 @@
 
 #include "frontend-stubs.h"
 #include "logging.h"
+#include "platform/platform.h"
 
 #include <obs.h>
 #include <util/config-file.h>
 
-#include <vector>
-#include <string>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
 
 namespace streamlumo {
 
@@ -24,14 +29,72 @@ HeadlessFrontend::HeadlessFrontend() {
     m_profileConfig = config_create("streamlumo-profile");
     m_appConfig = config_create("streamlumo-app");
     m_userConfig = config_create("streamlumo-user");
+
+    m_events.start(FrontendEventBus::Options());
+    m_sceneIndex.start([this](SceneIndex::List list) {
+        on_event(list == SceneIndex::List::Scenes ? OBS_FRONTEND_EVENT_SCENE_LIST_CHANGED
+                                                  : OBS_FRONTEND_EVENT_TRANSITION_LIST_CHANGED);
+    });
+
+    m_outputs = std::make_unique<OutputManager>(m_profileConfig);
+    m_outputs->setEventCallback([this](OutputManager::Event event) {
+        switch (event) {
+            case OutputManager::Event::StreamingStarting: on_event(OBS_FRONTEND_EVENT_STREAMING_STARTING); break;
+            case OutputManager::Event::StreamingStarted:  on_event(OBS_FRONTEND_EVENT_STREAMING_STARTED); break;
+            case OutputManager::Event::StreamingStopping: on_event(OBS_FRONTEND_EVENT_STREAMING_STOPPING); break;
+            case OutputManager::Event::StreamingStopped:  on_event(OBS_FRONTEND_EVENT_STREAMING_STOPPED); break;
+            case OutputManager::Event::RecordingStarting: on_event(OBS_FRONTEND_EVENT_RECORDING_STARTING); break;
+            case OutputManager::Event::RecordingStarted:  on_event(OBS_FRONTEND_EVENT_RECORDING_STARTED); break;
+            case OutputManager::Event::RecordingStopping: on_event(OBS_FRONTEND_EVENT_RECORDING_STOPPING); break;
+            case OutputManager::Event::RecordingStopped:  on_event(OBS_FRONTEND_EVENT_RECORDING_STOPPED); break;
+            case OutputManager::Event::RecordingPaused:   on_event(OBS_FRONTEND_EVENT_RECORDING_PAUSED); break;
+            case OutputManager::Event::RecordingUnpaused: on_event(OBS_FRONTEND_EVENT_RECORDING_UNPAUSED); break;
+            case OutputManager::Event::ReplayBufferStarting: on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTING); break;
+            case OutputManager::Event::ReplayBufferStarted:  on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTED); break;
+            case OutputManager::Event::ReplayBufferStopping: on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPING); break;
+            case OutputManager::Event::ReplayBufferStopped:  on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPED); break;
+            case OutputManager::Event::ReplayBufferSaved:    on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_SAVED); break;
+            case OutputManager::Event::VirtualCamStarting:   break;
+            case OutputManager::Event::VirtualCamStarted:    on_event(OBS_FRONTEND_EVENT_VIRTUALCAM_STARTED); break;
+            case OutputManager::Event::VirtualCamStopped:    on_event(OBS_FRONTEND_EVENT_VIRTUALCAM_STOPPED); break;
+        }
+    });
+
+    // Screenshots are saved next to recordings ([SimpleOutput] FilePath)
+    config_set_default_string(m_profileConfig, "SimpleOutput", "ScreenshotFormat", "png");
+    config_set_default_int(m_profileConfig, "SimpleOutput", "ScreenshotQuality", -1);
+
+    // Studio-mode preview for sinks; rendered only while one is attached
+    config_set_default_int(m_profileConfig, "Preview", "FPS", 10);
+    config_set_default_int(m_profileConfig, "Preview", "Width", 640);
+    m_screenshots = std::make_unique<ScreenshotService>();
 }
 
 HeadlessFrontend::~HeadlessFrontend() {
+    // Writes unsaved scene changes; the saver reads the state below
+    m_sceneCollections.stop();
+    m_sceneIndex.stop();
+    // Delivers queued events while the state they read is still here; later events run inline
+    m_events.stop();
+
+    m_preview.stop();
+    if (m_showingPreview) {
+        obs_source_dec_showing(m_showingPreview);
+        obs_source_release(m_showingPreview);
+        m_showingPreview = nullptr;
+    }
+
+    // Outputs and screenshots reference the profile config and fire events into this object
+    m_screenshots.reset();
+    m_outputs.reset();
+    m_canvases.clear();
+
     if (m_profileConfig) config_close(m_profileConfig);
     if (m_appConfig) config_close(m_appConfig);
     if (m_userConfig) config_close(m_userConfig);
     
     if (m_currentScene) obs_source_release(m_currentScene);
+    if (m_previewScene) obs_source_release(m_previewScene);
     if (m_currentTransition) obs_source_release(m_currentTransition);
     if (m_streamingService) obs_service_release(m_streamingService);
 }
@@ -40,6 +103,17 @@ void HeadlessFrontend::install() {
     if (!g_frontend) {
         g_frontend = new HeadlessFrontend();
         obs_frontend_set_callbacks_internal(g_frontend);
+        // libobs has no way to remove a proc; it checks for the frontend on each call
+        proc_handler_add(obs_get_proc_handler(),
+                         "void streamlumo_source_screenshot(in ptr source, in string image_format, "
+                         "in int image_width, in int image_height, in int quality, in string file_path, "
+                         "out ptr image_data, out int image_size, out bool success)",
+                         &HeadlessFrontend::sourceScreenshotProc, nullptr);
+        proc_handler_add(obs_get_proc_handler(),
+                         "void streamlumo_preview_add_sink(in ptr callback, in ptr param, out int sink_id)",
+                         &HeadlessFrontend::previewAddSinkProc, nullptr);
+        proc_handler_add(obs_get_proc_handler(), "void streamlumo_preview_remove_sink(in int sink_id)",
+                         &HeadlessFrontend::previewRemoveSinkProc, nullptr);
         log_info("Headless frontend callbacks installed");
     }
 }
@@ -58,9 +132,10 @@ HeadlessFrontend* HeadlessFrontend::instance() {
 }
 
 void HeadlessFrontend::signalFinishedLoading() {
-    log_info("Signaling OBS finished loading event... (%zu registered callbacks)", m_eventCallbacks.size());
+    log_info("Signaling OBS finished loading event... (%zu registered callbacks)", m_events.callbackCount());
+    // Synchronous: delivered before this returns
     on_event(OBS_FRONTEND_EVENT_FINISHED_LOADING);
-    log_info("OBS ready for requests (event dispatched to %zu callbacks)", m_eventCallbacks.size());
+    log_info("OBS ready for requests (event dispatched to %zu callbacks)", m_events.callbackCount());
 }
 
 // GUI-related - return nullptr (no GUI)
@@ -70,19 +145,14 @@ void* HeadlessFrontend::obs_frontend_get_system_tray() { return nullptr; }
 
 // Scene management
 void HeadlessFrontend::obs_frontend_get_scenes(struct obs_frontend_source_list* sources) {
-    // Enumerate all scenes
-    auto cb = [](void* param, obs_source_t* source) {
-        auto list = static_cast<obs_frontend_source_list*>(param);
-        if (obs_source_get_type(source) == OBS_SOURCE_TYPE_SCENE) {
-            obs_source_get_ref(source);
-            da_push_back(list->sources, &source);
-        }
-        return true;
-    };
-    obs_enum_scenes(cb, sources);
+    // The caller releases each entry
+    std::vector<obs_source_t*> scenes = m_sceneIndex.scenes();
+    da_reserve(sources->sources, sources->sources.num + scenes.size());
+    da_push_back_array(sources->sources, scenes.data(), scenes.size());
 }
 
 obs_source_t* HeadlessFrontend::obs_frontend_get_current_scene() {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
     if (m_currentScene) {
         obs_source_get_ref(m_currentScene);
     }
@@ -90,36 +160,57 @@ obs_source_t* HeadlessFrontend::obs_frontend_get_current_scene() {
 }
 
 void HeadlessFrontend::obs_frontend_set_current_scene(obs_source_t* scene) {
-    if (m_currentScene) obs_source_release(m_currentScene);
-    m_currentScene = scene;
-    if (m_currentScene) {
-        obs_source_get_ref(m_currentScene);
-        obs_set_output_source(0, m_currentScene);
+    if (scene) obs_source_get_ref(scene);
+    obs_source_t* previous;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        previous = m_currentScene;
+        m_currentScene = scene;
     }
+    if (scene) obs_set_output_source(0, scene);
+    if (previous) obs_source_release(previous);
+    m_canvases.setProgramScene(scene);
+    updatePreview();
     on_event(OBS_FRONTEND_EVENT_SCENE_CHANGED);
 }
 
 // Transitions
 void HeadlessFrontend::obs_frontend_get_transitions(struct obs_frontend_source_list* sources) {
-    // Return empty for now - transitions need to be enumerated
-    (void)sources;
+    std::vector<obs_source_t*> transitions = m_sceneIndex.transitions();
+    da_reserve(sources->sources, sources->sources.num + transitions.size());
+    da_push_back_array(sources->sources, transitions.data(), transitions.size());
 }
 
 obs_source_t* HeadlessFrontend::obs_frontend_get_current_transition() {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
     if (m_currentTransition) obs_source_get_ref(m_currentTransition);
     return m_currentTransition;
 }
 
 void HeadlessFrontend::obs_frontend_set_current_transition(obs_source_t* transition) {
-    if (m_currentTransition) obs_source_release(m_currentTransition);
-    m_currentTransition = transition;
-    if (m_currentTransition) obs_source_get_ref(m_currentTransition);
+    if (transition) obs_source_get_ref(transition);
+    // A private transition is never signalled; list it once it is in use
+    if (transition) m_sceneIndex.add(transition);
+    obs_source_t* previous;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        previous = m_currentTransition;
+        m_currentTransition = transition;
+    }
+    if (previous) obs_source_release(previous);
     on_event(OBS_FRONTEND_EVENT_TRANSITION_CHANGED);
 }
 
-int HeadlessFrontend::obs_frontend_get_transition_duration() { return m_transitionDuration; }
+int HeadlessFrontend::obs_frontend_get_transition_duration() {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    return m_transitionDuration;
+}
+
 void HeadlessFrontend::obs_frontend_set_transition_duration(int duration) { 
-    m_transitionDuration = duration; 
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_transitionDuration = duration;
+    }
     on_event(OBS_FRONTEND_EVENT_TRANSITION_DURATION_CHANGED);
 }
 
@@ -130,23 +221,198 @@ void HeadlessFrontend::obs_frontend_set_tbar_position(int position) { (void)posi
 // Scene collections
 void HeadlessFrontend::obs_frontend_get_scene_collections(std::vector<std::string>& strings) {
     strings.clear();
-    strings.push_back("Default");
+    if (!m_sceneCollections.running()) {
+        strings.push_back("Default");
+        return;
+    }
+    strings = m_sceneCollections.list();
 }
 
 char* HeadlessFrontend::obs_frontend_get_current_scene_collection() {
-    return bstrdup("Default");
+    if (!m_sceneCollections.running()) {
+        return bstrdup("Default");
+    }
+    return bstrdup(m_sceneCollections.collection().c_str());
 }
 
 void HeadlessFrontend::obs_frontend_set_current_scene_collection(const char* collection) {
-    (void)collection;
+    if (!collection || !*collection || !m_sceneCollections.running() ||
+        m_sceneCollections.collection() == collection) {
+        return;
+    }
+    on_event(OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGING);
+
+    // Tearing down fires source signals; hold saves until the new collection is in place
+    m_sceneCollections.flush();
+    m_sceneCollections.deferBegin();
+    on_event(OBS_FRONTEND_EVENT_SCENE_COLLECTION_CLEANUP);
+    clearSceneCollection();
+    m_sceneCollections.setCollection(collection);
+    if (!loadSceneCollection(collection)) {
+        createEmptyScene();
+    }
+    m_sceneCollections.deferEnd();
+
+    log_info("Scene collection switched to '%s'", collection);
     on_event(OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED);
 }
 
 bool HeadlessFrontend::obs_frontend_add_scene_collection(const char* name) {
-    (void)name;
+    if (!name || !*name || !m_sceneCollections.running() || m_sceneCollections.exists(name) ||
+        m_sceneCollections.collection() == name) {
+        return false;
+    }
+    // Like OBS: the new, empty collection becomes the current one
+    obs_frontend_set_current_scene_collection(name);
+    m_sceneCollections.requestSave();
+    on_event(OBS_FRONTEND_EVENT_SCENE_COLLECTION_LIST_CHANGED);
+    return true;
+}
+
+bool HeadlessFrontend::openSceneCollection(const std::string& name, SceneCollectionStore::Format format) {
+    SceneCollectionStore::Options options;
+    options.directory = platform::joinPath({platform::getAppDataDir(), "basic", "scenes"});
+    options.format = format;
+    if (!m_sceneCollections.start(options, [this](obs_data_t* data) { saveFrontendState(data); })) {
+        return false;
+    }
+    m_sceneCollections.setCollection(name);
+    return loadSceneCollection(name);
+}
+
+bool HeadlessFrontend::loadSceneCollection(const std::string& name) {
+    obs_data_t* data = m_sceneCollections.load(name);
+    if (!data) {
+        return false;
+    }
+    on_preload(data);
+
+    obs_data_array_t* sources = obs_data_get_array(data, "sources");
+    obs_load_sources(sources, nullptr, nullptr);
+    obs_data_array_release(sources);
+
+    obs_data_array_t* order = obs_data_get_array(data, "scene_order");
+    if (order) {
+        std::vector<std::string> names;
+        const size_t count = obs_data_array_count(order);
+        names.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            obs_data_t* entry = obs_data_array_item(order, i);
+            names.emplace_back(obs_data_get_string(entry, "name"));
+            obs_data_release(entry);
+        }
+        obs_data_array_release(order);
+        m_sceneIndex.reorderScenes(names);
+    }
+
+    // OBS writes the program scene as current_program_scene in studio mode
+    const char* sceneName = obs_data_get_string(data, "current_program_scene");
+    if (!sceneName || !*sceneName) {
+        sceneName = obs_data_get_string(data, "current_scene");
+    }
+    obs_source_t* scene = sceneName && *sceneName ? m_sceneIndex.findScene(sceneName) : nullptr;
+    if (!scene) {
+        // Fall back to the first scene in the list
+        std::vector<obs_source_t*> scenes = m_sceneIndex.scenes();
+        for (obs_source_t* candidate : scenes) {
+            if (!scene) {
+                scene = candidate;
+            } else {
+                obs_source_release(candidate);
+            }
+        }
+    }
+    if (scene) {
+        obs_frontend_set_current_scene(scene);
+        obs_frontend_set_current_preview_scene(scene);
+        obs_source_release(scene);
+    }
+    if (obs_data_has_user_value(data, "transition_duration")) {
+        obs_frontend_set_transition_duration(static_cast<int>(obs_data_get_int(data, "transition_duration")));
+    }
+
+    on_load(data);
+    obs_data_release(data);
+
+    // What was just read is what is on disk
+    m_sceneCollections.discardChanges();
+    log_info("Scene collection '%s' loaded", name.c_str());
     return true;
 }
 
+void HeadlessFrontend::saveFrontendState(obs_data_t* data) {
+    obs_source_t* program = obs_frontend_get_current_scene();
+    obs_source_t* preview = obs_frontend_get_current_preview_scene();
+    obs_source_t* transition = obs_frontend_get_current_transition();
+
+    // Same keys as OBS, so either can open the other's collections
+    const char* programName = program ? obs_source_get_name(program) : "";
+    obs_data_set_string(data, "current_program_scene", programName);
+    const bool studioMode = obs_frontend_preview_program_mode_active();
+    obs_data_set_string(data, "current_scene",
+                        studioMode && preview ? obs_source_get_name(preview) : programName);
+    obs_data_set_string(data, "current_transition", transition ? obs_source_get_name(transition) : "");
+    obs_data_set_int(data, "transition_duration", obs_frontend_get_transition_duration());
+
+    obs_data_array_t* order = obs_data_array_create();
+    for (obs_source_t* scene : m_sceneIndex.scenes()) {
+        obs_data_t* entry = obs_data_create();
+        obs_data_set_string(entry, "name", obs_source_get_name(scene));
+        obs_data_array_push_back(order, entry);
+        obs_data_release(entry);
+        obs_source_release(scene);
+    }
+    obs_data_set_array(data, "scene_order", order);
+    obs_data_array_release(order);
+
+    if (program) obs_source_release(program);
+    if (preview) obs_source_release(preview);
+    if (transition) obs_source_release(transition);
+
+    // Plugin save callbacks add their own keys
+    on_save(data);
+}
+
+void HeadlessFrontend::clearSceneCollection() {
+    obs_source_t* program;
+    obs_source_t* preview;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        program = m_currentScene;
+        preview = m_previewScene;
+        m_currentScene = nullptr;
+        m_previewScene = nullptr;
+    }
+    obs_set_output_source(0, nullptr);
+    if (program) obs_source_release(program);
+    if (preview) obs_source_release(preview);
+    updatePreview();
+
+    std::vector<obs_source_t*> sources = m_sceneIndex.scenes();
+    auto collect = [](void* param, obs_source_t* source) {
+        if (obs_source_t* ref = obs_source_get_ref(source)) {
+            static_cast<std::vector<obs_source_t*>*>(param)->push_back(ref);
+        }
+        return true;
+    };
+    obs_enum_sources(collect, &sources);
+    for (obs_source_t* source : sources) {
+        obs_source_remove(source);
+        obs_source_release(source);
+    }
+}
+
+void HeadlessFrontend::createEmptyScene() {
+    obs_scene_t* scene = obs_scene_create("Scene");
+    if (!scene) {
+        return;
+    }
+    obs_source_t* source = obs_scene_get_source(scene);
+    obs_frontend_set_current_scene(source);
+    obs_frontend_set_current_preview_scene(source);
+    obs_scene_release(scene);
+}
+
 // Profiles
 void HeadlessFrontend::obs_frontend_get_profiles(std::vector<std::string>& strings) {
     strings.clear();
@@ -170,58 +436,37 @@ void HeadlessFrontend::obs_frontend_create_profile(const char* name) { (void)nam
 void HeadlessFrontend::obs_frontend_duplicate_profile(const char* name) { (void)name; }
 void HeadlessFrontend::obs_frontend_delete_profile(const char* profile) { (void)profile; }
 
-// Streaming
+// Streaming - STARTED/STOPPED follow from the output's own start/stop signals
 void HeadlessFrontend::obs_frontend_streaming_start() {
-    m_streamingActive = true;
-    on_event(OBS_FRONTEND_EVENT_STREAMING_STARTING);
-    on_event(OBS_FRONTEND_EVENT_STREAMING_STARTED);
+    m_outputs->startStreaming(m_streamingService);
 }
 
 void HeadlessFrontend::obs_frontend_streaming_stop() {
-    on_event(OBS_FRONTEND_EVENT_STREAMING_STOPPING);
-    m_streamingActive = false;
-    on_event(OBS_FRONTEND_EVENT_STREAMING_STOPPED);
+    m_outputs->stopStreaming();
 }
 
-bool HeadlessFrontend::obs_frontend_streaming_active() { return m_streamingActive; }
+bool HeadlessFrontend::obs_frontend_streaming_active() { return m_outputs->streamingActive(); }
 
 // Recording
 void HeadlessFrontend::obs_frontend_recording_start() {
-    m_recordingActive = true;
-    on_event(OBS_FRONTEND_EVENT_RECORDING_STARTING);
-    on_event(OBS_FRONTEND_EVENT_RECORDING_STARTED);
+    m_outputs->startRecording(m_recordOutputPath);
 }
 
 void HeadlessFrontend::obs_frontend_recording_stop() {
-    on_event(OBS_FRONTEND_EVENT_RECORDING_STOPPING);
-    m_recordingActive = false;
-    on_event(OBS_FRONTEND_EVENT_RECORDING_STOPPED);
+    m_outputs->stopRecording();
 }
 
-bool HeadlessFrontend::obs_frontend_recording_active() { return m_recordingActive; }
-void HeadlessFrontend::obs_frontend_recording_pause(bool pause) { m_recordingPaused = pause; }
-bool HeadlessFrontend::obs_frontend_recording_paused() { return m_recordingPaused; }
-bool HeadlessFrontend::obs_frontend_recording_split_file() { return false; }
-bool HeadlessFrontend::obs_frontend_recording_add_chapter(const char* name) { (void)name; return false; }
+bool HeadlessFrontend::obs_frontend_recording_active() { return m_outputs->recordingActive(); }
+void HeadlessFrontend::obs_frontend_recording_pause(bool pause) { m_outputs->pauseRecording(pause); }
+bool HeadlessFrontend::obs_frontend_recording_paused() { return m_outputs->recordingPaused(); }
+bool HeadlessFrontend::obs_frontend_recording_split_file() { return m_outputs->splitRecording(); }
+bool HeadlessFrontend::obs_frontend_recording_add_chapter(const char* name) { return m_outputs->addRecordingChapter(name); }
 
 // Replay buffer
-void HeadlessFrontend::obs_frontend_replay_buffer_start() {
-    m_replayBufferActive = true;
-    on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTING);
-    on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTED);
-}
-
-void HeadlessFrontend::obs_frontend_replay_buffer_save() {
-    on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_SAVED);
-}
-
-void HeadlessFrontend::obs_frontend_replay_buffer_stop() {
-    on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPING);
-    m_replayBufferActive = false;
-    on_event(OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPED);
-}
-
-bool HeadlessFrontend::obs_frontend_replay_buffer_active() { return m_replayBufferActive; }
+void HeadlessFrontend::obs_frontend_replay_buffer_start() { m_outputs->startReplayBuffer(); }
+void HeadlessFrontend::obs_frontend_replay_buffer_save() { m_outputs->saveReplayBuffer(); }
+void HeadlessFrontend::obs_frontend_replay_buffer_stop() { m_outputs->stopReplayBuffer(); }
+bool HeadlessFrontend::obs_frontend_replay_buffer_active() { return m_outputs->replayBufferActive(); }
 
 // Tools menu - no-op in headless
 void* HeadlessFrontend::obs_frontend_add_tools_menu_qaction(const char* name) { 
@@ -248,25 +493,29 @@ bool HeadlessFrontend::obs_frontend_add_custom_qdock(const char* id, void* dock)
 
 // Event callbacks
 void HeadlessFrontend::obs_frontend_add_event_callback(obs_frontend_event_cb callback, void* private_data) {
-    EventCallback cb = {callback, private_data};
-    m_eventCallbacks.push_back(cb);
-    log_info("Frontend event callback registered (now %zu callbacks)", m_eventCallbacks.size());
+    m_events.addCallback(callback, private_data);
+    log_info("Frontend event callback registered (now %zu callbacks)", m_events.callbackCount());
 }
 
 void HeadlessFrontend::obs_frontend_remove_event_callback(obs_frontend_event_cb callback, void* private_data) {
-    m_eventCallbacks.erase(
-        std::remove_if(m_eventCallbacks.begin(), m_eventCallbacks.end(),
-            [callback, private_data](const EventCallback& cb) {
-                return cb.callback == callback && cb.private_data == private_data;
-            }),
-        m_eventCallbacks.end()
-    );
+    m_events.removeCallback(callback, private_data);
 }
 
-// Outputs - return nullptr for now (need actual output management)
-obs_output_t* HeadlessFrontend::obs_frontend_get_streaming_output() { return nullptr; }
-obs_output_t* HeadlessFrontend::obs_frontend_get_recording_output() { return nullptr; }
-obs_output_t* HeadlessFrontend::obs_frontend_get_replay_buffer_output() { return nullptr; }
+// Outputs - returned with a new reference, as the frontend API specifies
+obs_output_t* HeadlessFrontend::obs_frontend_get_streaming_output() {
+    obs_output_t* output = m_outputs->streamingOutput();
+    return output ? obs_output_get_ref(output) : nullptr;
+}
+
+obs_output_t* HeadlessFrontend::obs_frontend_get_recording_output() {
+    obs_output_t* output = m_outputs->recordingOutput();
+    return output ? obs_output_get_ref(output) : nullptr;
+}
+
+obs_output_t* HeadlessFrontend::obs_frontend_get_replay_buffer_output() {
+    obs_output_t* output = m_outputs->replayBufferOutput();
+    return output ? obs_output_get_ref(output) : nullptr;
+}
 
 // Config
 config_t* HeadlessFrontend::obs_frontend_get_profile_config() { return m_profileConfig; }
@@ -280,13 +529,18 @@ void HeadlessFrontend::obs_frontend_open_projector(const char* type, int monitor
 
 // Save
 void HeadlessFrontend::obs_frontend_save() {
-    obs_data_t* data = obs_data_create();
-    on_save(data);
-    obs_data_release(data);
+    if (!m_sceneCollections.running()) {
+        obs_data_t* data = obs_data_create();
+        on_save(data);
+        obs_data_release(data);
+        return;
+    }
+    // Written from the scene-saver thread; the caller never waits on the disk
+    m_sceneCollections.requestSave();
 }
 
-void HeadlessFrontend::obs_frontend_defer_save_begin() {}
-void HeadlessFrontend::obs_frontend_defer_save_end() {}
+void HeadlessFrontend::obs_frontend_defer_save_begin() { m_sceneCollections.deferBegin(); }
+void HeadlessFrontend::obs_frontend_defer_save_end() { m_sceneCollections.deferEnd(); }
 
 void HeadlessFrontend::obs_frontend_add_save_callback(obs_frontend_save_cb callback, void* private_data) {
     SaveCallback cb = {callback, private_data};
@@ -337,28 +591,149 @@ void HeadlessFrontend::obs_frontend_set_streaming_service(obs_service_t* service
 void HeadlessFrontend::obs_frontend_save_streaming_service() {}
 
 // Studio mode
-bool HeadlessFrontend::obs_frontend_preview_program_mode_active() { return m_studioMode; }
+bool HeadlessFrontend::obs_frontend_preview_program_mode_active() {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    return m_studioMode;
+}
+
 void HeadlessFrontend::obs_frontend_set_preview_program_mode(bool enable) { 
-    m_studioMode = enable;
+    obs_source_t* program = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        if (m_studioMode == enable) {
+            return;
+        }
+        m_studioMode = enable;
+        // Like OBS, studio mode opens with the program scene in the preview
+        if (enable && !m_previewScene && m_currentScene) {
+            program = obs_source_get_ref(m_currentScene);
+            m_previewScene = program;
+        }
+    }
+    updatePreview();
+    if (program) on_event(OBS_FRONTEND_EVENT_PREVIEW_SCENE_CHANGED);
     on_event(enable ? OBS_FRONTEND_EVENT_STUDIO_MODE_ENABLED : OBS_FRONTEND_EVENT_STUDIO_MODE_DISABLED);
 }
-void HeadlessFrontend::obs_frontend_preview_program_trigger_transition() {}
 
-bool HeadlessFrontend::obs_frontend_preview_enabled() { return m_previewEnabled; }
-void HeadlessFrontend::obs_frontend_set_preview_enabled(bool enable) { m_previewEnabled = enable; }
+void HeadlessFrontend::obs_frontend_preview_program_trigger_transition() {
+    obs_source_t* preview = nullptr;
+    bool onAir;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        if (!m_studioMode || !m_previewScene) {
+            return;
+        }
+        preview = obs_source_get_ref(m_previewScene);
+        onAir = m_previewScene == m_currentScene;
+    }
+    if (preview && !onAir) {
+        transitionTo(preview);
+    }
+    if (preview) obs_source_release(preview);
+}
+
+bool HeadlessFrontend::obs_frontend_preview_enabled() {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    return m_previewEnabled;
+}
+
+void HeadlessFrontend::obs_frontend_set_preview_enabled(bool enable) {
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_previewEnabled = enable;
+    }
+    updatePreview();
+}
 
 obs_source_t* HeadlessFrontend::obs_frontend_get_current_preview_scene() {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
     if (m_previewScene) obs_source_get_ref(m_previewScene);
     return m_previewScene;
 }
 
 void HeadlessFrontend::obs_frontend_set_current_preview_scene(obs_source_t* scene) {
-    if (m_previewScene) obs_source_release(m_previewScene);
-    m_previewScene = scene;
-    if (m_previewScene) obs_source_get_ref(m_previewScene);
+    if (scene) obs_source_get_ref(scene);
+    obs_source_t* previous;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        previous = m_previewScene;
+        m_previewScene = scene;
+    }
+    updatePreview();
+    if (previous) obs_source_release(previous);
     on_event(OBS_FRONTEND_EVENT_PREVIEW_SCENE_CHANGED);
 }
 
+void HeadlessFrontend::updatePreview() {
+    std::lock_guard<std::mutex> serialize(m_previewMutex);
+    obs_source_t* showing;
+    obs_source_t* rendered;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        showing = m_studioMode ? m_previewScene : nullptr;
+        rendered = m_previewEnabled ? (m_studioMode ? m_previewScene : m_currentScene) : nullptr;
+        if (showing) obs_source_get_ref(showing);
+        if (rendered) obs_source_get_ref(rendered);
+    }
+
+    // Showing without rendering: the preview's sources load and tick (a
+    // browser source keeps its page) but nothing is drawn, so the transition
+    // to program starts from warm sources. Show the new scene before hiding
+    // the old one so sources in both never stop.
+    if (showing != m_showingPreview) {
+        if (showing) obs_source_inc_showing(showing);
+        if (m_showingPreview) {
+            obs_source_dec_showing(m_showingPreview);
+            obs_source_release(m_showingPreview);
+        }
+        m_showingPreview = showing;
+    } else if (showing) {
+        obs_source_release(showing);
+    }
+
+    // Started on first use, so the profile's [Preview] keys are read once they are set
+    if (rendered && !m_preview.running()) {
+        PreviewRenderer::Options options;
+        options.fps = static_cast<uint32_t>(config_get_int(m_profileConfig, "Preview", "FPS"));
+        options.width = static_cast<uint32_t>(config_get_int(m_profileConfig, "Preview", "Width"));
+        m_preview.start(options);
+    }
+    m_preview.setScene(rendered);
+    if (rendered) obs_source_release(rendered);
+}
+
+void HeadlessFrontend::transitionTo(obs_source_t* scene) {
+    obs_source_t* transition = obs_frontend_get_current_transition();
+    if (!transition) {
+        obs_frontend_set_current_scene(scene);
+        return;
+    }
+
+    obs_source_t* output = obs_get_output_source(0);
+    if (output != transition) {
+        // Channel 0 carries the transition from now on, starting from what is on air
+        obs_transition_set(transition, output);
+        obs_set_output_source(0, transition);
+    }
+    if (output) obs_source_release(output);
+    obs_transition_start(transition, OBS_TRANSITION_MODE_AUTO,
+                         static_cast<uint32_t>(obs_frontend_get_transition_duration()), scene);
+    obs_source_release(transition);
+
+    obs_source_get_ref(scene);
+    obs_source_t* previous;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        previous = m_currentScene;
+        m_currentScene = scene;
+    }
+    if (previous) obs_source_release(previous);
+    // Other canvases cut; only the main program runs the transition
+    m_canvases.setProgramScene(scene);
+    updatePreview();
+    on_event(OBS_FRONTEND_EVENT_SCENE_CHANGED);
+}
+
 // Internal callbacks
 void HeadlessFrontend::on_load(obs_data_t* settings) {
     for (auto& cb : m_saveCallbacks) {
@@ -379,26 +754,165 @@ void HeadlessFrontend::on_save(obs_data_t* settings) {
 }
 
 void HeadlessFrontend::on_event(enum obs_frontend_event event) {
-    for (auto& cb : m_eventCallbacks) {
-        cb.callback(event, cb.private_data);
+    switch (event) {
+        // Frontend state that lives in the scene collection
+        case OBS_FRONTEND_EVENT_SCENE_CHANGED:
+        case OBS_FRONTEND_EVENT_PREVIEW_SCENE_CHANGED:
+        case OBS_FRONTEND_EVENT_TRANSITION_CHANGED:
+        case OBS_FRONTEND_EVENT_TRANSITION_DURATION_CHANGED:
+        case OBS_FRONTEND_EVENT_STUDIO_MODE_ENABLED:
+        case OBS_FRONTEND_EVENT_STUDIO_MODE_DISABLED:
+            if (m_sceneCollections.running()) m_sceneCollections.markDirty();
+            break;
+        default:
+            break;
     }
+    m_events.post(event);
 }
 
-// Screenshots - no-op
-void HeadlessFrontend::obs_frontend_take_screenshot() {}
-void HeadlessFrontend::obs_frontend_take_source_screenshot(obs_source_t* source) { (void)source; }
+// Screenshots
+void HeadlessFrontend::obs_frontend_take_screenshot() { takeScreenshot(nullptr); }
+void HeadlessFrontend::obs_frontend_take_source_screenshot(obs_source_t* source) { takeScreenshot(source); }
 
-// Virtual cam
-obs_output_t* HeadlessFrontend::obs_frontend_get_virtualcam_output() { return nullptr; }
-void HeadlessFrontend::obs_frontend_start_virtualcam() {
-    m_virtualCamActive = true;
-    on_event(OBS_FRONTEND_EVENT_VIRTUALCAM_STARTED);
+bool HeadlessFrontend::startScreenshots() {
+    // Started on first use: the tick callback needs libobs up
+    std::lock_guard<std::mutex> lock(m_screenshotMutex);
+    return m_screenshots->running() || m_screenshots->start(ScreenshotService::Options());
 }
-void HeadlessFrontend::obs_frontend_stop_virtualcam() {
-    m_virtualCamActive = false;
-    on_event(OBS_FRONTEND_EVENT_VIRTUALCAM_STOPPED);
+
+void HeadlessFrontend::takeScreenshot(obs_source_t* source) {
+    if (!startScreenshots()) {
+        return;
+    }
+
+    const char* dirValue = config_get_string(m_profileConfig, "SimpleOutput", "FilePath");
+    const std::string dir = dirValue ? dirValue : "";
+    if (dir.empty() || (!platform::isDirectory(dir) && !platform::createDirectory(dir))) {
+        log_error("Screenshots: cannot create directory %s", dir.c_str());
+        return;
+    }
+
+    ScreenshotService::Request request;
+    request.source = source;
+    const char* format = config_get_string(m_profileConfig, "SimpleOutput", "ScreenshotFormat");
+    if (!ScreenshotService::parseFormat(format ? format : "", request.format)) {
+        log_warn("Screenshots: unknown format '%s', using png", format ? format : "");
+    }
+    request.quality = static_cast<int>(config_get_int(m_profileConfig, "SimpleOutput", "ScreenshotQuality"));
+
+    // Milliseconds keep back-to-back captures from overwriting each other
+    const auto nowMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::system_clock::now().time_since_epoch()).count();
+    const time_t now = static_cast<time_t>(nowMillis / 1000);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H-%M-%S", localtime(&now));
+    char name[64];
+    snprintf(name, sizeof(name), "Screenshot %s-%03u.%s", stamp, static_cast<unsigned>(nowMillis % 1000),
+             ScreenshotService::extension(request.format));
+    request.path = platform::joinPath(dir, name);
+
+    // Runs on a screenshot worker
+    m_screenshots->request(std::move(request), [this](ScreenshotService::Result result) {
+        if (!result.success) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_screenshotMutex);
+            m_lastScreenshotPath = result.path;
+        }
+        log_info("Screenshot saved: %s (%ux%u)", result.path.c_str(), result.width, result.height);
+        on_event(OBS_FRONTEND_EVENT_SCREENSHOT_TAKEN);
+    });
+}
+
+// Blocks the calling (websocket) thread until the capture is encoded. The
+// image is returned in a bmalloc'd buffer the caller bfree()s. success is
+// false for a format the service does not encode, so the caller can fall
+// back to its own path.
+void HeadlessFrontend::previewAddSinkProc(void*, calldata_t* cd) {
+    calldata_set_int(cd, "sink_id", 0);
+    HeadlessFrontend* frontend = instance();
+    auto callback = reinterpret_cast<PreviewSinkFn>(calldata_ptr(cd, "callback"));
+    void* param = calldata_ptr(cd, "param");
+    if (!frontend || !callback) {
+        return;
+    }
+    const uint64_t id = frontend->m_preview.addSink([callback, param](gs_texture_t* texture, uint32_t width,
+                                                                      uint32_t height) {
+        callback(param, texture, width, height);
+    });
+    calldata_set_int(cd, "sink_id", static_cast<long long>(id));
+}
+
+void HeadlessFrontend::previewRemoveSinkProc(void*, calldata_t* cd) {
+    HeadlessFrontend* frontend = instance();
+    const long long id = calldata_int(cd, "sink_id");
+    if (frontend && id > 0) {
+        frontend->m_preview.removeSink(static_cast<uint64_t>(id));
+    }
 }
-bool HeadlessFrontend::obs_frontend_virtualcam_active() { return m_virtualCamActive; }
+
+void HeadlessFrontend::sourceScreenshotProc(void*, calldata_t* cd) {
+    calldata_set_bool(cd, "success", false);
+    calldata_set_ptr(cd, "image_data", nullptr);
+    calldata_set_int(cd, "image_size", 0);
+
+    HeadlessFrontend* frontend = instance();
+    auto* source = static_cast<obs_source_t*>(calldata_ptr(cd, "source"));
+    const char* format = calldata_string(cd, "image_format");
+    ScreenshotService::Request request;
+    if (!frontend || !source || !ScreenshotService::parseFormat(format ? format : "", request.format) ||
+        !frontend->startScreenshots()) {
+        return;
+    }
+    request.source = source;
+    request.width = static_cast<uint32_t>(std::max<long long>(calldata_int(cd, "image_width"), 0));
+    request.height = static_cast<uint32_t>(std::max<long long>(calldata_int(cd, "image_height"), 0));
+    request.quality = static_cast<int>(calldata_int(cd, "quality"));
+    const char* path = calldata_string(cd, "file_path");
+    request.path = path ? path : "";
+
+    // Outlives a timed-out wait; the worker still delivers into it
+    struct Pending {
+        std::mutex mutex;
+        std::condition_variable done;
+        bool finished = false;
+        ScreenshotService::Result result;
+    };
+    auto pending = std::make_shared<Pending>();
+    const bool queued = frontend->m_screenshots->request(std::move(request), [pending](ScreenshotService::Result result) {
+        std::lock_guard<std::mutex> lock(pending->mutex);
+        pending->result = std::move(result);
+        pending->finished = true;
+        pending->done.notify_all();
+    });
+    if (!queued) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(pending->mutex);
+    if (!pending->done.wait_for(lock, std::chrono::seconds(5), [&pending] { return pending->finished; })) {
+        log_warn("Screenshots: source capture for obs-websocket timed out");
+        return;
+    }
+    const ScreenshotService::Result& result = pending->result;
+    if (!result.success) {
+        return;
+    }
+    void* data = bmemdup(result.data.data(), result.data.size());
+    calldata_set_ptr(cd, "image_data", data);
+    calldata_set_int(cd, "image_size", static_cast<long long>(result.data.size()));
+    calldata_set_bool(cd, "success", true);
+}
+
+// Virtual cam (the shared-memory program feed)
+obs_output_t* HeadlessFrontend::obs_frontend_get_virtualcam_output() {
+    obs_output_t* output = m_outputs->virtualCamOutput();
+    return output ? obs_output_get_ref(output) : nullptr;
+}
+void HeadlessFrontend::obs_frontend_start_virtualcam() { m_outputs->startVirtualCam(); }
+void HeadlessFrontend::obs_frontend_stop_virtualcam() { m_outputs->stopVirtualCam(); }
+bool HeadlessFrontend::obs_frontend_virtualcam_active() { return m_outputs->virtualCamActive(); }
 
 void HeadlessFrontend::obs_frontend_reset_video() {}
 
@@ -409,6 +923,10 @@ void HeadlessFrontend::obs_frontend_open_source_interaction(obs_source_t* source
 void HeadlessFrontend::obs_frontend_open_sceneitem_edit_transform(obs_sceneitem_t* item) { (void)item; }
 
 char* HeadlessFrontend::obs_frontend_get_current_record_output_path() {
+    if (m_recordOutputPath.empty()) {
+        const char* path = config_get_string(m_profileConfig, "SimpleOutput", "FilePath");
+        return bstrdup(path ? path : "");
+    }
     return bstrdup(m_recordOutputPath.c_str());
 }
 
@@ -418,9 +936,12 @@ const char* HeadlessFrontend::obs_frontend_get_locale_string(const char* string)
 
 bool HeadlessFrontend::obs_frontend_is_theme_dark() { return true; }
 
-char* HeadlessFrontend::obs_frontend_get_last_recording() { return bstrdup(""); }
-char* HeadlessFrontend::obs_frontend_get_last_screenshot() { return bstrdup(""); }
-char* HeadlessFrontend::obs_frontend_get_last_replay() { return bstrdup(""); }
+char* HeadlessFrontend::obs_frontend_get_last_recording() { return bstrdup(m_outputs->lastRecordingPath().c_str()); }
+char* HeadlessFrontend::obs_frontend_get_last_screenshot() {
+    std::lock_guard<std::mutex> lock(m_screenshotMutex);
+    return bstrdup(m_lastScreenshotPath.c_str());
+}
+char* HeadlessFrontend::obs_frontend_get_last_replay() { return bstrdup(m_outputs->lastReplayPath().c_str()); }
 
 void HeadlessFrontend::obs_frontend_add_undo_redo_action(const char* name, const undo_redo_cb undo,
                                                           const undo_redo_cb redo, const char* undo_data,
@@ -430,17 +951,27 @@ void HeadlessFrontend::obs_frontend_add_undo_redo_action(const char* name, const
 
 // Canvas management
 obs_canvas_t* HeadlessFrontend::obs_frontend_add_canvas(const char* name, obs_video_info* ovi, int flags) {
-    (void)name; (void)ovi; (void)flags;
-    return nullptr;
+    // Like OBS, the frontend keeps the reference; callers get a borrowed pointer
+    obs_canvas_t* canvas = m_canvases.add(name, ovi, flags);
+    if (canvas) {
+        on_event(OBS_FRONTEND_EVENT_CANVAS_ADDED);
+    }
+    return canvas;
 }
 
 bool HeadlessFrontend::obs_frontend_remove_canvas(obs_canvas_t* canvas) {
-    (void)canvas;
-    return false;
+    if (!m_canvases.remove(canvas)) {
+        return false;
+    }
+    on_event(OBS_FRONTEND_EVENT_CANVAS_REMOVED);
+    return true;
 }
 
 void HeadlessFrontend::obs_frontend_get_canvases(obs_frontend_canvas_list* canvas_list) {
-    (void)canvas_list;
+    // References are released by obs_frontend_canvas_list_free()
+    for (obs_canvas_t* canvas : m_canvases.canvases()) {
+        da_push_back(canvas_list->canvases, &canvas);
+    }
 }
 
 } // namespace streamlumo
@@ -6,7 +6,17 @@
 
 #pragma once
 
+#include "canvas_manager.h"
+#include "frontend_event_bus.h"
+#include "output_manager.h"
+#include "preview_renderer.h"
+#include "scene_collection_store.h"
+#include "scene_index.h"
+#include "screenshot_service.h"
+
 #include <obs-frontend-internal.hpp>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -28,6 +38,15 @@ public:
     void setProfilePath(const std::string& path) { m_profilePath = path; }
     void setRecordOutputPath(const std::string& path) { m_recordOutputPath = path; }
     
+    // Canvases beyond the main one (--canvas and obs_frontend_add_canvas)
+    CanvasManager& canvases() { return m_canvases; }
+    
+    /**
+     * @brief Persist scene collections under <app data>/basic/scenes and load one
+     * @return false if the collection has nothing saved yet (the caller sets up a default scene)
+     */
+    bool openSceneCollection(const std::string& name, SceneCollectionStore::Format format);
+    
     // GUI-related (return nullptr/no-op for headless)
     void* obs_frontend_get_main_window() override;
     void* obs_frontend_get_main_window_handle() override;
@@ -179,17 +198,38 @@ public:
     void obs_frontend_get_canvases(obs_frontend_canvas_list* canvas_list) override;
     
 private:
-    struct EventCallback {
-        obs_frontend_event_cb callback;
-        void* private_data;
-    };
+    // Saves to [SimpleOutput] FilePath; nullptr = program output
+    void takeScreenshot(obs_source_t* source);
+    bool startScreenshots();
+    // "streamlumo_source_screenshot": obs-websocket's Get/SaveSourceScreenshot in headless builds
+    static void sourceScreenshotProc(void* data, calldata_t* cd);
+    // "streamlumo_preview_add_sink" / "streamlumo_preview_remove_sink": preview
+    // frames (the preview scene in studio mode, otherwise the program) for modules.
+    // The sink is void (*)(void* param, gs_texture_t* texture, uint32_t width,
+    // uint32_t height), called on the graphics thread; see PreviewRenderer
+    using PreviewSinkFn = void (*)(void* param, gs_texture_t* texture, uint32_t width, uint32_t height);
+    static void previewAddSinkProc(void* data, calldata_t* cd);
+    static void previewRemoveSinkProc(void* data, calldata_t* cd);
+    
+    // Scene collections: frontend state in/out of the saved data, and
+    // removing every scene and input before switching collections
+    void saveFrontendState(obs_data_t* data);
+    bool loadSceneCollection(const std::string& name);
+    void clearSceneCollection();
+    void createEmptyScene();
+    
+    // Studio mode: keeps the preview scene showing and points the preview renderer at it
+    void updatePreview();
+    // Program switch through the current transition (a cut if there is none)
+    void transitionTo(obs_source_t* scene);
     
     struct SaveCallback {
         obs_frontend_save_cb callback;
         void* private_data;
     };
     
-    std::vector<EventCallback> m_eventCallbacks;
+    // Plugin event callbacks, run on the "frontend-events" thread (see frontend_event_bus.h)
+    FrontendEventBus m_events;
     std::vector<SaveCallback> m_saveCallbacks;
     std::vector<SaveCallback> m_preloadCallbacks;
     
@@ -197,22 +237,40 @@ private:
     config_t* m_appConfig = nullptr;
     config_t* m_userConfig = nullptr;
     
+    // Guards the scene/transition/studio mode state below, which the scene saver reads
+    std::mutex m_stateMutex;
     obs_source_t* m_currentScene = nullptr;
     obs_source_t* m_previewScene = nullptr;
     obs_source_t* m_currentTransition = nullptr;
+    int m_transitionDuration = 300;
+    bool m_studioMode = false;
+    bool m_previewEnabled = true;
+    
+    // Serializes updatePreview(); the scene it holds showing keeps the preview's sources warm
+    std::mutex m_previewMutex;
+    obs_source_t* m_showingPreview = nullptr;
+    PreviewRenderer m_preview;
+    
     obs_service_t* m_streamingService = nullptr;
     
     std::string m_profilePath;
     std::string m_recordOutputPath;
     
-    int m_transitionDuration = 300;
-    bool m_streamingActive = false;
-    bool m_recordingActive = false;
-    bool m_recordingPaused = false;
-    bool m_replayBufferActive = false;
-    bool m_studioMode = false;
-    bool m_previewEnabled = true;
-    bool m_virtualCamActive = false;
+    // Streaming/recording outputs and their shared encoders
+    std::unique_ptr<OutputManager> m_outputs;
+    
+    // Program/source screenshots; started on first use
+    std::unique_ptr<ScreenshotService> m_screenshots;
+    std::mutex m_screenshotMutex;       // Also serializes starting the service
+    std::string m_lastScreenshotPath;
+    
+    CanvasManager m_canvases;
+    
+    // Saved on the scene-saver thread, debounced (see scene_collection_store.h)
+    SceneCollectionStore m_sceneCollections;
+    
+    // Scene and transition lists, kept from source signals instead of enumerated per call
+    SceneIndex m_sceneIndex;
 };
 
 } // namespace streamlumo
@@ -0,0 +1,210 @@
+// streamlumo-engine/src/frontend_event_bus.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "frontend_event_bus.h"
+#include "logging.h"
+#include "platform/platform.h"
+#include "trace.h"
+
+#include <algorithm>
+
+namespace streamlumo {
+
+FrontendEventBus::~FrontendEventBus() {
+    stop();
+}
+
+bool FrontendEventBus::start(const Options& options) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return true;
+    }
+    m_options = options;
+    m_stopping = false;
+    m_running = true;
+    m_thread = std::thread(&FrontendEventBus::dispatcherMain, this);
+    return true;
+}
+
+void FrontendEventBus::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    const Stats stats = this->stats();
+    if (stats.delivered > 0) {
+        log_info("Frontend events: %llu delivered, %llu coalesced, queue depth max %llu, "
+                 "wait avg %.2f ms max %.2f ms, dispatch avg %.2f ms max %.2f ms",
+                 static_cast<unsigned long long>(stats.delivered), static_cast<unsigned long long>(stats.coalesced),
+                 static_cast<unsigned long long>(stats.maxQueueDepth),
+                 stats.totalWaitMicros / 1000.0 / stats.delivered, stats.maxWaitMicros / 1000.0,
+                 stats.totalDispatchMicros / 1000.0 / stats.delivered, stats.maxDispatchMicros / 1000.0);
+    }
+}
+
+void FrontendEventBus::post(enum obs_frontend_event event) {
+    const bool synchronous = isSynchronous(event);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stats.posted++;
+
+    // Not dispatching, or a callback posting a synchronous event: waiting
+    // for the dispatcher would wait on ourselves
+    if (!m_running || m_stopping || (synchronous && onDispatcherThread())) {
+        lock.unlock();
+        deliver(event);
+        return;
+    }
+
+    if (m_options.coalesce && isCoalescable(event)) {
+        const auto begin = m_queue.begin() + static_cast<std::ptrdiff_t>(m_coalesceFrom);
+        if (std::any_of(begin, m_queue.end(), [event](const Pending& pending) { return pending.event == event; })) {
+            m_stats.coalesced++;
+            return;
+        }
+    }
+
+    const uint64_t sequence = m_nextSequence++;
+    m_queue.push_back(Pending{event, sequence, platform::getTimestampMicros()});
+    if (!isCoalescable(event)) {
+        m_coalesceFrom = m_queue.size();
+    }
+    m_stats.maxQueueDepth = std::max<uint64_t>(m_stats.maxQueueDepth, m_queue.size());
+    m_wake.notify_one();
+
+    if (synchronous) {
+        m_delivered.wait(lock, [this, sequence] { return m_deliveredSequence >= sequence; });
+    }
+}
+
+void FrontendEventBus::addCallback(obs_frontend_event_cb callback, void* privateData) {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_callbacks.push_back(Callback{callback, privateData});
+}
+
+void FrontendEventBus::removeCallback(obs_frontend_event_cb callback, void* privateData) {
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        m_callbacks.erase(std::remove_if(m_callbacks.begin(), m_callbacks.end(),
+                                         [callback, privateData](const Callback& cb) {
+                                             return cb.callback == callback && cb.privateData == privateData;
+                                         }),
+                          m_callbacks.end());
+    }
+    // Wait out a delivery that may be inside the callback right now. On the
+    // dispatcher thread that delivery is our caller; it skips removed callbacks.
+    std::lock_guard<std::recursive_mutex> wait(m_deliverMutex);
+}
+
+size_t FrontendEventBus::callbackCount() const {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    return m_callbacks.size();
+}
+
+FrontendEventBus::Stats FrontendEventBus::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+bool FrontendEventBus::isCoalescable(enum obs_frontend_event event) {
+    switch (event) {
+    case OBS_FRONTEND_EVENT_SCENE_CHANGED:
+    case OBS_FRONTEND_EVENT_PREVIEW_SCENE_CHANGED:
+    case OBS_FRONTEND_EVENT_TRANSITION_DURATION_CHANGED:
+    case OBS_FRONTEND_EVENT_TBAR_VALUE_CHANGED:
+    case OBS_FRONTEND_EVENT_SCENE_LIST_CHANGED:
+    case OBS_FRONTEND_EVENT_TRANSITION_LIST_CHANGED:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FrontendEventBus::isSynchronous(enum obs_frontend_event event) {
+    switch (event) {
+    case OBS_FRONTEND_EVENT_EXIT:
+    case OBS_FRONTEND_EVENT_FINISHED_LOADING:
+    case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGING:
+    case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CLEANUP:
+    case OBS_FRONTEND_EVENT_PROFILE_CHANGING:
+    case OBS_FRONTEND_EVENT_SCRIPTING_SHUTDOWN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void FrontendEventBus::dispatcherMain() {
+    platform::setThreadName("frontend-events");
+    Trace::setThreadName("frontend-events");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            break;  // Stopping, and everything posted has been delivered
+        }
+
+        const Pending pending = m_queue.front();
+        m_queue.pop_front();
+        if (m_coalesceFrom > 0) {
+            m_coalesceFrom--;
+        }
+        const uint64_t start = platform::getTimestampMicros();
+        const uint64_t wait = start - pending.postedMicros;
+        lock.unlock();
+
+        deliver(pending.event);
+
+        const uint64_t elapsed = platform::getTimestampMicros() - start;
+        if (elapsed >= static_cast<uint64_t>(m_options.slowDispatchMs) * 1000) {
+            log_warn("Frontend events: callbacks for event %d took %.1f ms", static_cast<int>(pending.event),
+                     elapsed / 1000.0);
+        }
+
+        lock.lock();
+        m_stats.delivered++;
+        m_stats.totalWaitMicros += wait;
+        m_stats.maxWaitMicros = std::max(m_stats.maxWaitMicros, wait);
+        m_stats.totalDispatchMicros += elapsed;
+        m_stats.maxDispatchMicros = std::max(m_stats.maxDispatchMicros, elapsed);
+        m_deliveredSequence = pending.sequence;
+        m_delivered.notify_all();
+    }
+}
+
+void FrontendEventBus::deliver(enum obs_frontend_event event) {
+    TRACE_SCOPE("frontend", "event");
+    std::lock_guard<std::recursive_mutex> delivering(m_deliverMutex);
+
+    std::vector<Callback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        callbacks = m_callbacks;
+    }
+    for (const Callback& cb : callbacks) {
+        // A callback earlier in this event may have removed a later one
+        {
+            std::lock_guard<std::mutex> lock(m_callbackMutex);
+            const bool registered = std::any_of(m_callbacks.begin(), m_callbacks.end(), [&cb](const Callback& c) {
+                return c.callback == cb.callback && c.privateData == cb.privateData;
+            });
+            if (!registered) {
+                continue;
+            }
+        }
+        cb.callback(event, cb.privateData);
+    }
+}
+
+} // namespace streamlumo
@@ -0,0 +1,119 @@
+// streamlumo-engine/src/frontend_event_bus.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <obs-frontend-api.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Delivers frontend events to plugin callbacks from a dispatcher thread
+ *
+ * post() queues the event and returns, so the thread that changed the scene
+ * (often obs-websocket's request thread) does not run every plugin's event
+ * handling inline. Events are delivered one at a time, in the order they
+ * were posted, on the "frontend-events" thread.
+ *
+ * Coalescing: state notifications whose handlers read the current state
+ * (scene, preview scene, transition duration, T-bar, scene/transition list
+ * changed) are dropped when the same event is still waiting in the queue
+ * with only other such notifications behind it. The queued copy is
+ * delivered instead and reads the newest state, so a burst of scene
+ * switches costs one broadcast. An event never moves past a
+ * non-coalescable one.
+ *
+ * Events that plugins must handle before the caller carries on (exit,
+ * finished loading, collection/profile changing, collection cleanup,
+ * scripting shutdown) are synchronous: post() waits until everything queued
+ * before them and the event itself has been delivered.
+ *
+ * Before start() and after stop(), events are delivered inline.
+ */
+class FrontendEventBus {
+public:
+    struct Options {
+        bool coalesce = true;
+        uint32_t slowDispatchMs = 250;  // Warn when one event's callbacks take longer
+    };
+
+    struct Stats {
+        uint64_t posted = 0;
+        uint64_t delivered = 0;
+        uint64_t coalesced = 0;         // Posts absorbed by an event already in the queue
+        uint64_t maxQueueDepth = 0;
+        uint64_t totalWaitMicros = 0;   // Post to dispatch
+        uint64_t maxWaitMicros = 0;
+        uint64_t totalDispatchMicros = 0;
+        uint64_t maxDispatchMicros = 0;
+    };
+
+    FrontendEventBus() = default;
+    ~FrontendEventBus();
+
+    FrontendEventBus(const FrontendEventBus&) = delete;
+    FrontendEventBus& operator=(const FrontendEventBus&) = delete;
+
+    bool start(const Options& options);
+    // Delivers whatever is still queued, then joins the dispatcher
+    void stop();
+
+    void post(enum obs_frontend_event event);
+
+    void addCallback(obs_frontend_event_cb callback, void* privateData);
+    // Once this returns (off the dispatcher thread), the callback is not running and will not be called
+    void removeCallback(obs_frontend_event_cb callback, void* privateData);
+    size_t callbackCount() const;
+
+    Stats stats() const;
+
+    static bool isCoalescable(enum obs_frontend_event event);
+    static bool isSynchronous(enum obs_frontend_event event);
+
+private:
+    struct Callback {
+        obs_frontend_event_cb callback;
+        void* privateData;
+    };
+
+    struct Pending {
+        enum obs_frontend_event event;
+        uint64_t sequence;
+        uint64_t postedMicros;
+    };
+
+    void dispatcherMain();
+    void deliver(enum obs_frontend_event event);
+    bool onDispatcherThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
+
+    Options m_options;
+
+    // Queue, shared with the dispatcher
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_delivered;
+    std::deque<Pending> m_queue;
+    size_t m_coalesceFrom = 0;          // Queue index after the last non-coalescable event
+    uint64_t m_nextSequence = 1;
+    uint64_t m_deliveredSequence = 0;
+    bool m_running = false;
+    bool m_stopping = false;
+    Stats m_stats;
+
+    // Held for the whole of one event's delivery; removeCallback() waits on it
+    std::recursive_mutex m_deliverMutex;
+    mutable std::mutex m_callbackMutex;
+    std::vector<Callback> m_callbacks;
+
+    std::thread m_thread;
+};
+
+} // namespace streamlumo
@@ -0,0 +1,302 @@
+// streamlumo-engine/src/helper_health_monitor.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "helper_health_monitor.h"
+#include "browser_helper_client.h"
+#include "browser_helper_launcher.h"
+#include "logging.h"
+#include "platform/platform.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+namespace streamlumo {
+
+static constexpr uint64_t kPingIntervalNanos = 2000ULL * 1000000ULL;
+static constexpr uint64_t kPingTimeoutNanos = 1500ULL * 1000000ULL;
+static constexpr uint64_t kReconnectBackoffNanos = 2000ULL * 1000000ULL;
+static constexpr uint64_t kReportIntervalNanos = 60ULL * 1000000000ULL;
+static constexpr uint64_t kMaxMissedPings = 3;
+static constexpr int kMaxWaitMs = 100;  // Bounds stop() latency
+
+// Unsigned integer field of a flat JSON line ("seq":42); false if absent
+static bool jsonUintField(const std::string& line, const char* key, uint64_t& value)
+{
+    const std::string needle = std::string("\"") + key + "\":";
+    size_t pos = line.find(needle);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos += needle.size();
+    while (pos < line.size() && line[pos] == ' ') {
+        ++pos;
+    }
+    char* end = nullptr;
+    value = std::strtoull(line.c_str() + pos, &end, 10);
+    return end != line.c_str() + pos;
+}
+
+uint64_t HelperHealthMonitor::Stats::rttPercentileUs(double percentile) const
+{
+    uint64_t total = 0;
+    for (uint64_t count : rttHistogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(total * percentile / 100.0 + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kRttBucketsUs.size(); ++i) {
+        seen += rttHistogram[i];
+        if (seen >= rank) {
+            return kRttBucketsUs[i];
+        }
+    }
+    return rttMaxUs;
+}
+
+HelperHealthMonitor::HelperHealthMonitor(BrowserHelperLauncher& launcher, std::string bundlePath,
+                                         uint16_t port, std::string token)
+    : m_launcher(launcher)
+    , m_bundlePath(std::move(bundlePath))
+    , m_port(port)
+    , m_token(std::move(token))
+{
+}
+
+HelperHealthMonitor::~HelperHealthMonitor()
+{
+    stop();
+}
+
+void HelperHealthMonitor::start(std::unique_ptr<BrowserHelperClient> client)
+{
+    if (m_running) {
+        return;
+    }
+    m_client = client ? std::move(client) : std::make_unique<BrowserHelperClient>();
+    m_everConnected = m_client->isConnected();
+    m_running = true;
+    m_thread = std::thread(&HelperHealthMonitor::run, this);
+}
+
+std::unique_ptr<BrowserHelperClient> HelperHealthMonitor::stop()
+{
+    if (m_running.exchange(false) && m_thread.joinable()) {
+        m_thread.join();
+        logReport("Helper health (final)");
+    }
+    return std::move(m_client);
+}
+
+HelperHealthMonitor::Stats HelperHealthMonitor::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void HelperHealthMonitor::requestRestart()
+{
+    m_restartRequested = true;
+}
+
+void HelperHealthMonitor::run()
+{
+    platform::setThreadName("helper-health");
+
+    uint64_t nextPing = platform::getTimestampNanos();
+    uint64_t nextReconnect = 0;
+    uint64_t nextReport = nextPing + kReportIntervalNanos;
+    std::vector<std::string> lines;
+
+    while (m_running) {
+        uint64_t now = platform::getTimestampNanos();
+
+        if (m_restartRequested.exchange(false)) {
+            log_warn("[helper] browser bridge cannot reach the helper; reconnecting");
+            m_client->stop();
+            nextReconnect = 0;
+        }
+
+        if (!m_client->isConnected()) {
+            if (now >= nextReconnect) {
+                reconnect("not connected");
+                nextReconnect = now + kReconnectBackoffNanos;
+                nextPing = platform::getTimestampNanos();
+            }
+        } else if (now >= nextPing) {
+            sendPing(now);
+            nextPing = now + kPingIntervalNanos;
+        }
+
+        expirePings(now);
+        {
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.connected = m_client->isConnected();
+        }
+        if (m_client->isConnected() && m_stats.consecutiveMissed >= kMaxMissedPings) {
+            log_warn("[helper] %llu consecutive pings unanswered; reconnecting",
+                     static_cast<unsigned long long>(m_stats.consecutiveMissed));
+            m_client->stop();
+            nextReconnect = 0;
+            continue;
+        }
+
+        if (now >= nextReport) {
+            logReport("Helper health");
+            nextReport = now + kReportIntervalNanos;
+        }
+
+        // Sleep until the helper says something or the next ping is due
+        const uint64_t until = m_client->isConnected() ? nextPing : nextReconnect;
+        int timeoutMs = until > now ? static_cast<int>((until - now) / 1000000ULL) : 0;
+        timeoutMs = std::min(timeoutMs, kMaxWaitMs);
+#ifndef _WIN32
+        if (m_client->isConnected()) {
+            struct pollfd pfd = {m_client->fd(), POLLIN, 0};
+            if (poll(&pfd, 1, timeoutMs) <= 0) {
+                continue;
+            }
+            lines.clear();
+            const bool open = m_client->readLines(lines);
+            now = platform::getTimestampNanos();
+            for (const std::string& line : lines) {
+                handleLine(line, now);
+            }
+            if (!open) {
+                log_warn("[helper] connection closed by browser helper");
+                m_client->stop();
+                nextReconnect = 0;
+            }
+            continue;
+        }
+#endif
+        platform::sleepMillis(static_cast<uint32_t>(timeoutMs));
+    }
+}
+
+void HelperHealthMonitor::sendPing(uint64_t nowNanos)
+{
+    const uint64_t seq = m_nextSeq++;
+    if (!m_client->sendPing(seq, nowNanos)) {
+        log_warn("[helper] ping %llu could not be sent", static_cast<unsigned long long>(seq));
+        m_client->stop();
+        return;
+    }
+    m_outstanding.emplace(seq, nowNanos);
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.pingsSent;
+}
+
+void HelperHealthMonitor::handleLine(const std::string& line, uint64_t nowNanos)
+{
+    if (line.find("\"type\":\"pong\"") == std::string::npos) {
+        return;  // browserReady, helper_ready, errors, ... are not ours
+    }
+
+    uint64_t seq = 0;
+    if (!jsonUintField(line, "seq", seq)) {
+        // Helpers without seq echo: answer the oldest outstanding ping
+        if (m_outstanding.empty()) {
+            return;
+        }
+        seq = m_outstanding.begin()->first;
+    }
+
+    if (seq == 0) {
+        return;  // Connection check sent by BrowserHelperClient::start()
+    }
+
+    auto it = m_outstanding.find(seq);
+    if (it == m_outstanding.end()) {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        ++m_stats.late;
+        m_stats.consecutiveMissed = 0;
+        return;
+    }
+    const uint64_t sent = it->second;
+    m_outstanding.erase(it);
+    recordPong(sent, nowNanos);
+}
+
+void HelperHealthMonitor::recordPong(uint64_t sentNanos, uint64_t nowNanos)
+{
+    const uint64_t rttUs = nowNanos > sentNanos ? (nowNanos - sentNanos) / 1000ULL : 0;
+    size_t bucket = 0;
+    while (bucket < kRttBucketsUs.size() && rttUs > kRttBucketsUs[bucket]) {
+        ++bucket;
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.pongs;
+    m_stats.consecutiveMissed = 0;
+    m_stats.rttSumUs += rttUs;
+    m_stats.rttMaxUs = std::max(m_stats.rttMaxUs, rttUs);
+    ++m_stats.rttHistogram[bucket];
+}
+
+void HelperHealthMonitor::expirePings(uint64_t nowNanos)
+{
+    uint64_t expired = 0;
+    for (auto it = m_outstanding.begin(); it != m_outstanding.end();) {
+        if (nowNanos - it->second < kPingTimeoutNanos) {
+            break;  // Ordered by seq, so by send time
+        }
+        it = m_outstanding.erase(it);
+        ++expired;
+    }
+    if (expired == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.missed += expired;
+    m_stats.consecutiveMissed += expired;
+}
+
+void HelperHealthMonitor::reconnect(const char* reason)
+{
+    m_outstanding.clear();
+    m_client->stop();
+
+    bool restarted = false;
+    if (!m_launcher.checkAlive() && !m_bundlePath.empty()) {
+        log_warn("Helper process not alive; restarting...");
+        restarted = m_launcher.start(m_bundlePath);
+    }
+
+    const bool connected = m_client->start(m_port, m_token);
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    if (restarted) {
+        ++m_stats.restarts;
+    }
+    if (connected) {
+        m_stats.consecutiveMissed = 0;
+        if (m_everConnected) {
+            ++m_stats.reconnects;
+            log_info("[helper] reconnected (%s)", reason);
+        }
+        m_everConnected = true;
+    }
+}
+
+void HelperHealthMonitor::logReport(const char* prefix)
+{
+    const Stats s = stats();
+    log_info("%s: %s, %llu pings, %llu pongs, rtt avg %.2f ms p50 <=%.2f ms p99 <=%.2f ms "
+             "max %.2f ms, %llu missed, %llu late, %llu reconnects, %llu restarts",
+             prefix, s.connected ? "connected" : "disconnected",
+             static_cast<unsigned long long>(s.pingsSent), static_cast<unsigned long long>(s.pongs),
+             s.pongs ? s.rttSumUs / 1000.0 / s.pongs : 0.0,
+             s.rttPercentileUs(50) / 1000.0, s.rttPercentileUs(99) / 1000.0, s.rttMaxUs / 1000.0,
+             static_cast<unsigned long long>(s.missed), static_cast<unsigned long long>(s.late),
+             static_cast<unsigned long long>(s.reconnects), static_cast<unsigned long long>(s.restarts));
+}
+
+} // namespace streamlumo
@@ -0,0 +1,117 @@
+// streamlumo-engine/src/helper_health_monitor.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace streamlumo {
+
+class BrowserHelperClient;
+class BrowserHelperLauncher;
+
+/**
+ * @brief Background health check for the browser helper's control socket
+ * 
+ * Owns the BrowserHelperClient on its own thread. Every 2s it sends a ping
+ * carrying a sequence number and timestamp; pongs are matched by sequence
+ * (other helper messages on the socket are ignored), their round-trip time
+ * is recorded in a histogram, and pings left unanswered for 1.5s count as
+ * missed. Only sustained failure (3 consecutive missed pings, or the
+ * connection closing) triggers a reconnect, restarting the helper process
+ * first if it has exited. The main thread never waits on the helper, not
+ * even for the first connection when start() is given no client.
+ * 
+ * The monitor is the only owner of the helper process it watches:
+ * obs-browser-bridge does not relaunch it when its own connection keeps
+ * failing, it calls requestRestart() (through the
+ * streamlumo_browser_helper_restart proc) and only reconnects.
+ */
+class HelperHealthMonitor {
+public:
+    // RTT histogram bucket upper bounds in microseconds; the last bucket is open-ended
+    static constexpr std::array<uint32_t, 13> kRttBucketsUs = {
+        100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000};
+
+    struct Stats {
+        uint64_t pingsSent = 0;
+        uint64_t pongs = 0;
+        uint64_t missed = 0;            // Pings not answered within the timeout
+        uint64_t late = 0;              // Pongs that arrived after being counted missed
+        uint64_t consecutiveMissed = 0;
+        uint64_t reconnects = 0;
+        uint64_t restarts = 0;          // Helper process relaunches
+        uint64_t rttSumUs = 0;
+        uint64_t rttMaxUs = 0;
+        std::array<uint64_t, kRttBucketsUs.size() + 1> rttHistogram{};
+        bool connected = false;
+
+        // Upper bound of the bucket holding the given percentile (0-100), 0 if no samples
+        uint64_t rttPercentileUs(double percentile) const;
+    };
+
+    HelperHealthMonitor(BrowserHelperLauncher& launcher, std::string bundlePath,
+                        uint16_t port, std::string token);
+    ~HelperHealthMonitor();
+
+    HelperHealthMonitor(const HelperHealthMonitor&) = delete;
+    HelperHealthMonitor& operator=(const HelperHealthMonitor&) = delete;
+
+    /**
+     * @brief Start monitoring
+     * @param client Already connected client (may be null or disconnected;
+     *               the monitor then connects on its own)
+     */
+    void start(std::unique_ptr<BrowserHelperClient> client);
+
+    /**
+     * @brief Stop the monitor thread and hand the client back (for shutdown)
+     */
+    std::unique_ptr<BrowserHelperClient> stop();
+
+    Stats stats() const;
+
+    /**
+     * @brief Reconnect (restarting the helper if it exited) on the next pass
+     * 
+     * Thread-safe; called when another client of the helper lost it.
+     */
+    void requestRestart();
+
+private:
+    void run();
+    void sendPing(uint64_t nowNanos);
+    void handleLine(const std::string& line, uint64_t nowNanos);
+    void recordPong(uint64_t sentNanos, uint64_t nowNanos);
+    void expirePings(uint64_t nowNanos);
+    void reconnect(const char* reason);
+    void logReport(const char* prefix);
+
+    BrowserHelperLauncher& m_launcher;
+    std::string m_bundlePath;
+    uint16_t m_port;
+    std::string m_token;
+
+    std::unique_ptr<BrowserHelperClient> m_client;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_restartRequested{false};
+
+    // Monitor thread only
+    uint64_t m_nextSeq = 1;
+    bool m_everConnected = false;
+    std::map<uint64_t, uint64_t> m_outstanding;  // seq -> send time
+
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+};
+
+} // namespace streamlumo
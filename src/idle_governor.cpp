@@ -0,0 +1,143 @@
+// streamlumo-engine/src/idle_governor.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "idle_governor.h"
+#include "logging.h"
+#include "platform/platform.h"
+
+#include <obs.h>
+
+#include <cstring>
+#include <string>
+
+namespace streamlumo {
+
+// Consumers are sampled at most this often while rendering; while idle the
+// main loop polls every 100 ms and every poll samples
+static constexpr uint64_t kIdleSampleNanos = 250ULL * 1000000ULL;
+
+IdleGovernor::IdleGovernor(int timeoutSeconds, uint16_t controlPort)
+    : m_timeoutNanos(timeoutSeconds > 0 ? static_cast<uint64_t>(timeoutSeconds) * 1000000000ULL : 0)
+    , m_controlPort(controlPort)
+    , m_lastActiveNanos(platform::getTimestampNanos())
+{
+    if (!enabled()) {
+        return;
+    }
+    log_info("Idle mode: suspending rendering after %ds without outputs or control clients",
+             timeoutSeconds);
+    if (platform::countTcpConnections(m_controlPort) < 0) {
+        log_warn("Idle mode: cannot count clients on port %u on this platform; "
+                 "the engine will never go idle", static_cast<unsigned>(m_controlPort));
+    }
+}
+
+IdleGovernor::~IdleGovernor() {
+    restoreProgram();
+}
+
+IdleGovernor::Activity IdleGovernor::sample() const {
+    Activity activity;
+
+    obs_enum_outputs([](void* param, obs_output_t* output) {
+        if (obs_output_active(output)) {
+            ++static_cast<Activity*>(param)->outputs;
+        }
+        return true;
+    }, &activity);
+
+    obs_enum_sources([](void* param, obs_source_t* source) {
+        const char* id = obs_source_get_unversioned_id(source);
+        if (id && strcmp(id, "browser_bridge_source") == 0 && obs_source_showing(source)) {
+            ++static_cast<Activity*>(param)->browsers;
+        }
+        return true;
+    }, &activity);
+
+    activity.clients = platform::countTcpConnections(m_controlPort);
+    return activity;
+}
+
+bool IdleGovernor::update(uint64_t nowNanos) {
+    if (!enabled()) {
+        return false;
+    }
+    if (!m_idle && nowNanos - m_lastSampleNanos < kIdleSampleNanos) {
+        return false;
+    }
+    m_lastSampleNanos = nowNanos;
+
+    const Activity activity = sample();
+    if (activity.outputs > 0 || activity.clients != 0) {
+        m_lastActiveNanos = nowNanos;
+        if (m_idle) {
+            leaveIdle(nowNanos, activity);
+        }
+        return false;
+    }
+
+    if (!m_idle && nowNanos - m_lastActiveNanos >= m_timeoutNanos) {
+        enterIdle(nowNanos, activity);
+    }
+    return m_idle;
+}
+
+void IdleGovernor::enterIdle(uint64_t nowNanos, const Activity& activity) {
+    m_idle = true;
+    m_idleSinceNanos = nowNanos;
+    if (activity.browsers > 0) {
+        m_producersPaused = setBrowserProducersPaused(true);
+    }
+    detachProgram();
+    log_info("Idle mode: no outputs or control clients for %llus, rendering suspended "
+             "(program %s, %d on-screen browser source(s)%s)",
+             static_cast<unsigned long long>(m_timeoutNanos / 1000000000ULL),
+             m_heldProgram ? "detached" : "was empty", activity.browsers,
+             m_producersPaused ? ", paused unless on another canvas" : "");
+}
+
+void IdleGovernor::leaveIdle(uint64_t nowNanos, const Activity& activity) {
+    m_idle = false;
+    if (m_producersPaused) {
+        setBrowserProducersPaused(false);
+        m_producersPaused = false;
+    }
+    restoreProgram();
+    log_info("Idle mode: resuming after %.1fs idle (%d active output(s), %s control client(s))",
+             (nowNanos - m_idleSinceNanos) / 1e9, activity.outputs,
+             activity.clients < 0 ? "unknown" : std::to_string(activity.clients).c_str());
+}
+
+void IdleGovernor::detachProgram() {
+    m_heldProgram = obs_get_output_source(0);
+    if (m_heldProgram) {
+        obs_set_output_source(0, nullptr);
+    }
+}
+
+void IdleGovernor::restoreProgram() {
+    if (!m_heldProgram) {
+        return;
+    }
+    // A client may have set a program before the sample that woke us
+    obs_source_t* current = obs_get_output_source(0);
+    if (!current) {
+        obs_set_output_source(0, m_heldProgram);
+    }
+    obs_source_release(current);
+    obs_source_release(m_heldProgram);
+    m_heldProgram = nullptr;
+}
+
+bool IdleGovernor::setBrowserProducersPaused(bool paused) {
+    // Registered by obs-browser-bridge; absent when the plugin is not loaded
+    calldata_t cd;
+    calldata_init(&cd);
+    calldata_set_bool(&cd, "paused", paused);
+    bool called = proc_handler_call(obs_get_proc_handler(), "browser_bridge_set_paused", &cd);
+    calldata_free(&cd);
+    return called;
+}
+
+} // namespace streamlumo
@@ -0,0 +1,72 @@
+// streamlumo-engine/src/idle_governor.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <obs.h>
+
+#include <cstdint>
+
+namespace streamlumo {
+
+/**
+ * @brief Suspends rendering while nothing consumes the engine's output
+ * 
+ * Consumers are active outputs (stream, record, virtual camera, ...) and
+ * control clients connected to the WebSocket port. Once neither has been
+ * seen for the configured timeout the governor goes idle:
+ * - the program source is taken off output channel 0, so libobs' own
+ *   graphics thread renders an empty frame and the program's sources stop
+ *   showing (sources on extra canvases keep rendering there);
+ * - the main loop skips its manual render;
+ * - the browser bridge enters idle mode (browser_bridge_set_paused proc)
+ *   and pauses the helper-side producer of every browser no canvas is
+ *   still showing; browsers on extra canvases keep producing.
+ * The first sample that sees a consumer again undoes all three. If a client
+ * set a new program in the meantime, that one is kept.
+ */
+class IdleGovernor {
+public:
+    IdleGovernor(int timeoutSeconds, uint16_t controlPort);
+    // Puts the program back if still idle
+    ~IdleGovernor();
+
+    IdleGovernor(const IdleGovernor&) = delete;
+    IdleGovernor& operator=(const IdleGovernor&) = delete;
+
+    bool enabled() const { return m_timeoutNanos > 0; }
+    bool isIdle() const { return m_idle; }
+
+    /**
+     * @brief Sample consumers (rate-limited while active) and update state
+     * @param nowNanos platform::getTimestampNanos()
+     * @return true while rendering should stay suspended
+     */
+    bool update(uint64_t nowNanos);
+
+private:
+    struct Activity {
+        int outputs = 0;
+        int clients = 0;   // -1 = unknown, counted as connected
+        int browsers = 0;  // On-screen browser bridge sources
+    };
+
+    Activity sample() const;
+    void enterIdle(uint64_t nowNanos, const Activity& activity);
+    void leaveIdle(uint64_t nowNanos, const Activity& activity);
+    static bool setBrowserProducersPaused(bool paused);
+    void detachProgram();
+    void restoreProgram();
+
+    uint64_t m_timeoutNanos = 0;
+    uint16_t m_controlPort = 0;
+    uint64_t m_lastSampleNanos = 0;
+    uint64_t m_lastActiveNanos = 0;
+    uint64_t m_idleSinceNanos = 0;
+    bool m_idle = false;
+    bool m_producersPaused = false;
+    obs_source_t* m_heldProgram = nullptr;  // Channel 0 while idle; owned reference
+};
+
+} // namespace streamlumo
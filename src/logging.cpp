@@ -3,11 +3,17 @@
 // Copyright (C) 2024 StreamLumo
 
 #include "logging.h"
+#include "platform/platform.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdarg>
 #include <ctime>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <unistd.h>
 
 namespace streamlumo {
@@ -16,27 +22,267 @@ LogLevel Logging::s_level = LogLevel::Info;
 std::string Logging::s_logFile;
 void* Logging::s_fileHandle = nullptr;
 
-static std::mutex s_logMutex;
+namespace {
+
+// 2048 x 1 KB: the ring is the whole memory budget of the async path
+constexpr uint64_t kRingSlots = 2048;
+constexpr size_t kMaxLineBytes = 1000;
+constexpr size_t kBatchBytes = 64 * 1024;
+
+// Backstop for a wakeup lost between the writer's last check and its wait
+constexpr auto kWriterIdleWait = std::chrono::milliseconds(50);
+constexpr auto kFlushTimeout = std::chrono::seconds(2);
+
+// One slot of a bounded MPSC queue (Vyukov): sequence == position while the
+// slot is free for that position, position + 1 once its line is published
+struct Record {
+    std::atomic<uint64_t> sequence{0};
+    time_t time = 0;
+    LogLevel level = LogLevel::Info;
+    uint32_t length = 0;
+    char text[kMaxLineBytes];
+};
+
+// Allocated once and never freed, so a straggling producer can't touch freed memory
+std::unique_ptr<Record[]> s_ring;
+std::atomic<uint64_t> s_enqueuePos{0};
+uint64_t s_dequeuePos = 0;            // writer thread only
+std::atomic<uint64_t> s_written{0};   // lines the writer has flushed
+std::atomic<uint64_t> s_dropped{0};
+
+std::atomic<bool> s_async{false};
+std::atomic<bool> s_writerIdle{false};
+bool s_stopping = false;              // guarded by s_wakeMutex
+std::mutex s_wakeMutex;
+std::condition_variable s_wakeCv;
+std::condition_variable s_flushedCv;
+std::thread s_writer;
+
+// Direct path, used before init() and after shutdown()
+std::mutex s_directMutex;
+
+bool s_useColors = false;
+
+struct LevelStyle {
+    const char* label;
+    const char* color;
+};
+
+LevelStyle styleFor(LogLevel level)
+{
+    switch (level) {
+        case LogLevel::Debug:   return {"DEBUG", "\033[36m"};
+        case LogLevel::Info:    return {"INFO ", "\033[32m"};
+        case LogLevel::Warning: return {"WARN ", "\033[33m"};
+        case LogLevel::Error:   return {"ERROR", "\033[31m"};
+        default:                return {"?????", ""};
+    }
+}
+
+FILE* streamFor(LogLevel level, void* fileHandle)
+{
+    if (fileHandle) {
+        return static_cast<FILE*>(fileHandle);
+    }
+    return level == LogLevel::Error ? stderr : stdout;
+}
+
+// localtime_r + strftime only when the second changes
+class TimestampCache {
+public:
+    const char* format(time_t now)
+    {
+        if (now != m_second) {
+            struct tm tm_info;
+#ifdef _WIN32
+            localtime_s(&tm_info, &now);
+#else
+            localtime_r(&now, &tm_info);
+#endif
+            strftime(m_text, sizeof(m_text), "%Y-%m-%d %H:%M:%S", &tm_info);
+            m_second = now;
+        }
+        return m_text;
+    }
+
+private:
+    time_t m_second = -1;
+    char m_text[32] = {};
+};
+
+void appendLine(std::string& out, const char* timestamp, LogLevel level, const char* text, size_t length)
+{
+    const LevelStyle style = styleFor(level);
+    out += timestamp;
+    out += "[streamlumo-engine] [";
+    if (s_useColors && style.color[0]) {
+        out += style.color;
+        out += style.label;
+        out += "\033[0m";
+    } else {
+        out += style.label;
+    }
+    out += "] ";
+    out.append(text, length);
+    out += '\n';
+}
+
+// Lines bound for one stream; switching streams writes out what is pending
+struct Batch {
+    std::string text;
+    FILE* stream = nullptr;
+
+    void switchTo(FILE* next)
+    {
+        if (next != stream) {
+            write();
+            stream = next;
+        }
+    }
+
+    void write()
+    {
+        if (stream && !text.empty()) {
+            fwrite(text.data(), 1, text.size(), stream);
+            fflush(stream);
+        }
+        text.clear();
+    }
+};
+
+bool recordReady()
+{
+    const Record& record = s_ring[s_dequeuePos & (kRingSlots - 1)];
+    return record.sequence.load(std::memory_order_acquire) == s_dequeuePos + 1;
+}
+
+size_t drain(Batch& batch, TimestampCache& timestamps, uint64_t& reportedDrops, void* fileHandle)
+{
+    size_t count = 0;
+    while (recordReady()) {
+        Record& record = s_ring[s_dequeuePos & (kRingSlots - 1)];
+        batch.switchTo(streamFor(record.level, fileHandle));
+        appendLine(batch.text, timestamps.format(record.time), record.level, record.text, record.length);
+        record.sequence.store(s_dequeuePos + kRingSlots, std::memory_order_release);
+        ++s_dequeuePos;
+        ++count;
+        if (batch.text.size() >= kBatchBytes) {
+            batch.write();
+        }
+    }
+
+    const uint64_t dropped = s_dropped.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops) {
+        char note[96];
+        int length = snprintf(note, sizeof(note), "Logging: %llu lines dropped (queue full)",
+                              static_cast<unsigned long long>(dropped - reportedDrops));
+        batch.switchTo(streamFor(LogLevel::Warning, fileHandle));
+        appendLine(batch.text, timestamps.format(time(nullptr)), LogLevel::Warning, note,
+                   static_cast<size_t>(length));
+        reportedDrops = dropped;
+    }
+
+    if (count > 0) {
+        batch.write();
+        s_written.store(s_dequeuePos, std::memory_order_release);
+        { std::lock_guard<std::mutex> lock(s_wakeMutex); }
+        s_flushedCv.notify_all();
+    }
+    return count;
+}
+
+void writerMain(void* fileHandle)
+{
+    platform::setThreadName("log-writer");
+
+    Batch batch;
+    batch.text.reserve(kBatchBytes + kMaxLineBytes + 64);
+    TimestampCache timestamps;
+    uint64_t reportedDrops = 0;
+
+    for (;;) {
+        if (drain(batch, timestamps, reportedDrops, fileHandle) > 0) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(s_wakeMutex);
+        if (s_stopping && !recordReady()) {
+            break;
+        }
+        s_writerIdle.store(true);
+        s_wakeCv.wait_for(lock, kWriterIdleWait, [] { return s_stopping || recordReady(); });
+        s_writerIdle.store(false);
+    }
+}
+
+} // namespace
 
 void Logging::init(LogLevel level, const std::string& logFile) {
     s_level = level;
     s_logFile = logFile;
-    
+
     if (!logFile.empty()) {
         s_fileHandle = fopen(logFile.c_str(), "a");
         if (!s_fileHandle) {
             fprintf(stderr, "[streamlumo-engine] Warning: Could not open log file: %s\n", logFile.c_str());
         }
     }
+    s_useColors = !s_fileHandle && isatty(fileno(stdout));
+
+    if (!s_ring) {
+        s_ring.reset(new Record[kRingSlots]);
+        for (uint64_t i = 0; i < kRingSlots; ++i) {
+            s_ring[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // main() has already blocked the termination signals (EventLoop::captureSignals),
+    // so the writer inherits the mask and never receives them
+    s_stopping = false;
+    s_writer = std::thread(writerMain, s_fileHandle);
+    s_async.store(true, std::memory_order_release);
 }
 
 void Logging::shutdown() {
+    if (s_writer.joinable()) {
+        s_async.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(s_wakeMutex);
+            s_stopping = true;
+        }
+        s_wakeCv.notify_one();
+        s_writer.join();
+    }
+
+    const uint64_t dropped = s_dropped.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+        log(LogLevel::Info, "Logging: %llu lines dropped in total", static_cast<unsigned long long>(dropped));
+    }
+
     if (s_fileHandle) {
         fclose(static_cast<FILE*>(s_fileHandle));
         s_fileHandle = nullptr;
     }
 }
 
+void Logging::flush() {
+    if (!s_async.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(s_directMutex);
+        fflush(s_fileHandle ? static_cast<FILE*>(s_fileHandle) : stdout);
+        return;
+    }
+
+    const uint64_t target = s_enqueuePos.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(s_wakeMutex);
+    s_wakeCv.notify_one();
+    s_flushedCv.wait_for(lock, kFlushTimeout, [target] {
+        return s_written.load(std::memory_order_acquire) >= target;
+    });
+}
+
+uint64_t Logging::droppedCount() {
+    return s_dropped.load(std::memory_order_relaxed);
+}
+
 LogLevel Logging::getLevel() {
     return s_level;
 }
@@ -46,61 +292,81 @@ void Logging::log(LogLevel level, const char* format, ...) {
     if (static_cast<int>(level) < static_cast<int>(s_level)) {
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(s_logMutex);
-    
-    // Get timestamp
-    time_t now = time(nullptr);
-    struct tm* tm_info = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
-    
-    // Get level string
-    const char* levelStr;
-    const char* colorCode = "";
-    const char* resetCode = "";
-    
-    // Use colors for terminal output
-    FILE* output = s_fileHandle ? static_cast<FILE*>(s_fileHandle) : stdout;
-    bool useColors = !s_fileHandle && isatty(fileno(stdout));
-    
-    switch (level) {
-        case LogLevel::Debug:
-            levelStr = "DEBUG";
-            if (useColors) { colorCode = "\033[36m"; resetCode = "\033[0m"; }
-            break;
-        case LogLevel::Info:
-            levelStr = "INFO ";
-            if (useColors) { colorCode = "\033[32m"; resetCode = "\033[0m"; }
-            break;
-        case LogLevel::Warning:
-            levelStr = "WARN ";
-            if (useColors) { colorCode = "\033[33m"; resetCode = "\033[0m"; }
-            break;
-        case LogLevel::Error:
-            levelStr = "ERROR";
-            if (useColors) { colorCode = "\033[31m"; resetCode = "\033[0m"; }
-            output = s_fileHandle ? static_cast<FILE*>(s_fileHandle) : stderr;
-            break;
-        default:
-            levelStr = "?????";
-            break;
-    }
-    
-    // Print prefix
-    fprintf(output, "%s[%s] [%s%s%s] ", 
-            timestamp, 
-            "streamlumo-engine",
-            colorCode, levelStr, resetCode);
-    
-    // Print message
+
     va_list args;
     va_start(args, format);
-    vfprintf(output, format, args);
+    logv(level, format, args);
     va_end(args);
-    
-    fprintf(output, "\n");
-    fflush(output);
+}
+
+void Logging::logv(LogLevel level, const char* format, va_list args) {
+    if (static_cast<int>(level) < static_cast<int>(s_level)) {
+        return;
+    }
+
+    if (!s_async.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(s_directMutex);
+        static TimestampCache timestamps;
+        char text[kMaxLineBytes];
+        int length = vsnprintf(text, sizeof(text), format, args);
+        if (length < 0) {
+            length = 0;
+        } else if (static_cast<size_t>(length) >= sizeof(text)) {
+            length = sizeof(text) - 1;
+        }
+
+        std::string line;
+        appendLine(line, timestamps.format(time(nullptr)), level, text, static_cast<size_t>(length));
+        FILE* output = streamFor(level, s_fileHandle);
+        fwrite(line.data(), 1, line.size(), output);
+        fflush(output);
+        return;
+    }
+
+    // Claim a slot; a full ring drops the line rather than blocking the
+    // caller, except for errors which wait once for the writer to make room
+    uint64_t pos = s_enqueuePos.load(std::memory_order_relaxed);
+    Record* record;
+    bool waited = false;
+    for (;;) {
+        record = &s_ring[pos & (kRingSlots - 1)];
+        const uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+        const int64_t diff = static_cast<int64_t>(sequence - pos);
+        if (diff == 0) {
+            if (s_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            if (level == LogLevel::Error && !waited) {
+                flush();
+                waited = true;
+                pos = s_enqueuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = s_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->time = time(nullptr);
+    record->level = level;
+    int length = vsnprintf(record->text, kMaxLineBytes, format, args);
+    if (length < 0) {
+        length = 0;
+    } else if (static_cast<size_t>(length) >= kMaxLineBytes) {
+        length = kMaxLineBytes - 1;
+    }
+    record->length = static_cast<uint32_t>(length);
+    record->sequence.store(pos + 1, std::memory_order_release);
+
+    if (level == LogLevel::Error) {
+        // Errors often precede a crash or exit: make sure they are written
+        flush();
+    } else if (s_writerIdle.load()) {
+        s_wakeCv.notify_one();
+    }
 }
 
 } // namespace streamlumo
@@ -5,27 +5,45 @@
 #pragma once
 
 #include "config.h"
+#include <cstdarg>
+#include <cstdint>
 #include <string>
 
 namespace streamlumo {
 
 /**
  * @brief Logging utility for StreamLumo Engine
+ * 
+ * Between init() and shutdown() log() never blocks on I/O: the caller
+ * formats its line into a slot of a fixed-size lock-free ring and a writer
+ * thread drains the ring in batches. When the ring is full the line is
+ * dropped and counted. Errors are flushed synchronously so they reach the
+ * log before a crash. Outside init()/shutdown() lines are written directly.
  */
 class Logging {
 public:
     /**
-     * @brief Initialize logging system
+     * @brief Initialize logging system and start the writer thread
      * @param level Minimum log level to output
      * @param logFile Optional file path for logging (empty = stdout)
      */
     static void init(LogLevel level, const std::string& logFile = "");
     
     /**
-     * @brief Shutdown logging system
+     * @brief Drain all queued lines, stop the writer thread and close the log file
      */
     static void shutdown();
     
+    /**
+     * @brief Block until every line logged before this call has been written
+     */
+    static void flush();
+    
+    /**
+     * @brief Lines dropped because the ring was full
+     */
+    static uint64_t droppedCount();
+    
     /**
      * @brief Log a message
      * @param level Log level
@@ -34,6 +52,11 @@ public:
      */
     static void log(LogLevel level, const char* format, ...);
     
+    /**
+     * @brief va_list variant of log(), for forwarding other loggers
+     */
+    static void logv(LogLevel level, const char* format, va_list args);
+    
     /**
      * @brief Get current log level
      */
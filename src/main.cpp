@@ -11,22 +11,12 @@
 #include "engine.h"
 #include "config.h"
 #include "logging.h"
+#include "event_loop.h"
 
-#include <csignal>
 #include <iostream>
 #include <atomic>
 
 static std::atomic<bool> g_running{true};
-static streamlumo::Engine* g_engine = nullptr;
-
-void signal_handler(int sig) {
-    log_info("Received signal %d, initiating shutdown...", sig);
-    g_running = false;
-    
-    if (g_engine) {
-        g_engine->requestShutdown();
-    }
-}
 
 void print_banner() {
     std::cout << R"(
@@ -44,6 +34,11 @@ void print_banner() {
 }
 
 int main(int argc, char* argv[]) {
+    // Termination signals are consumed by the engine's event loop (checked
+    // between startup phases, then in run()); this must happen before any
+    // thread exists so all of them inherit the signal mask
+    streamlumo::EventLoop::captureSignals();
+    
     // Parse command line arguments
     streamlumo::Config config;
     if (!config.parseArgs(argc, argv)) {
@@ -63,20 +58,19 @@ int main(int argc, char* argv[]) {
     log_info("Resolution: %dx%d @ %d fps", 
              config.getWidth(), config.getHeight(), config.getFPS());
     
-    // Set up signal handlers for graceful shutdown
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
-#ifndef _WIN32
-    std::signal(SIGHUP, signal_handler);
-#endif
-    
     // Create and initialize the engine
     streamlumo::Engine engine(config);
-    g_engine = &engine;
     
     if (!engine.initialize()) {
-        log_error("Failed to initialize engine");
-        return 1;
+        // A signal during startup is a requested exit, not a failure
+        const bool interrupted = engine.startupSignal() != 0;
+        if (interrupted) {
+            streamlumo::EventLoop::releaseSignals();
+        } else {
+            log_error("Failed to initialize engine");
+        }
+        streamlumo::Logging::shutdown();
+        return interrupted ? 0 : 1;
     }
     
     log_info("Engine initialized successfully");
@@ -93,6 +87,5 @@ int main(int argc, char* argv[]) {
     log_info("Shutdown complete");
     streamlumo::Logging::shutdown();
     
-    g_engine = nullptr;
     return exitCode;
 }
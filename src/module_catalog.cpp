@@ -0,0 +1,160 @@
+// streamlumo-engine/src/module_catalog.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "module_catalog.h"
+#include "logging.h"
+
+#include <obs-module.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace streamlumo {
+
+static const char* kManifestHeader = "streamlumo-module-manifest 1";
+
+static int64_t parseInt64(const std::string& text) {
+    return static_cast<int64_t>(std::strtoll(text.c_str(), nullptr, 10));
+}
+
+// Last write time as a plain integer; -1 if the path is gone
+static int64_t pathMtime(const std::string& path) {
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    if (ec) {
+        return -1;
+    }
+    return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+void ModuleCatalog::discover(const std::string& manifestPath, const std::string& key,
+                             const std::vector<std::string>& extraDirs) {
+    m_modules.clear();
+    m_dirs.clear();
+    m_fromCache = false;
+
+    if (!manifestPath.empty() && loadManifest(manifestPath, key)) {
+        m_fromCache = true;
+        log_info("Module manifest: %zu modules from %s", m_modules.size(), manifestPath.c_str());
+        return;
+    }
+
+    scan(extraDirs);
+    log_info("Module scan: %zu modules found", m_modules.size());
+    if (!manifestPath.empty()) {
+        saveManifest(manifestPath, key);
+    }
+}
+
+void ModuleCatalog::scan(const std::vector<std::string>& extraDirs) {
+    obs_find_modules2([](void* param, const struct obs_module_info2* info) {
+        auto* modules = static_cast<std::vector<Module>*>(param);
+        Module module;
+        module.name = info->name ? info->name : "";
+        module.binPath = info->bin_path ? info->bin_path : "";
+        module.dataPath = info->data_path ? info->data_path : "";
+        module.mtime = pathMtime(module.binPath);
+        log_debug("  Found module: %s (%s)", module.name.c_str(), module.binPath.c_str());
+        modules->push_back(std::move(module));
+    }, &m_modules);
+
+    std::set<std::string> dirs(extraDirs.begin(), extraDirs.end());
+    for (const Module& module : m_modules) {
+        dirs.insert(fs::path(module.binPath).parent_path().string());
+    }
+    for (const std::string& dir : dirs) {
+        m_dirs.emplace_back(dir, pathMtime(dir));
+    }
+}
+
+bool ModuleCatalog::loadManifest(const std::string& path, const std::string& key) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != kManifestHeader) {
+        return false;
+    }
+
+    bool keyMatches = false;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (fields.empty()) {
+            continue;
+        }
+
+        if (fields[0] == "key" && fields.size() == 2) {
+            keyMatches = fields[1] == key;
+            if (!keyMatches) {
+                log_info("Module manifest: key changed, rescanning");
+                return false;
+            }
+        } else if (fields[0] == "dir" && fields.size() == 3) {
+            const int64_t mtime = parseInt64(fields[2]);
+            if (pathMtime(fields[1]) != mtime) {
+                log_info("Module manifest: %s changed, rescanning", fields[1].c_str());
+                return false;
+            }
+            m_dirs.emplace_back(fields[1], mtime);
+        } else if (fields[0] == "module" && fields.size() == 5) {
+            Module module{fields[1], fields[2], fields[3], parseInt64(fields[4])};
+            if (pathMtime(module.binPath) != module.mtime) {
+                log_info("Module manifest: %s changed, rescanning", module.binPath.c_str());
+                return false;
+            }
+            m_modules.push_back(std::move(module));
+        } else {
+            return false;
+        }
+    }
+
+    if (!keyMatches) {
+        m_modules.clear();
+        m_dirs.clear();
+        return false;
+    }
+    return true;
+}
+
+void ModuleCatalog::saveManifest(const std::string& path, const std::string& key) const {
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    // Write to a temporary file and rename so a crash never leaves half a manifest
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file) {
+            log_warn("Module manifest: cannot write %s", tmpPath.c_str());
+            return;
+        }
+        file << kManifestHeader << "\n";
+        file << "key\t" << key << "\n";
+        for (const auto& dir : m_dirs) {
+            file << "dir\t" << dir.first << "\t" << dir.second << "\n";
+        }
+        for (const Module& module : m_modules) {
+            file << "module\t" << module.name << "\t" << module.binPath << "\t"
+                 << module.dataPath << "\t" << module.mtime << "\n";
+        }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        log_warn("Module manifest: cannot replace %s: %s", path.c_str(), ec.message().c_str());
+    }
+}
+
+} // namespace streamlumo
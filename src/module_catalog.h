@@ -0,0 +1,61 @@
+// streamlumo-engine/src/module_catalog.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief OBS modules found in the registered module paths, with an on-disk cache
+ * 
+ * discover() reuses the manifest written by a previous startup when it is
+ * still valid and only falls back to obs_find_modules2() (a walk of every
+ * module directory) when it is not. The manifest is valid when
+ * - its key matches (libobs version plus the engine's module search paths),
+ * - every recorded directory still has the same mtime (modules added or
+ *   removed change their parent directory), and
+ * - every module binary still has the same mtime.
+ * 
+ * Format (text, tab-separated):
+ *   streamlumo-module-manifest 1
+ *   key   <key>
+ *   dir   <path> <mtime>
+ *   module <name> <bin path> <data path> <mtime>
+ */
+class ModuleCatalog {
+public:
+    struct Module {
+        std::string name;
+        std::string binPath;
+        std::string dataPath;
+        int64_t mtime = 0;
+    };
+
+    /**
+     * @brief Populate the catalog
+     * @param manifestPath Cache file; empty disables the cache
+     * @param key Anything that must match for the cache to be reused
+     * @param extraDirs Search roots whose mtime is part of the cache key
+     */
+    void discover(const std::string& manifestPath, const std::string& key,
+                  const std::vector<std::string>& extraDirs);
+
+    const std::vector<Module>& modules() const { return m_modules; }
+    bool fromCache() const { return m_fromCache; }
+
+private:
+    bool loadManifest(const std::string& path, const std::string& key);
+    void saveManifest(const std::string& path, const std::string& key) const;
+    void scan(const std::vector<std::string>& extraDirs);
+
+    std::vector<Module> m_modules;
+    std::vector<std::pair<std::string, int64_t>> m_dirs;
+    bool m_fromCache = false;
+};
+
+} // namespace streamlumo
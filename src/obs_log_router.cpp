@@ -0,0 +1,167 @@
+// streamlumo-engine/src/obs_log_router.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "obs_log_router.h"
+#include "logging.h"
+#include "platform/platform.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace streamlumo {
+
+// Bounds the table when call sites come from generated format strings
+static constexpr size_t kMaxCallSites = 4096;
+static constexpr size_t kSampleLength = 60;
+static constexpr size_t kMaxSubsystemLength = 32;
+
+static LogLevel fromObsLevel(int lvl) {
+    if (lvl <= LOG_ERROR) {
+        return LogLevel::Error;
+    }
+    if (lvl <= LOG_WARNING) {
+        return LogLevel::Warning;
+    }
+    if (lvl <= LOG_INFO) {
+        return LogLevel::Info;
+    }
+    return LogLevel::Debug;
+}
+
+// "[browser-bridge] No source ..." -> "browser-bridge"; anything else -> "libobs"
+static std::string subsystemOf(const char* format) {
+    if (format[0] == '[') {
+        for (size_t i = 1; i <= kMaxSubsystemLength && format[i] && format[i] != '%'; ++i) {
+            if (format[i] == ']') {
+                return i > 1 ? std::string(format + 1, i - 1) : "libobs";
+            }
+        }
+    }
+    return "libobs";
+}
+
+ObsLogRouter::~ObsLogRouter() {
+    uninstall();
+}
+
+void ObsLogRouter::install(LogLevel defaultLevel, const std::map<std::string, LogLevel>& subsystemLevels,
+                           int linesPerSecond) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_defaultLevel = defaultLevel;
+    m_subsystemLevels = subsystemLevels;
+    m_floorLevel = defaultLevel;
+    for (const auto& entry : subsystemLevels) {
+        m_floorLevel = std::min(m_floorLevel, entry.second);
+    }
+    m_rate = linesPerSecond;
+    m_burst = 2.0 * linesPerSecond;
+    m_sites.clear();
+    m_overflowSite = CallSite();
+    m_overflowSite.minLevel = defaultLevel;
+    m_overflowSite.tokens = m_burst;
+    m_overflowSite.sample = "(other call sites)";
+
+    base_set_log_handler(&ObsLogRouter::handler, this);
+    m_installed = true;
+}
+
+void ObsLogRouter::uninstall() {
+    if (!m_installed) {
+        return;
+    }
+    base_set_log_handler(nullptr, nullptr);
+    m_installed = false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<const CallSite*> noisy;
+    uint64_t total = m_overflowSite.suppressedTotal;
+    if (total > 0) {
+        noisy.push_back(&m_overflowSite);
+    }
+    for (const auto& entry : m_sites) {
+        if (entry.second.suppressedTotal > 0) {
+            total += entry.second.suppressedTotal;
+            noisy.push_back(&entry.second);
+        }
+    }
+    if (total == 0) {
+        return;
+    }
+
+    std::sort(noisy.begin(), noisy.end(), [](const CallSite* a, const CallSite* b) {
+        return a->suppressedTotal > b->suppressedTotal;
+    });
+    log_info("libobs log: %llu lines suppressed by rate limiting", static_cast<unsigned long long>(total));
+    for (size_t i = 0; i < noisy.size() && i < 5; ++i) {
+        log_info("  %8llu  %s", static_cast<unsigned long long>(noisy[i]->suppressedTotal),
+                 noisy[i]->sample.c_str());
+    }
+}
+
+void ObsLogRouter::handler(int lvl, const char* msg, va_list args, void* param) {
+    static_cast<ObsLogRouter*>(param)->route(lvl, msg, args);
+}
+
+ObsLogRouter::CallSite& ObsLogRouter::callSite(const char* format) {
+    auto it = m_sites.find(format);
+    if (it != m_sites.end()) {
+        return it->second;
+    }
+    if (m_sites.size() >= kMaxCallSites) {
+        return m_overflowSite;
+    }
+
+    CallSite site;
+    auto level = m_subsystemLevels.find(subsystemOf(format));
+    site.minLevel = level != m_subsystemLevels.end() ? level->second : m_defaultLevel;
+    site.tokens = m_burst;
+    site.sample.assign(format, strnlen(format, kSampleLength));
+    return m_sites.emplace(format, std::move(site)).first->second;
+}
+
+void ObsLogRouter::route(int lvl, const char* msg, va_list args) {
+    const LogLevel level = fromObsLevel(lvl);
+    if (level < m_floorLevel || level < Logging::getLevel()) {
+        return;
+    }
+
+    uint64_t suppressed = 0;
+    std::string sample;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CallSite& site = callSite(msg);
+        if (level < site.minLevel) {
+            return;
+        }
+        if (m_rate > 0.0) {
+            const uint64_t now = platform::getTimestampNanos();
+            if (site.refillNanos != 0) {
+                site.tokens = std::min(m_burst, site.tokens + (now - site.refillNanos) * 1e-9 * m_rate);
+            }
+            site.refillNanos = now;
+            if (site.tokens < 1.0) {
+                ++site.suppressed;
+                ++site.suppressedTotal;
+                return;
+            }
+            site.tokens -= 1.0;
+        }
+        if (site.suppressed > 0) {
+            suppressed = site.suppressed;
+            sample = site.sample;
+            site.suppressed = 0;
+        }
+    }
+
+    if (suppressed > 0) {
+        Logging::log(level, "(%llu lines suppressed like: %s)", static_cast<unsigned long long>(suppressed),
+                     sample.c_str());
+    }
+    Logging::logv(level, msg, args);
+}
+
+} // namespace streamlumo
@@ -0,0 +1,73 @@
+// streamlumo-engine/src/obs_log_router.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include "config.h"
+
+#include <cstdarg>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace streamlumo {
+
+/**
+ * @brief Routes libobs/plugin blog() output into streamlumo::Logging
+ *
+ * Installed as the libobs log handler. Every blog() call site (identified by
+ * its format string) gets a token bucket, so a message logged per frame is
+ * cut down to a few lines per second instead of flooding the log; the number
+ * of suppressed lines is reported when the call site next gets through and
+ * in a summary at uninstall(). Lines are filtered by subsystem, taken from a
+ * leading "[name]" in the format string ("libobs" when there is none),
+ * before they are formatted.
+ */
+class ObsLogRouter {
+public:
+    ObsLogRouter() = default;
+    ~ObsLogRouter();
+
+    ObsLogRouter(const ObsLogRouter&) = delete;
+    ObsLogRouter& operator=(const ObsLogRouter&) = delete;
+
+    /**
+     * @param defaultLevel Level for subsystems not in subsystemLevels
+     * @param linesPerSecond Sustained rate per call site (0 = unlimited)
+     */
+    void install(LogLevel defaultLevel, const std::map<std::string, LogLevel>& subsystemLevels,
+                 int linesPerSecond);
+
+    // Restores libobs' default handler and logs the suppression summary
+    void uninstall();
+
+private:
+    struct CallSite {
+        LogLevel minLevel = LogLevel::Info;
+        double tokens = 0.0;
+        uint64_t refillNanos = 0;
+        uint64_t suppressed = 0;       // Since the last line that got through
+        uint64_t suppressedTotal = 0;
+        std::string sample;            // Copied: the module owning the format may unload
+    };
+
+    static void handler(int lvl, const char* msg, va_list args, void* param);
+    void route(int lvl, const char* msg, va_list args);
+    CallSite& callSite(const char* format);
+
+    bool m_installed = false;
+    LogLevel m_defaultLevel = LogLevel::Info;
+    LogLevel m_floorLevel = LogLevel::Info;   // Lowest level any subsystem wants
+    std::map<std::string, LogLevel> m_subsystemLevels;
+    double m_rate = 0.0;
+    double m_burst = 0.0;
+
+    std::mutex m_mutex;
+    std::unordered_map<const char*, CallSite> m_sites;
+    CallSite m_overflowSite;                  // Shared once m_sites is full
+};
+
+} // namespace streamlumo
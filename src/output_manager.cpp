@@ -0,0 +1,741 @@
+// streamlumo-engine/src/output_manager.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "output_manager.h"
+#include "flv_recorder.h"
+#include "program_feed.h"
+#include "replay_buffer.h"
+#include "logging.h"
+#include "platform/platform.h"
+
+#include <util/config-file.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+namespace streamlumo {
+
+// Tried in order after the profile's encoder when that one is not available
+static const char* kVideoEncoderFallbacks[] = {
+    "obs_x264",
+    "com.apple.videotoolbox.videoencoder.ave.avc",
+    "com.apple.videotoolbox.videoencoder.h264.gva",
+    "obs_nvenc_h264_tex",
+    "jim_nvenc",
+    "ffmpeg_nvenc",
+    "h264_texture_amf",
+    "obs_qsv11_v2",
+    "ffmpeg_vaapi_tex",
+    "ffmpeg_vaapi",
+    nullptr
+};
+
+static const char* kAudioEncoderFallbacks[] = {
+    "ffmpeg_aac",
+    "CoreAudio_AAC",
+    "libfdk_aac",
+    nullptr
+};
+
+// The video a session's frames come from; the encoder-less virtual camera
+// session takes the main canvas
+static video_t* sessionVideo(obs_encoder_t* videoEncoder) {
+    video_t* video = videoEncoder ? obs_encoder_video(videoEncoder) : nullptr;
+    return video ? video : obs_get_video();
+}
+
+static bool encoderAvailable(const std::string& id) {
+    return !id.empty() && obs_get_encoder_codec(id.c_str()) != nullptr;
+}
+
+static std::string resolveEncoderId(const std::string& wanted, const char* const* fallbacks, const char* kind) {
+    if (encoderAvailable(wanted)) {
+        return wanted;
+    }
+    for (int i = 0; fallbacks[i] != nullptr; i++) {
+        if (encoderAvailable(fallbacks[i])) {
+            if (!wanted.empty()) {
+                log_warn("Outputs: %s encoder '%s' not available, using '%s'", kind, wanted.c_str(), fallbacks[i]);
+            }
+            return fallbacks[i];
+        }
+    }
+    log_error("Outputs: no %s encoder available", kind);
+    return std::string();
+}
+
+static std::string configString(config_t* config, const char* section, const char* name) {
+    const char* value = config_get_string(config, section, name);
+    return value ? value : "";
+}
+
+OutputManager::OutputManager(config_t* profileConfig)
+    : m_profileConfig(profileConfig) {
+    applyProfileDefaults(m_profileConfig);
+    m_streamSession.owner = this;
+    m_recordSession.owner = this;
+    m_streamSession.name = "Streaming";
+    m_streamSession.started = Event::StreamingStarted;
+    m_streamSession.stopped = Event::StreamingStopped;
+    m_recordSession.name = "Recording";
+    m_recordSession.started = Event::RecordingStarted;
+    m_recordSession.stopped = Event::RecordingStopped;
+    m_replaySession.owner = this;
+    m_replaySession.name = "Replay buffer";
+    m_replaySession.started = Event::ReplayBufferStarted;
+    m_replaySession.stopped = Event::ReplayBufferStopped;
+    m_virtualCamSession.owner = this;
+    m_virtualCamSession.name = "Virtual camera";
+    m_virtualCamSession.started = Event::VirtualCamStarted;
+    m_virtualCamSession.stopped = Event::VirtualCamStopped;
+}
+
+OutputManager::~OutputManager() {
+    shutdown();
+}
+
+void OutputManager::applyProfileDefaults(config_t* config) {
+    if (!config) {
+        return;
+    }
+    config_set_default_string(config, "SimpleOutput", "StreamEncoder", "obs_x264");
+    config_set_default_int(config, "SimpleOutput", "VBitrate", 2500);
+    config_set_default_int(config, "SimpleOutput", "ABitrate", 160);
+    config_set_default_int(config, "SimpleOutput", "KeyintSec", 2);
+    config_set_default_string(config, "SimpleOutput", "Preset", "veryfast");
+    // Empty/0 = same as streaming, which lets recording share its encoder
+    config_set_default_string(config, "SimpleOutput", "RecEncoder", "");
+    config_set_default_int(config, "SimpleOutput", "RecVBitrate", 0);
+    // Canvas to encode, by name (e.g. a --canvas); empty = the main canvas
+    config_set_default_string(config, "SimpleOutput", "StreamCanvas", "");
+    config_set_default_string(config, "SimpleOutput", "RecCanvas", "");
+    config_set_default_string(config, "SimpleOutput", "FilePath",
+                              platform::joinPath(platform::getHomeDir(), "Videos").c_str());
+    config_set_default_string(config, "SimpleOutput", "RecFormat2", "flv");
+    // 0 = never split
+    config_set_default_int(config, "SimpleOutput", "RecSplitFileSizeMB", 0);
+    config_set_default_int(config, "SimpleOutput", "RecSplitFileTimeSec", 0);
+    config_set_default_bool(config, "SimpleOutput", "RecDirectIO", false);
+    config_set_default_int(config, "SimpleOutput", "RecRBTime", 20);
+    config_set_default_int(config, "SimpleOutput", "RecRBSize", 512);
+    config_set_default_string(config, "SimpleOutput", "RecRBPrefix", "Replay");
+    config_set_default_string(config, "ProgramFeed", "Name", "streamlumo_program");
+    config_set_default_string(config, "ProgramFeed", "Format", "nv12");
+    config_set_default_int(config, "ProgramFeed", "VideoSlots", 4);
+    config_set_default_bool(config, "ProgramFeed", "Audio", true);
+    config_set_default_string(config, "Stream", "Server", "");
+    config_set_default_string(config, "Stream", "Key", "");
+}
+
+OutputManager::VideoEncoderSettings OutputManager::streamVideoSettings() const {
+    VideoEncoderSettings settings;
+    settings.id = configString(m_profileConfig, "SimpleOutput", "StreamEncoder");
+    settings.bitrate = static_cast<int>(config_get_int(m_profileConfig, "SimpleOutput", "VBitrate"));
+    settings.keyintSec = static_cast<int>(config_get_int(m_profileConfig, "SimpleOutput", "KeyintSec"));
+    settings.preset = configString(m_profileConfig, "SimpleOutput", "Preset");
+    settings.canvas = configString(m_profileConfig, "SimpleOutput", "StreamCanvas");
+    return settings;
+}
+
+OutputManager::VideoEncoderSettings OutputManager::recordVideoSettings() const {
+    VideoEncoderSettings settings = streamVideoSettings();
+    settings.canvas = configString(m_profileConfig, "SimpleOutput", "RecCanvas");
+    std::string id = configString(m_profileConfig, "SimpleOutput", "RecEncoder");
+    int bitrate = static_cast<int>(config_get_int(m_profileConfig, "SimpleOutput", "RecVBitrate"));
+    if (!id.empty()) {
+        settings.id = id;
+    }
+    if (bitrate > 0) {
+        settings.bitrate = bitrate;
+    }
+    return settings;
+}
+
+void OutputManager::releaseIdleEncoders() {
+    auto prune = [](std::vector<CachedEncoder>& cache) {
+        cache.erase(std::remove_if(cache.begin(), cache.end(), [](const CachedEncoder& cached) {
+            if (obs_encoder_active(cached.encoder)) {
+                return false;
+            }
+            obs_encoder_release(cached.encoder);
+            return true;
+        }), cache.end());
+    };
+    prune(m_videoEncoders);
+    prune(m_audioEncoders);
+}
+
+obs_encoder_t* OutputManager::acquireVideoEncoder(const VideoEncoderSettings& wanted, const char* name) {
+    VideoEncoderSettings settings = wanted;
+    settings.id = resolveEncoderId(wanted.id, kVideoEncoderFallbacks, "video");
+    if (settings.id.empty()) {
+        return nullptr;
+    }
+
+    // Same id and settings as an encoder another output already uses: share
+    // it, unless it belongs to a paused recording (it would freeze us too)
+    obs_encoder_t* paused = m_recordOutput && obs_output_paused(m_recordOutput)
+        ? obs_output_get_video_encoder(m_recordOutput) : nullptr;
+    for (const CachedEncoder& cached : m_videoEncoders) {
+        if (cached.settings == settings && cached.encoder != paused) {
+            log_info("Outputs: %s shares video encoder '%s' (%s, %d kbps)",
+                     name, obs_encoder_get_name(cached.encoder), settings.id.c_str(), settings.bitrate);
+            return cached.encoder;
+        }
+    }
+
+    video_t* video = obs_get_video();
+    if (!settings.canvas.empty()) {
+        obs_canvas_t* canvas = obs_get_canvas_by_name(settings.canvas.c_str());
+        video = canvas ? obs_canvas_get_video(canvas) : nullptr;
+        obs_canvas_release(canvas);
+        if (!video) {
+            log_error("Outputs: %s canvas '%s' does not exist", name, settings.canvas.c_str());
+            return nullptr;
+        }
+    }
+
+    obs_data_t* data = obs_data_create();
+    obs_data_set_string(data, "rate_control", "CBR");
+    obs_data_set_int(data, "bitrate", settings.bitrate);
+    obs_data_set_int(data, "keyint_sec", settings.keyintSec);
+    if (!settings.preset.empty()) {
+        obs_data_set_string(data, "preset", settings.preset.c_str());
+    }
+    const std::string encoderName = std::string("streamlumo_") + name + "_video";
+    obs_encoder_t* encoder = obs_video_encoder_create(settings.id.c_str(), encoderName.c_str(), data, nullptr);
+    obs_data_release(data);
+    if (!encoder) {
+        log_error("Outputs: failed to create video encoder '%s'", settings.id.c_str());
+        return nullptr;
+    }
+    obs_encoder_set_video(encoder, video);
+    log_info("Outputs: created video encoder %s (%s, %d kbps, keyint %ds, canvas %s)",
+             encoderName.c_str(), settings.id.c_str(), settings.bitrate, settings.keyintSec,
+             settings.canvas.empty() ? "main" : settings.canvas.c_str());
+
+    CachedEncoder cached;
+    cached.settings = settings;
+    cached.encoder = encoder;
+    m_videoEncoders.push_back(cached);
+    return encoder;
+}
+
+obs_encoder_t* OutputManager::acquireAudioEncoder(int bitrate, const char* name, bool shared) {
+    for (const CachedEncoder& cached : m_audioEncoders) {
+        if (shared && cached.shared && cached.audioBitrate == bitrate) {
+            return cached.encoder;
+        }
+    }
+
+    const std::string id = resolveEncoderId("", kAudioEncoderFallbacks, "audio");
+    if (id.empty()) {
+        return nullptr;
+    }
+    obs_data_t* data = obs_data_create();
+    obs_data_set_int(data, "bitrate", bitrate);
+    const std::string encoderName = std::string("streamlumo_") + name + "_audio";
+    obs_encoder_t* encoder = obs_audio_encoder_create(id.c_str(), encoderName.c_str(), data, 0, nullptr);
+    obs_data_release(data);
+    if (!encoder) {
+        log_error("Outputs: failed to create audio encoder '%s'", id.c_str());
+        return nullptr;
+    }
+    obs_encoder_set_audio(encoder, obs_get_audio());
+
+    CachedEncoder cached;
+    cached.audioBitrate = bitrate;
+    cached.shared = shared;
+    cached.encoder = encoder;
+    m_audioEncoders.push_back(cached);
+    return encoder;
+}
+
+obs_service_t* OutputManager::profileService() {
+    if (m_service) {
+        return m_service;
+    }
+    const std::string server = configString(m_profileConfig, "Stream", "Server");
+    if (server.empty()) {
+        return nullptr;
+    }
+    obs_data_t* data = obs_data_create();
+    obs_data_set_string(data, "server", server.c_str());
+    obs_data_set_string(data, "key", configString(m_profileConfig, "Stream", "Key").c_str());
+    m_service = obs_service_create("rtmp_custom", "streamlumo_profile_service", data, nullptr);
+    obs_data_release(data);
+    return m_service;
+}
+
+void OutputManager::connectSignals(obs_output_t* output, Session* session) {
+    signal_handler_t* handler = obs_output_get_signal_handler(output);
+    signal_handler_connect(handler, "start", onOutputStart, session);
+    signal_handler_connect(handler, "stop", onOutputStop, session);
+}
+
+void OutputManager::disconnectSignals(obs_output_t* output, Session* session) {
+    signal_handler_t* handler = obs_output_get_signal_handler(output);
+    signal_handler_disconnect(handler, "start", onOutputStart, session);
+    signal_handler_disconnect(handler, "stop", onOutputStop, session);
+}
+
+// Output signal thread; must not take m_mutex (stop/force_stop may signal synchronously)
+void OutputManager::onOutputStart(void* data, calldata_t* cd) {
+    (void)cd;
+    auto* session = static_cast<Session*>(data);
+    log_info("Outputs: %s started", session->name);
+    session->owner->emit(session->started);
+}
+
+void OutputManager::onOutputStop(void* data, calldata_t* cd) {
+    auto* session = static_cast<Session*>(data);
+    const int code = static_cast<int>(calldata_int(cd, "code"));
+    session->owner->logSessionReport(*session, code);
+    session->owner->emit(session->stopped);
+}
+
+// Recorder's encoder thread, after a split
+void OutputManager::onRecordFileChanged(void* data, calldata_t* cd) {
+    auto* manager = static_cast<OutputManager*>(data);
+    const char* next = calldata_string(cd, "next_file");
+    if (next) {
+        std::lock_guard<std::mutex> lock(manager->m_pathMutex);
+        manager->m_lastRecordingPath = next;
+    }
+}
+
+// Replay buffer's save thread
+void OutputManager::onReplaySaved(void* data, calldata_t* cd) {
+    (void)cd;
+    static_cast<OutputManager*>(data)->emit(Event::ReplayBufferSaved);
+}
+
+void OutputManager::releaseRecordOutput() {
+    if (!m_recordOutput) {
+        return;
+    }
+    disconnectSignals(m_recordOutput, &m_recordSession);
+    signal_handler_disconnect(obs_output_get_signal_handler(m_recordOutput), "file_changed",
+                              onRecordFileChanged, this);
+    obs_output_release(m_recordOutput);
+    m_recordOutput = nullptr;
+}
+
+bool OutputManager::startSession(Session& session, Event starting) {
+    session.startNanos = platform::getTimestampNanos();
+    session.startCpuNanos = platform::getProcessCpuNanos();
+    session.startSkipped = video_output_get_skipped_frames(sessionVideo(session.videoEncoder));
+    session.startLagged = obs_get_lagged_frames();
+
+    emit(starting);
+    if (!obs_output_start(session.output)) {
+        const char* error = obs_output_get_last_error(session.output);
+        log_error("Outputs: %s failed to start: %s", session.name, error ? error : "unknown error");
+        emit(session.stopped);
+        return false;
+    }
+    return true;
+}
+
+bool OutputManager::startStreaming(obs_service_t* service) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_streamOutput && obs_output_active(m_streamOutput)) {
+        return true;
+    }
+
+    if (service) {
+        if (m_service != service) {
+            obs_service_release(m_service);
+            m_service = obs_service_get_ref(service);
+        }
+    } else {
+        service = profileService();
+    }
+    if (!m_service) {
+        log_error("Outputs: no streaming service configured (set one over WebSocket or [Stream] Server in the profile)");
+        return false;
+    }
+
+    const char* type = obs_service_get_preferred_output_type(m_service);
+    if (!type) {
+        type = "rtmp_output";
+    }
+    if (m_streamOutput && strcmp(obs_output_get_id(m_streamOutput), type) != 0) {
+        disconnectSignals(m_streamOutput, &m_streamSession);
+        obs_output_release(m_streamOutput);
+        m_streamOutput = nullptr;
+    }
+    if (!m_streamOutput) {
+        m_streamOutput = obs_output_create(type, "streamlumo_stream", nullptr, nullptr);
+        if (!m_streamOutput) {
+            log_error("Outputs: failed to create %s output", type);
+            return false;
+        }
+        connectSignals(m_streamOutput, &m_streamSession);
+    }
+
+    releaseIdleEncoders();
+    obs_encoder_t* video = acquireVideoEncoder(streamVideoSettings(), "stream");
+    obs_encoder_t* audio = acquireAudioEncoder(
+        static_cast<int>(config_get_int(m_profileConfig, "SimpleOutput", "ABitrate")), "stream");
+    if (!video || !audio) {
+        return false;
+    }
+    obs_output_set_video_encoder(m_streamOutput, video);
+    obs_output_set_audio_encoder(m_streamOutput, audio, 0);
+    obs_output_set_service(m_streamOutput, m_service);
+
+    m_streamSession.output = m_streamOutput;
+    m_streamSession.videoEncoder = video;
+    return startSession(m_streamSession, Event::StreamingStarting);
+}
+
+void OutputManager::stopStreaming() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_streamOutput && obs_output_active(m_streamOutput)) {
+        emit(Event::StreamingStopping);
+        obs_output_stop(m_streamOutput);
+    }
+}
+
+bool OutputManager::streamingActive() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_streamOutput && obs_output_active(m_streamOutput);
+}
+
+bool OutputManager::startRecording(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_recordOutput && obs_output_active(m_recordOutput)) {
+        return true;
+    }
+
+    std::string dir = directory.empty() ? configString(m_profileConfig, "SimpleOutput", "FilePath") : directory;
+    if (!platform::isDirectory(dir) && !platform::createDirectory(dir)) {
+        log_error("Outputs: cannot create recording directory %s", dir.c_str());
+        return false;
+    }
+    const std::string format = configString(m_profileConfig, "SimpleOutput", "RecFormat2");
+    char stamp[32];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H-%M-%S", localtime(&now));
+    const std::string path = platform::joinPath(dir, std::string(stamp) + "." + format);
+    {
+        std::lock_guard<std::mutex> pathLock(m_pathMutex);
+        m_lastRecordingPath = path;
+    }
+
+    const char* type = format == "flv" ? kFlvRecorderOutputId : "ffmpeg_muxer";
+    if (m_recordOutput && strcmp(obs_output_get_id(m_recordOutput), type) != 0) {
+        releaseRecordOutput();
+    }
+    if (!m_recordOutput) {
+        m_recordOutput = obs_output_create(type, "streamlumo_record", nullptr, nullptr);
+        if (!m_recordOutput) {
+            log_error("Outputs: failed to create %s output", type);
+            return false;
+        }
+        connectSignals(m_recordOutput, &m_recordSession);
+        signal_handler_connect(obs_output_get_signal_handler(m_recordOutput), "file_changed",
+                               onRecordFileChanged, this);
+    }
+    obs_data_t* settings = obs_data_create();
+    obs_data_set_string(settings, "path", path.c_str());
+    obs_data_set_int(settings, "max_size_mb", config_get_int(m_profileConfig, "SimpleOutput", "RecSplitFileSizeMB"));
+    obs_data_set_int(settings, "max_time_sec", config_get_int(m_profileConfig, "SimpleOutput", "RecSplitFileTimeSec"));
+    obs_data_set_bool(settings, "direct_io", config_get_bool(m_profileConfig, "SimpleOutput", "RecDirectIO"));
+    obs_output_update(m_recordOutput, settings);
+    obs_data_release(settings);
+
+    releaseIdleEncoders();
+    obs_encoder_t* video = acquireVideoEncoder(recordVideoSettings(), "record");
+    // Audio encoding is cheap: recording always gets its own, so a shared
+    // video encoder is the only thing that can stand in the way of pausing
+    obs_encoder_t* audio = acquireAudioEncoder(
+        static_cast<int>(config_get_int(m_profileConfig, "SimpleOutput", "ABitrate")), "record", false);
+    if (!video || !audio) {
+        return false;
+    }
+    obs_output_set_video_encoder(m_recordOutput, video);
+    obs_output_set_audio_encoder(m_recordOutput, audio, 0);
+
+    m_recordSession.output = m_recordOutput;
+    m_recordSession.videoEncoder = video;
+    log_info("Outputs: recording to %s", path.c_str());
+    return startSession(m_recordSession, Event::RecordingStarting);
+}
+
+void OutputManager::stopRecording() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_recordOutput && obs_output_active(m_recordOutput)) {
+        emit(Event::RecordingStopping);
+        obs_output_stop(m_recordOutput);
+    }
+}
+
+bool OutputManager::recordingActive() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recordOutput && obs_output_active(m_recordOutput);
+}
+
+bool OutputManager::pauseRecording(bool pause) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recordOutput || !obs_output_active(m_recordOutput) || obs_output_paused(m_recordOutput) == pause) {
+        return false;
+    }
+    if (pause && recordEncoderShared()) {
+        log_warn("Outputs: cannot pause recording while it shares its video encoder with another output; "
+                 "set [SimpleOutput] RecEncoder or RecVBitrate to give it its own");
+        return false;
+    }
+    if (!obs_output_pause(m_recordOutput, pause)) {
+        log_warn("Outputs: failed to %s recording", pause ? "pause" : "unpause");
+        return false;
+    }
+    emit(pause ? Event::RecordingPaused : Event::RecordingUnpaused);
+    return true;
+}
+
+// Caller holds m_mutex
+bool OutputManager::recordEncoderShared() const {
+    for (obs_output_t* other : {m_streamOutput, m_replayOutput}) {
+        if (!other || !obs_output_active(other)) {
+            continue;
+        }
+        if (obs_output_get_video_encoder(other) == obs_output_get_video_encoder(m_recordOutput)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OutputManager::recordingPaused() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recordOutput && obs_output_paused(m_recordOutput);
+}
+
+bool OutputManager::splitRecording() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recordOutput || !obs_output_active(m_recordOutput)) {
+        return false;
+    }
+    uint8_t stack[128];
+    calldata_t cd;
+    calldata_init_fixed(&cd, stack, sizeof(stack));
+    proc_handler_call(obs_output_get_proc_handler(m_recordOutput), "split_file", &cd);
+    return calldata_bool(&cd, "split_file_enabled");
+}
+
+bool OutputManager::addRecordingChapter(const char* name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recordOutput || !obs_output_active(m_recordOutput)) {
+        return false;
+    }
+    uint8_t stack[256];
+    calldata_t cd;
+    calldata_init_fixed(&cd, stack, sizeof(stack));
+    calldata_set_string(&cd, "chapter_name", name ? name : "");
+    if (!proc_handler_call(obs_output_get_proc_handler(m_recordOutput), "add_chapter", &cd)) {
+        log_warn("Outputs: %s does not support chapters", obs_output_get_id(m_recordOutput));
+        return false;
+    }
+    return calldata_bool(&cd, "success");
+}
+
+bool OutputManager::startReplayBuffer() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_replayOutput && obs_output_active(m_replayOutput)) {
+        return true;
+    }
+
+    const std::string dir = configString(m_profileConfig, "SimpleOutput", "FilePath");
+    if (!platform::isDirectory(dir) && !platform::createDirectory(dir)) {
+        log_error("Outputs: cannot create recording directory %s", dir.c_str());
+        return false;
+    }
+    if (!m_replayOutput) {
+        m_replayOutput = obs_output_create(kReplayBufferOutputId, "streamlumo_replay_buffer", nullptr, nullptr);
+        if (!m_replayOutput) {
+            log_error("Outputs: failed to create %s output", kReplayBufferOutputId);
+            return false;
+        }
+        connectSignals(m_replayOutput, &m_replaySession);
+        signal_handler_connect(obs_output_get_signal_handler(m_replayOutput), "saved", onReplaySaved, this);
+    }
+    obs_data_t* settings = obs_data_create();
+    obs_data_set_string(settings, "directory", dir.c_str());
+    obs_data_set_string(settings, "prefix", configString(m_profileConfig, "SimpleOutput", "RecRBPrefix").c_str());
+    obs_data_set_int(settings, "max_time_sec", config_get_int(m_profileConfig, "SimpleOutput", "RecRBTime"));
+    obs_data_set_int(settings, "max_size_mb", config_get_int(m_profileConfig, "SimpleOutput", "RecRBSize"));
+    obs_output_update(m_replayOutput, settings);
+    obs_data_release(settings);
+
+    releaseIdleEncoders();
+    // Recording settings, so a running recording's video encoder is reused.
+    // The replay buffer is never paused and shares audio with the stream;
+    // the recording's audio encoder is private to it
+    obs_encoder_t* video = acquireVideoEncoder(recordVideoSettings(), "replay");
+    obs_encoder_t* audio = acquireAudioEncoder(
+        static_cast<int>(config_get_int(m_profileConfig, "SimpleOutput", "ABitrate")), "replay");
+    if (!video || !audio) {
+        return false;
+    }
+    obs_output_set_video_encoder(m_replayOutput, video);
+    obs_output_set_audio_encoder(m_replayOutput, audio, 0);
+
+    m_replaySession.output = m_replayOutput;
+    m_replaySession.videoEncoder = video;
+    return startSession(m_replaySession, Event::ReplayBufferStarting);
+}
+
+void OutputManager::stopReplayBuffer() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_replayOutput && obs_output_active(m_replayOutput)) {
+        emit(Event::ReplayBufferStopping);
+        obs_output_stop(m_replayOutput);
+    }
+}
+
+bool OutputManager::replayBufferActive() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_replayOutput && obs_output_active(m_replayOutput);
+}
+
+bool OutputManager::saveReplayBuffer() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_replayOutput || !obs_output_active(m_replayOutput)) {
+        return false;
+    }
+    uint8_t stack[64];
+    calldata_t cd;
+    calldata_init_fixed(&cd, stack, sizeof(stack));
+    return proc_handler_call(obs_output_get_proc_handler(m_replayOutput), "save", &cd);
+}
+
+std::string OutputManager::lastReplayPath() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_replayOutput) {
+        return std::string();
+    }
+    uint8_t stack[512];
+    calldata_t cd;
+    calldata_init_fixed(&cd, stack, sizeof(stack));
+    proc_handler_call(obs_output_get_proc_handler(m_replayOutput), "get_last_replay", &cd);
+    const char* path = calldata_string(&cd, "path");
+    return path ? path : "";
+}
+
+bool OutputManager::startVirtualCam() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_virtualCamOutput && obs_output_active(m_virtualCamOutput)) {
+        return true;
+    }
+    if (!m_virtualCamOutput) {
+        m_virtualCamOutput = obs_output_create(kProgramFeedOutputId, "streamlumo_virtualcam", nullptr, nullptr);
+        if (!m_virtualCamOutput) {
+            log_error("Outputs: failed to create %s output", kProgramFeedOutputId);
+            return false;
+        }
+        connectSignals(m_virtualCamOutput, &m_virtualCamSession);
+    }
+    obs_data_t* settings = obs_data_create();
+    obs_data_set_string(settings, "name", configString(m_profileConfig, "ProgramFeed", "Name").c_str());
+    obs_data_set_string(settings, "format", configString(m_profileConfig, "ProgramFeed", "Format").c_str());
+    obs_data_set_int(settings, "video_slots", config_get_int(m_profileConfig, "ProgramFeed", "VideoSlots"));
+    obs_data_set_bool(settings, "audio", config_get_bool(m_profileConfig, "ProgramFeed", "Audio"));
+    obs_output_update(m_virtualCamOutput, settings);
+    obs_data_release(settings);
+
+    m_virtualCamSession.output = m_virtualCamOutput;
+    return startSession(m_virtualCamSession, Event::VirtualCamStarting);
+}
+
+void OutputManager::stopVirtualCam() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_virtualCamOutput && obs_output_active(m_virtualCamOutput)) {
+        obs_output_stop(m_virtualCamOutput);
+    }
+}
+
+bool OutputManager::virtualCamActive() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_virtualCamOutput && obs_output_active(m_virtualCamOutput);
+}
+
+std::string OutputManager::lastRecordingPath() const {
+    std::lock_guard<std::mutex> lock(m_pathMutex);
+    return m_lastRecordingPath;
+}
+
+void OutputManager::logSessionReport(const Session& session, int code) const {
+    const double seconds = (platform::getTimestampNanos() - session.startNanos) / 1e9;
+    const double cpuSeconds = (platform::getProcessCpuNanos() - session.startCpuNanos) / 1e9;
+    const int total = obs_output_get_total_frames(session.output);
+    const int dropped = obs_output_get_frames_dropped(session.output);
+    const uint64_t bytes = obs_output_get_total_bytes(session.output);
+    const uint32_t skipped = video_output_get_skipped_frames(sessionVideo(session.videoEncoder)) - session.startSkipped;
+    const uint32_t lagged = obs_get_lagged_frames() - session.startLagged;
+
+    if (code != OBS_OUTPUT_SUCCESS) {
+        const char* error = obs_output_get_last_error(session.output);
+        log_error("Outputs: %s stopped with code %d: %s", session.name, code, error ? error : "unknown error");
+    }
+    int users = 0;
+    for (const Session* other : {&m_streamSession, &m_recordSession, &m_replaySession}) {
+        if (other->videoEncoder == session.videoEncoder) {
+            users++;
+        }
+    }
+    const bool shared = session.videoEncoder && users > 1;
+    log_info("Outputs: %s ran %.1f s, %d frames, %d dropped (%.2f%%), %.1f MB, %.0f kbps avg",
+             session.name, seconds, total, dropped, total > 0 ? 100.0 * dropped / total : 0.0,
+             bytes / 1048576.0, seconds > 0 ? bytes * 8 / 1000.0 / seconds : 0.0);
+    log_info("Outputs: %s encoder %s%s: %u frames skipped (encoder behind), %u lagged (render behind), "
+             "process CPU %.1f s (%.0f%% of one core)",
+             session.name, session.videoEncoder ? obs_encoder_get_name(session.videoEncoder) : "none (raw)",
+             shared ? " (shared)" : "", skipped, lagged, cpuSeconds,
+             seconds > 0 ? 100.0 * cpuSeconds / seconds : 0.0);
+}
+
+void OutputManager::emit(Event event) const {
+    if (m_eventCallback) {
+        m_eventCallback(event);
+    }
+}
+
+void OutputManager::shutdown() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (obs_output_t* output : {m_streamOutput, m_recordOutput, m_replayOutput, m_virtualCamOutput}) {
+        if (output && obs_output_active(output)) {
+            obs_output_force_stop(output);
+        }
+    }
+    if (m_streamOutput) {
+        disconnectSignals(m_streamOutput, &m_streamSession);
+        obs_output_release(m_streamOutput);
+        m_streamOutput = nullptr;
+    }
+    releaseRecordOutput();
+    if (m_replayOutput) {
+        disconnectSignals(m_replayOutput, &m_replaySession);
+        signal_handler_disconnect(obs_output_get_signal_handler(m_replayOutput), "saved", onReplaySaved, this);
+        obs_output_release(m_replayOutput);
+        m_replayOutput = nullptr;
+    }
+    if (m_virtualCamOutput) {
+        disconnectSignals(m_virtualCamOutput, &m_virtualCamSession);
+        obs_output_release(m_virtualCamOutput);
+        m_virtualCamOutput = nullptr;
+    }
+    for (auto* cache : {&m_videoEncoders, &m_audioEncoders}) {
+        for (const CachedEncoder& cached : *cache) {
+            obs_encoder_release(cached.encoder);
+        }
+        cache->clear();
+    }
+    obs_service_release(m_service);
+    m_service = nullptr;
+}
+
+} // namespace streamlumo
@@ -0,0 +1,212 @@
+// streamlumo-engine/src/output_manager.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <obs.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct config_data;
+typedef struct config_data config_t;
+
+namespace streamlumo {
+
+/**
+ * @brief Streaming and recording outputs behind the headless frontend API
+ *
+ * Builds the service -> output -> encoder chain from the profile config
+ * ([SimpleOutput] and [Stream] sections, see applyProfileDefaults()).
+ * Encoders are shared: when recording asks for the same encoder id and
+ * settings as streaming, both outputs are fed by one encoder instance, so
+ * each frame is encoded once and muxed twice.
+ *
+ * Recordings in the default "flv" format use the engine's own FLV recorder
+ * (see flv_recorder.h), which writes from a background thread and supports
+ * chapters; other formats go through ffmpeg_muxer. Both split files by
+ * [SimpleOutput] RecSplitFileSizeMB / RecSplitFileTimeSec.
+ *
+ * The replay buffer (replay_buffer.h) keeps recent packets in memory. It
+ * shares the recording's video encoder and the stream's audio encoder. The virtual camera is the program feed
+ * (program_feed.h): raw frames in shared memory, no encoder.
+ *
+ * Start/stop completion is reported asynchronously through the event
+ * callback from the output's signal thread. On stop a session summary
+ * (frames, drops, encoder skips/lag, process CPU time) is logged.
+ */
+class OutputManager {
+public:
+    enum class Event {
+        StreamingStarting,
+        StreamingStarted,
+        StreamingStopping,
+        StreamingStopped,
+        RecordingStarting,
+        RecordingStarted,
+        RecordingStopping,
+        RecordingStopped,
+        RecordingPaused,
+        RecordingUnpaused,
+        ReplayBufferStarting,
+        ReplayBufferStarted,
+        ReplayBufferStopping,
+        ReplayBufferStopped,
+        ReplayBufferSaved,
+        VirtualCamStarting,
+        VirtualCamStarted,
+        VirtualCamStopped,
+    };
+    using EventCallback = std::function<void(Event)>;
+
+    explicit OutputManager(config_t* profileConfig);
+    ~OutputManager();
+
+    OutputManager(const OutputManager&) = delete;
+    OutputManager& operator=(const OutputManager&) = delete;
+
+    void setEventCallback(EventCallback callback) { m_eventCallback = std::move(callback); }
+
+    // Profile defaults for every key the manager reads
+    static void applyProfileDefaults(config_t* profileConfig);
+
+    /**
+     * @brief Start streaming to service (nullptr = [Stream] Server/Key from the profile)
+     * @return false if the chain could not be built or the output refused to start
+     */
+    bool startStreaming(obs_service_t* service);
+    void stopStreaming();
+    bool streamingActive() const;
+
+    /**
+     * @brief Start recording into directory (empty = [SimpleOutput] FilePath)
+     */
+    bool startRecording(const std::string& directory);
+    void stopRecording();
+    bool recordingActive() const;
+    // Pausing is refused (false) while the recording shares its video encoder
+    // with the stream or the replay buffer: libobs pauses the encoder itself
+    bool pauseRecording(bool pause);
+    bool recordingPaused() const;
+
+    // Start a new file at the next keyframe; false if the output can't split
+    bool splitRecording();
+
+    // Mark a chapter at the current position; only the FLV recorder supports it
+    bool addRecordingChapter(const char* name);
+
+    // Current file; follows splits
+    std::string lastRecordingPath() const;
+
+    /**
+     * @brief Start the in-memory replay buffer ([SimpleOutput] RecRBTime / RecRBSize)
+     */
+    bool startReplayBuffer();
+    void stopReplayBuffer();
+    bool replayBufferActive() const;
+
+    // Writes the buffer to disk in the background; ReplayBufferSaved follows
+    bool saveReplayBuffer();
+    std::string lastReplayPath() const;
+
+    /**
+     * @brief Publish the program feed to shared memory ([ProgramFeed] section)
+     */
+    bool startVirtualCam();
+    void stopVirtualCam();
+    bool virtualCamActive() const;
+
+    // Borrowed; nullptr until the output was first created
+    obs_output_t* streamingOutput() const { return m_streamOutput; }
+    obs_output_t* recordingOutput() const { return m_recordOutput; }
+    obs_output_t* replayBufferOutput() const { return m_replayOutput; }
+    obs_output_t* virtualCamOutput() const { return m_virtualCamOutput; }
+
+    // Force-stop outputs and release every encoder; call before obs_shutdown()
+    void shutdown();
+
+private:
+    struct VideoEncoderSettings {
+        std::string id;
+        int bitrate = 0;
+        int keyintSec = 0;
+        std::string preset;
+        std::string canvas;             // Empty = the main canvas
+
+        bool operator==(const VideoEncoderSettings& other) const {
+            return id == other.id && bitrate == other.bitrate &&
+                   keyintSec == other.keyintSec && preset == other.preset && canvas == other.canvas;
+        }
+    };
+
+    struct CachedEncoder {
+        VideoEncoderSettings settings;   // Video encoders only
+        int audioBitrate = 0;            // Audio encoders only
+        bool shared = true;              // Audio encoders only
+        obs_encoder_t* encoder = nullptr;
+    };
+
+    // Per-output accounting for the stop summary
+    struct Session {
+        OutputManager* owner = nullptr;
+        const char* name = "";
+        obs_output_t* output = nullptr;
+        obs_encoder_t* videoEncoder = nullptr;
+        uint64_t startNanos = 0;
+        uint64_t startCpuNanos = 0;
+        uint32_t startSkipped = 0;
+        uint32_t startLagged = 0;
+        Event started = Event::StreamingStarted;
+        Event stopped = Event::StreamingStopped;
+    };
+
+    VideoEncoderSettings streamVideoSettings() const;
+    VideoEncoderSettings recordVideoSettings() const;
+    obs_encoder_t* acquireVideoEncoder(const VideoEncoderSettings& settings, const char* name);
+    // shared = false: a private encoder, so pausing its output leaves the others running
+    obs_encoder_t* acquireAudioEncoder(int bitrate, const char* name, bool shared = true);
+    void releaseIdleEncoders();
+    bool recordEncoderShared() const;
+    obs_service_t* profileService();
+
+    bool startSession(Session& session, Event starting);
+    static void onOutputStart(void* data, calldata_t* cd);
+    static void onOutputStop(void* data, calldata_t* cd);
+    static void onRecordFileChanged(void* data, calldata_t* cd);
+    static void onReplaySaved(void* data, calldata_t* cd);
+    void releaseRecordOutput();
+    void connectSignals(obs_output_t* output, Session* session);
+    void disconnectSignals(obs_output_t* output, Session* session);
+    void logSessionReport(const Session& session, int code) const;
+    void emit(Event event) const;
+
+    config_t* m_profileConfig = nullptr;
+    EventCallback m_eventCallback;
+
+    mutable std::mutex m_mutex;
+    std::vector<CachedEncoder> m_videoEncoders;
+    std::vector<CachedEncoder> m_audioEncoders;
+
+    obs_output_t* m_streamOutput = nullptr;
+    obs_service_t* m_service = nullptr;
+    Session m_streamSession;
+
+    obs_output_t* m_recordOutput = nullptr;
+    Session m_recordSession;
+
+    obs_output_t* m_replayOutput = nullptr;
+    Session m_replaySession;
+
+    obs_output_t* m_virtualCamOutput = nullptr;
+    Session m_virtualCamSession;
+
+    // Separate from m_mutex: updated from the recorder's encoder thread on split
+    mutable std::mutex m_pathMutex;
+    std::string m_lastRecordingPath;
+};
+
+} // namespace streamlumo
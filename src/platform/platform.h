@@ -113,6 +113,16 @@ std::string getOSVersion();
 std::string getCPUName();
 uint64_t getTotalMemoryBytes();
 uint64_t getAvailableMemoryBytes();
+
+/**
+ * @brief Resident set size of this process in bytes (0 if unknown)
+ */
+uint64_t getProcessResidentBytes();
+
+/**
+ * @brief User + system CPU time consumed by this process, in nanoseconds
+ */
+uint64_t getProcessCpuNanos();
 int getCPUCoreCount();
 int getCPUThreadCount();
 
@@ -306,6 +316,15 @@ bool isProcessRunning(uint32_t pid);
  */
 bool terminateProcess(uint32_t pid);
 
+/**
+ * @brief Count established TCP connections on a local port
+ * 
+ * Used to tell whether any control client is connected to a server running
+ * in this process (e.g. the WebSocket server owned by a plugin).
+ * @return Connection count, or -1 if it cannot be determined
+ */
+int countTcpConnections(uint16_t localPort);
+
 // =============================================================================
 // Threading Utilities
 // =============================================================================
@@ -365,6 +384,98 @@ bool lockMemory(void* ptr, size_t size);
  */
 bool unlockMemory(void* ptr, size_t size);
 
+// =============================================================================
+// Raw File Output
+// =============================================================================
+
+/**
+ * @brief OS file handle for large sequential writes that bypass stdio
+ */
+using FileHandle = intptr_t;
+constexpr FileHandle kInvalidFile = -1;
+
+/**
+ * @brief Create or truncate a file for writing
+ * @param directIO Bypass the page cache (O_DIRECT on Linux, F_NOCACHE on
+ *        macOS, ignored on Windows). With O_DIRECT every write must come from
+ *        a buffer aligned to, and sized in multiples of, getDirectIOAlignment()
+ * @return kInvalidFile on failure
+ */
+FileHandle openFileForWrite(const std::string& path, bool directIO);
+
+/**
+ * @brief Write all of data at the current position
+ */
+bool writeFile(FileHandle file, const void* data, size_t size);
+
+/**
+ * @brief Write all of data at offset without moving the current position
+ */
+bool writeFileAt(FileHandle file, uint64_t offset, const void* data, size_t size);
+
+/**
+ * @brief Turn page-cache bypass on or off for an open file
+ *
+ * Used to write the unaligned tail of a direct-I/O file.
+ */
+bool setFileDirectIO(FileHandle file, bool enable);
+
+void closeFile(FileHandle file);
+
+/**
+ * @brief Buffer/size/offset alignment direct-I/O writes must respect
+ */
+size_t getDirectIOAlignment();
+
+// =============================================================================
+// Shared Memory
+// =============================================================================
+
+/**
+ * @brief A named memory region other local processes can map
+ */
+struct SharedMemory {
+    void* data = nullptr;
+    size_t size = 0;
+    intptr_t handle = -1;    // fd on POSIX, HANDLE on Windows
+    std::string name;
+};
+
+/**
+ * @brief Create and map a new zero-filled region, accessible to this user only
+ *
+ * Fails if the name already exists; an existing region is never replaced.
+ * @param name Without leading slash; "/name" for shm_open on POSIX,
+ *        Local\name on Windows
+ */
+bool createSharedMemory(const std::string& name, size_t size, SharedMemory& region);
+
+/**
+ * @brief Map an existing region read-only, e.g. to check who left it behind
+ *
+ * The name stays when the mapping is released with destroySharedMemory().
+ */
+bool openSharedMemoryReadOnly(const std::string& name, SharedMemory& region);
+
+/**
+ * @brief Remove a region's name (POSIX); processes that have it mapped keep it
+ */
+void removeSharedMemory(const std::string& name);
+
+/**
+ * @brief Unmap the region and remove its name
+ *
+ * Processes that still have it mapped keep their mapping.
+ */
+void destroySharedMemory(SharedMemory& region);
+
+/**
+ * @brief Wake every process blocked on a 32-bit word inside shared memory
+ *
+ * FUTEX_WAKE (process-shared) on Linux. A no-op elsewhere; readers there poll.
+ */
+void wakeSharedAddress(void* word);
+
 // =============================================================================
 // High-Resolution Timing
 // =============================================================================
@@ -396,6 +507,17 @@ void sleepMicros(uint32_t micros);
  */
 void preciseSleep(uint64_t nanos);
 
+/**
+ * @brief Sleep until an absolute deadline on the getTimestampNanos() clock
+ * 
+ * Deadline-based loops should use this rather than preciseSleep(now - x):
+ * the wake-up is anchored to the deadline, so time spent between reading
+ * the clock and going to sleep does not accumulate as drift.
+ * Linux uses clock_nanosleep(TIMER_ABSTIME), macOS mach_wait_until().
+ * Returns immediately if the deadline has passed.
+ */
+void sleepUntilNanos(uint64_t deadlineNanos);
+
 // =============================================================================
 // Console Utilities
 // =============================================================================
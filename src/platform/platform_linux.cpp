@@ -9,6 +9,7 @@
 #include "platform.h"
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <dlfcn.h>
 #include <dirent.h>
 #include <signal.h>
@@ -21,12 +22,17 @@
 #include <sys/sysinfo.h>
 #include <sys/wait.h>
 #include <sys/prctl.h>
+#include <sys/resource.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
 #include <sys/utsname.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include <linux/limits.h>
 #include <termios.h>
 
+#include <cerrno>
+#include <climits>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
@@ -127,6 +133,27 @@ uint64_t getAvailableMemoryBytes() {
     return 0;
 }
 
+uint64_t getProcessResidentBytes() {
+    // statm: size resident shared text lib data dt (in pages)
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    if (statm >> size >> resident) {
+        return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+}
+
+uint64_t getProcessCpuNanos() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    auto toNanos = [](const struct timeval& tv) {
+        return static_cast<uint64_t>(tv.tv_sec) * 1000000000ULL + static_cast<uint64_t>(tv.tv_usec) * 1000ULL;
+    };
+    return toNanos(usage.ru_utime) + toNanos(usage.ru_stime);
+}
+
 int getCPUCoreCount() {
     // Get physical core count from /proc/cpuinfo
     std::ifstream cpuinfo("/proc/cpuinfo");
@@ -370,9 +397,19 @@ uint32_t startProcess(const std::string& command) {
     posix_spawn_file_actions_t actions;
     posix_spawn_file_actions_init(&actions);
     
-    int result = posix_spawn(&pid, "/bin/sh", &actions, nullptr, 
+    // The engine blocks its termination signals (EventLoop::captureSignals);
+    // the child must not inherit that mask or it would ignore SIGTERM
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    
+    int result = posix_spawn(&pid, "/bin/sh", &actions, &attr, 
                               const_cast<char**>(argv), environ);
     
+    posix_spawnattr_destroy(&attr);
     posix_spawn_file_actions_destroy(&actions);
     
     if (result != 0) {
@@ -390,6 +427,39 @@ bool terminateProcess(uint32_t pid) {
     return kill(static_cast<pid_t>(pid), SIGTERM) == 0;
 }
 
+int countTcpConnections(uint16_t localPort) {
+    // "  sl  local_address rem_address   st ..." with hex ADDR:PORT and state
+    // 01 = TCP_ESTABLISHED
+    int count = 0;
+    bool anyTable = false;
+    for (const char* table : {"/proc/net/tcp", "/proc/net/tcp6"}) {
+        std::ifstream file(table);
+        if (!file) {
+            continue;
+        }
+        anyTable = true;
+        
+        std::string line;
+        std::getline(file, line);  // Header
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string slot, local, remote, state;
+            if (!(fields >> slot >> local >> remote >> state)) {
+                continue;
+            }
+            size_t colon = local.rfind(':');
+            if (colon == std::string::npos || state != "01") {
+                continue;
+            }
+            unsigned long port = std::strtoul(local.c_str() + colon + 1, nullptr, 16);
+            if (port == localPort) {
+                ++count;
+            }
+        }
+    }
+    return anyTable ? count : -1;
+}
+
 // =============================================================================
 // Threading Utilities
 // =============================================================================
@@ -472,6 +542,142 @@ bool unlockMemory(void* ptr, size_t size) {
     return munlock(ptr, size) == 0;
 }
 
+// =============================================================================
+// Raw File Output
+// =============================================================================
+
+FileHandle openFileForWrite(const std::string& path, bool directIO) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (directIO) {
+        flags |= O_DIRECT;
+    }
+    int fd = open(path.c_str(), flags, 0644);
+    if (fd < 0 && directIO && errno == EINVAL) {
+        // tmpfs and some network filesystems refuse O_DIRECT
+        fd = open(path.c_str(), flags & ~O_DIRECT, 0644);
+    }
+    return fd < 0 ? kInvalidFile : static_cast<FileHandle>(fd);
+}
+
+bool writeFile(FileHandle file, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = write(static_cast<int>(file), bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool writeFileAt(FileHandle file, uint64_t offset, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(static_cast<int>(file), bytes, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        offset += static_cast<uint64_t>(written);
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool setFileDirectIO(FileHandle file, bool enable) {
+    int flags = fcntl(static_cast<int>(file), F_GETFL);
+    if (flags < 0) {
+        return false;
+    }
+    flags = enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+    return fcntl(static_cast<int>(file), F_SETFL, flags) == 0;
+}
+
+void closeFile(FileHandle file) {
+    if (file != kInvalidFile) {
+        close(static_cast<int>(file));
+    }
+}
+
+size_t getDirectIOAlignment() {
+    return 4096;
+}
+
+// =============================================================================
+// Shared Memory
+// =============================================================================
+
+bool createSharedMemory(const std::string& name, size_t size, SharedMemory& region) {
+    const std::string shmName = "/" + name;
+    int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+    region.data = data;
+    region.size = size;
+    region.handle = fd;
+    region.name = shmName;
+    return true;
+}
+
+bool openSharedMemoryReadOnly(const std::string& name, SharedMemory& region) {
+    const std::string shmName = "/" + name;
+    int fd = shm_open(shmName.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // No handle: destroySharedMemory() then only unmaps
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    region.data = data;
+    region.size = static_cast<size_t>(st.st_size);
+    region.handle = -1;
+    region.name = shmName;
+    return true;
+}
+
+void removeSharedMemory(const std::string& name) {
+    shm_unlink(("/" + name).c_str());
+}
+
+void destroySharedMemory(SharedMemory& region) {
+    if (region.data) {
+        munmap(region.data, region.size);
+    }
+    if (region.handle >= 0) {
+        close(static_cast<int>(region.handle));
+        shm_unlink(region.name.c_str());
+    }
+    region = SharedMemory();
+}
+
+void wakeSharedAddress(void* word) {
+    // No FUTEX_PRIVATE_FLAG: waiters live in other processes
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
 // =============================================================================
 // High-Resolution Timing
 // =============================================================================
@@ -482,6 +688,15 @@ uint64_t getTimestampNanos() {
     return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
 }
 
+void sleepUntilNanos(uint64_t deadlineNanos) {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNanos / 1000000000ULL);
+    ts.tv_nsec = static_cast<long>(deadlineNanos % 1000000000ULL);
+    // Same CLOCK_MONOTONIC as getTimestampNanos(); restart after signals
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
 // =============================================================================
 // Console Utilities
 // =============================================================================
@@ -16,16 +16,21 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/ioctl.h>
 #include <termios.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <dlfcn.h>
 #include <dirent.h>
 #include <signal.h>
 #include <fnmatch.h>
 #include <spawn.h>
 #include <sys/wait.h>
+#include <libproc.h>
+#include <arpa/inet.h>
 
+#include <cerrno>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
@@ -98,6 +103,27 @@ uint64_t getAvailableMemoryBytes() {
     return 0;
 }
 
+uint64_t getProcessResidentBytes() {
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+uint64_t getProcessCpuNanos() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    auto toNanos = [](const struct timeval& tv) {
+        return static_cast<uint64_t>(tv.tv_sec) * 1000000000ULL + static_cast<uint64_t>(tv.tv_usec) * 1000ULL;
+    };
+    return toNanos(usage.ru_utime) + toNanos(usage.ru_stime);
+}
+
 int getCPUCoreCount() {
     int cores = 0;
     size_t size = sizeof(cores);
@@ -320,9 +346,19 @@ uint32_t startProcess(const std::string& command) {
     posix_spawn_file_actions_t actions;
     posix_spawn_file_actions_init(&actions);
     
-    int result = posix_spawn(&pid, "/bin/sh", &actions, nullptr, 
+    // The engine blocks its termination signals (EventLoop::captureSignals);
+    // the child must not inherit that mask or it would ignore SIGTERM
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    
+    int result = posix_spawn(&pid, "/bin/sh", &actions, &attr, 
                               const_cast<char**>(argv), environ);
     
+    posix_spawnattr_destroy(&attr);
     posix_spawn_file_actions_destroy(&actions);
     
     if (result != 0) {
@@ -340,6 +376,43 @@ bool terminateProcess(uint32_t pid) {
     return kill(static_cast<pid_t>(pid), SIGTERM) == 0;
 }
 
+int countTcpConnections(uint16_t localPort) {
+    // Walk our own socket descriptors; the server lives in this process
+    pid_t pid = getpid();
+    int bytes = proc_pidinfo(pid, PROC_PIDLISTFDS, 0, nullptr, 0);
+    if (bytes <= 0) {
+        return -1;
+    }
+    std::vector<proc_fdinfo> fds(static_cast<size_t>(bytes) / sizeof(proc_fdinfo));
+    bytes = proc_pidinfo(pid, PROC_PIDLISTFDS, 0, fds.data(),
+                         static_cast<int>(fds.size() * sizeof(proc_fdinfo)));
+    if (bytes <= 0) {
+        return -1;
+    }
+    fds.resize(static_cast<size_t>(bytes) / sizeof(proc_fdinfo));
+    
+    int count = 0;
+    for (const proc_fdinfo& fd : fds) {
+        if (fd.proc_fdtype != PROX_FDTYPE_SOCKET) {
+            continue;
+        }
+        socket_fdinfo info;
+        if (proc_pidfdinfo(pid, fd.proc_fd, PROC_PIDFDSOCKETINFO, &info, sizeof(info)) !=
+            static_cast<int>(sizeof(info))) {
+            continue;
+        }
+        if (info.psi.soi_kind != SOCKINFO_TCP) {
+            continue;
+        }
+        const tcp_sockinfo& tcp = info.psi.soi_proto.pri_tcp;
+        if (tcp.tcpsi_state == TSI_S_ESTABLISHED &&
+            ntohs(static_cast<uint16_t>(tcp.tcpsi_ini.insi_lport)) == localPort) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 // =============================================================================
 // Threading Utilities
 // =============================================================================
@@ -419,6 +492,135 @@ bool unlockMemory(void* ptr, size_t size) {
     return munlock(ptr, size) == 0;
 }
 
+// =============================================================================
+// Raw File Output
+// =============================================================================
+
+FileHandle openFileForWrite(const std::string& path, bool directIO) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return kInvalidFile;
+    }
+    if (directIO) {
+        fcntl(fd, F_NOCACHE, 1);
+    }
+    return static_cast<FileHandle>(fd);
+}
+
+bool writeFile(FileHandle file, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = write(static_cast<int>(file), bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool writeFileAt(FileHandle file, uint64_t offset, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(static_cast<int>(file), bytes, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        offset += static_cast<uint64_t>(written);
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool setFileDirectIO(FileHandle file, bool enable) {
+    return fcntl(static_cast<int>(file), F_NOCACHE, enable ? 1 : 0) != -1;
+}
+
+void closeFile(FileHandle file) {
+    if (file != kInvalidFile) {
+        close(static_cast<int>(file));
+    }
+}
+
+size_t getDirectIOAlignment() {
+    return 4096;
+}
+
+// =============================================================================
+// Shared Memory
+// =============================================================================
+
+bool createSharedMemory(const std::string& name, size_t size, SharedMemory& region) {
+    const std::string shmName = "/" + name;
+    int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    // macOS only allows ftruncate once on a shm object, right after creation
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+    region.data = data;
+    region.size = size;
+    region.handle = fd;
+    region.name = shmName;
+    return true;
+}
+
+bool openSharedMemoryReadOnly(const std::string& name, SharedMemory& region) {
+    const std::string shmName = "/" + name;
+    int fd = shm_open(shmName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // No handle: destroySharedMemory() then only unmaps
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    region.data = data;
+    region.size = static_cast<size_t>(st.st_size);
+    region.handle = -1;
+    region.name = shmName;
+    return true;
+}
+
+void removeSharedMemory(const std::string& name) {
+    shm_unlink(("/" + name).c_str());
+}
+
+void destroySharedMemory(SharedMemory& region) {
+    if (region.data) {
+        munmap(region.data, region.size);
+    }
+    if (region.handle >= 0) {
+        close(static_cast<int>(region.handle));
+        shm_unlink(region.name.c_str());
+    }
+    region = SharedMemory();
+}
+
+void wakeSharedAddress(void* word) {
+    (void)word;
+}
+
 // =============================================================================
 // High-Resolution Timing
 // =============================================================================
@@ -434,6 +636,16 @@ uint64_t getTimestampNanos() {
     return machTime * s_timebaseInfo.numer / s_timebaseInfo.denom;
 }
 
+void sleepUntilNanos(uint64_t deadlineNanos) {
+    if (s_timebaseInfo.denom == 0) {
+        mach_timebase_info(&s_timebaseInfo);
+    }
+    
+    // Inverse of getTimestampNanos(); mach_wait_until() takes absolute ticks
+    uint64_t deadlineMach = deadlineNanos * s_timebaseInfo.denom / s_timebaseInfo.numer;
+    mach_wait_until(deadlineMach);
+}
+
 // =============================================================================
 // Console Utilities
 // =============================================================================
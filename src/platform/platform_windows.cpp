@@ -146,6 +146,26 @@ uint64_t getAvailableMemoryBytes() {
     return 0;
 }
 
+uint64_t getProcessResidentBytes() {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+}
+
+uint64_t getProcessCpuNanos() {
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    auto toNanos = [](const FILETIME& ft) {
+        // FILETIME counts 100 ns intervals
+        return ((static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) * 100ULL;
+    };
+    return toNanos(kernel) + toNanos(user);
+}
+
 int getCPUCoreCount() {
     SYSTEM_INFO sysInfo;
     GetNativeSystemInfo(&sysInfo);
@@ -505,6 +525,11 @@ bool terminateProcess(uint32_t pid) {
     return result;
 }
 
+int countTcpConnections(uint16_t /*localPort*/) {
+    // Not implemented (would need GetExtendedTcpTable / iphlpapi)
+    return -1;
+}
+
 // =============================================================================
 // Threading Utilities
 // =============================================================================
@@ -578,6 +603,135 @@ bool unlockMemory(void* ptr, size_t size) {
     return VirtualUnlock(ptr, size) != 0;
 }
 
+// =============================================================================
+// Raw File Output
+// =============================================================================
+
+FileHandle openFileForWrite(const std::string& path, bool directIO) {
+    // FILE_FLAG_NO_BUFFERING cannot be turned off for the unaligned tail, so
+    // directIO is not supported here
+    (void)directIO;
+    std::wstring wpath = utf8ToWide(path);
+    HANDLE handle = CreateFileW(wpath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    return handle == INVALID_HANDLE_VALUE ? kInvalidFile : reinterpret_cast<FileHandle>(handle);
+}
+
+bool writeFile(FileHandle file, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        DWORD written = 0;
+        if (!WriteFile(reinterpret_cast<HANDLE>(file), bytes, chunk, &written, nullptr)) {
+            return false;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool writeFileAt(FileHandle file, uint64_t offset, const void* data, size_t size) {
+    HANDLE handle = reinterpret_cast<HANDLE>(file);
+    LARGE_INTEGER current = {};
+    LARGE_INTEGER target = {};
+    target.QuadPart = static_cast<LONGLONG>(offset);
+    if (!SetFilePointerEx(handle, LARGE_INTEGER{}, &current, FILE_CURRENT) ||
+        !SetFilePointerEx(handle, target, nullptr, FILE_BEGIN)) {
+        return false;
+    }
+    bool ok = writeFile(file, data, size);
+    SetFilePointerEx(handle, current, nullptr, FILE_BEGIN);
+    return ok;
+}
+
+bool setFileDirectIO(FileHandle file, bool enable) {
+    (void)file;
+    return !enable;
+}
+
+void closeFile(FileHandle file) {
+    if (file != kInvalidFile) {
+        CloseHandle(reinterpret_cast<HANDLE>(file));
+    }
+}
+
+size_t getDirectIOAlignment() {
+    return 4096;
+}
+
+// =============================================================================
+// Shared Memory
+// =============================================================================
+
+bool createSharedMemory(const std::string& name, size_t size, SharedMemory& region) {
+    // Pagefile-backed; the name disappears with the last handle, so nothing stale survives
+    std::wstring wname = utf8ToWide("Local\\" + name);
+    const uint64_t size64 = size;
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                       static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64),
+                                       wname.c_str());
+    if (!mapping) {
+        return false;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Another process's live mapping (a name can't outlive its handles)
+        CloseHandle(mapping);
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!data) {
+        CloseHandle(mapping);
+        return false;
+    }
+    region.data = data;
+    region.size = size;
+    region.handle = reinterpret_cast<intptr_t>(mapping);
+    region.name = name;
+    return true;
+}
+
+bool openSharedMemoryReadOnly(const std::string& name, SharedMemory& region) {
+    std::wstring wname = utf8ToWide("Local\\" + name);
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, wname.c_str());
+    if (!mapping) {
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    // The view keeps the mapping alive; destroySharedMemory() then only unmaps
+    CloseHandle(mapping);
+    MEMORY_BASIC_INFORMATION info = {};
+    if (!data || !VirtualQuery(data, &info, sizeof(info))) {
+        if (data) UnmapViewOfFile(data);
+        return false;
+    }
+    region.data = data;
+    region.size = info.RegionSize;
+    region.handle = -1;
+    region.name = name;
+    return true;
+}
+
+void removeSharedMemory(const std::string& name) {
+    // Names go away with their last handle
+    (void)name;
+}
+
+void destroySharedMemory(SharedMemory& region) {
+    if (region.data) {
+        UnmapViewOfFile(region.data);
+    }
+    if (region.handle != -1) {
+        CloseHandle(reinterpret_cast<HANDLE>(region.handle));
+    }
+    region = SharedMemory();
+}
+
+void wakeSharedAddress(void* word) {
+    // WakeByAddressAll only reaches threads of this process
+    (void)word;
+}
+
 // =============================================================================
 // High-Resolution Timing
 // =============================================================================
@@ -597,6 +751,14 @@ uint64_t getTimestampNanos() {
         (counter.QuadPart * 1000000000LL) / s_qpcFrequency.QuadPart);
 }
 
+void sleepUntilNanos(uint64_t deadlineNanos) {
+    // No absolute timer on the QPC timebase; sleep the remainder
+    uint64_t now = getTimestampNanos();
+    if (deadlineNanos > now) {
+        preciseSleep(deadlineNanos - now);
+    }
+}
+
 // =============================================================================
 // Console Utilities
 // =============================================================================
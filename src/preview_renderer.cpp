@@ -0,0 +1,190 @@
+// streamlumo-engine/src/preview_renderer.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "preview_renderer.h"
+#include "logging.h"
+#include "platform/platform.h"
+#include "trace.h"
+
+#include <graphics/vec4.h>
+
+#include <algorithm>
+
+namespace streamlumo {
+
+PreviewRenderer::~PreviewRenderer() {
+    stop();
+}
+
+bool PreviewRenderer::start(const Options& options) {
+    if (m_running) {
+        return true;
+    }
+    m_options = options;
+    m_options.fps = std::clamp<uint32_t>(m_options.fps, 1, 60);
+    // Render on the first tick that has a sink
+    m_sinceFrame = 1.0f;
+    obs_add_tick_callback(&PreviewRenderer::tickCallback, this);
+    m_running = true;
+    if (m_options.width) {
+        log_info("Preview: rendered on demand at %u fps, %u px wide", m_options.fps, m_options.width);
+    } else {
+        log_info("Preview: rendered on demand at %u fps, full size", m_options.fps);
+    }
+    return true;
+}
+
+void PreviewRenderer::stop() {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+
+    // Once removed, no tick is running and none will start
+    obs_remove_tick_callback(&PreviewRenderer::tickCallback, this);
+    obs_enter_graphics();
+    gs_texrender_destroy(m_texrender);
+    obs_leave_graphics();
+    m_texrender = nullptr;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    obs_weak_source_release(m_scene);
+    m_scene = nullptr;
+    m_frameValid = false;
+    if (m_stats.frames > 0) {
+        log_info("Preview: %llu frames, render avg %.2f ms max %.2f ms",
+                 static_cast<unsigned long long>(m_stats.frames),
+                 m_stats.totalRenderMicros / 1000.0 / m_stats.frames, m_stats.maxRenderMicros / 1000.0);
+    }
+}
+
+void PreviewRenderer::setScene(obs_source_t* scene) {
+    obs_weak_source_t* weak = scene ? obs_source_get_weak_source(scene) : nullptr;
+    obs_weak_source_t* previous;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (obs_weak_source_references_source(m_scene, scene) || (!m_scene && !scene)) {
+            obs_weak_source_release(weak);
+            return;
+        }
+        previous = m_scene;
+        m_scene = weak;
+        m_frameValid = false;
+    }
+    obs_weak_source_release(previous);
+}
+
+uint64_t PreviewRenderer::addSink(FrameCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint64_t id = m_nextSinkId++;
+    m_sinks.push_back(Sink{id, std::move(callback), true});
+    return id;
+}
+
+void PreviewRenderer::removeSink(uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sinks.erase(std::remove_if(m_sinks.begin(), m_sinks.end(), [id](const Sink& sink) { return sink.id == id; }),
+                  m_sinks.end());
+}
+
+bool PreviewRenderer::observed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_sinks.empty() && m_scene;
+}
+
+PreviewRenderer::Stats PreviewRenderer::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void PreviewRenderer::tickCallback(void* param, float seconds) {
+    static_cast<PreviewRenderer*>(param)->tick(seconds);
+}
+
+void PreviewRenderer::tick(float seconds) {
+    const float interval = 1.0f / static_cast<float>(m_options.fps);
+    m_sinceFrame += seconds;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_sinks.empty() || !m_scene) {
+        return;
+    }
+    const bool due = m_sinceFrame >= interval || !m_frameValid;
+    const bool freshSinks = std::any_of(m_sinks.begin(), m_sinks.end(), [](const Sink& sink) { return sink.fresh; });
+    if (!due && !freshSinks) {
+        return;
+    }
+
+    obs_source_t* scene = nullptr;
+    if (due) {
+        scene = obs_weak_source_get_source(m_scene);
+        if (!scene) {
+            return;
+        }
+    }
+
+    TRACE_SCOPE("graphics", "preview_render");
+    obs_enter_graphics();
+    if (due) {
+        const uint64_t start = platform::getTimestampMicros();
+        m_frameValid = render(scene);
+        const uint64_t micros = platform::getTimestampMicros() - start;
+        // Keep the cadence, but never try to catch up on missed frames
+        m_sinceFrame = std::clamp(m_sinceFrame - interval, 0.0f, interval);
+        if (m_frameValid) {
+            m_stats.frames++;
+            m_stats.totalRenderMicros += micros;
+            m_stats.maxRenderMicros = std::max(m_stats.maxRenderMicros, micros);
+        }
+    }
+    if (m_frameValid) {
+        gs_texture_t* texture = gs_texrender_get_texture(m_texrender);
+        for (Sink& sink : m_sinks) {
+            // Between renders only sinks that have not seen this frame get it
+            if (due || sink.fresh) {
+                sink.fresh = false;
+                sink.callback(texture, m_width, m_height);
+            }
+        }
+    }
+    obs_leave_graphics();
+    obs_source_release(scene);
+}
+
+bool PreviewRenderer::render(obs_source_t* scene) {
+    const uint32_t baseWidth = obs_source_get_width(scene);
+    const uint32_t baseHeight = obs_source_get_height(scene);
+    if (baseWidth == 0 || baseHeight == 0) {
+        return false;
+    }
+    uint32_t width = m_options.width ? std::min(m_options.width, baseWidth) : baseWidth;
+    uint32_t height = std::max<uint32_t>(static_cast<uint32_t>(static_cast<uint64_t>(baseHeight) * width / baseWidth), 1);
+
+    if (!m_texrender) {
+        m_texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+        if (!m_texrender) {
+            log_error("Preview: failed to create the render target");
+            return false;
+        }
+    }
+    gs_texrender_reset(m_texrender);
+    if (!gs_texrender_begin(m_texrender, width, height)) {
+        return false;
+    }
+    vec4 clear;
+    vec4_zero(&clear);
+    gs_clear(GS_CLEAR_COLOR, &clear, 0.0f, 0);
+    gs_ortho(0.0f, static_cast<float>(baseWidth), 0.0f, static_cast<float>(baseHeight), -100.0f, 100.0f);
+    gs_blend_state_push();
+    gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+    obs_source_video_render(scene);
+    gs_blend_state_pop();
+    gs_texrender_end(m_texrender);
+
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+} // namespace streamlumo
@@ -0,0 +1,97 @@
+// streamlumo-engine/src/preview_renderer.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <obs.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Renders the studio-mode preview scene, only while something watches it
+ *
+ * A sink receives the rendered texture on the graphics thread at
+ * Options::fps, which is normally well below the program frame rate, and
+ * at Options::width (height keeps the aspect ratio). With no sink attached
+ * the tick callback returns straight away: nothing is rendered or uploaded.
+ * Keeping the preview's sources warm (loaded, ticking, ready for a
+ * transition) is the frontend's job, through obs_source_inc_showing();
+ * that costs no GPU work.
+ *
+ * The last frame is kept in the texture, so a sink attached between renders
+ * gets the cached frame on the next tick instead of waiting an interval.
+ */
+class PreviewRenderer {
+public:
+    struct Options {
+        uint32_t fps = 10;
+        uint32_t width = 640;           // 0 = the scene's own size
+    };
+
+    // Graphics thread, inside obs_enter_graphics(); the texture is only valid for the call.
+    // Must not call addSink()/removeSink().
+    using FrameCallback = std::function<void(gs_texture_t* texture, uint32_t width, uint32_t height)>;
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t totalRenderMicros = 0;
+        uint64_t maxRenderMicros = 0;
+    };
+
+    PreviewRenderer() = default;
+    ~PreviewRenderer();
+
+    PreviewRenderer(const PreviewRenderer&) = delete;
+    PreviewRenderer& operator=(const PreviewRenderer&) = delete;
+
+    // Requires obs_startup(); call stop() before obs_shutdown()
+    bool start(const Options& options);
+    void stop();
+    bool running() const { return m_running; }
+
+    // nullptr = nothing to preview; sinks get no frames until a scene is set
+    void setScene(obs_source_t* scene);
+
+    // Returns an id for removeSink(); once removeSink() returns the callback is not running
+    uint64_t addSink(FrameCallback callback);
+    void removeSink(uint64_t id);
+    bool observed() const;
+
+    Stats stats() const;
+
+private:
+    struct Sink {
+        uint64_t id;
+        FrameCallback callback;
+        bool fresh;                     // Attached since the last frame was delivered
+    };
+
+    static void tickCallback(void* param, float seconds);
+    void tick(float seconds);
+    bool render(obs_source_t* scene);
+
+    Options m_options;
+    bool m_running = false;
+
+    // Shared with the graphics thread; held while sinks run
+    mutable std::mutex m_mutex;
+    obs_weak_source_t* m_scene = nullptr;
+    std::vector<Sink> m_sinks;
+    uint64_t m_nextSinkId = 1;
+    bool m_frameValid = false;          // The texture holds a frame of m_scene
+    Stats m_stats;
+
+    // Graphics thread only
+    gs_texrender_t* m_texrender = nullptr;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    float m_sinceFrame = 0.0f;
+};
+
+} // namespace streamlumo
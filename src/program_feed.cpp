@@ -0,0 +1,371 @@
+// streamlumo-engine/src/program_feed.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "program_feed.h"
+#include "program_feed_shm.h"
+#include "logging.h"
+#include "platform/platform.h"
+#include "trace.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace streamlumo {
+
+const char* const kProgramFeedOutputId = "streamlumo_program_feed";
+
+namespace {
+
+constexpr size_t kSlotAlignment = 64;
+constexpr uint32_t kAudioFramesMax = AUDIO_OUTPUT_FRAMES;
+
+size_t alignUp(size_t value) {
+    return (value + kSlotAlignment - 1) & ~(kSlotAlignment - 1);
+}
+
+void copyPlane(uint8_t* dst, uint32_t dstLinesize, const uint8_t* src, uint32_t srcLinesize,
+               uint32_t rowBytes, uint32_t rows) {
+    if (dstLinesize == srcLinesize) {
+        memcpy(dst, src, static_cast<size_t>(dstLinesize) * rows);
+        return;
+    }
+    for (uint32_t y = 0; y < rows; y++) {
+        memcpy(dst + static_cast<size_t>(y) * dstLinesize, src + static_cast<size_t>(y) * srcLinesize, rowBytes);
+    }
+}
+
+// A writer that crashed leaves its region behind. Only a program feed whose
+// writer is gone is removed; any other region keeps its name.
+bool reclaimStaleRegion(const std::string& name) {
+    platform::SharedMemory existing;
+    if (!platform::openSharedMemoryReadOnly(name, existing)) {
+        return false;
+    }
+    bool feed = false;
+    uint32_t pid = 0;
+    if (existing.size >= sizeof(ProgramFeedHeader)) {
+        const auto* header = static_cast<const ProgramFeedHeader*>(existing.data);
+        feed = header->magic == kProgramFeedMagic;
+        pid = header->writer_pid;
+    }
+    platform::destroySharedMemory(existing);
+
+    if (!feed) {
+        log_error("Program feed: '%s' exists and is not a program feed", name.c_str());
+        return false;
+    }
+    if (pid == platform::getCurrentProcessId() || platform::isProcessRunning(pid)) {
+        log_error("Program feed: '%s' is in use by process %u", name.c_str(), pid);
+        return false;
+    }
+    log_warn("Program feed: removing '%s' left behind by process %u", name.c_str(), pid);
+    platform::removeSharedMemory(name);
+    return true;
+}
+
+class ProgramFeed {
+public:
+    explicit ProgramFeed(obs_output_t* output) : m_output(output) {}
+    ~ProgramFeed();
+
+    bool start();
+    void stop();
+    void onVideo(video_data* frame);
+    void onAudio(audio_data* frames);
+    uint64_t totalBytes() const { return m_bytesPublished; }
+
+private:
+    bool createRegion(const std::string& name, uint32_t format, uint32_t videoSlots, uint32_t audioSlots,
+                      const obs_video_info& ovi, uint32_t sampleRate, uint32_t channels);
+    ProgramFeedSlot* slotAt(uint64_t offset, uint32_t slotSize, uint32_t count, uint64_t sequence) const;
+    void publish();
+    void joinStopper();
+
+    obs_output_t* m_output = nullptr;
+    platform::SharedMemory m_region;
+    ProgramFeedHeader* m_header = nullptr;
+    uint8_t* m_base = nullptr;
+
+    // Writer side, only touched from libobs' video and audio threads while active
+    uint32_t m_rowBytes[2] = {};
+    uint32_t m_rows[2] = {};
+    uint32_t m_frameBytes = 0;
+    bool m_audioEnabled = false;
+    uint64_t m_videoSeq = 0;
+    uint64_t m_audioSeq = 0;
+    bool m_audioTruncated = false;
+
+    std::atomic<bool> m_active{false};
+    std::atomic<uint64_t> m_bytesPublished{0};
+    std::thread m_stopper;
+};
+
+ProgramFeed::~ProgramFeed() {
+    joinStopper();
+    // libobs no longer calls us, so the mapping can go
+    platform::destroySharedMemory(m_region);
+}
+
+void ProgramFeed::joinStopper() {
+    if (m_stopper.joinable()) {
+        m_stopper.join();
+    }
+}
+
+bool ProgramFeed::start() {
+    joinStopper();
+    // The previous run's region stays mapped until here: a raw callback may
+    // still have been finishing when it stopped
+    platform::destroySharedMemory(m_region);
+    m_header = nullptr;
+    m_base = nullptr;
+
+    obs_data_t* settings = obs_output_get_settings(m_output);
+    const char* nameValue = obs_data_get_string(settings, "name");
+    const char* formatValue = obs_data_get_string(settings, "format");
+    const std::string name = nameValue && *nameValue ? nameValue : "streamlumo_program";
+    const bool bgra = formatValue && strcmp(formatValue, "bgra") == 0;
+    const uint32_t videoSlots =
+        static_cast<uint32_t>(std::clamp<int64_t>(obs_data_get_int(settings, "video_slots"), 2, 64));
+    const uint32_t audioSlots =
+        static_cast<uint32_t>(std::clamp<int64_t>(obs_data_get_int(settings, "audio_slots"), 2, 1024));
+    m_audioEnabled = obs_data_get_bool(settings, "audio");
+    obs_data_release(settings);
+
+    obs_video_info ovi = {};
+    obs_audio_info oai = {};
+    if (!obs_get_video_info(&ovi) || !obs_get_audio_info(&oai)) {
+        obs_output_set_last_error(m_output, "Video or audio is not initialised");
+        return false;
+    }
+
+    video_scale_info conversion = {};
+    conversion.format = bgra ? VIDEO_FORMAT_BGRA : VIDEO_FORMAT_NV12;
+    conversion.width = ovi.output_width;
+    conversion.height = ovi.output_height;
+    conversion.range = ovi.range;
+    conversion.colorspace = ovi.colorspace;
+    obs_output_set_video_conversion(m_output, &conversion);
+
+    audio_convert_info audioConversion = {};
+    audioConversion.samples_per_sec = oai.samples_per_sec;
+    audioConversion.format = AUDIO_FORMAT_FLOAT_PLANAR;
+    audioConversion.speakers = oai.speakers;
+    obs_output_set_audio_conversion(m_output, &audioConversion);
+
+    const uint32_t channels = get_audio_channels(oai.speakers);
+    if (!createRegion(name, bgra ? kProgramFeedFormatBGRA : kProgramFeedFormatNV12, videoSlots,
+                      m_audioEnabled ? audioSlots : 0, ovi, oai.samples_per_sec, channels)) {
+        log_error("Program feed: cannot create shared memory '%s'", name.c_str());
+        obs_output_set_last_error(m_output, "Cannot create shared memory");
+        return false;
+    }
+
+    if (!obs_output_can_begin_data_capture(m_output, 0)) {
+        platform::destroySharedMemory(m_region);
+        m_header = nullptr;
+        return false;
+    }
+    m_videoSeq = 0;
+    m_audioSeq = 0;
+    m_audioTruncated = false;
+    m_bytesPublished = 0;
+    m_active = true;
+    m_header->state.store(kProgramFeedRunning, std::memory_order_release);
+    if (!obs_output_begin_data_capture(m_output, 0)) {
+        m_active = false;
+        platform::destroySharedMemory(m_region);
+        m_header = nullptr;
+        return false;
+    }
+
+    log_info("Program feed: %ux%u %s at %s (%.1f MB, %u video slots%s)", ovi.output_width, ovi.output_height,
+             bgra ? "BGRA" : "NV12", m_region.name.c_str(), m_region.size / 1048576.0, videoSlots,
+             m_audioEnabled ? ", audio" : "");
+    return true;
+}
+
+bool ProgramFeed::createRegion(const std::string& name, uint32_t format, uint32_t videoSlots, uint32_t audioSlots,
+                               const obs_video_info& ovi, uint32_t sampleRate, uint32_t channels) {
+    const uint32_t width = ovi.output_width;
+    const uint32_t height = ovi.output_height;
+    uint32_t planeOffset[2] = {};
+    uint32_t linesize[2] = {};
+    uint32_t planeCount = 1;
+    if (format == kProgramFeedFormatBGRA) {
+        m_rowBytes[0] = linesize[0] = width * 4;
+        m_rows[0] = height;
+        m_frameBytes = linesize[0] * height;
+    } else {
+        // Y plane, then interleaved UV at half height
+        planeCount = 2;
+        m_rowBytes[0] = linesize[0] = width;
+        m_rows[0] = height;
+        m_rowBytes[1] = linesize[1] = (width + 1) / 2 * 2;
+        m_rows[1] = (height + 1) / 2;
+        planeOffset[1] = static_cast<uint32_t>(alignUp(static_cast<size_t>(linesize[0]) * height));
+        m_frameBytes = planeOffset[1] + linesize[1] * m_rows[1];
+    }
+
+    const uint32_t videoSlotSize = static_cast<uint32_t>(alignUp(sizeof(ProgramFeedSlot) + m_frameBytes));
+    const uint32_t audioSlotSize =
+        static_cast<uint32_t>(alignUp(sizeof(ProgramFeedSlot) + sizeof(float) * channels * kAudioFramesMax));
+    const uint64_t videoOffset = sizeof(ProgramFeedHeader);
+    const uint64_t audioOffset = videoOffset + static_cast<uint64_t>(videoSlots) * videoSlotSize;
+    const uint64_t total = audioOffset + static_cast<uint64_t>(audioSlots) * audioSlotSize;
+
+    if (!platform::createSharedMemory(name, static_cast<size_t>(total), m_region) &&
+        !(reclaimStaleRegion(name) && platform::createSharedMemory(name, static_cast<size_t>(total), m_region))) {
+        return false;
+    }
+    m_base = static_cast<uint8_t*>(m_region.data);
+    m_header = new (m_base) ProgramFeedHeader();
+    m_header->magic = kProgramFeedMagic;
+    m_header->version = kProgramFeedVersion;
+    m_header->video_offset = static_cast<uint32_t>(videoOffset);
+    m_header->video_slot_count = videoSlots;
+    m_header->video_slot_size = videoSlotSize;
+    m_header->audio_slot_count = audioSlots;
+    m_header->audio_slot_size = audioSlotSize;
+    m_header->audio_frames_max = kAudioFramesMax;
+    m_header->audio_offset = audioOffset;
+    m_header->width = width;
+    m_header->height = height;
+    m_header->format = format;
+    m_header->fps_num = ovi.fps_num;
+    m_header->fps_den = ovi.fps_den;
+    m_header->plane_count = planeCount;
+    for (int i = 0; i < 2; i++) {
+        m_header->plane_offset[i] = planeOffset[i];
+        m_header->plane_linesize[i] = linesize[i];
+    }
+    m_header->sample_rate = sampleRate;
+    m_header->channels = channels;
+    m_header->writer_pid = platform::getCurrentProcessId();
+    for (uint32_t i = 0; i < videoSlots; i++) {
+        new (slotAt(videoOffset, videoSlotSize, videoSlots, i)) ProgramFeedSlot();
+    }
+    for (uint32_t i = 0; i < audioSlots; i++) {
+        new (slotAt(audioOffset, audioSlotSize, audioSlots, i)) ProgramFeedSlot();
+    }
+    return true;
+}
+
+ProgramFeedSlot* ProgramFeed::slotAt(uint64_t offset, uint32_t slotSize, uint32_t count, uint64_t sequence) const {
+    return reinterpret_cast<ProgramFeedSlot*>(m_base + offset + (sequence % count) * slotSize);
+}
+
+void ProgramFeed::stop() {
+    if (!m_active.exchange(false)) {
+        return;
+    }
+    m_header->state.store(kProgramFeedStopped);
+    // Blocked readers wake up, see the state and go looking for the next region
+    m_header->wake_seq.fetch_add(1);
+    platform::wakeSharedAddress(&m_header->wake_seq);
+    log_info("Program feed: stopped after %llu frames, %.1f MB published",
+             static_cast<unsigned long long>(m_videoSeq), m_bytesPublished.load() / 1048576.0);
+
+    // libobs must not be told to end capture from inside the stop callback
+    joinStopper();
+    m_stopper = std::thread([this] { obs_output_end_data_capture(m_output); });
+}
+
+// libobs video thread
+void ProgramFeed::onVideo(video_data* frame) {
+    if (!m_active.load(std::memory_order_acquire)) {
+        return;
+    }
+    TRACE_SCOPE("output", "program_feed_video");
+    const uint64_t n = m_videoSeq++;
+    ProgramFeedSlot* slot = slotAt(m_header->video_offset, m_header->video_slot_size, m_header->video_slot_count, n);
+    uint8_t* data = reinterpret_cast<uint8_t*>(slot + 1);
+
+    slot->seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t p = 0; p < m_header->plane_count; p++) {
+        copyPlane(data + m_header->plane_offset[p], m_header->plane_linesize[p], frame->data[p], frame->linesize[p],
+                  m_rowBytes[p], m_rows[p]);
+    }
+    slot->timestamp_ns = frame->timestamp;
+    slot->size = m_frameBytes;
+    slot->seq.store(2 * n + 2, std::memory_order_release);
+
+    m_header->video_seq.store(n + 1, std::memory_order_release);
+    m_bytesPublished.fetch_add(m_frameBytes, std::memory_order_relaxed);
+    publish();
+}
+
+// libobs audio thread
+void ProgramFeed::onAudio(audio_data* frames) {
+    if (!m_audioEnabled || !m_active.load(std::memory_order_acquire)) {
+        return;
+    }
+    uint32_t count = frames->frames;
+    if (count > kAudioFramesMax) {
+        if (!m_audioTruncated) {
+            log_warn("Program feed: audio packet of %u frames truncated to %u", count, kAudioFramesMax);
+            m_audioTruncated = true;
+        }
+        count = kAudioFramesMax;
+    }
+    const uint64_t n = m_audioSeq++;
+    ProgramFeedSlot* slot = slotAt(m_header->audio_offset, m_header->audio_slot_size, m_header->audio_slot_count, n);
+    uint8_t* data = reinterpret_cast<uint8_t*>(slot + 1);
+    const size_t channelBytes = sizeof(float) * kAudioFramesMax;
+
+    slot->seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t c = 0; c < m_header->channels; c++) {
+        memcpy(data + c * channelBytes, frames->data[c], sizeof(float) * count);
+    }
+    slot->timestamp_ns = frames->timestamp;
+    slot->size = count;
+    slot->seq.store(2 * n + 2, std::memory_order_release);
+
+    m_header->audio_seq.store(n + 1, std::memory_order_release);
+    publish();
+}
+
+// Readers register in waiters before re-checking wake_seq and sleeping; with
+// both sides sequentially consistent, either they see the new wake_seq or we
+// see them and make the syscall.
+void ProgramFeed::publish() {
+    m_header->wake_seq.fetch_add(1);
+    if (m_header->waiters.load() != 0) {
+        platform::wakeSharedAddress(&m_header->wake_seq);
+    }
+}
+
+} // namespace
+
+void registerProgramFeedOutput() {
+    obs_output_info info = {};
+    info.id = kProgramFeedOutputId;
+    info.flags = OBS_OUTPUT_AV;
+    info.get_name = [](void*) -> const char* { return "StreamLumo Program Feed"; };
+    info.create = [](obs_data_t*, obs_output_t* output) -> void* { return new ProgramFeed(output); };
+    info.destroy = [](void* data) { delete static_cast<ProgramFeed*>(data); };
+    info.start = [](void* data) { return static_cast<ProgramFeed*>(data)->start(); };
+    info.stop = [](void* data, uint64_t) { static_cast<ProgramFeed*>(data)->stop(); };
+    info.raw_video = [](void* data, video_data* frame) { static_cast<ProgramFeed*>(data)->onVideo(frame); };
+    info.raw_audio = [](void* data, audio_data* frames) { static_cast<ProgramFeed*>(data)->onAudio(frames); };
+    info.get_defaults = [](obs_data_t* settings) {
+        obs_data_set_default_string(settings, "name", "streamlumo_program");
+        obs_data_set_default_string(settings, "format", "nv12");
+        obs_data_set_default_int(settings, "video_slots", 4);
+        obs_data_set_default_bool(settings, "audio", true);
+        obs_data_set_default_int(settings, "audio_slots", 32);
+    };
+    info.get_total_bytes = [](void* data) { return static_cast<ProgramFeed*>(data)->totalBytes(); };
+    obs_register_output(&info);
+}
+
+} // namespace streamlumo
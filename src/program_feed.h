@@ -0,0 +1,40 @@
+// streamlumo-engine/src/program_feed.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+namespace streamlumo {
+
+/**
+ * @brief Output id of the program feed, the engine's virtual camera
+ *
+ * Publishes raw program frames (NV12 or BGRA at the output resolution) and
+ * planar float audio into a shared-memory ring other local processes map
+ * read-only (layout in program_feed_shm.h, usage in docs/program-feed.md).
+ * Nothing is encoded: each frame is copied once, from libobs into a slot,
+ * and any number of readers use it in place.
+ *
+ * The writer never waits for readers. A reader that falls more than
+ * "video_slots" frames behind sees a slot's seqlock change and skips ahead.
+ * Readers block on a futex in the header (Linux); elsewhere they poll.
+ *
+ * This is not the browser helper's BrowserFrameBuffer. That is a triple
+ * buffer whose read_index handoff assumes a single consumer and only ever
+ * offers the latest frame. Here any number of readers share one region,
+ * none of them can take a frame away from another, and audio needs every
+ * packet in order. A ring of seqlocked slots gives each reader that.
+ *
+ * The region is created for this user only (0600 on POSIX). If the name
+ * already exists, the region is only replaced when it is a program feed
+ * whose writer process has exited; otherwise start fails.
+ *
+ * Settings: "name" (shm name), "format" ("nv12"/"bgra"), "video_slots",
+ * "audio" (bool), "audio_slots".
+ */
+extern const char* const kProgramFeedOutputId;
+
+// Call once after obs_startup()
+void registerProgramFeedOutput();
+
+} // namespace streamlumo
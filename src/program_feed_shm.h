@@ -0,0 +1,87 @@
+// streamlumo-engine/src/program_feed_shm.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+//
+// Shared-memory layout of the program feed (see docs/program-feed.md).
+// Self-contained so local consumers can include it as is.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace streamlumo {
+
+constexpr uint32_t kProgramFeedMagic = 0x46504C53;    // "SLPF"
+constexpr uint32_t kProgramFeedVersion = 1;
+
+// Same values as BrowserFrameBuffer::format where they overlap
+constexpr uint32_t kProgramFeedFormatBGRA = 1;
+constexpr uint32_t kProgramFeedFormatNV12 = 2;
+
+// ProgramFeedHeader::state
+constexpr uint32_t kProgramFeedStopped = 0;           // Region is dead; reopen by name
+constexpr uint32_t kProgramFeedRunning = 1;
+
+/**
+ * @brief Start of the region, followed by the video slots and then the audio slots
+ *
+ * Everything above the atomics is written once before the region is
+ * published (state = running) and never changes; a new format means a new
+ * region. Offsets are from the start of the mapping.
+ */
+struct ProgramFeedHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t video_offset;          // First video slot
+    uint32_t video_slot_count;
+    uint32_t video_slot_size;       // Slot header + frame, multiple of 64
+    uint32_t audio_slot_count;      // 0 = no audio
+    uint32_t audio_slot_size;
+    uint32_t audio_frames_max;      // Samples per channel that fit in one audio slot
+    uint64_t audio_offset;          // First audio slot
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;                // kProgramFeedFormat*
+    uint32_t fps_num;
+    uint32_t fps_den;
+    uint32_t plane_count;           // 1 for BGRA, 2 for NV12 (Y, then interleaved UV)
+    uint32_t plane_offset[2];       // From the start of a video slot's data
+    uint32_t plane_linesize[2];
+    uint32_t sample_rate;
+    uint32_t channels;              // Planar 32-bit float, one plane per channel
+
+    // Futex word: incremented after every published video frame or audio packet
+    std::atomic<uint32_t> wake_seq;
+    // Readers blocked on wake_seq; the writer only calls FUTEX_WAKE when non-zero
+    std::atomic<uint32_t> waiters;
+    std::atomic<uint32_t> state;
+    uint32_t writer_pid;
+    // Published counts; item n lives in slot n % slot_count
+    std::atomic<uint64_t> video_seq;
+    std::atomic<uint64_t> audio_seq;
+    uint64_t reserved[9];           // Pads the header to 192 bytes
+};
+
+/**
+ * @brief 64-byte header in front of each slot's data
+ *
+ * seq is a per-slot seqlock: 2n+1 while item n is being written into the
+ * slot, 2n+2 once it is complete. Readers check it before and after using
+ * the data in place; a change means the writer lapped them and the data
+ * they read is torn.
+ */
+struct ProgramFeedSlot {
+    std::atomic<uint64_t> seq;
+    uint64_t timestamp_ns;          // libobs frame/audio timestamp
+    uint32_t size;                  // Video: bytes; audio: samples per channel
+    uint32_t reserved[11];
+};
+
+static_assert(sizeof(ProgramFeedSlot) == 64, "ProgramFeedSlot must stay 64 bytes");
+static_assert(sizeof(ProgramFeedHeader) % 64 == 0, "ProgramFeedHeader must stay a multiple of 64 bytes");
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "Shared atomics must be lock-free to work across processes");
+
+} // namespace streamlumo
@@ -0,0 +1,572 @@
+// streamlumo-engine/src/replay_buffer.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "replay_buffer.h"
+#include "async_file_writer.h"
+#include "flv_muxer.h"
+#include "logging.h"
+#include "platform/platform.h"
+#include "trace.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace streamlumo {
+
+const char* const kReplayBufferOutputId = "streamlumo_replay_buffer";
+
+namespace {
+
+constexpr size_t kChunkBytes = 1024 * 1024;
+
+// Chunks allocated past max_size_mb at any one time (pinned by a save, or a
+// GOP too long for the budget): a quarter of the budget, at least this many
+constexpr size_t kMinOverflowChunks = 4;
+
+// Index slots per second on top of the video frame rate (AAC at 48 kHz is ~47)
+constexpr size_t kAudioPacketsPerSecond = 64;
+
+struct Chunk {
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    int pins = 0;             // Saves still reading this chunk
+    bool retired = false;     // Left the ring while pinned
+    bool pooled = true;       // false: allocated past the budget, freed on release
+};
+
+// One packet in the ring; the payload lives in chunk->data + offset
+struct PacketRef {
+    Chunk* chunk = nullptr;
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    int64_t pts = 0;
+    int64_t dts = 0;
+    int32_t timebaseNum = 1;
+    int32_t timebaseDen = 1;
+    int64_t dtsUsec = 0;
+    bool video = false;
+    bool keyframe = false;
+};
+
+struct KeyframeRef {
+    uint64_t packet = 0;      // Sequence number in the packet ring
+    int64_t dtsUsec = 0;
+};
+
+size_t nextPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+class ReplayBuffer {
+public:
+    explicit ReplayBuffer(obs_output_t* output);
+    ~ReplayBuffer();
+
+    bool start();
+    void stop();
+    void onPacket(encoder_packet* packet);
+    uint64_t totalBytes() const { return m_bytesPushed; }
+
+    static void saveProc(void* data, calldata_t* cd);
+    static void lastReplayProc(void* data, calldata_t* cd);
+
+private:
+    bool save();
+    void writeSnapshot(std::vector<PacketRef> packets, std::vector<Chunk*> pinned,
+                       FlvMuxer::StreamInfo info, std::string path);
+    Chunk* allocateChunk(size_t capacity, bool pooled);
+    void freeChunk(Chunk* chunk);
+    Chunk* nextChunk(size_t size);
+    void releaseChunk(Chunk* chunk);
+    void recycleChunk(Chunk* chunk);
+    bool trimOldestGop();
+    void clear();
+    void endCapture(int code);
+    void joinThreads();
+
+    PacketRef& packetAt(uint64_t sequence) { return m_packets[sequence & (m_packets.size() - 1)]; }
+    KeyframeRef& keyframeAt(uint64_t sequence) { return m_keyframes[sequence & (m_keyframes.size() - 1)]; }
+
+    obs_output_t* m_output = nullptr;
+
+    // Settings, read at start
+    std::string m_directory;
+    std::string m_prefix;
+    int64_t m_maxUsec = 0;
+    size_t m_maxChunks = 0;
+
+    std::mutex m_mutex;
+    bool m_active = false;
+    std::vector<Chunk*> m_owned;            // Every pooled chunk
+    std::vector<Chunk*> m_pool;
+    std::deque<Chunk*> m_live;              // Oldest first; back() is being filled
+    std::vector<PacketRef> m_packets;       // Power-of-two ring indexed by sequence number
+    uint64_t m_packetHead = 0;
+    uint64_t m_packetTail = 0;
+    std::vector<KeyframeRef> m_keyframes;   // Video keyframes in the ring, oldest first
+    uint64_t m_keyHead = 0;
+    uint64_t m_keyTail = 0;
+    uint64_t m_dropped = 0;
+    uint64_t m_overflowChunks = 0;          // Allocated past the budget since start
+    size_t m_overflowLive = 0;              // Of those, not freed yet
+    size_t m_maxOverflow = 0;
+    bool m_videoGap = false;                // A video packet was dropped; skip to the next keyframe
+    bool m_saving = false;
+    std::string m_lastReplay;
+
+    std::atomic<uint64_t> m_bytesPushed{0};
+    std::thread m_saver;
+    std::thread m_stopper;
+};
+
+ReplayBuffer::ReplayBuffer(obs_output_t* output)
+    : m_output(output) {
+    proc_handler_t* procs = obs_output_get_proc_handler(output);
+    proc_handler_add(procs, "void save()", saveProc, this);
+    proc_handler_add(procs, "void get_last_replay(out string path)", lastReplayProc, this);
+    signal_handler_add(obs_output_get_signal_handler(output), "void saved()");
+}
+
+ReplayBuffer::~ReplayBuffer() {
+    joinThreads();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    clear();
+    for (Chunk* chunk : m_owned) {
+        freeChunk(chunk);
+    }
+}
+
+void ReplayBuffer::joinThreads() {
+    if (m_saver.joinable()) {
+        m_saver.join();
+    }
+    if (m_stopper.joinable()) {
+        m_stopper.join();
+    }
+}
+
+Chunk* ReplayBuffer::allocateChunk(size_t capacity, bool pooled) {
+    // Not touched until written, so unused parts of the budget stay virtual
+    auto* chunk = new Chunk();
+    chunk->data = static_cast<uint8_t*>(platform::alignedAlloc(capacity, 64));
+    chunk->capacity = chunk->data ? capacity : 0;
+    chunk->pooled = pooled;
+    return chunk;
+}
+
+void ReplayBuffer::freeChunk(Chunk* chunk) {
+    platform::alignedFree(chunk->data);
+    delete chunk;
+}
+
+bool ReplayBuffer::start() {
+    joinThreads();
+
+    obs_data_t* settings = obs_output_get_settings(m_output);
+    const char* directory = obs_data_get_string(settings, "directory");
+    const char* prefix = obs_data_get_string(settings, "prefix");
+    m_directory = directory ? directory : "";
+    m_prefix = prefix && *prefix ? prefix : "Replay";
+    const int64_t maxSeconds = std::max<int64_t>(1, obs_data_get_int(settings, "max_time_sec"));
+    const int64_t maxMegabytes = std::max<int64_t>(2, obs_data_get_int(settings, "max_size_mb"));
+    obs_data_release(settings);
+
+    obs_encoder_t* video = obs_output_get_video_encoder(m_output);
+    obs_encoder_t* audio = obs_output_get_audio_encoder(m_output, 0);
+    if (m_directory.empty()) {
+        obs_output_set_last_error(m_output, "No replay buffer directory set");
+        return false;
+    }
+    if (!video || !audio || strcmp(obs_encoder_get_codec(video), "h264") != 0 ||
+        strcmp(obs_encoder_get_codec(audio), "aac") != 0) {
+        obs_output_set_last_error(m_output, "The replay buffer needs an H.264 video and an AAC audio encoder");
+        return false;
+    }
+    if (!obs_output_can_begin_data_capture(m_output, 0) || !obs_output_initialize_encoders(m_output, 0)) {
+        return false;
+    }
+
+    obs_video_info ovi = {};
+    obs_get_video_info(&ovi);
+    const size_t fps = ovi.fps_den > 0 ? (ovi.fps_num + ovi.fps_den - 1) / ovi.fps_den : 60;
+    // Headroom for the GOP that is kept past max_time_sec until the next keyframe
+    const size_t slots = nextPowerOfTwo((static_cast<size_t>(maxSeconds) + 20) * (fps + kAudioPacketsPerSecond));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        clear();
+        const size_t chunks = static_cast<size_t>(maxMegabytes) * 1024 * 1024 / kChunkBytes;
+        if (chunks != m_maxChunks) {
+            for (Chunk* chunk : m_owned) {
+                freeChunk(chunk);
+            }
+            m_owned.clear();
+            m_pool.clear();
+            for (size_t i = 0; i < chunks; ++i) {
+                Chunk* chunk = allocateChunk(kChunkBytes, true);
+                m_owned.push_back(chunk);
+                m_pool.push_back(chunk);
+            }
+            m_maxChunks = chunks;
+        }
+        m_packets.assign(slots, PacketRef());
+        m_keyframes.assign(slots, KeyframeRef());
+        m_packetHead = m_packetTail = 0;
+        m_keyHead = m_keyTail = 0;
+        m_maxUsec = maxSeconds * 1000000;
+        m_dropped = 0;
+        m_overflowChunks = 0;
+        m_maxOverflow = std::max(m_maxChunks / 4, kMinOverflowChunks);
+        m_videoGap = false;
+        m_bytesPushed = 0;
+        m_active = true;
+    }
+
+    log_info("Replay buffer: keeping %lld s / %lld MB (%zu x %zu KB chunks, %zu packet slots)",
+             static_cast<long long>(maxSeconds), static_cast<long long>(maxMegabytes), m_maxChunks,
+             kChunkBytes / 1024, slots);
+    return obs_output_begin_data_capture(m_output, 0);
+}
+
+void ReplayBuffer::stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_active) {
+        endCapture(OBS_OUTPUT_SUCCESS);
+    }
+}
+
+// Caller holds m_mutex. libobs must not be told to end capture from inside
+// the stop/packet callbacks, so that happens on a short-lived thread.
+void ReplayBuffer::endCapture(int code) {
+    m_active = false;
+    if (m_dropped > 0 || m_overflowChunks > 0) {
+        log_warn("Replay buffer: %llu packets dropped (index or memory full), %llu chunks allocated past "
+                 "the %zu MB budget (at most %zu at a time)",
+                 static_cast<unsigned long long>(m_dropped), static_cast<unsigned long long>(m_overflowChunks),
+                 m_maxChunks * kChunkBytes / (1024 * 1024), m_maxOverflow);
+    }
+    clear();
+    if (m_stopper.joinable()) {
+        m_stopper.join();
+    }
+    m_stopper = std::thread([this, code] {
+        if (code == OBS_OUTPUT_SUCCESS) {
+            obs_output_end_data_capture(m_output);
+        } else {
+            obs_output_signal_stop(m_output, code);
+        }
+    });
+}
+
+void ReplayBuffer::clear() {
+    for (Chunk* chunk : m_live) {
+        releaseChunk(chunk);
+    }
+    m_live.clear();
+    m_packetTail = m_packetHead;
+    m_keyTail = m_keyHead;
+}
+
+void ReplayBuffer::releaseChunk(Chunk* chunk) {
+    if (chunk->pins > 0) {
+        chunk->retired = true;
+        return;
+    }
+    recycleChunk(chunk);
+}
+
+void ReplayBuffer::recycleChunk(Chunk* chunk) {
+    chunk->retired = false;
+    chunk->used = 0;
+    if (chunk->pooled) {
+        m_pool.push_back(chunk);
+    } else {
+        m_overflowLive--;
+        freeChunk(chunk);
+    }
+}
+
+// nullptr when the packet has to be dropped: the overflow allowance is
+// used up (or the allocation failed)
+Chunk* ReplayBuffer::nextChunk(size_t size) {
+    Chunk* chunk = nullptr;
+    if (size <= kChunkBytes) {
+        // Make room within the budget; chunks pinned by a save can't be
+        // reused, so trimming them would only lose history
+        while (m_pool.empty() && !m_live.empty() && m_live.front()->pins == 0 && trimOldestGop()) {
+        }
+        if (!m_pool.empty()) {
+            chunk = m_pool.back();
+            m_pool.pop_back();
+            m_live.push_back(chunk);
+            return chunk;
+        }
+    }
+    // A packet larger than a chunk (very high bitrate keyframe), or no room
+    // left in the budget
+    if (m_overflowLive >= m_maxOverflow) {
+        return nullptr;
+    }
+    chunk = allocateChunk(std::max(size, kChunkBytes), false);
+    if (!chunk->data) {
+        freeChunk(chunk);
+        return nullptr;
+    }
+    m_overflowChunks++;
+    m_overflowLive++;
+    m_live.push_back(chunk);
+    return chunk;
+}
+
+bool ReplayBuffer::trimOldestGop() {
+    if (m_keyHead - m_keyTail < 2) {
+        return false;
+    }
+    m_keyTail++;
+    m_packetTail = keyframeAt(m_keyTail).packet;
+    Chunk* keep = packetAt(m_packetTail).chunk;
+    while (m_live.front() != keep) {
+        releaseChunk(m_live.front());
+        m_live.pop_front();
+    }
+    return true;
+}
+
+void ReplayBuffer::onPacket(encoder_packet* packet) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_active) {
+        return;
+    }
+    if (!packet) {
+        endCapture(OBS_OUTPUT_ENCODE_ERROR);
+        return;
+    }
+
+    TRACE_SCOPE("output", "replay_push");
+    const bool video = packet->type == OBS_ENCODER_VIDEO;
+    if (!video && packet->track_idx != 0) {
+        return;
+    }
+    const bool keyframe = video && packet->keyframe;
+    if (m_packetHead == m_packetTail && !keyframe) {
+        // The buffer always starts on a keyframe
+        return;
+    }
+    if (video && m_videoGap && !keyframe) {
+        // The frames after a dropped one can't be decoded without it
+        m_dropped++;
+        return;
+    }
+    if ((m_packetHead - m_packetTail == m_packets.size() || m_keyHead - m_keyTail == m_keyframes.size()) &&
+        !trimOldestGop()) {
+        m_dropped++;
+        m_videoGap = m_videoGap || video;
+        return;
+    }
+
+    Chunk* chunk = m_live.empty() ? nullptr : m_live.back();
+    if (!chunk || chunk->capacity - chunk->used < packet->size) {
+        chunk = nextChunk(packet->size);
+        if (!chunk && keyframe && !m_saving) {
+            // One GOP is filling the budget and the overflow: start over
+            // from this keyframe rather than refuse everything after it
+            clear();
+            chunk = nextChunk(packet->size);
+        }
+        if (!chunk) {
+            m_dropped++;
+            m_videoGap = m_videoGap || video;
+            return;
+        }
+    }
+    if (keyframe) {
+        m_videoGap = false;
+    }
+
+    PacketRef& ref = packetAt(m_packetHead);
+    ref.chunk = chunk;
+    ref.offset = static_cast<uint32_t>(chunk->used);
+    ref.size = static_cast<uint32_t>(packet->size);
+    ref.pts = packet->pts;
+    ref.dts = packet->dts;
+    ref.timebaseNum = packet->timebase_num;
+    ref.timebaseDen = packet->timebase_den;
+    ref.dtsUsec = packet->dts_usec;
+    ref.video = video;
+    ref.keyframe = keyframe;
+    memcpy(chunk->data + chunk->used, packet->data, packet->size);
+    chunk->used += packet->size;
+
+    if (keyframe) {
+        KeyframeRef& key = keyframeAt(m_keyHead++);
+        key.packet = m_packetHead;
+        key.dtsUsec = packet->dts_usec;
+    }
+    m_packetHead++;
+    m_bytesPushed += packet->size;
+
+    // Drop the oldest GOP while the rest still covers max_time_sec
+    while (m_keyHead - m_keyTail >= 2 && packet->dts_usec - keyframeAt(m_keyTail + 1).dtsUsec >= m_maxUsec) {
+        trimOldestGop();
+    }
+}
+
+bool ReplayBuffer::save() {
+    std::vector<PacketRef> packets;
+    std::vector<Chunk*> pinned;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_active || m_saving || m_packetHead == m_packetTail) {
+            return false;
+        }
+        packets.reserve(static_cast<size_t>(m_packetHead - m_packetTail));
+        for (uint64_t sequence = m_packetTail; sequence != m_packetHead; ++sequence) {
+            packets.push_back(packetAt(sequence));
+        }
+        for (Chunk* chunk : m_live) {
+            chunk->pins++;
+            pinned.push_back(chunk);
+        }
+        m_saving = true;
+    }
+    if (m_saver.joinable()) {
+        m_saver.join();
+    }
+
+    char stamp[32];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H-%M-%S", localtime(&now));
+    std::string path = platform::joinPath(m_directory, m_prefix + " " + stamp + ".flv");
+    FlvMuxer::StreamInfo info = FlvMuxer::describe(obs_output_get_video_encoder(m_output),
+                                                   obs_output_get_audio_encoder(m_output, 0));
+    m_saver = std::thread(&ReplayBuffer::writeSnapshot, this, std::move(packets), std::move(pinned),
+                          std::move(info), std::move(path));
+    return true;
+}
+
+void ReplayBuffer::writeSnapshot(std::vector<PacketRef> packets, std::vector<Chunk*> pinned,
+                                 FlvMuxer::StreamInfo info, std::string path) {
+    platform::setThreadName("replay-save");
+    Trace::setThreadName("replay-save");
+    const uint64_t startNanos = platform::getTimestampNanos();
+
+    int64_t durationMillis = 0;
+    AsyncFileWriter::Stats stats;
+    bool ok;
+    {
+        TRACE_SCOPE("output", "replay_save");
+        AsyncFileWriter writer;
+        writer.start(AsyncFileWriter::Options());
+        FlvMuxer muxer(writer);
+        writer.open(path);
+        muxer.writeHeader(info);
+
+        int64_t startMillis = 0;
+        for (size_t i = 0; i < packets.size(); ++i) {
+            const PacketRef& ref = packets[i];
+            encoder_packet packet = {};
+            packet.data = ref.chunk->data + ref.offset;
+            packet.size = ref.size;
+            packet.pts = ref.pts;
+            packet.dts = ref.dts;
+            packet.timebase_num = ref.timebaseNum;
+            packet.timebase_den = ref.timebaseDen;
+            packet.type = ref.video ? OBS_ENCODER_VIDEO : OBS_ENCODER_AUDIO;
+            packet.keyframe = ref.keyframe;
+
+            const int64_t dtsMillis = FlvMuxer::toMillis(packet.dts, &packet);
+            if (i == 0) {
+                startMillis = dtsMillis;
+            }
+            const int64_t millis = dtsMillis - startMillis;
+            if (millis < 0) {
+                continue;
+            }
+            if (ref.video) {
+                muxer.writeVideo(millis, &packet);
+            } else {
+                muxer.writeAudio(millis, &packet);
+            }
+            durationMillis = std::max(durationMillis, millis);
+        }
+
+        writer.closeFile(muxer.closingPatches(durationMillis));
+        writer.stop();
+        stats = writer.stats();
+        ok = !writer.failed();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Chunk* chunk : pinned) {
+            if (--chunk->pins == 0 && chunk->retired) {
+                recycleChunk(chunk);
+            }
+        }
+        m_saving = false;
+        if (ok) {
+            m_lastReplay = path;
+        }
+    }
+
+    if (!ok) {
+        log_error("Replay buffer: saving %s failed", path.c_str());
+        return;
+    }
+    log_info("Replay buffer: saved %s (%.1f s, %.1f MB) in %.0f ms", path.c_str(), durationMillis / 1000.0,
+             stats.bytesWritten / 1048576.0, (platform::getTimestampNanos() - startNanos) / 1e6);
+
+    uint8_t stack[64];
+    calldata_t cd;
+    calldata_init_fixed(&cd, stack, sizeof(stack));
+    signal_handler_signal(obs_output_get_signal_handler(m_output), "saved", &cd);
+}
+
+void ReplayBuffer::saveProc(void* data, calldata_t* cd) {
+    (void)cd;
+    static_cast<ReplayBuffer*>(data)->save();
+}
+
+void ReplayBuffer::lastReplayProc(void* data, calldata_t* cd) {
+    auto* buffer = static_cast<ReplayBuffer*>(data);
+    std::lock_guard<std::mutex> lock(buffer->m_mutex);
+    calldata_set_string(cd, "path", buffer->m_lastReplay.c_str());
+}
+
+} // namespace
+
+void registerReplayBufferOutput() {
+    obs_output_info info = {};
+    info.id = kReplayBufferOutputId;
+    info.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED;
+    info.encoded_video_codecs = "h264";
+    info.encoded_audio_codecs = "aac";
+    info.get_name = [](void*) -> const char* { return "StreamLumo Replay Buffer"; };
+    info.create = [](obs_data_t*, obs_output_t* output) -> void* { return new ReplayBuffer(output); };
+    info.destroy = [](void* data) { delete static_cast<ReplayBuffer*>(data); };
+    info.start = [](void* data) { return static_cast<ReplayBuffer*>(data)->start(); };
+    info.stop = [](void* data, uint64_t) { static_cast<ReplayBuffer*>(data)->stop(); };
+    info.encoded_packet = [](void* data, encoder_packet* packet) {
+        static_cast<ReplayBuffer*>(data)->onPacket(packet);
+    };
+    info.get_total_bytes = [](void* data) { return static_cast<ReplayBuffer*>(data)->totalBytes(); };
+    obs_register_output(&info);
+}
+
+} // namespace streamlumo
@@ -0,0 +1,31 @@
+// streamlumo-engine/src/replay_buffer.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+namespace streamlumo {
+
+/**
+ * @brief Output id of the engine's in-memory replay buffer
+ *
+ * Keeps the last "max_time_sec" seconds of encoded H.264 + AAC packets, and
+ * at most "max_size_mb" of them, in a ring of fixed-size chunks allocated at
+ * start. Trimming drops whole GOPs from the front through a keyframe index,
+ * so the buffer always begins on a keyframe.
+ *
+ * "save()" snapshots the ring and writes it as FLV ("directory"/"prefix"
+ * + timestamp) from a background thread while packets keep arriving. The
+ * chunks being saved are pinned; if the ring needs them before the save is
+ * done, extra chunks are allocated for the duration of the save instead of
+ * blocking the encoder, up to a quarter of "max_size_mb". Past that,
+ * packets are dropped until the save releases its chunks, and video resumes
+ * at the next keyframe. Emits "saved" when the file is complete;
+ * "get_last_replay(out string path)" returns it.
+ */
+extern const char* const kReplayBufferOutputId;
+
+// Call once after obs_startup()
+void registerReplayBufferOutput();
+
+} // namespace streamlumo
@@ -0,0 +1,1035 @@
+// streamlumo-engine/src/scene_collection_store.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "scene_collection_store.h"
+#include "logging.h"
+#include "platform/platform.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <set>
+
+namespace streamlumo {
+
+namespace {
+
+const char* const kJsonExtension = ".json";
+const char* const kBinaryExtension = ".slsc";
+
+// Signals every source has that change what obs_save_source() writes
+// ("update" is connected separately: it also refreshes the settings copy)
+const char* const kSourceSignals[] = {
+    "rename", "volume", "mute", "audio_sync", "audio_balance", "audio_mixers",
+    "audio_monitoring", "filter_add", "filter_remove", "reorder_filters", "enable",
+};
+// Scenes and groups additionally save their items
+const char* const kSceneSignals[] = {
+    "item_add", "item_remove", "reorder", "refresh", "item_visible", "item_locked", "item_transform",
+};
+
+// =============================================================================
+// Binary format (.slsc), little-endian:
+//
+//   "SLSC", u32 version
+//   varint key count, keys (varint length + bytes); every item name is an index
+//   root object
+//   u32 FNV-1a of everything above
+//
+//   object = varint item count, then per item: varint key index, u8 tag, value
+//   value  = string: varint length + bytes | int: zigzag varint | double: 8 bytes
+//          | object | array: varint count + objects | null/false/true: nothing
+// =============================================================================
+
+constexpr uint8_t kMagic[4] = {'S', 'L', 'S', 'C'};
+constexpr uint32_t kBinaryVersion = 1;
+constexpr int kMaxDepth = 64;
+
+enum Tag : uint8_t {
+    TagNull = 0,
+    TagString = 1,
+    TagInt = 2,
+    TagDouble = 3,
+    TagFalse = 4,
+    TagTrue = 5,
+    TagObject = 6,
+    TagArray = 7,
+};
+
+uint32_t fnv1a(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+class BinaryWriter {
+public:
+    void object(obs_data_t* data) {
+        size_t count = 0;
+        for (obs_data_item_t* item = obs_data_first(data); item; obs_data_item_next(&item)) {
+            if (obs_data_item_has_user_value(item)) ++count;
+        }
+        putVarint(m_body, count);
+        for (obs_data_item_t* item = obs_data_first(data); item; obs_data_item_next(&item)) {
+            if (obs_data_item_has_user_value(item)) this->item(item);
+        }
+    }
+
+    void finish(std::vector<uint8_t>& out) {
+        out.clear();
+        out.reserve(m_body.size() + m_keyBytes + 16);
+        out.insert(out.end(), kMagic, kMagic + 4);
+        putU32(out, kBinaryVersion);
+        putVarint(out, m_keys.size());
+        for (const std::string* key : m_keys) {
+            putVarint(out, key->size());
+            out.insert(out.end(), key->begin(), key->end());
+        }
+        out.insert(out.end(), m_body.begin(), m_body.end());
+        putU32(out, fnv1a(out.data(), out.size()));
+    }
+
+private:
+    void item(obs_data_item_t* item) {
+        const char* name = obs_data_item_get_name(item);
+        auto inserted = m_keyIndex.emplace(name ? name : "", static_cast<uint32_t>(m_keys.size()));
+        if (inserted.second) {
+            m_keys.push_back(&inserted.first->first);
+            m_keyBytes += inserted.first->first.size() + 2;
+        }
+        putVarint(m_body, inserted.first->second);
+
+        switch (obs_data_item_gettype(item)) {
+            case OBS_DATA_STRING: {
+                const char* value = obs_data_item_get_string(item);
+                const size_t length = value ? std::strlen(value) : 0;
+                m_body.push_back(TagString);
+                putVarint(m_body, length);
+                m_body.insert(m_body.end(), value, value + length);
+                break;
+            }
+            case OBS_DATA_NUMBER:
+                if (obs_data_item_numtype(item) == OBS_DATA_NUM_DOUBLE) {
+                    const double value = obs_data_item_get_double(item);
+                    uint64_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    m_body.push_back(TagDouble);
+                    for (int i = 0; i < 8; ++i) m_body.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+                } else {
+                    const int64_t value = obs_data_item_get_int(item);
+                    m_body.push_back(TagInt);
+                    putVarint(m_body, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+                }
+                break;
+            case OBS_DATA_BOOLEAN:
+                m_body.push_back(obs_data_item_get_bool(item) ? TagTrue : TagFalse);
+                break;
+            case OBS_DATA_OBJECT: {
+                obs_data_t* child = obs_data_item_get_obj(item);
+                m_body.push_back(TagObject);
+                if (child) {
+                    object(child);
+                    obs_data_release(child);
+                } else {
+                    putVarint(m_body, 0);
+                }
+                break;
+            }
+            case OBS_DATA_ARRAY: {
+                obs_data_array_t* array = obs_data_item_get_array(item);
+                const size_t count = array ? obs_data_array_count(array) : 0;
+                m_body.push_back(TagArray);
+                putVarint(m_body, count);
+                for (size_t i = 0; i < count; ++i) {
+                    obs_data_t* child = obs_data_array_item(array, i);
+                    if (child) {
+                        object(child);
+                        obs_data_release(child);
+                    } else {
+                        putVarint(m_body, 0);
+                    }
+                }
+                obs_data_array_release(array);
+                break;
+            }
+            case OBS_DATA_NULL:
+            default:
+                m_body.push_back(TagNull);
+                break;
+        }
+    }
+
+    std::vector<uint8_t> m_body;
+    std::unordered_map<std::string, uint32_t> m_keyIndex;
+    std::vector<const std::string*> m_keys;
+    size_t m_keyBytes = 0;
+};
+
+class BinaryReader {
+public:
+    BinaryReader(const uint8_t* data, const uint8_t* end) : m_pos(data), m_end(end) {}
+
+    bool keys() {
+        uint64_t count;
+        if (!varint(count) || count > static_cast<uint64_t>(m_end - m_pos)) return false;
+        m_keys.reserve(static_cast<size_t>(count));
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t length;
+            if (!varint(length) || length > static_cast<uint64_t>(m_end - m_pos)) return false;
+            m_keys.emplace_back(reinterpret_cast<const char*>(m_pos), static_cast<size_t>(length));
+            m_pos += length;
+        }
+        return true;
+    }
+
+    // New reference, nullptr on malformed input
+    obs_data_t* object(int depth) {
+        uint64_t count;
+        if (depth > kMaxDepth || !varint(count)) return nullptr;
+        obs_data_t* data = obs_data_create();
+        for (uint64_t i = 0; i < count; ++i) {
+            if (!item(data, depth)) {
+                obs_data_release(data);
+                return nullptr;
+            }
+        }
+        return data;
+    }
+
+    bool atEnd() const { return m_pos == m_end; }
+
+private:
+    bool varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && m_pos < m_end; shift += 7) {
+            const uint8_t byte = *m_pos++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool item(obs_data_t* data, int depth) {
+        uint64_t keyIndex;
+        if (!varint(keyIndex) || keyIndex >= m_keys.size() || m_pos >= m_end) return false;
+        const char* name = m_keys[static_cast<size_t>(keyIndex)].c_str();
+
+        switch (*m_pos++) {
+            case TagNull:
+                return true;
+            case TagString: {
+                uint64_t length;
+                if (!varint(length) || length > static_cast<uint64_t>(m_end - m_pos)) return false;
+                m_scratch.assign(reinterpret_cast<const char*>(m_pos), static_cast<size_t>(length));
+                m_pos += length;
+                obs_data_set_string(data, name, m_scratch.c_str());
+                return true;
+            }
+            case TagInt: {
+                uint64_t zigzag;
+                if (!varint(zigzag)) return false;
+                obs_data_set_int(data, name, static_cast<long long>((zigzag >> 1) ^ (~(zigzag & 1) + 1)));
+                return true;
+            }
+            case TagDouble: {
+                if (m_end - m_pos < 8) return false;
+                uint64_t bits = 0;
+                for (int i = 0; i < 8; ++i) bits |= static_cast<uint64_t>(m_pos[i]) << (8 * i);
+                m_pos += 8;
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                obs_data_set_double(data, name, value);
+                return true;
+            }
+            case TagFalse:
+            case TagTrue:
+                obs_data_set_bool(data, name, m_pos[-1] == TagTrue);
+                return true;
+            case TagObject: {
+                obs_data_t* child = object(depth + 1);
+                if (!child) return false;
+                obs_data_set_obj(data, name, child);
+                obs_data_release(child);
+                return true;
+            }
+            case TagArray: {
+                uint64_t count;
+                if (!varint(count) || count > static_cast<uint64_t>(m_end - m_pos)) return false;
+                obs_data_array_t* array = obs_data_array_create();
+                for (uint64_t i = 0; i < count; ++i) {
+                    obs_data_t* child = object(depth + 1);
+                    if (!child) {
+                        obs_data_array_release(array);
+                        return false;
+                    }
+                    obs_data_array_push_back(array, child);
+                    obs_data_release(child);
+                }
+                obs_data_set_array(data, name, array);
+                obs_data_array_release(array);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    const uint8_t* m_pos;
+    const uint8_t* m_end;
+    std::vector<std::string> m_keys;
+    std::string m_scratch;
+};
+
+// Copies the user values of the whole tree; keys in skip are left out at
+// the top level only
+obs_data_t* deepCopy(obs_data_t* data, int depth = 0, std::initializer_list<const char*> skip = {}) {
+    obs_data_t* copy = obs_data_create();
+    if (depth > kMaxDepth) {
+        return copy;
+    }
+    for (obs_data_item_t* item = obs_data_first(data); item; obs_data_item_next(&item)) {
+        if (!obs_data_item_has_user_value(item)) {
+            continue;
+        }
+        const char* name = obs_data_item_get_name(item);
+        if (std::any_of(skip.begin(), skip.end(), [name](const char* key) { return std::strcmp(key, name) == 0; })) {
+            continue;
+        }
+        switch (obs_data_item_gettype(item)) {
+            case OBS_DATA_STRING:
+                obs_data_set_string(copy, name, obs_data_item_get_string(item));
+                break;
+            case OBS_DATA_NUMBER:
+                if (obs_data_item_numtype(item) == OBS_DATA_NUM_DOUBLE) {
+                    obs_data_set_double(copy, name, obs_data_item_get_double(item));
+                } else {
+                    obs_data_set_int(copy, name, obs_data_item_get_int(item));
+                }
+                break;
+            case OBS_DATA_BOOLEAN:
+                obs_data_set_bool(copy, name, obs_data_item_get_bool(item));
+                break;
+            case OBS_DATA_OBJECT:
+                if (obs_data_t* child = obs_data_item_get_obj(item)) {
+                    obs_data_t* childCopy = deepCopy(child, depth + 1);
+                    obs_data_set_obj(copy, name, childCopy);
+                    obs_data_release(childCopy);
+                    obs_data_release(child);
+                }
+                break;
+            case OBS_DATA_ARRAY:
+                if (obs_data_array_t* array = obs_data_item_get_array(item)) {
+                    obs_data_array_t* arrayCopy = obs_data_array_create();
+                    const size_t count = obs_data_array_count(array);
+                    for (size_t i = 0; i < count; ++i) {
+                        obs_data_t* child = obs_data_array_item(array, i);
+                        obs_data_t* childCopy = child ? deepCopy(child, depth + 1) : obs_data_create();
+                        obs_data_array_push_back(arrayCopy, childCopy);
+                        obs_data_release(childCopy);
+                        obs_data_release(child);
+                    }
+                    obs_data_set_array(copy, name, arrayCopy);
+                    obs_data_array_release(arrayCopy);
+                    obs_data_array_release(array);
+                }
+                break;
+            case OBS_DATA_NULL:
+            default:
+                break;
+        }
+    }
+    return copy;
+}
+
+// Collection names become file names; keep them readable but never a path
+std::string fileStem(const std::string& name) {
+    std::string stem = name;
+    for (char& c : stem) {
+        if (static_cast<unsigned char>(c) < 0x20 || std::strchr("/\\:*?\"<>|", c)) c = '_';
+    }
+    if (stem.empty() || stem == "." || stem == "..") stem = "_" + stem;
+    return stem;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    bytes.clear();
+    uint8_t buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    const bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+// Write to a temporary file and rename so a crash never leaves half a collection
+bool writeFileAtomic(const std::string& path, const void* data, size_t size) {
+    const std::string tmpPath = path + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(data, 1, size, file) == size;
+    ok = fflush(file) == 0 && ok;
+    ok = fclose(file) == 0 && ok;
+    if (ok) {
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+    }
+    return ok;
+}
+
+} // namespace
+
+// =============================================================================
+// Lifecycle
+// =============================================================================
+
+SceneCollectionStore::~SceneCollectionStore() {
+    stop();
+}
+
+bool SceneCollectionStore::start(const Options& options, StateCallback stateCallback) {
+    if (running()) {
+        return true;
+    }
+    if (options.directory.empty() || !platform::createDirectory(options.directory)) {
+        log_error("Scene collections: cannot create directory %s", options.directory.c_str());
+        return false;
+    }
+    m_options = options;
+    m_options.fullSaveEvery = std::max<uint32_t>(m_options.fullSaveEvery, 1);
+    m_stateCallback = std::move(stateCallback);
+    m_stopping = false;
+
+    signal_handler_t* signals = obs_get_signal_handler();
+    signal_handler_connect(signals, "source_create", sourceCreated, this);
+    signal_handler_connect(signals, "source_destroy", sourceDestroyed, this);
+    signal_handler_connect(signals, "source_remove", sourceEdited, this);
+    signal_handler_connect(signals, "source_rename", sourceRenamed, this);
+
+    // Sources created before the store started
+    auto connectExisting = [](void* param, obs_source_t* source) {
+        static_cast<SceneCollectionStore*>(param)->connectSource(source);
+        return true;
+    };
+    obs_enum_scenes(connectExisting, this);
+    obs_enum_sources(connectExisting, this);
+
+    m_thread = std::thread(&SceneCollectionStore::saverMain, this);
+    log_info("Scene collections: %s (%s, saved %u ms after the last change)", m_options.directory.c_str(),
+             m_options.format == Format::Binary ? "binary" : "json", m_options.debounceMs);
+    return true;
+}
+
+void SceneCollectionStore::stop() {
+    if (!running()) {
+        return;
+    }
+    signal_handler_t* signals = obs_get_signal_handler();
+    signal_handler_disconnect(signals, "source_create", sourceCreated, this);
+    signal_handler_disconnect(signals, "source_destroy", sourceDestroyed, this);
+    signal_handler_disconnect(signals, "source_remove", sourceEdited, this);
+    signal_handler_disconnect(signals, "source_rename", sourceRenamed, this);
+
+    {
+        // The saver writes pending changes before it exits
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+
+    std::vector<obs_source_t*> sources;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        for (auto& entry : m_cache) {
+            sources.push_back(entry.first);
+        }
+    }
+    for (obs_source_t* source : sources) {
+        disconnectSource(source);
+    }
+    clearCache();
+    std::vector<obs_data_t*> settings;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        for (auto& entry : m_cache) {
+            settings.push_back(entry.second.settings);
+        }
+        m_cache.clear();
+    }
+    for (obs_data_t* data : settings) {
+        obs_data_release(data);
+    }
+}
+
+void SceneCollectionStore::setCollection(const std::string& name) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // A save in progress still belongs to the previous collection
+        m_saved.wait(lock, [this] { return !m_saving; });
+        m_collection = name;
+        m_savedChanges = m_changes;
+        m_urgent = false;
+        m_fullRequested = true;
+    }
+    clearCache();
+}
+
+std::string SceneCollectionStore::collection() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_collection;
+}
+
+// =============================================================================
+// Change tracking
+// =============================================================================
+
+void SceneCollectionStore::markDirty() {
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const uint64_t now = platform::getTimestampMillis();
+        first = m_changes == m_savedChanges;
+        if (first) {
+            m_firstChangeMs = now;
+        }
+        m_lastChangeMs = now;
+        ++m_changes;
+    }
+    // Later changes only push the deadline back; the saver re-checks it when it wakes
+    if (first) {
+        m_wake.notify_one();
+    }
+}
+
+void SceneCollectionStore::discardChanges() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_savedChanges = m_changes;
+    m_urgent = false;
+}
+
+void SceneCollectionStore::requestSave() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_changes;
+        m_urgent = true;
+        m_fullRequested = true;
+    }
+    m_wake.notify_one();
+}
+
+void SceneCollectionStore::flush() {
+    if (!running()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_changes == m_savedChanges && !m_saving) {
+        return;
+    }
+    m_urgent = true;
+    m_wake.notify_one();
+    m_saved.wait(lock, [this] { return (m_changes == m_savedChanges && !m_saving) || m_stopping; });
+}
+
+void SceneCollectionStore::deferBegin() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_deferDepth;
+}
+
+void SceneCollectionStore::deferEnd() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_deferDepth > 0) {
+            --m_deferDepth;
+        }
+    }
+    m_wake.notify_one();
+}
+
+void SceneCollectionStore::connectSource(obs_source_t* source) {
+    const obs_source_type type = obs_source_get_type(source);
+    if (type == OBS_SOURCE_TYPE_TRANSITION) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        if (!m_cache.emplace(source, SourceEntry()).second) {
+            return;
+        }
+    }
+    // Normally runs on the thread creating the source, before anything can update it
+    copySettings(source);
+    signal_handler_t* signals = obs_source_get_signal_handler(source);
+    signal_handler_connect(signals, "update", sourceUpdated, this);
+    for (const char* signal : kSourceSignals) {
+        signal_handler_connect(signals, signal, sourceEdited, this);
+    }
+    if (type == OBS_SOURCE_TYPE_SCENE) {
+        for (const char* signal : kSceneSignals) {
+            signal_handler_connect(signals, signal, sourceEdited, this);
+        }
+    }
+}
+
+void SceneCollectionStore::disconnectSource(obs_source_t* source) {
+    signal_handler_t* signals = obs_source_get_signal_handler(source);
+    signal_handler_disconnect(signals, "update", sourceUpdated, this);
+    for (const char* signal : kSourceSignals) {
+        signal_handler_disconnect(signals, signal, sourceEdited, this);
+    }
+    if (obs_source_get_type(source) == OBS_SOURCE_TYPE_SCENE) {
+        for (const char* signal : kSceneSignals) {
+            signal_handler_disconnect(signals, signal, sourceEdited, this);
+        }
+    }
+}
+
+void SceneCollectionStore::copySettings(obs_source_t* source) {
+    obs_data_t* live = obs_source_get_settings(source);
+    obs_data_t* copy = live ? deepCopy(live) : nullptr;
+    obs_data_release(live);
+    obs_data_t* previous = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        auto it = m_cache.find(source);
+        if (it == m_cache.end()) {
+            previous = copy;
+        } else {
+            previous = it->second.settings;
+            it->second.settings = copy;
+        }
+    }
+    obs_data_release(previous);
+}
+
+obs_data_t* SceneCollectionStore::settingsCopy(obs_source_t* source) {
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        auto it = m_cache.find(source);
+        if (it != m_cache.end() && it->second.settings) {
+            obs_data_addref(it->second.settings);
+            return it->second.settings;
+        }
+    }
+    // Not tracked (a filter that predates start()): read the live object
+    obs_data_t* live = obs_source_get_settings(source);
+    obs_data_t* copy = live ? deepCopy(live) : obs_data_create();
+    obs_data_release(live);
+    return copy;
+}
+
+obs_data_t* SceneCollectionStore::copySaved(obs_source_t* source, obs_data_t* saved) {
+    obs_data_t* data = deepCopy(saved, 0, {"settings", "filters"});
+    obs_data_t* settings = settingsCopy(source);
+    obs_data_set_obj(data, "settings", settings);
+    obs_data_release(settings);
+
+    if (obs_data_array_t* filters = obs_data_get_array(saved, "filters")) {
+        obs_data_array_t* filtersCopy = obs_data_array_create();
+        const size_t count = obs_data_array_count(filters);
+        for (size_t i = 0; i < count; ++i) {
+            obs_data_t* item = obs_data_array_item(filters, i);
+            if (!item) {
+                continue;
+            }
+            obs_data_t* itemCopy = deepCopy(item, 1, {"settings"});
+            obs_source_t* filter = obs_source_get_filter_by_name(source, obs_data_get_string(item, "name"));
+            obs_data_t* filterSettings = filter ? settingsCopy(filter) : obs_data_create();
+            obs_data_set_obj(itemCopy, "settings", filterSettings);
+            obs_data_release(filterSettings);
+            obs_source_release(filter);
+            obs_data_array_push_back(filtersCopy, itemCopy);
+            obs_data_release(itemCopy);
+            obs_data_release(item);
+        }
+        obs_data_set_array(data, "filters", filtersCopy);
+        obs_data_array_release(filtersCopy);
+        obs_data_array_release(filters);
+    }
+    return data;
+}
+
+void SceneCollectionStore::sourceChanged(obs_source_t* source) {
+    // Filters are saved inside their parent
+    if (source && obs_source_get_type(source) == OBS_SOURCE_TYPE_FILTER) {
+        source = obs_filter_get_parent(source);
+    }
+    if (source) {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        auto it = m_cache.find(source);
+        if (it != m_cache.end()) {
+            it->second.dirty = true;
+        }
+    }
+    markDirty();
+}
+
+void SceneCollectionStore::sourceCreated(void* param, calldata_t* data) {
+    auto* self = static_cast<SceneCollectionStore*>(param);
+    auto* source = static_cast<obs_source_t*>(calldata_ptr(data, "source"));
+    if (source) {
+        self->connectSource(source);
+        if (obs_source_get_type(source) != OBS_SOURCE_TYPE_TRANSITION) {
+            self->markDirty();
+        }
+    }
+}
+
+void SceneCollectionStore::sourceDestroyed(void* param, calldata_t* data) {
+    auto* self = static_cast<SceneCollectionStore*>(param);
+    auto* source = static_cast<obs_source_t*>(calldata_ptr(data, "source"));
+    obs_data_t* cached = nullptr;
+    obs_data_t* settings = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(self->m_cacheMutex);
+        auto it = self->m_cache.find(source);
+        if (it == self->m_cache.end()) {
+            return;
+        }
+        cached = it->second.data;
+        settings = it->second.settings;
+        self->m_cache.erase(it);
+    }
+    obs_data_release(cached);
+    obs_data_release(settings);
+}
+
+void SceneCollectionStore::sourceRenamed(void* param, calldata_t* data) {
+    auto* self = static_cast<SceneCollectionStore*>(param);
+    {
+        // Scene items refer to their source by name
+        std::lock_guard<std::mutex> lock(self->m_cacheMutex);
+        for (auto& entry : self->m_cache) {
+            if (obs_source_get_type(entry.first) == OBS_SOURCE_TYPE_SCENE) {
+                entry.second.dirty = true;
+            }
+        }
+    }
+    self->sourceChanged(static_cast<obs_source_t*>(calldata_ptr(data, "source")));
+}
+
+void SceneCollectionStore::sourceUpdated(void* param, calldata_t* data) {
+    auto* self = static_cast<SceneCollectionStore*>(param);
+    auto* source = static_cast<obs_source_t*>(calldata_ptr(data, "source"));
+    if (source) {
+        // Emitted on the thread that just applied the settings, so the copy
+        // is taken where the object is written rather than on the saver
+        self->copySettings(source);
+    }
+    self->sourceChanged(source);
+}
+
+void SceneCollectionStore::sourceEdited(void* param, calldata_t* data) {
+    auto* source = static_cast<obs_source_t*>(calldata_ptr(data, "source"));
+    if (!source) {
+        // Scene item signals carry the scene instead
+        auto* scene = static_cast<obs_scene_t*>(calldata_ptr(data, "scene"));
+        source = scene ? obs_scene_get_source(scene) : nullptr;
+    }
+    static_cast<SceneCollectionStore*>(param)->sourceChanged(source);
+}
+
+// =============================================================================
+// Saving
+// =============================================================================
+
+void SceneCollectionStore::saverMain() {
+    platform::setThreadName("scene-saver");
+    Trace::setThreadName("scene-saver");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        if (m_changes == m_savedChanges) {
+            if (m_stopping) {
+                break;
+            }
+            m_wake.wait(lock);
+            continue;
+        }
+        if (!m_urgent && !m_stopping) {
+            if (m_deferDepth > 0) {
+                m_wake.wait(lock);
+                continue;
+            }
+            const uint64_t due = std::min<uint64_t>(m_lastChangeMs + m_options.debounceMs,
+                                                    m_firstChangeMs + m_options.maxDelayMs);
+            const uint64_t now = platform::getTimestampMillis();
+            if (now < due) {
+                m_wake.wait_for(lock, std::chrono::milliseconds(due - now));
+                continue;
+            }
+        }
+
+        const uint64_t changes = m_changes;
+        const bool full = m_fullRequested || m_savesSinceFull + 1 >= m_options.fullSaveEvery;
+        const std::string name = m_collection;
+        m_fullRequested = false;
+        m_urgent = false;
+        m_saving = true;
+        lock.unlock();
+
+        // A failed save is logged and retried on the next change
+        if (!name.empty()) {
+            save(name, full);
+        }
+
+        lock.lock();
+        m_saving = false;
+        m_savesSinceFull = full ? 0 : m_savesSinceFull + 1;
+        m_savedChanges = std::max(m_savedChanges, changes);
+        if (m_changes != m_savedChanges) {
+            // Edits that arrived during the save start a new debounce window
+            m_firstChangeMs = platform::getTimestampMillis();
+        }
+        m_saved.notify_all();
+    }
+}
+
+obs_data_array_t* SceneCollectionStore::snapshotSources(bool full, size_t& reused, size_t& serialized) {
+    std::vector<obs_source_t*> sources;
+    auto collect = [](void* param, obs_source_t* source) {
+        if (!obs_source_removed(source) && obs_source_get_type(source) != OBS_SOURCE_TYPE_TRANSITION) {
+            if (obs_source_t* ref = obs_source_get_ref(source)) {
+                static_cast<std::vector<obs_source_t*>*>(param)->push_back(ref);
+            }
+        }
+        return true;
+    };
+    obs_enum_scenes(collect, &sources);
+    obs_enum_sources(collect, &sources);
+
+    obs_data_array_t* array = obs_data_array_create();
+    for (obs_source_t* source : sources) {
+        // No-op unless the source was created while its signal was in flight
+        connectSource(source);
+        obs_data_t* data = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_cacheMutex);
+            SourceEntry& entry = m_cache[source];
+            if (!full && !entry.dirty && entry.data) {
+                data = entry.data;
+                obs_data_addref(data);
+            } else {
+                // Cleared before serializing: an edit made meanwhile marks it again
+                entry.dirty = false;
+            }
+        }
+        if (data) {
+            ++reused;
+        } else {
+            if (obs_data_t* live = obs_save_source(source)) {
+                data = copySaved(source, live);
+                obs_data_release(live);
+            }
+            ++serialized;
+            obs_data_t* previous = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_cacheMutex);
+                auto it = m_cache.find(source);
+                if (it != m_cache.end() && data) {
+                    previous = it->second.data;
+                    obs_data_addref(data);
+                    it->second.data = data;
+                }
+            }
+            obs_data_release(previous);
+        }
+        if (data) {
+            obs_data_array_push_back(array, data);
+            obs_data_release(data);
+        }
+        obs_source_release(source);
+    }
+    return array;
+}
+
+bool SceneCollectionStore::save(const std::string& name, bool full) {
+    TRACE_SCOPE("scenes", "save_collection");
+    const uint64_t start = platform::getTimestampMicros();
+
+    size_t reused = 0;
+    size_t serialized = 0;
+    obs_data_t* root = obs_data_create();
+    obs_data_set_string(root, "name", name.c_str());
+    obs_data_array_t* sources = snapshotSources(full, reused, serialized);
+    obs_data_set_array(root, "sources", sources);
+    obs_data_array_release(sources);
+    if (m_stateCallback) {
+        m_stateCallback(root);
+    }
+    const uint64_t snapshotDone = platform::getTimestampMicros();
+
+    bool ok;
+    size_t bytes;
+    const std::string path = pathFor(name, m_options.format);
+    if (m_options.format == Format::Binary) {
+        std::vector<uint8_t> encoded;
+        encodeBinary(root, encoded);
+        bytes = encoded.size();
+        ok = writeFileAtomic(path, encoded.data(), encoded.size());
+    } else {
+        const char* json = obs_data_get_json(root);
+        bytes = json ? std::strlen(json) : 0;
+        ok = json && writeFileAtomic(path, json, bytes);
+    }
+    obs_data_release(root);
+    const uint64_t end = platform::getTimestampMicros();
+
+    if (!ok) {
+        log_error("Scene collection '%s': cannot write %s", name.c_str(), path.c_str());
+        return false;
+    }
+    log_debug("Scene collection '%s': %zu sources (%zu re-serialized) snapshot in %.1f ms, %zu KB written in %.1f ms",
+              name.c_str(), reused + serialized, serialized, (snapshotDone - start) / 1000.0, bytes / 1024,
+              (end - snapshotDone) / 1000.0);
+    return true;
+}
+
+void SceneCollectionStore::clearCache() {
+    std::vector<obs_data_t*> released;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        for (auto& entry : m_cache) {
+            released.push_back(entry.second.data);
+            entry.second.data = nullptr;
+            entry.second.dirty = true;
+        }
+    }
+    for (obs_data_t* data : released) {
+        obs_data_release(data);
+    }
+}
+
+// =============================================================================
+// Files
+// =============================================================================
+
+std::string SceneCollectionStore::pathFor(const std::string& name, Format format) const {
+    return platform::joinPath(m_options.directory,
+                              fileStem(name) + (format == Format::Binary ? kBinaryExtension : kJsonExtension));
+}
+
+obs_data_t* SceneCollectionStore::load(const std::string& name) const {
+    const Format other = m_options.format == Format::Binary ? Format::Json : Format::Binary;
+    for (Format format : {m_options.format, other}) {
+        const std::string path = pathFor(name, format);
+        std::vector<uint8_t> bytes;
+        if (!platform::isFile(path) || !readFile(path, bytes)) {
+            continue;
+        }
+
+        const uint64_t start = platform::getTimestampMicros();
+        obs_data_t* data;
+        if (format == Format::Binary) {
+            data = decodeBinary(bytes.data(), bytes.size());
+        } else {
+            bytes.push_back('\0');
+            data = obs_data_create_from_json(reinterpret_cast<const char*>(bytes.data()));
+        }
+        if (!data) {
+            log_error("Scene collection '%s': %s is corrupt, ignoring it", name.c_str(), path.c_str());
+            continue;
+        }
+        log_info("Scene collection '%s': read %zu KB in %.1f ms (%s)", name.c_str(), bytes.size() / 1024,
+                 (platform::getTimestampMicros() - start) / 1000.0, format == Format::Binary ? "binary" : "json");
+        return data;
+    }
+    return nullptr;
+}
+
+bool SceneCollectionStore::exists(const std::string& name) const {
+    return platform::isFile(pathFor(name, Format::Json)) || platform::isFile(pathFor(name, Format::Binary));
+}
+
+std::vector<std::string> SceneCollectionStore::list() const {
+    std::set<std::string> names;
+    for (const char* extension : {kJsonExtension, kBinaryExtension}) {
+        const size_t length = std::strlen(extension);
+        for (const std::string& file : platform::listDirectory(m_options.directory, std::string("*") + extension)) {
+            names.insert(file.substr(0, file.size() - length));
+        }
+    }
+    // File names are sanitized; the open collection is listed by its real name
+    const std::string current = collection();
+    if (!current.empty()) {
+        names.erase(fileStem(current));
+        names.insert(current);
+    }
+    return std::vector<std::string>(names.begin(), names.end());
+}
+
+bool SceneCollectionStore::parseFormat(const std::string& name, Format& format) {
+    if (name == "json") {
+        format = Format::Json;
+    } else if (name == "binary") {
+        format = Format::Binary;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void SceneCollectionStore::encodeBinary(obs_data_t* data, std::vector<uint8_t>& out) {
+    BinaryWriter writer;
+    writer.object(data);
+    writer.finish(out);
+}
+
+obs_data_t* SceneCollectionStore::decodeBinary(const uint8_t* data, size_t size) {
+    if (size < 12 || std::memcmp(data, kMagic, 4) != 0) {
+        return nullptr;
+    }
+    const uint8_t* trailer = data + size - 4;
+    const uint32_t stored = static_cast<uint32_t>(trailer[0]) | static_cast<uint32_t>(trailer[1]) << 8 |
+                            static_cast<uint32_t>(trailer[2]) << 16 | static_cast<uint32_t>(trailer[3]) << 24;
+    const uint32_t version = static_cast<uint32_t>(data[4]) | static_cast<uint32_t>(data[5]) << 8 |
+                             static_cast<uint32_t>(data[6]) << 16 | static_cast<uint32_t>(data[7]) << 24;
+    if (version != kBinaryVersion || stored != fnv1a(data, size - 4)) {
+        return nullptr;
+    }
+
+    BinaryReader reader(data + 8, trailer);
+    if (!reader.keys()) {
+        return nullptr;
+    }
+    obs_data_t* root = reader.object(0);
+    if (root && !reader.atEnd()) {
+        obs_data_release(root);
+        return nullptr;
+    }
+    return root;
+}
+
+} // namespace streamlumo
@@ -0,0 +1,160 @@
+// streamlumo-engine/src/scene_collection_store.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <obs.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Scene collection persistence with debounced background saves
+ *
+ * Changes are tracked from libobs signals (sources created, removed,
+ * renamed, updated, filters and scene items edited) and from
+ * markDirty(). A save starts once edits have been quiet for
+ * Options::debounceMs, or Options::maxDelayMs after the first unsaved edit,
+ * so a burst of WebSocket requests costs one save.
+ *
+ * Saves run on the "scene-saver" thread. The snapshot is an obs_data tree in
+ * which each source's entry is cached and reused until a signal marks that
+ * source changed, so a save only re-serializes what was edited. Cached
+ * entries are never modified once built, so the snapshot stays immutable
+ * while it is serialized and written (temporary file + rename).
+ *
+ * obs_source_update() edits a source's settings in place on whatever thread
+ * handles the request, and nothing serializes that with the saver. So the
+ * saver never walks live settings: each source's (and filter's) settings
+ * are copied by its "update" handler, on the thread that just wrote them,
+ * and the snapshot embeds that copy.
+ *
+ * Collections live in Options::directory as "<name>.json" (obs_data JSON,
+ * readable by OBS) or "<name>.slsc", a compact binary encoding of the same
+ * tree that loads without JSON parsing (layout in scene_collection_store.cpp).
+ */
+class SceneCollectionStore {
+public:
+    enum class Format { Json, Binary };
+
+    struct Options {
+        std::string directory;
+        Format format = Format::Json;
+        uint32_t debounceMs = 1000;     // Quiet time after the last edit
+        uint32_t maxDelayMs = 5000;     // Longest a stream of edits can hold back a save
+        uint32_t fullSaveEvery = 20;    // Re-serialize every source on every Nth save
+    };
+
+    // Adds frontend state (current scene, transition, plugin data) to the
+    // snapshot root; runs on the saver thread
+    using StateCallback = std::function<void(obs_data_t* root)>;
+
+    SceneCollectionStore() = default;
+    ~SceneCollectionStore();
+
+    SceneCollectionStore(const SceneCollectionStore&) = delete;
+    SceneCollectionStore& operator=(const SceneCollectionStore&) = delete;
+
+    // Requires obs_startup(); call stop() before obs_shutdown()
+    bool start(const Options& options, StateCallback stateCallback);
+    // Writes any unsaved changes first
+    void stop();
+    bool running() const { return m_thread.joinable(); }
+
+    // Saves go to this collection from now on; drops unsaved changes and the source cache
+    void setCollection(const std::string& name);
+    std::string collection() const;
+
+    // Collection-level change (current scene, transition, ...)
+    void markDirty();
+    // Forget unsaved changes, e.g. right after loading the collection
+    void discardChanges();
+    // Save everything now, without waiting for the debounce
+    void requestSave();
+    // Block until every change so far is on disk
+    void flush();
+
+    // obs_frontend_defer_save_begin/end: saves are held while the depth is > 0
+    void deferBegin();
+    void deferEnd();
+
+    /**
+     * @brief Read a saved collection (the configured format first, then the other)
+     * @return New reference, or nullptr if there is none or it is unreadable
+     */
+    obs_data_t* load(const std::string& name) const;
+    bool exists(const std::string& name) const;
+    std::vector<std::string> list() const;
+
+    // "json" / "binary"
+    static bool parseFormat(const std::string& name, Format& format);
+
+    // Binary codec for obs_data trees (user values only, like the JSON writer)
+    static void encodeBinary(obs_data_t* data, std::vector<uint8_t>& out);
+    static obs_data_t* decodeBinary(const uint8_t* data, size_t size);
+
+private:
+    struct SourceEntry {
+        obs_data_t* data = nullptr;     // Deep copy of the last serialized state; immutable once stored
+        obs_data_t* settings = nullptr; // Copy of the settings, taken on the updating thread
+        bool dirty = true;
+    };
+
+    std::string pathFor(const std::string& name, Format format) const;
+
+    // libobs signal handlers (global "source_*" and per-source edits)
+    static void sourceCreated(void* param, calldata_t* data);
+    static void sourceDestroyed(void* param, calldata_t* data);
+    static void sourceRenamed(void* param, calldata_t* data);
+    static void sourceUpdated(void* param, calldata_t* data);
+    static void sourceEdited(void* param, calldata_t* data);
+    void connectSource(obs_source_t* source);
+    void disconnectSource(obs_source_t* source);
+    void sourceChanged(obs_source_t* source);
+    void copySettings(obs_source_t* source);
+    // New reference: the settings copy, or a copy of the live object if there is none
+    obs_data_t* settingsCopy(obs_source_t* source);
+    // obs_save_source() output with the settings copies in place of the live objects
+    obs_data_t* copySaved(obs_source_t* source, obs_data_t* saved);
+
+    void saverMain();
+    bool save(const std::string& name, bool full);
+    obs_data_array_t* snapshotSources(bool full, size_t& reused, size_t& serialized);
+    void clearCache();
+
+    Options m_options;
+    StateCallback m_stateCallback;
+
+    // Scheduling, shared with the saver thread
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_saved;
+    std::string m_collection;
+    uint64_t m_changes = 0;             // Bumped per change; saved when m_savedChanges catches up
+    uint64_t m_savedChanges = 0;
+    uint64_t m_firstChangeMs = 0;       // First unsaved change
+    uint64_t m_lastChangeMs = 0;
+    bool m_urgent = false;              // requestSave()/flush(): no debounce, ignore deferral
+    bool m_fullRequested = false;
+    int m_deferDepth = 0;
+    bool m_saving = false;
+    bool m_stopping = false;
+    uint32_t m_savesSinceFull = 0;
+
+    // Per-source snapshot cache, keyed by the live source
+    std::mutex m_cacheMutex;
+    std::unordered_map<obs_source_t*, SourceEntry> m_cache;
+
+    std::thread m_thread;
+};
+
+} // namespace streamlumo
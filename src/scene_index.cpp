@@ -0,0 +1,275 @@
+// streamlumo-engine/src/scene_index.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "scene_index.h"
+
+#include <algorithm>
+
+namespace streamlumo {
+
+namespace {
+
+// obs_frontend_get_scenes lists the main canvas only; canvas scenes belong to their canvas.
+// A source created before its canvas is assigned counts as the main canvas's.
+bool onMainCanvas(obs_source_t* source) {
+    obs_canvas_t* canvas = obs_source_get_canvas(source);
+    if (!canvas) {
+        return true;
+    }
+    obs_canvas_t* main = obs_get_main_canvas();
+    const bool same = canvas == main;
+    obs_canvas_release(main);
+    obs_canvas_release(canvas);
+    return same;
+}
+
+} // namespace
+
+SceneIndex::~SceneIndex() {
+    stop();
+}
+
+void SceneIndex::start(ChangeCallback callback) {
+    if (m_started) {
+        return;
+    }
+    m_callback = std::move(callback);
+
+    // Connect first: a source created during the enumeration is caught by
+    // one or the other, and insert() ignores the duplicate
+    signal_handler_t* handler = obs_get_signal_handler();
+    signal_handler_connect(handler, "source_create", &SceneIndex::sourceCreated, this);
+    signal_handler_connect(handler, "source_remove", &SceneIndex::sourceRemoved, this);
+    signal_handler_connect(handler, "source_destroy", &SceneIndex::sourceRemoved, this);
+    signal_handler_connect(handler, "source_rename", &SceneIndex::sourceRenamed, this);
+    m_started = true;
+
+    auto existing = [](void* param, obs_source_t* source) {
+        List list;
+        static_cast<SceneIndex*>(param)->insert(source, list);
+        return true;
+    };
+    obs_enum_all_sources(existing, this);
+}
+
+void SceneIndex::stop() {
+    if (!m_started) {
+        return;
+    }
+    signal_handler_t* handler = obs_get_signal_handler();
+    signal_handler_disconnect(handler, "source_create", &SceneIndex::sourceCreated, this);
+    signal_handler_disconnect(handler, "source_remove", &SceneIndex::sourceRemoved, this);
+    signal_handler_disconnect(handler, "source_destroy", &SceneIndex::sourceRemoved, this);
+    signal_handler_disconnect(handler, "source_rename", &SceneIndex::sourceRenamed, this);
+    m_started = false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& [source, entry] : m_entries) {
+        obs_weak_source_release(entry.weak);
+    }
+    m_entries.clear();
+    m_scenes.clear();
+    m_transitions.clear();
+    m_sceneNames.clear();
+}
+
+std::vector<obs_source_t*> SceneIndex::scenes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return refs(m_scenes);
+}
+
+std::vector<obs_source_t*> SceneIndex::transitions() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return refs(m_transitions);
+}
+
+obs_source_t* SceneIndex::findScene(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto named = m_sceneNames.find(name);
+    if (named == m_sceneNames.end()) {
+        return nullptr;
+    }
+    auto entry = m_entries.find(named->second);
+    return entry != m_entries.end() ? obs_weak_source_get_source(entry->second.weak) : nullptr;
+}
+
+void SceneIndex::reorderScenes(const std::vector<std::string>& names) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unordered_map<obs_source_t*, size_t> positions;
+        for (size_t i = 0; i < m_scenes.size(); i++) {
+            positions.emplace(m_scenes[i], i);
+        }
+
+        std::vector<obs_source_t*> ordered;
+        ordered.reserve(m_scenes.size());
+        std::vector<bool> placed(m_scenes.size(), false);
+        for (const std::string& name : names) {
+            auto named = m_sceneNames.find(name);
+            if (named == m_sceneNames.end()) {
+                continue;
+            }
+            auto position = positions.find(named->second);
+            if (position != positions.end() && !placed[position->second]) {
+                placed[position->second] = true;
+                ordered.push_back(m_scenes[position->second]);
+            }
+        }
+        for (size_t i = 0; i < m_scenes.size(); i++) {
+            if (!placed[i]) {
+                ordered.push_back(m_scenes[i]);
+            }
+        }
+        m_scenes.swap(ordered);
+    }
+    notify(List::Scenes);
+}
+
+void SceneIndex::add(obs_source_t* source) {
+    List list;
+    if (insert(source, list)) {
+        notify(list);
+    }
+}
+
+void SceneIndex::sourceCreated(void* param, calldata_t* data) {
+    auto* self = static_cast<SceneIndex*>(param);
+    List list;
+    if (self->insert(static_cast<obs_source_t*>(calldata_ptr(data, "source")), list)) {
+        self->notify(list);
+    }
+}
+
+void SceneIndex::sourceRemoved(void* param, calldata_t* data) {
+    auto* self = static_cast<SceneIndex*>(param);
+    List list;
+    if (self->erase(static_cast<obs_source_t*>(calldata_ptr(data, "source")), list)) {
+        self->notify(list);
+    }
+}
+
+void SceneIndex::sourceRenamed(void* param, calldata_t* data) {
+    auto* self = static_cast<SceneIndex*>(param);
+    auto* source = static_cast<obs_source_t*>(calldata_ptr(data, "source"));
+    const char* previous = calldata_string(data, "prev_name");
+    const char* name = calldata_string(data, "new_name");
+    if (!source || !name) {
+        return;
+    }
+
+    List list;
+    {
+        std::lock_guard<std::mutex> lock(self->m_mutex);
+        auto entry = self->m_entries.find(source);
+        if (entry == self->m_entries.end()) {
+            return;
+        }
+        list = entry->second.list;
+        if (list == List::Scenes) {
+            auto named = previous ? self->m_sceneNames.find(previous) : self->m_sceneNames.end();
+            if (named != self->m_sceneNames.end() && named->second == source) {
+                self->m_sceneNames.erase(named);
+            }
+            self->m_sceneNames[name] = source;
+        }
+    }
+    self->notify(list);
+}
+
+bool SceneIndex::insert(obs_source_t* source, List& list) {
+    if (!source) {
+        return false;
+    }
+    const obs_source_type type = obs_source_get_type(source);
+    if (type == OBS_SOURCE_TYPE_SCENE) {
+        if (!onMainCanvas(source)) {
+            return false;
+        }
+        list = List::Scenes;
+    } else if (type == OBS_SOURCE_TYPE_TRANSITION) {
+        list = List::Transitions;
+    } else {
+        return false;
+    }
+
+    obs_weak_source_t* weak = obs_source_get_weak_source(source);
+    const char* name = obs_source_get_name(source);
+    obs_weak_source_t* stale = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto entry = m_entries.find(source);
+        if (entry != m_entries.end()) {
+            // A private source added through add() is never signalled gone, so a
+            // new source can reuse its address; the dead entry gives way
+            if (!obs_weak_source_expired(entry->second.weak)) {
+                obs_weak_source_release(weak);
+                return false;
+            }
+            stale = entry->second.weak;
+            unlink(source, entry->second.list);
+            m_entries.erase(entry);
+        }
+        m_entries.emplace(source, Entry{weak, list});
+        if (list == List::Scenes) {
+            m_scenes.push_back(source);
+            if (name) {
+                m_sceneNames[name] = source;
+            }
+        } else {
+            m_transitions.push_back(source);
+        }
+    }
+    obs_weak_source_release(stale);
+    return true;
+}
+
+bool SceneIndex::erase(obs_source_t* source, List& list) {
+    obs_weak_source_t* weak;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto entry = m_entries.find(source);
+        if (entry == m_entries.end()) {
+            return false;
+        }
+        weak = entry->second.weak;
+        list = entry->second.list;
+        m_entries.erase(entry);
+        unlink(source, list);
+    }
+    obs_weak_source_release(weak);
+    return true;
+}
+
+void SceneIndex::unlink(obs_source_t* source, List list) {
+    std::vector<obs_source_t*>& order = list == List::Scenes ? m_scenes : m_transitions;
+    order.erase(std::find(order.begin(), order.end(), source));
+    if (list == List::Scenes) {
+        for (auto named = m_sceneNames.begin(); named != m_sceneNames.end(); ++named) {
+            if (named->second == source) {
+                m_sceneNames.erase(named);
+                break;
+            }
+        }
+    }
+}
+
+void SceneIndex::notify(List list) {
+    if (m_callback) {
+        m_callback(list);
+    }
+}
+
+std::vector<obs_source_t*> SceneIndex::refs(const std::vector<obs_source_t*>& order) const {
+    std::vector<obs_source_t*> sources;
+    sources.reserve(order.size());
+    for (obs_source_t* key : order) {
+        // nullptr once the last strong reference is gone, before "source_destroy" reaches us
+        if (obs_source_t* source = obs_weak_source_get_source(m_entries.at(key).weak)) {
+            sources.push_back(source);
+        }
+    }
+    return sources;
+}
+
+} // namespace streamlumo
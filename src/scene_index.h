@@ -0,0 +1,93 @@
+// streamlumo-engine/src/scene_index.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <obs.h>
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Ordered list of the main canvas's scenes and of transitions
+ *
+ * Kept up to date from the libobs "source_create", "source_remove",
+ * "source_destroy" and "source_rename" signals, so listing the scenes is a
+ * copy of this index instead of obs_enum_scenes(), which walks every
+ * public source under the global sources lock. Scenes are in creation
+ * order until reorderScenes() applies a saved order. Entries hold weak
+ * references; a source is only returned while it is still alive.
+ *
+ * The index only sees public sources (libobs signals nothing for private
+ * ones). add() covers a transition the frontend is handed that was never
+ * signalled; since its destruction is never signalled either, its entry
+ * stays until a new source reuses the address and replaces it.
+ */
+class SceneIndex {
+public:
+    enum class List { Scenes, Transitions };
+
+    // Called after a list gained, lost or renamed an entry; runs on the
+    // thread that changed the source
+    using ChangeCallback = std::function<void(List list)>;
+
+    SceneIndex() = default;
+    ~SceneIndex();
+
+    SceneIndex(const SceneIndex&) = delete;
+    SceneIndex& operator=(const SceneIndex&) = delete;
+
+    // Requires obs_startup(); indexes existing sources; call stop() before obs_shutdown()
+    void start(ChangeCallback callback);
+    void stop();
+
+    // New references, in list order; release each with obs_source_release()
+    std::vector<obs_source_t*> scenes() const;
+    std::vector<obs_source_t*> transitions() const;
+
+    // New reference, or nullptr
+    obs_source_t* findScene(const std::string& name) const;
+
+    // Named scenes first, in the given order; the rest keep their order after them
+    void reorderScenes(const std::vector<std::string>& names);
+
+    // Adds a public or private scene/transition source if it is not indexed yet
+    void add(obs_source_t* source);
+
+private:
+    struct Entry {
+        obs_weak_source_t* weak;
+        List list;
+    };
+
+    static void sourceCreated(void* param, calldata_t* data);
+    static void sourceRemoved(void* param, calldata_t* data);
+    static void sourceRenamed(void* param, calldata_t* data);
+
+    // false if the source is not a main-canvas scene or a transition, or already indexed
+    bool insert(obs_source_t* source, List& list);
+    bool erase(obs_source_t* source, List& list);
+    // Drops the source from its list order and the scene names; m_mutex held
+    void unlink(obs_source_t* source, List list);
+    void notify(List list);
+
+    std::vector<obs_source_t*> refs(const std::vector<obs_source_t*>& order) const;
+
+    ChangeCallback m_callback;
+    bool m_started = false;
+
+    mutable std::mutex m_mutex;
+    // Keys identify sources only; never dereferenced once removed
+    std::unordered_map<obs_source_t*, Entry> m_entries;
+    std::vector<obs_source_t*> m_scenes;        // List order
+    std::vector<obs_source_t*> m_transitions;
+    std::unordered_map<std::string, obs_source_t*> m_sceneNames;
+};
+
+} // namespace streamlumo
@@ -0,0 +1,562 @@
+// streamlumo-engine/src/screenshot_service.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "screenshot_service.h"
+#include "logging.h"
+#include "platform/platform.h"
+#include "trace.h"
+
+#include <graphics/graphics.h>
+#include <graphics/vec4.h>
+
+#ifdef HAS_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace streamlumo {
+
+namespace {
+
+constexpr uint32_t kMaxDimension = 8192;
+
+#ifdef HAS_FFMPEG
+
+struct CodecContextDeleter {
+    void operator()(AVCodecContext* context) const { avcodec_free_context(&context); }
+};
+struct FrameDeleter {
+    void operator()(AVFrame* frame) const { av_frame_free(&frame); }
+};
+struct PacketDeleter {
+    void operator()(AVPacket* packet) const { av_packet_free(&packet); }
+};
+
+// RGBA pixels (tightly packed) -> encoded image
+bool encodeImage(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height,
+                 ScreenshotService::Format format, int quality, std::vector<uint8_t>& out) {
+    const AVCodec* codec = nullptr;
+    AVPixelFormat pixelFormat = AV_PIX_FMT_RGBA;
+    switch (format) {
+    case ScreenshotService::Format::Png:
+        codec = avcodec_find_encoder(AV_CODEC_ID_PNG);
+        break;
+    case ScreenshotService::Format::Jpeg:
+        codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+        pixelFormat = AV_PIX_FMT_YUVJ420P;
+        break;
+    case ScreenshotService::Format::WebP:
+        codec = avcodec_find_encoder_by_name("libwebp");
+        pixelFormat = AV_PIX_FMT_YUVA420P;
+        break;
+    }
+    if (!codec) {
+        log_error("Screenshots: no %s encoder in this FFmpeg build", ScreenshotService::extension(format));
+        return false;
+    }
+
+    std::unique_ptr<AVCodecContext, CodecContextDeleter> context(avcodec_alloc_context3(codec));
+    std::unique_ptr<AVFrame, FrameDeleter> frame(av_frame_alloc());
+    std::unique_ptr<AVPacket, PacketDeleter> packet(av_packet_alloc());
+    if (!context || !frame || !packet) {
+        return false;
+    }
+    context->width = static_cast<int>(width);
+    context->height = static_cast<int>(height);
+    context->pix_fmt = pixelFormat;
+    context->time_base = AVRational{1, 1};
+    if (format == ScreenshotService::Format::Jpeg) {
+        context->color_range = AVCOL_RANGE_JPEG;
+    }
+    if (quality >= 0 && format != ScreenshotService::Format::Png) {
+        quality = std::min(quality, 100);
+        // MJPEG takes a quantiser (2 best .. 31 worst), libwebp a 0-100 quality
+        const int scale = format == ScreenshotService::Format::Jpeg ? 2 + (100 - quality) * 29 / 100 : quality;
+        context->flags |= AV_CODEC_FLAG_QSCALE;
+        context->global_quality = scale * FF_QP2LAMBDA;
+        frame->quality = context->global_quality;
+    }
+    if (avcodec_open2(context.get(), codec, nullptr) < 0) {
+        log_error("Screenshots: cannot open the %s encoder", ScreenshotService::extension(format));
+        return false;
+    }
+
+    frame->format = pixelFormat;
+    frame->width = context->width;
+    frame->height = context->height;
+    if (av_frame_get_buffer(frame.get(), 0) < 0) {
+        return false;
+    }
+    const uint8_t* source[1] = {pixels.data()};
+    const int sourceLinesize[1] = {static_cast<int>(width * 4)};
+    if (pixelFormat == AV_PIX_FMT_RGBA) {
+        av_image_copy_plane(frame->data[0], frame->linesize[0], source[0], sourceLinesize[0],
+                            sourceLinesize[0], context->height);
+    } else {
+        SwsContext* sws = sws_getContext(context->width, context->height, AV_PIX_FMT_RGBA, context->width,
+                                         context->height, pixelFormat, SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws) {
+            return false;
+        }
+        sws_scale(sws, source, sourceLinesize, 0, context->height, frame->data, frame->linesize);
+        sws_freeContext(sws);
+    }
+
+    if (avcodec_send_frame(context.get(), frame.get()) < 0 || avcodec_send_frame(context.get(), nullptr) < 0 ||
+        avcodec_receive_packet(context.get(), packet.get()) < 0) {
+        return false;
+    }
+    out.assign(packet->data, packet->data + packet->size);
+    return true;
+}
+
+#else
+
+bool encodeImage(const std::vector<uint8_t>&, uint32_t, uint32_t, ScreenshotService::Format, int,
+                 std::vector<uint8_t>&) {
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true)) {
+        log_error("Screenshots: engine built without FFmpeg, images cannot be encoded");
+    }
+    return false;
+}
+
+#endif
+
+bool writeImage(const std::string& path, const std::vector<uint8_t>& data) {
+    platform::FileHandle file = platform::openFileForWrite(path, false);
+    if (file == platform::kInvalidFile) {
+        return false;
+    }
+    const bool ok = platform::writeFile(file, data.data(), data.size());
+    platform::closeFile(file);
+    return ok;
+}
+
+} // namespace
+
+struct ScreenshotService::Surface {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    gs_texrender_t* texrender = nullptr;
+    gs_stagesurf_t* stage = nullptr;
+    bool busy = false;
+};
+
+struct ScreenshotService::Capture {
+    ~Capture() { obs_weak_source_release(weakSource); }
+
+    Request request;
+    Callback callback;
+    obs_weak_source_t* weakSource = nullptr;    // nullptr = program output
+    Surface* surface = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t ticksWaited = 0;
+};
+
+struct ScreenshotService::Job {
+    std::unique_ptr<Capture> capture;
+    std::vector<uint8_t> pixels;                // Tightly packed RGBA; empty = capture failed
+};
+
+ScreenshotService::ScreenshotService() = default;
+
+ScreenshotService::~ScreenshotService() {
+    stop();
+}
+
+bool ScreenshotService::start(const Options& options) {
+    if (m_running) {
+        return true;
+    }
+    m_options = options;
+    m_options.workers = std::max<size_t>(m_options.workers, 1);
+    m_options.maxSurfaces = std::max<size_t>(m_options.maxSurfaces, 1);
+    m_options.readbackDelayTicks = std::max<uint32_t>(m_options.readbackDelayTicks, 1);
+
+    m_stopping = false;
+    for (size_t i = 0; i < m_options.workers; i++) {
+        m_workers.emplace_back(&ScreenshotService::workerMain, this);
+    }
+    obs_add_tick_callback(&ScreenshotService::tickCallback, this);
+    m_running = true;
+    log_info("Screenshots: started (%zu workers, %zu staging surfaces)", m_options.workers, m_options.maxSurfaces);
+    return true;
+}
+
+void ScreenshotService::stop() {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+
+    // Once removed, no tick is running and none will start
+    obs_remove_tick_callback(&ScreenshotService::tickCallback, this);
+
+    std::vector<std::unique_ptr<Capture>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& capture : m_pending) {
+            abandoned.push_back(std::move(capture));
+        }
+        m_pending.clear();
+    }
+    for (auto& capture : m_inFlight) {
+        abandoned.push_back(std::move(capture));
+    }
+    m_inFlight.clear();
+    for (auto& capture : abandoned) {
+        auto job = std::make_unique<Job>();
+        job->capture = std::move(capture);
+        queueJob(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_stopping = true;
+    }
+    m_jobReady.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    obs_enter_graphics();
+    destroySurfaces();
+    obs_leave_graphics();
+
+    const Stats stats = this->stats();
+    if (stats.captures > 0) {
+        log_info("Screenshots: %llu captures (%llu failed), graphics thread avg %.2f ms max %.2f ms per tick, "
+                 "encode avg %.2f ms",
+                 static_cast<unsigned long long>(stats.captures), static_cast<unsigned long long>(stats.failures),
+                 stats.busyTicks ? stats.totalTickMicros / 1000.0 / stats.busyTicks : 0.0,
+                 stats.maxTickMicros / 1000.0, stats.totalEncodeMicros / 1000.0 / stats.captures);
+    }
+}
+
+bool ScreenshotService::request(Request request, Callback callback) {
+    if (!m_running) {
+        return false;
+    }
+    auto capture = std::make_unique<Capture>();
+    if (request.source) {
+        capture->weakSource = obs_source_get_weak_source(request.source);
+        request.source = nullptr;
+    }
+    capture->request = std::move(request);
+    capture->callback = std::move(callback);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending.size() >= m_options.maxPending) {
+        log_warn("Screenshots: %zu captures waiting, request dropped", m_pending.size());
+        return false;
+    }
+    m_pending.push_back(std::move(capture));
+    return true;
+}
+
+ScreenshotService::Stats ScreenshotService::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+bool ScreenshotService::parseFormat(const std::string& name, Format& format) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lower == "png") {
+        format = Format::Png;
+    } else if (lower == "jpg" || lower == "jpeg") {
+        format = Format::Jpeg;
+    } else if (lower == "webp") {
+        format = Format::WebP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ScreenshotService::extension(Format format) {
+    switch (format) {
+    case Format::Jpeg: return "jpg";
+    case Format::WebP: return "webp";
+    case Format::Png: break;
+    }
+    return "png";
+}
+
+void ScreenshotService::tickCallback(void* param, float) {
+    static_cast<ScreenshotService*>(param)->tick();
+}
+
+void ScreenshotService::tick() {
+    bool pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pending = !m_pending.empty();
+    }
+    if (!pending && m_inFlight.empty()) {
+        return;
+    }
+
+    TRACE_SCOPE("graphics", "screenshot_tick");
+    const uint64_t start = platform::getTimestampMicros();
+    obs_enter_graphics();
+
+    // Readbacks first, so their surfaces can be reused by this tick's captures
+    for (auto it = m_inFlight.begin(); it != m_inFlight.end();) {
+        Capture& capture = **it;
+        if (++capture.ticksWaited < m_options.readbackDelayTicks) {
+            ++it;
+            continue;
+        }
+        auto job = std::make_unique<Job>();
+        readback(capture, job->pixels);
+        job->capture = std::move(*it);
+        it = m_inFlight.erase(it);
+        queueJob(std::move(job));
+    }
+
+    std::vector<std::unique_ptr<Capture>> incoming;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Each capture in flight holds one surface until its readback
+        while (!m_pending.empty() && m_inFlight.size() + incoming.size() < m_options.maxSurfaces) {
+            incoming.push_back(std::move(m_pending.front()));
+            m_pending.pop_front();
+        }
+    }
+    for (auto& capture : incoming) {
+        if (render(*capture)) {
+            m_inFlight.push_back(std::move(capture));
+            continue;
+        }
+        // Failed captures still go through the workers so callbacks never run here
+        auto job = std::make_unique<Job>();
+        job->capture = std::move(capture);
+        queueJob(std::move(job));
+    }
+
+    obs_leave_graphics();
+
+    const uint64_t micros = platform::getTimestampMicros() - start;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.busyTicks++;
+    m_stats.totalTickMicros += micros;
+    m_stats.maxTickMicros = std::max(m_stats.maxTickMicros, micros);
+}
+
+bool ScreenshotService::render(Capture& capture) {
+    obs_source_t* source = nullptr;
+    uint32_t baseWidth = 0;
+    uint32_t baseHeight = 0;
+    if (capture.weakSource) {
+        source = obs_weak_source_get_source(capture.weakSource);
+        if (!source) {
+            return false;
+        }
+        baseWidth = obs_source_get_width(source);
+        baseHeight = obs_source_get_height(source);
+    } else {
+        obs_video_info ovi = {};
+        if (obs_get_video_info(&ovi)) {
+            baseWidth = ovi.base_width;
+            baseHeight = ovi.base_height;
+        }
+    }
+    if (baseWidth == 0 || baseHeight == 0) {
+        obs_source_release(source);
+        return false;
+    }
+
+    uint32_t width = capture.request.width;
+    uint32_t height = capture.request.height;
+    if (width == 0 && height == 0) {
+        width = baseWidth;
+        height = baseHeight;
+    } else if (height == 0) {
+        height = static_cast<uint32_t>(static_cast<uint64_t>(baseHeight) * width / baseWidth);
+    } else if (width == 0) {
+        width = static_cast<uint32_t>(static_cast<uint64_t>(baseWidth) * height / baseHeight);
+    }
+    capture.width = std::clamp<uint32_t>(width, 1, kMaxDimension);
+    capture.height = std::clamp<uint32_t>(height, 1, kMaxDimension);
+
+    Surface* surface = acquireSurface(capture.width, capture.height);
+    if (!surface) {
+        obs_source_release(source);
+        return false;
+    }
+
+    bool rendered = false;
+    gs_texrender_reset(surface->texrender);
+    if (gs_texrender_begin(surface->texrender, capture.width, capture.height)) {
+        vec4 clear;
+        vec4_zero(&clear);
+        gs_clear(GS_CLEAR_COLOR, &clear, 0.0f, 0);
+        // The projection maps the source's own size onto the surface, so scaling is free
+        gs_ortho(0.0f, static_cast<float>(baseWidth), 0.0f, static_cast<float>(baseHeight), -100.0f, 100.0f);
+        gs_blend_state_push();
+        gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+        if (source) {
+            obs_source_inc_showing(source);
+            obs_source_video_render(source);
+            obs_source_dec_showing(source);
+        } else {
+            obs_render_main_texture();
+        }
+        gs_blend_state_pop();
+        gs_texrender_end(surface->texrender);
+
+        // Queues the GPU copy; mapped by a later tick
+        gs_stage_texture(surface->stage, gs_texrender_get_texture(surface->texrender));
+        rendered = true;
+    }
+    obs_source_release(source);
+
+    if (!rendered) {
+        return false;
+    }
+    surface->busy = true;
+    capture.surface = surface;
+    capture.ticksWaited = 0;
+    return true;
+}
+
+void ScreenshotService::readback(Capture& capture, std::vector<uint8_t>& pixels) {
+    Surface* surface = capture.surface;
+    capture.surface = nullptr;
+
+    uint8_t* data = nullptr;
+    uint32_t linesize = 0;
+    if (gs_stagesurface_map(surface->stage, &data, &linesize)) {
+        const size_t rowBytes = static_cast<size_t>(capture.width) * 4;
+        pixels.resize(rowBytes * capture.height);
+        for (uint32_t y = 0; y < capture.height; y++) {
+            memcpy(pixels.data() + y * rowBytes, data + static_cast<size_t>(y) * linesize, rowBytes);
+        }
+        gs_stagesurface_unmap(surface->stage);
+    }
+    surface->busy = false;
+}
+
+ScreenshotService::Surface* ScreenshotService::acquireSurface(uint32_t width, uint32_t height) {
+    Surface* reuse = nullptr;
+    for (auto& surface : m_surfaces) {
+        if (surface->busy) {
+            continue;
+        }
+        if (surface->width == width && surface->height == height) {
+            return surface.get();
+        }
+        reuse = surface.get();
+    }
+
+    if (!reuse && m_surfaces.size() >= m_options.maxSurfaces) {
+        return nullptr;
+    }
+    if (!reuse) {
+        m_surfaces.push_back(std::make_unique<Surface>());
+        reuse = m_surfaces.back().get();
+    }
+
+    // Replace a free surface of another size (or fill a new slot)
+    gs_texrender_destroy(reuse->texrender);
+    gs_stagesurface_destroy(reuse->stage);
+    reuse->width = width;
+    reuse->height = height;
+    reuse->texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+    reuse->stage = gs_stagesurface_create(width, height, GS_RGBA);
+    if (!reuse->texrender || !reuse->stage) {
+        log_error("Screenshots: cannot create a %ux%u staging surface", width, height);
+        gs_texrender_destroy(reuse->texrender);
+        gs_stagesurface_destroy(reuse->stage);
+        reuse->texrender = nullptr;
+        reuse->stage = nullptr;
+        reuse->width = 0;
+        reuse->height = 0;
+        return nullptr;
+    }
+    return reuse;
+}
+
+void ScreenshotService::destroySurfaces() {
+    for (auto& surface : m_surfaces) {
+        gs_texrender_destroy(surface->texrender);
+        gs_stagesurface_destroy(surface->stage);
+    }
+    m_surfaces.clear();
+}
+
+void ScreenshotService::queueJob(std::unique_ptr<Job> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_jobReady.notify_one();
+}
+
+void ScreenshotService::workerMain() {
+    platform::setThreadName("screenshot");
+    Trace::setThreadName("screenshot");
+
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobReady.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                break;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        encode(*job);
+    }
+}
+
+void ScreenshotService::encode(Job& job) {
+    Capture& capture = *job.capture;
+    Result result;
+    result.width = capture.width;
+    result.height = capture.height;
+
+    const uint64_t start = platform::getTimestampMicros();
+    if (!job.pixels.empty()) {
+        TRACE_SCOPE("screenshot", "encode");
+        result.success = encodeImage(job.pixels, capture.width, capture.height, capture.request.format,
+                                     capture.request.quality, result.data);
+    }
+    if (result.success && !capture.request.path.empty()) {
+        result.path = capture.request.path;
+        if (!writeImage(result.path, result.data)) {
+            log_error("Screenshots: cannot write %s", result.path.c_str());
+            result.success = false;
+        }
+    }
+    const uint64_t micros = platform::getTimestampMicros() - start;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.captures++;
+        m_stats.totalEncodeMicros += micros;
+        if (!result.success) {
+            m_stats.failures++;
+        }
+    }
+    if (capture.callback) {
+        capture.callback(std::move(result));
+    }
+}
+
+} // namespace streamlumo
@@ -0,0 +1,133 @@
+// streamlumo-engine/src/screenshot_service.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <obs.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Program and source screenshots without stalling the render thread
+ *
+ * Captures run from a libobs tick callback on the graphics thread. A tick
+ * renders the source into a pooled texrender and queues a copy into a
+ * pooled staging surface; the surface is mapped a few ticks later, once
+ * the GPU has finished the copy, so the map never waits on the GPU. The
+ * pixels are then handed to a small worker pool for colour conversion and
+ * PNG / JPEG / WebP encoding (FFmpeg), and optionally written to a file.
+ *
+ * Scaling to the requested size happens in the render pass, which also
+ * shrinks the readback. Surfaces are reused across ticks for the same size,
+ * so a UI polling thumbnails of many sources allocates nothing per frame.
+ */
+class ScreenshotService {
+public:
+    enum class Format { Png, Jpeg, WebP };
+
+    struct Options {
+        size_t workers = 2;
+        size_t maxSurfaces = 16;        // Staging surfaces (and captures in flight on the GPU)
+        uint32_t readbackDelayTicks = 2;
+        size_t maxPending = 128;        // Requests waiting for a surface before request() refuses
+    };
+
+    struct Request {
+        obs_source_t* source = nullptr; // nullptr = program output
+        Format format = Format::Png;
+        uint32_t width = 0;             // 0 = source size; one of the two keeps the aspect ratio
+        uint32_t height = 0;
+        int quality = -1;               // 0-100 for JPEG/WebP, -1 = encoder default
+        std::string path;               // Empty = only deliver the encoded bytes
+    };
+
+    struct Result {
+        bool success = false;
+        std::string path;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> data;      // Encoded image
+    };
+    using Callback = std::function<void(Result)>;
+
+    struct Stats {
+        uint64_t captures = 0;
+        uint64_t failures = 0;
+        uint64_t busyTicks = 0;         // Ticks that rendered or mapped something
+        uint64_t totalTickMicros = 0;   // Time spent on the graphics thread
+        uint64_t maxTickMicros = 0;
+        uint64_t totalEncodeMicros = 0;
+    };
+
+    ScreenshotService();
+    ~ScreenshotService();
+
+    ScreenshotService(const ScreenshotService&) = delete;
+    ScreenshotService& operator=(const ScreenshotService&) = delete;
+
+    // Requires obs_startup(); call stop() before obs_shutdown()
+    bool start(const Options& options);
+    void stop();
+    bool running() const { return m_running; }
+
+    /**
+     * @brief Queue a capture; callback runs on a worker thread
+     * @return false if the service is stopped or too many captures are waiting
+     */
+    bool request(Request request, Callback callback);
+
+    Stats stats() const;
+
+    // "png", "jpg"/"jpeg", "webp" (case-insensitive)
+    static bool parseFormat(const std::string& name, Format& format);
+    static const char* extension(Format format);
+
+private:
+    struct Surface;
+    struct Capture;
+    struct Job;
+
+    static void tickCallback(void* param, float seconds);
+    void tick();
+    bool render(Capture& capture);
+    void readback(Capture& capture, std::vector<uint8_t>& pixels);
+    Surface* acquireSurface(uint32_t width, uint32_t height);
+    void destroySurfaces();
+
+    void queueJob(std::unique_ptr<Job> job);
+    void workerMain();
+    void encode(Job& job);
+
+    Options m_options;
+    std::atomic<bool> m_running{false};
+
+    // Requests from any thread, taken by the tick
+    mutable std::mutex m_mutex;
+    std::deque<std::unique_ptr<Capture>> m_pending;
+    Stats m_stats;
+
+    // Graphics thread only
+    std::vector<std::unique_ptr<Surface>> m_surfaces;
+    std::vector<std::unique_ptr<Capture>> m_inFlight;
+
+    // Worker pool
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobReady;
+    std::deque<std::unique_ptr<Job>> m_jobs;
+    bool m_stopping = false;
+    std::vector<std::thread> m_workers;
+};
+
+} // namespace streamlumo
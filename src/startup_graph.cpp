@@ -0,0 +1,168 @@
+// streamlumo-engine/src/startup_graph.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "startup_graph.h"
+#include "logging.h"
+#include "trace.h"
+#include "platform/platform.h"
+
+#include <algorithm>
+#include <future>
+
+namespace streamlumo {
+
+void StartupGraph::add(const std::string& name, const std::vector<std::string>& deps, Runs where,
+                       std::function<bool()> fn, bool required)
+{
+    Phase phase;
+    phase.name = name;
+    phase.where = where;
+    phase.fn = std::move(fn);
+    phase.required = required;
+    for (const std::string& dep : deps) {
+        auto it = std::find_if(m_phases.begin(), m_phases.end(),
+                               [&](const Phase& p) { return p.name == dep; });
+        if (it == m_phases.end()) {
+            // Dependencies must be added first, which also rules out cycles
+            log_error("Startup: phase '%s' depends on unknown phase '%s'", name.c_str(), dep.c_str());
+            continue;
+        }
+        phase.deps.push_back(static_cast<size_t>(it - m_phases.begin()));
+    }
+    m_phases.push_back(std::move(phase));
+}
+
+bool StartupGraph::depsDone(const Phase& phase) const
+{
+    return std::all_of(phase.deps.begin(), phase.deps.end(), [&](size_t dep) {
+        const Phase& d = m_phases[dep];
+        return d.state == State::Done || (d.state == State::Failed && !d.required);
+    });
+}
+
+bool StartupGraph::depsBroken(const Phase& phase) const
+{
+    return std::any_of(phase.deps.begin(), phase.deps.end(), [&](size_t dep) {
+        const Phase& d = m_phases[dep];
+        return d.state == State::Skipped || (d.state == State::Failed && d.required);
+    });
+}
+
+void StartupGraph::finish(size_t index, bool ok)
+{
+    Phase& phase = m_phases[index];
+    phase.endNanos = platform::getTimestampNanos();
+    phase.state = ok ? State::Done : State::Failed;
+    Trace::complete("startup", phase.name.c_str(), phase.startNanos, phase.endNanos);
+    if (!ok) {
+        if (phase.required) {
+            log_error("Startup: phase '%s' failed", phase.name.c_str());
+        } else {
+            log_warn("Startup: phase '%s' failed (non-fatal)", phase.name.c_str());
+        }
+    }
+}
+
+bool StartupGraph::run()
+{
+    m_startNanos = platform::getTimestampNanos();
+    std::vector<std::future<void>> workers;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        bool unfinished = false;
+        bool progressed = false;
+
+        if (!m_cancelled && m_cancelCheck && m_cancelCheck()) {
+            m_cancelled = true;
+            for (Phase& phase : m_phases) {
+                if (phase.state == State::Pending) {
+                    phase.state = State::Skipped;
+                    log_warn("Startup: skipping phase '%s' (cancelled)", phase.name.c_str());
+                }
+            }
+        }
+
+        for (size_t i = 0; i < m_phases.size(); ++i) {
+            Phase& phase = m_phases[i];
+            if (phase.state != State::Pending) {
+                unfinished = unfinished || phase.state == State::Running;
+                continue;
+            }
+            unfinished = true;
+            if (depsBroken(phase)) {
+                phase.state = State::Skipped;
+                log_warn("Startup: skipping phase '%s' (dependency failed)", phase.name.c_str());
+                progressed = true;
+                continue;
+            }
+            if (!depsDone(phase)) {
+                continue;
+            }
+
+            phase.state = State::Running;
+            phase.startNanos = platform::getTimestampNanos();
+            progressed = true;
+            if (phase.where == Runs::Worker) {
+                workers.push_back(std::async(std::launch::async, [this, i] {
+                    Trace::setThreadName("startup worker");
+                    const bool ok = m_phases[i].fn();
+                    std::lock_guard<std::mutex> guard(m_mutex);
+                    finish(i, ok);
+                    m_cv.notify_all();
+                }));
+                continue;
+            }
+
+            // Main-thread phase: run it unlocked, then rescan from the top so
+            // Main phases keep their insertion order
+            lock.unlock();
+            const bool ok = phase.fn();
+            lock.lock();
+            finish(i, ok);
+            break;
+        }
+
+        if (!unfinished) {
+            break;
+        }
+        if (!progressed) {
+            m_cv.wait(lock);
+        }
+    }
+    lock.unlock();
+
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    m_endNanos = platform::getTimestampNanos();
+
+    return std::none_of(m_phases.begin(), m_phases.end(), [](const Phase& p) {
+        return p.required && (p.state == State::Failed || p.state == State::Skipped);
+    });
+}
+
+void StartupGraph::report() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint64_t serialNanos = 0;
+    for (const Phase& phase : m_phases) {
+        const char* state = phase.state == State::Done ? "ok"
+                          : phase.state == State::Failed ? "FAILED"
+                          : phase.state == State::Skipped ? "skipped" : "?";
+        const uint64_t duration = phase.endNanos > phase.startNanos ? phase.endNanos - phase.startNanos : 0;
+        serialNanos += duration;
+        log_info("Startup phase %-16s %-6s +%8.1f ms  %8.1f ms  %s",
+                 phase.name.c_str(), phase.where == Runs::Main ? "main" : "worker",
+                 phase.startNanos ? (phase.startNanos - m_startNanos) / 1e6 : 0.0,
+                 duration / 1e6, state);
+    }
+    const uint64_t wallNanos = m_endNanos - m_startNanos;
+    log_info("Startup: ready in %.1f ms (phases sum to %.1f ms, %.1f ms overlapped)",
+             wallNanos / 1e6, serialNanos / 1e6,
+             serialNanos > wallNanos ? (serialNanos - wallNanos) / 1e6 : 0.0);
+}
+
+} // namespace streamlumo
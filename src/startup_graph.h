@@ -0,0 +1,78 @@
+// streamlumo-engine/src/startup_graph.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace streamlumo {
+
+/**
+ * @brief Runs startup phases as a dependency graph
+ * 
+ * Each phase names the phases it depends on and where it must run:
+ * Main phases (anything touching libobs core state) run on the calling
+ * thread in the order they were added, Worker phases run on their own
+ * std::async thread as soon as their dependencies are done, so helper
+ * launch, path resolution and module discovery overlap with OBS startup.
+ * 
+ * A failed required phase skips everything that depends on it and makes
+ * run() return false; a failed optional phase only logs a warning. A cancel
+ * check, polled before each phase starts, skips every phase not yet started
+ * (running Worker phases are still waited for).
+ * report() logs the start offset and duration of every phase.
+ */
+class StartupGraph {
+public:
+    enum class Runs { Main, Worker };
+
+    void add(const std::string& name, const std::vector<std::string>& deps, Runs where,
+             std::function<bool()> fn, bool required = true);
+
+    // Polled on the calling thread; returning true cancels the remaining phases
+    void setCancelCheck(std::function<bool()> check) { m_cancelCheck = std::move(check); }
+    bool cancelled() const { return m_cancelled; }
+
+    /**
+     * @brief Execute all phases; returns once every phase finished or was skipped
+     * @return false if a required phase failed or was skipped
+     */
+    bool run();
+
+    void report() const;
+
+private:
+    enum class State { Pending, Running, Done, Failed, Skipped };
+
+    struct Phase {
+        std::string name;
+        std::vector<size_t> deps;
+        Runs where;
+        std::function<bool()> fn;
+        bool required;
+        State state = State::Pending;
+        uint64_t startNanos = 0;
+        uint64_t endNanos = 0;
+    };
+
+    // Both require m_mutex
+    bool depsDone(const Phase& phase) const;
+    bool depsBroken(const Phase& phase) const;
+    void finish(size_t index, bool ok);
+
+    std::vector<Phase> m_phases;
+    std::function<bool()> m_cancelCheck;
+    bool m_cancelled = false;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    uint64_t m_startNanos = 0;
+    uint64_t m_endNanos = 0;
+};
+
+} // namespace streamlumo
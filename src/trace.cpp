@@ -0,0 +1,235 @@
+// streamlumo-engine/src/trace.cpp
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#include "trace.h"
+#include "logging.h"
+#include "platform/platform.h"
+
+#include <obs.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace streamlumo {
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+// 64 bytes per event, 2 MB per thread that ever records
+constexpr size_t kEventsPerThread = 32768;
+
+struct Event {
+    uint64_t startNanos;
+    uint64_t durationNanos;
+    char category[16];
+    char name[32];
+};
+
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::string threadName;
+
+    // Only contended while a dump copies the ring
+    std::mutex mutex;
+    std::vector<Event> events;
+    size_t next = 0;
+    bool wrapped = false;
+};
+
+std::mutex s_registryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> s_buffers;
+uint32_t s_nextTid = 1;
+uint64_t s_epochNanos = 0;
+
+thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+
+ThreadBuffer& threadBuffer()
+{
+    if (!t_buffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        buffer->events.resize(kEventsPerThread);
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        buffer->tid = s_nextTid++;
+        buffer->threadName = "thread " + std::to_string(buffer->tid);
+        s_buffers.push_back(buffer);
+        t_buffer = std::move(buffer);
+    }
+    return *t_buffer;
+}
+
+void copyName(char* dst, size_t size, const char* src)
+{
+    std::strncpy(dst, src ? src : "", size - 1);
+    dst[size - 1] = '\0';
+}
+
+void writeJsonString(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (const char* p = text; *p; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if (c < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+bool apiEnabled() { return Trace::enabled(); }
+uint64_t apiNow() { return Trace::now(); }
+
+const TraceApi s_api = {
+    1,
+    apiEnabled,
+    apiNow,
+    Trace::complete,
+    Trace::setThreadName,
+};
+
+// proc: void streamlumo_trace_get_api(out ptr api)
+void getApiProc(void*, calldata_t* cd)
+{
+    calldata_set_ptr(cd, "api", const_cast<TraceApi*>(&s_api));
+}
+
+} // namespace
+
+void Trace::enable()
+{
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        if (s_epochNanos == 0) {
+            s_epochNanos = now();
+        }
+    }
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+uint64_t Trace::now()
+{
+    return platform::getTimestampNanos();
+}
+
+void Trace::complete(const char* category, const char* name, uint64_t startNanos, uint64_t endNanos)
+{
+    if (!enabled()) {
+        return;
+    }
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    Event& event = buffer.events[buffer.next];
+    event.startNanos = startNanos;
+    event.durationNanos = endNanos > startNanos ? endNanos - startNanos : 0;
+    copyName(event.category, sizeof(event.category), category);
+    copyName(event.name, sizeof(event.name), name);
+    if (++buffer.next == buffer.events.size()) {
+        buffer.next = 0;
+        buffer.wrapped = true;
+    }
+}
+
+void Trace::setThreadName(const char* name)
+{
+    if (!enabled()) {
+        return;
+    }
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    buffer.threadName = name ? name : "";
+}
+
+bool Trace::writeJson(const std::string& path)
+{
+    const uint64_t start = now();
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<std::string> names;
+    uint64_t epoch;
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        buffers = s_buffers;
+        for (const auto& buffer : buffers) {
+            names.push_back(buffer->threadName);
+        }
+        epoch = s_epochNanos;
+    }
+
+    // Write to a temporary file and rename so a viewer never opens half a trace
+    const std::string tmpPath = path + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "w");
+    if (!file) {
+        log_warn("Trace: cannot write %s", tmpPath.c_str());
+        return false;
+    }
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    size_t count = 0;
+    std::vector<Event> events;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        ThreadBuffer& buffer = *buffers[i];
+
+        fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                first ? "" : ",\n", buffer.tid);
+        writeJsonString(file, names[i].c_str());
+        fputs("}}", file);
+        first = false;
+
+        // Copy the ring oldest-first so the owning thread is blocked only briefly
+        {
+            std::lock_guard<std::mutex> lock(buffer.mutex);
+            events.clear();
+            if (buffer.wrapped) {
+                events.insert(events.end(), buffer.events.begin() + buffer.next, buffer.events.end());
+            }
+            events.insert(events.end(), buffer.events.begin(), buffer.events.begin() + buffer.next);
+        }
+
+        for (const Event& event : events) {
+            const uint64_t relative = event.startNanos > epoch ? event.startNanos - epoch : 0;
+            fputs(",\n{\"ph\":\"X\",\"name\":", file);
+            writeJsonString(file, event.name);
+            fputs(",\"cat\":", file);
+            writeJsonString(file, event.category);
+            fprintf(file, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    buffer.tid, relative / 1e3, event.durationNanos / 1e3);
+        }
+        count += events.size();
+    }
+    fputs("\n]}\n", file);
+
+    const bool ok = fflush(file) == 0 && !ferror(file);
+    fclose(file);
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmpPath, path, ec);
+    }
+    if (!ok || ec) {
+        log_warn("Trace: failed to write %s", path.c_str());
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    log_info("Trace: wrote %zu events from %zu threads to %s in %.1f ms",
+             count, buffers.size(), path.c_str(), (now() - start) / 1e6);
+    return true;
+}
+
+void Trace::registerProc()
+{
+    proc_handler_add(obs_get_proc_handler(), "void streamlumo_trace_get_api(out ptr api)",
+                     getApiProc, nullptr);
+}
+
+} // namespace streamlumo
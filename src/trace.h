@@ -0,0 +1,90 @@
+// streamlumo-engine/src/trace.h
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2024 StreamLumo
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace streamlumo {
+
+/**
+ * @brief Scoped timing trace exported as Chrome trace JSON
+ *
+ * Each thread records complete ("X") events into its own fixed-size ring,
+ * so recording never contends with other threads and never allocates after
+ * the first event. Rings keep the most recent events; a dump snapshots all
+ * of them into a JSON file that chrome://tracing and ui.perfetto.dev load.
+ *
+ * While disabled (the default) a TraceScope costs one relaxed atomic load.
+ * Loaded modules reach the same buffers through the proc
+ * "void streamlumo_trace_get_api(out ptr api)" (see TraceApi).
+ */
+class Trace {
+public:
+    static void enable();
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Same clock as platform::getTimestampNanos()
+    static uint64_t now();
+
+    // Names are copied (truncated to a few dozen characters)
+    static void complete(const char* category, const char* name, uint64_t startNanos, uint64_t endNanos);
+    static void setThreadName(const char* name);
+
+    /**
+     * @brief Write every thread's buffered events to path
+     * @return false if the file could not be written
+     */
+    static bool writeJson(const std::string& path);
+
+    // Register the proc handler that hands TraceApi to modules
+    static void registerProc();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief Records [construction, destruction) as one event when tracing is on
+ */
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name)
+        : m_category(category), m_name(name), m_start(Trace::enabled() ? Trace::now() : 0) {}
+    ~TraceScope() {
+        if (m_start != 0) {
+            Trace::complete(m_category, m_name, m_start, Trace::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_category;
+    const char* m_name;
+    uint64_t m_start;
+};
+
+/**
+ * @brief C function table handed to modules by streamlumo_trace_get_api
+ *
+ * Only ever extended at the end; modules check version before use.
+ */
+struct TraceApi {
+    uint32_t version;
+    bool (*enabled)(void);
+    uint64_t (*now)(void);
+    void (*complete)(const char* category, const char* name, uint64_t startNanos, uint64_t endNanos);
+    void (*setThreadName)(const char* name);
+};
+
+} // namespace streamlumo
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, name) \
+    streamlumo::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(category, name)